@@ -0,0 +1,49 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Memory.h"
+#include "mn/Buf.h"
+#include "mn/Str.h"
+
+namespace mn
+{
+	// a named allocator along with its stats at the time of the snapshot
+	struct Allocator_Registry_Entry
+	{
+		Str name;
+		Allocator allocator;
+		memory::Stats stats;
+	};
+
+	// frees the given allocator registry entry
+	inline static void
+	allocator_registry_entry_free(Allocator_Registry_Entry& self)
+	{
+		str_free(self.name);
+	}
+
+	// destruct overload for allocator registry entry free
+	inline static void
+	destruct(Allocator_Registry_Entry& self)
+	{
+		allocator_registry_entry_free(self);
+	}
+
+	// the allocator registry is a global thread safe list of named allocators, it's used to enumerate the allocators
+	// of the different subsystems to report their memory usage, registering an allocator doesn't change its behaviour
+	// make sure you unregister the allocator before freeing it
+
+	// adds the given allocator to the registry with the given name, if the allocator is already registered
+	// it renames it
+	MN_EXPORT void
+	allocator_register(Allocator allocator, const char* name);
+
+	// removes the given allocator from the registry, if it's not registered it does nothing
+	MN_EXPORT void
+	allocator_unregister(Allocator allocator);
+
+	// returns the registered allocators along with their current stats, the entries are sorted by registration order
+	// you should free the result using destruct
+	MN_EXPORT Buf<Allocator_Registry_Entry>
+	allocator_registry_snapshot(Allocator allocator = allocator_top());
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Buf.h"
+#include "mn/Assert.h"
+
+#if MN_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+namespace mn
+{
+	// returns the count of the set bits in the given word
+	inline static size_t
+	_bitset_popcount(uint64_t word)
+	{
+		#if MN_COMPILER_MSVC
+			word = word - ((word >> 1) & 0x5555555555555555ULL);
+			word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+			word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+			return size_t((word * 0x0101010101010101ULL) >> 56);
+		#else
+			return size_t(__builtin_popcountll(word));
+		#endif
+	}
+
+	// returns the index of the least significant set bit in the given non zero word
+	inline static size_t
+	_bitset_ctz(uint64_t word)
+	{
+		mn_assert(word != 0);
+		#if MN_COMPILER_MSVC
+			unsigned long index = 0;
+			_BitScanForward64(&index, word);
+			return size_t(index);
+		#else
+			return size_t(__builtin_ctzll(word));
+		#endif
+	}
+
+	// a dynamic bitset which uses a single bit per integer, the bulk operations work on 128 bits at a time using SIMD
+	// so set algebra over millions of integers is bound by memory bandwidth
+	struct Bitset
+	{
+		Buf<uint64_t> words;
+		// count of bits in the bitset, the bits beyond the count in the last word are always 0
+		size_t count;
+	};
+
+	// returned by find functions when there's no set bit
+	constexpr size_t BITSET_NPOS = SIZE_MAX;
+
+	// creates a new bitset with the given count of bits which are all unset
+	MN_EXPORT Bitset
+	bitset_new(size_t count = 0, Allocator allocator = allocator_top());
+
+	// frees the given bitset
+	MN_EXPORT void
+	bitset_free(Bitset& self);
+
+	// destruct overload for bitset free
+	inline static void
+	destruct(Bitset& self)
+	{
+		bitset_free(self);
+	}
+
+	// clones the given bitset using the given allocator
+	MN_EXPORT Bitset
+	bitset_clone(const Bitset& other, Allocator allocator = allocator_top());
+
+	// clone overload for bitset
+	inline static Bitset
+	clone(const Bitset& other)
+	{
+		return bitset_clone(other);
+	}
+
+	// resizes the given bitset to the given count of bits, the new bits are unset
+	MN_EXPORT void
+	bitset_resize(Bitset& self, size_t count);
+
+	// unsets all the bits in the given bitset, it keeps its count
+	MN_EXPORT void
+	bitset_clear(Bitset& self);
+
+	// returns whether the given bit is set
+	inline static bool
+	bitset_test(const Bitset& self, size_t index)
+	{
+		mn_assert(index < self.count);
+		return (self.words[index >> 6] >> (index & 63)) & 1;
+	}
+
+	// sets the given bit
+	inline static void
+	bitset_set(Bitset& self, size_t index)
+	{
+		mn_assert(index < self.count);
+		self.words[index >> 6] |= uint64_t(1) << (index & 63);
+	}
+
+	// unsets the given bit
+	inline static void
+	bitset_unset(Bitset& self, size_t index)
+	{
+		mn_assert(index < self.count);
+		self.words[index >> 6] &= ~(uint64_t(1) << (index & 63));
+	}
+
+	// sets the given bit, and grows the bitset if the bit is beyond its count
+	inline static void
+	bitset_insert(Bitset& self, size_t index)
+	{
+		if (index >= self.count)
+			bitset_resize(self, index + 1);
+		bitset_set(self, index);
+	}
+
+	// returns the count of the set bits in the given bitset
+	MN_EXPORT size_t
+	bitset_popcount(const Bitset& self);
+
+	// returns the index of the first set bit starting from the given index, or BITSET_NPOS if there's none
+	MN_EXPORT size_t
+	bitset_find_next(const Bitset& self, size_t start = 0);
+
+	// self = self & other, the bits beyond the other bitset count are treated as unset
+	MN_EXPORT void
+	bitset_and(Bitset& self, const Bitset& other);
+
+	// self = self | other, self grows to the other bitset count if it's smaller
+	MN_EXPORT void
+	bitset_or(Bitset& self, const Bitset& other);
+
+	// self = self ^ other, self grows to the other bitset count if it's smaller
+	MN_EXPORT void
+	bitset_xor(Bitset& self, const Bitset& other);
+
+	// self = self & ~other, removes the other bitset set bits from self
+	MN_EXPORT void
+	bitset_andnot(Bitset& self, const Bitset& other);
+
+	// calls the given function `fn(size_t index)` with the index of each set bit in ascending order
+	template<typename TFunc>
+	inline static void
+	bitset_each(const Bitset& self, TFunc&& fn)
+	{
+		for (size_t i = 0; i < self.words.count; ++i)
+		{
+			auto word = self.words[i];
+			while (word)
+			{
+				fn(i * 64 + _bitset_ctz(word));
+				// clear the least significant set bit
+				word &= word - 1;
+			}
+		}
+	}
+
+	// a roaring bitset container which holds the integers which share the same high 16 bits, it's a sorted array of
+	// the low 16 bits when it has a few integers or a 2^16 bits bitmap when it has more than ROARING_ARRAY_MAX_COUNT
+	struct Roaring_Container
+	{
+		uint32_t count;
+		uint16_t key;
+		Buf<uint16_t> array;
+		// 1024 words when the container is a bitmap, empty otherwise
+		Buf<uint64_t> bitmap;
+	};
+
+	// max count of integers in an array container, at this count the array and the bitmap have the same size (8KiB)
+	constexpr size_t ROARING_ARRAY_MAX_COUNT = 4096;
+	// count of words in a bitmap container
+	constexpr size_t ROARING_BITMAP_WORDS_COUNT = 1024;
+
+	// a compressed bitset of uint32 integers (roaring bitmap), the integers are partitioned by their high 16 bits into
+	// containers, sparse containers are sorted arrays and dense containers are bitmaps, so sparse sets take 2 bytes per
+	// integer and dense sets take a bit per integer
+	struct Roaring_Bitset
+	{
+		Allocator allocator;
+		// sorted by their keys
+		Buf<Roaring_Container> containers;
+	};
+
+	// creates a new empty roaring bitset
+	MN_EXPORT Roaring_Bitset
+	roaring_bitset_new(Allocator allocator = allocator_top());
+
+	// frees the given roaring bitset
+	MN_EXPORT void
+	roaring_bitset_free(Roaring_Bitset& self);
+
+	// destruct overload for roaring bitset free
+	inline static void
+	destruct(Roaring_Bitset& self)
+	{
+		roaring_bitset_free(self);
+	}
+
+	// clones the given roaring bitset using the given allocator
+	MN_EXPORT Roaring_Bitset
+	roaring_bitset_clone(const Roaring_Bitset& other, Allocator allocator = allocator_top());
+
+	// clone overload for roaring bitset
+	inline static Roaring_Bitset
+	clone(const Roaring_Bitset& other)
+	{
+		return roaring_bitset_clone(other);
+	}
+
+	// removes all the integers from the given roaring bitset
+	MN_EXPORT void
+	roaring_bitset_clear(Roaring_Bitset& self);
+
+	// adds the given integer to the roaring bitset, returns whether it was added (false if it already exists)
+	MN_EXPORT bool
+	roaring_bitset_add(Roaring_Bitset& self, uint32_t v);
+
+	// removes the given integer from the roaring bitset, returns whether it was found
+	MN_EXPORT bool
+	roaring_bitset_remove(Roaring_Bitset& self, uint32_t v);
+
+	// returns whether the given integer is in the roaring bitset
+	MN_EXPORT bool
+	roaring_bitset_contains(const Roaring_Bitset& self, uint32_t v);
+
+	// returns the count of the integers in the roaring bitset
+	MN_EXPORT size_t
+	roaring_bitset_count(const Roaring_Bitset& self);
+
+	// returns a new roaring bitset with the integers which are in both a and b
+	MN_EXPORT Roaring_Bitset
+	roaring_bitset_and(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator = allocator_top());
+
+	// returns a new roaring bitset with the integers which are in a or b
+	MN_EXPORT Roaring_Bitset
+	roaring_bitset_or(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator = allocator_top());
+
+	// returns a new roaring bitset with the integers which are in either a or b but not both
+	MN_EXPORT Roaring_Bitset
+	roaring_bitset_xor(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator = allocator_top());
+
+	// returns a new roaring bitset with the integers which are in a but not in b
+	MN_EXPORT Roaring_Bitset
+	roaring_bitset_andnot(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator = allocator_top());
+
+	// calls the given function `fn(uint32_t v)` with each integer in the roaring bitset in ascending order
+	template<typename TFunc>
+	inline static void
+	roaring_bitset_each(const Roaring_Bitset& self, TFunc&& fn)
+	{
+		for (const auto& container: self.containers)
+		{
+			auto high = uint32_t(container.key) << 16;
+			if (container.bitmap.count > 0)
+			{
+				for (size_t i = 0; i < container.bitmap.count; ++i)
+				{
+					auto word = container.bitmap[i];
+					while (word)
+					{
+						fn(high | uint32_t(i * 64 + _bitset_ctz(word)));
+						word &= word - 1;
+					}
+				}
+			}
+			else
+			{
+				for (auto low: container.array)
+					fn(high | low);
+			}
+		}
+	}
+}
@@ -576,4 +576,17 @@ namespace mn
 	{
 		return Block{ b.ptr, b.count * sizeof(T) };
 	}
-}
\ No newline at end of file
+
+	// default ordering of the ordered containers and heaps using the less than operator, it accepts different types on
+	// both sides to support heterogeneous lookup (ex. searching a Str ordered set using a const char*)
+	template<typename T>
+	struct Less
+	{
+		template<typename TLeft, typename TRight>
+		inline bool
+		operator()(const TLeft& a, const TRight& b) const
+		{
+			return a < b;
+		}
+	};
+}
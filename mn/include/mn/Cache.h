@@ -0,0 +1,341 @@
+#pragma once
+
+#include "mn/Map.h"
+#include "mn/Buf.h"
+#include "mn/Assert.h"
+
+namespace mn
+{
+	// eviction policy of the cache
+	enum CACHE_POLICY
+	{
+		// evicts the least recently used entry, every hit moves the entry to the front of a linked list
+		CACHE_POLICY_LRU,
+		// approximates LRU using a referenced bit per entry and a clock hand which sweeps the entries on eviction, hits
+		// only set the referenced bit which makes them cheaper than LRU hits
+		CACHE_POLICY_CLOCK,
+	};
+
+	// cache statistics
+	struct Cache_Stats
+	{
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		// count of the entries in the cache
+		size_t count;
+		// sum of the entries sizes
+		size_t size;
+		size_t capacity;
+	};
+
+	// cache entry, the entries are linked using their indices, the free entries are linked in a free list using next
+	template<typename TKey, typename TValue>
+	struct Cache_Entry
+	{
+		TKey key;
+		TValue value;
+		size_t size;
+		uint32_t prev;
+		uint32_t next;
+		bool referenced;
+		bool alive;
+	};
+
+	constexpr uint32_t CACHE_INVALID_INDEX = UINT32_MAX;
+
+	// a bounded cache which maps keys to values, every entry has a size (ex. its size in bytes) and the cache evicts
+	// entries using its policy when the sum of the entries sizes exceeds its capacity, all operations are O(1)
+	// the evict callback is called with each entry which leaves the cache (eviction, removal, overwrite, clear, and
+	// free) so it can destruct them, the cache doesn't own its entries otherwise
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Cache
+	{
+		CACHE_POLICY policy;
+		size_t capacity;
+		size_t size;
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		void (*on_evict)(void* user_data, TKey& key, TValue& value);
+		void* on_evict_user_data;
+
+		Map<TKey, uint32_t, THash> _index;
+		Buf<Cache_Entry<TKey, TValue>> _entries;
+		uint32_t _free_list_head;
+		// the most recently used entry is at the head of the list
+		uint32_t _lru_head;
+		uint32_t _lru_tail;
+		uint32_t _clock_hand;
+	};
+
+	// evict callback which destructs the key and the value of the evicted entry
+	template<typename TKey, typename TValue>
+	inline static void
+	cache_evict_destruct(void*, TKey& key, TValue& value)
+	{
+		destruct(key);
+		destruct(value);
+	}
+
+	// creates a new cache with the given capacity in size units (ex. bytes) and the given eviction policy
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Cache<TKey, TValue, THash>
+	cache_new(size_t capacity, CACHE_POLICY policy = CACHE_POLICY_LRU, Allocator allocator = allocator_top())
+	{
+		Cache<TKey, TValue, THash> self{};
+		self.policy = policy;
+		self.capacity = capacity;
+		self._index = map_with_allocator<TKey, uint32_t, THash>(allocator);
+		self._entries = buf_with_allocator<Cache_Entry<TKey, TValue>>(allocator);
+		self._free_list_head = CACHE_INVALID_INDEX;
+		self._lru_head = CACHE_INVALID_INDEX;
+		self._lru_tail = CACHE_INVALID_INDEX;
+		return self;
+	}
+
+	// sets the callback which is called with each entry which leaves the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	cache_set_evict_callback(Cache<TKey, TValue, THash>& self, void (*on_evict)(void*, TKey&, TValue&), void* user_data = nullptr)
+	{
+		self.on_evict = on_evict;
+		self.on_evict_user_data = user_data;
+	}
+
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_lru_unlink(Cache<TKey, TValue, THash>& self, uint32_t index)
+	{
+		auto& entry = self._entries[index];
+		if (entry.prev != CACHE_INVALID_INDEX)
+			self._entries[entry.prev].next = entry.next;
+		else
+			self._lru_head = entry.next;
+
+		if (entry.next != CACHE_INVALID_INDEX)
+			self._entries[entry.next].prev = entry.prev;
+		else
+			self._lru_tail = entry.prev;
+
+		entry.prev = CACHE_INVALID_INDEX;
+		entry.next = CACHE_INVALID_INDEX;
+	}
+
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_lru_push_front(Cache<TKey, TValue, THash>& self, uint32_t index)
+	{
+		auto& entry = self._entries[index];
+		entry.prev = CACHE_INVALID_INDEX;
+		entry.next = self._lru_head;
+		if (self._lru_head != CACHE_INVALID_INDEX)
+			self._entries[self._lru_head].prev = index;
+		else
+			self._lru_tail = index;
+		self._lru_head = index;
+	}
+
+	// removes the given entry from the cache, calls the evict callback, and pushes it to the free list
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_entry_release(Cache<TKey, TValue, THash>& self, uint32_t index)
+	{
+		auto& entry = self._entries[index];
+		mn_assert(entry.alive);
+		map_remove(self._index, entry.key);
+		if (self.policy == CACHE_POLICY_LRU)
+			_cache_lru_unlink(self, index);
+		self.size -= entry.size;
+
+		if (self.on_evict)
+			self.on_evict(self.on_evict_user_data, entry.key, entry.value);
+
+		entry.alive = false;
+		entry.next = self._free_list_head;
+		self._free_list_head = index;
+	}
+
+	// evicts a single entry according to the cache policy
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_evict_one(Cache<TKey, TValue, THash>& self)
+	{
+		mn_assert(self._index.count > 0);
+		if (self.policy == CACHE_POLICY_LRU)
+		{
+			_cache_entry_release(self, self._lru_tail);
+		}
+		else
+		{
+			// sweep the entries giving the referenced ones a second chance, it terminates after at most 2 rounds
+			while (true)
+			{
+				if (self._clock_hand >= self._entries.count)
+					self._clock_hand = 0;
+				auto index = self._clock_hand++;
+				auto& entry = self._entries[index];
+				if (entry.alive == false)
+					continue;
+				if (entry.referenced)
+				{
+					entry.referenced = false;
+					continue;
+				}
+				_cache_entry_release(self, index);
+				break;
+			}
+		}
+		++self.evictions;
+	}
+
+	// removes all the entries from the cache and calls the evict callback with each one of them, it keeps the memory
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	cache_clear(Cache<TKey, TValue, THash>& self)
+	{
+		if (self.on_evict)
+		{
+			for (auto& entry: self._entries)
+				if (entry.alive)
+					self.on_evict(self.on_evict_user_data, entry.key, entry.value);
+		}
+		map_clear(self._index);
+		buf_clear(self._entries);
+		self.size = 0;
+		self._free_list_head = CACHE_INVALID_INDEX;
+		self._lru_head = CACHE_INVALID_INDEX;
+		self._lru_tail = CACHE_INVALID_INDEX;
+		self._clock_hand = 0;
+	}
+
+	// frees the given cache, the evict callback is called with the remaining entries
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	cache_free(Cache<TKey, TValue, THash>& self)
+	{
+		cache_clear(self);
+		map_free(self._index);
+		buf_free(self._entries);
+	}
+
+	// destruct overload for cache free, if there's no evict callback the remaining keys and values are destructed
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	destruct(Cache<TKey, TValue, THash>& self)
+	{
+		if (self.on_evict == nullptr)
+			self.on_evict = cache_evict_destruct<TKey, TValue>;
+		cache_free(self);
+	}
+
+	// searches for the given key in the cache, and marks it as recently used, returns a pointer to its value or nullptr
+	// on miss, the pointer is invalidated by the next insert
+	// the key can be of any type which the key hash functor accepts and which can be compared to the keys using ==
+	template<typename TKey, typename TValue, typename THash, typename TProbe>
+	inline static TValue*
+	cache_lookup(Cache<TKey, TValue, THash>& self, const TProbe& key)
+	{
+		auto it = map_lookup_as(self._index, key);
+		if (it == nullptr)
+		{
+			++self.misses;
+			return nullptr;
+		}
+
+		++self.hits;
+		auto index = it->value;
+		auto& entry = self._entries[index];
+		if (self.policy == CACHE_POLICY_LRU)
+		{
+			if (self._lru_head != index)
+			{
+				_cache_lru_unlink(self, index);
+				_cache_lru_push_front(self, index);
+			}
+		}
+		else
+		{
+			entry.referenced = true;
+		}
+		return &entry.value;
+	}
+
+	// removes the given key from the cache and calls the evict callback with it, returns whether it was found
+	template<typename TKey, typename TValue, typename THash, typename TProbe>
+	inline static bool
+	cache_remove(Cache<TKey, TValue, THash>& self, const TProbe& key)
+	{
+		auto it = map_lookup_as(self._index, key);
+		if (it == nullptr)
+			return false;
+		_cache_entry_release(self, it->value);
+		return true;
+	}
+
+	// inserts the given key and value into the cache with the given size, the least valuable entries are evicted until
+	// it fits, if the key exists its old entry is removed first, returns false if the size is bigger than the capacity
+	// in which case the key and value are not inserted and remain owned by the caller
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	cache_insert(Cache<TKey, TValue, THash>& self, const TKey& key, const TValue& value, size_t size = 1)
+	{
+		if (size > self.capacity)
+			return false;
+
+		if (auto it = map_lookup(self._index, key))
+			_cache_entry_release(self, it->value);
+
+		while (self.size + size > self.capacity)
+			_cache_evict_one(self);
+
+		uint32_t index = self._free_list_head;
+		if (index != CACHE_INVALID_INDEX)
+		{
+			self._free_list_head = self._entries[index].next;
+		}
+		else
+		{
+			index = uint32_t(self._entries.count);
+			buf_push(self._entries, Cache_Entry<TKey, TValue>{});
+		}
+
+		auto& entry = self._entries[index];
+		entry.key = key;
+		entry.value = value;
+		entry.size = size;
+		entry.prev = CACHE_INVALID_INDEX;
+		entry.next = CACHE_INVALID_INDEX;
+		entry.referenced = false;
+		entry.alive = true;
+		map_insert(self._index, key, index);
+		self.size += size;
+
+		if (self.policy == CACHE_POLICY_LRU)
+			_cache_lru_push_front(self, index);
+		return true;
+	}
+
+	// returns the count of the entries in the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static size_t
+	cache_count(const Cache<TKey, TValue, THash>& self)
+	{
+		return self._index.count;
+	}
+
+	// returns the statistics of the given cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static Cache_Stats
+	cache_stats(const Cache<TKey, TValue, THash>& self)
+	{
+		Cache_Stats stats{};
+		stats.hits = self.hits;
+		stats.misses = self.misses;
+		stats.evictions = self.evictions;
+		stats.count = self._index.count;
+		stats.size = self.size;
+		stats.capacity = self.capacity;
+		return stats;
+	}
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Cache.h"
+#include "mn/Thread.h"
+
+namespace mn
+{
+	// size of the cache line, the shards are separated by a padding of this size to avoid false sharing, padding is
+	// used instead of alignas since the allocators don't guarantee over aligned memory
+	constexpr size_t CONCURRENT_CACHE_CACHE_LINE_SIZE = 64;
+
+	// a single shard of the concurrent cache, which is a normal cache guarded by a mutex
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Concurrent_Cache_Shard
+	{
+		Mutex mtx;
+		Cache<TKey, TValue, THash> cache;
+		char _pad[CONCURRENT_CACHE_CACHE_LINE_SIZE];
+	};
+
+	// a thread safe cache, the keys are distributed over a fixed number of shards using their hash, each shard is an
+	// independent cache with its own lock and an equal part of the capacity, so the eviction is per shard
+	// lookups update the recency information so they lock the shard exclusively, the CLOCK policy makes the critical
+	// section of hits shorter since it only sets a bit
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Concurrent_Cache
+	{
+		Allocator allocator;
+		Concurrent_Cache_Shard<TKey, TValue, THash>* shards;
+		size_t shards_count;
+		// log2 of the shards count, used to select the shard from the most significant bits of the hash
+		size_t shards_bits;
+	};
+
+	// creates a new concurrent cache with the given total capacity which is divided evenly between the shards, the
+	// shards count is rounded up to a power of 2
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Concurrent_Cache<TKey, TValue, THash>
+	concurrent_cache_new(size_t capacity, CACHE_POLICY policy = CACHE_POLICY_LRU, size_t shards_count = 16, Allocator allocator = allocator_top())
+	{
+		mn_assert(shards_count > 0);
+
+		size_t shards_bits = 0;
+		while ((size_t(1) << shards_bits) < shards_count)
+			++shards_bits;
+		shards_count = size_t(1) << shards_bits;
+
+		Concurrent_Cache<TKey, TValue, THash> self{};
+		self.allocator = allocator;
+		self.shards_count = shards_count;
+		self.shards_bits = shards_bits;
+		self.shards = (Concurrent_Cache_Shard<TKey, TValue, THash>*)alloc_from(
+			allocator,
+			sizeof(Concurrent_Cache_Shard<TKey, TValue, THash>) * shards_count,
+			alignof(Concurrent_Cache_Shard<TKey, TValue, THash>)
+		).ptr;
+		auto shard_capacity = (capacity + shards_count - 1) / shards_count;
+		for (size_t i = 0; i < shards_count; ++i)
+		{
+			auto shard = ::new (self.shards + i) Concurrent_Cache_Shard<TKey, TValue, THash>{};
+			shard->mtx = mutex_new("concurrent cache shard mutex");
+			shard->cache = cache_new<TKey, TValue, THash>(shard_capacity, policy, allocator);
+		}
+		return self;
+	}
+
+	// frees the given concurrent cache, the evict callback is called with the remaining entries
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static void
+	concurrent_cache_free(Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_free(self.shards[i].mtx);
+			cache_free(self.shards[i].cache);
+		}
+		free_from(self.allocator, Block{self.shards, sizeof(Concurrent_Cache_Shard<TKey, TValue, THash>) * self.shards_count});
+		self.shards = nullptr;
+		self.shards_count = 0;
+	}
+
+	// destruct overload for the concurrent cache, if there's no evict callback the remaining keys and values are
+	// destructed
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static void
+	destruct(Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_free(self.shards[i].mtx);
+			destruct(self.shards[i].cache);
+		}
+		free_from(self.allocator, Block{self.shards, sizeof(Concurrent_Cache_Shard<TKey, TValue, THash>) * self.shards_count});
+		self.shards = nullptr;
+		self.shards_count = 0;
+	}
+
+	// sets the callback which is called with each entry which leaves the cache, it's called while the entry's shard is
+	// locked so it shouldn't access the cache, it should be set before the cache is shared with other threads
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_cache_set_evict_callback(Concurrent_Cache<TKey, TValue, THash>& self, void (*on_evict)(void*, TKey&, TValue&), void* user_data = nullptr)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+			cache_set_evict_callback(self.shards[i].cache, on_evict, user_data);
+	}
+
+	// returns the shard of the given key
+	template<typename TKey, typename TValue, typename THash, typename TProbe>
+	inline static Concurrent_Cache_Shard<TKey, TValue, THash>&
+	_concurrent_cache_shard(const Concurrent_Cache<TKey, TValue, THash>& self, const TProbe& key)
+	{
+		if (self.shards_bits == 0)
+			return self.shards[0];
+		auto hash = _hash_ctrl_mix(THash()(key));
+		return self.shards[hash >> (sizeof(size_t) * 8 - self.shards_bits)];
+	}
+
+	// inserts the given key and value into the concurrent cache with the given size, returns false if the size is
+	// bigger than the shard capacity
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	concurrent_cache_insert(Concurrent_Cache<TKey, TValue, THash>& self, const TKey& key, const TValue& value, size_t size = 1)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		auto inserted = cache_insert(shard.cache, key, value, size);
+		mutex_unlock(shard.mtx);
+		return inserted;
+	}
+
+	// searches for the given key and copies its value into the given out value, returns whether the key was found
+	template<typename TKey, typename TValue, typename THash, typename TProbe>
+	inline static bool
+	concurrent_cache_lookup(Concurrent_Cache<TKey, TValue, THash>& self, const TProbe& key, TValue* out_value = nullptr)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		auto value = cache_lookup(shard.cache, key);
+		if (value && out_value)
+			*out_value = *value;
+		mutex_unlock(shard.mtx);
+		return value != nullptr;
+	}
+
+	// searches for the given key and calls the given function `fn(TValue&)` with its value while the shard is locked,
+	// which is useful to clone the value before another thread evicts it, returns whether the key was found
+	template<typename TKey, typename TValue, typename THash, typename TProbe, typename TFunc>
+	inline static bool
+	concurrent_cache_lookup_with(Concurrent_Cache<TKey, TValue, THash>& self, const TProbe& key, TFunc&& fn)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		auto value = cache_lookup(shard.cache, key);
+		if (value)
+			fn(*value);
+		mutex_unlock(shard.mtx);
+		return value != nullptr;
+	}
+
+	// removes the given key from the concurrent cache and calls the evict callback with it, returns whether it was found
+	template<typename TKey, typename TValue, typename THash, typename TProbe>
+	inline static bool
+	concurrent_cache_remove(Concurrent_Cache<TKey, TValue, THash>& self, const TProbe& key)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		auto removed = cache_remove(shard.cache, key);
+		mutex_unlock(shard.mtx);
+		return removed;
+	}
+
+	// removes all the entries from the concurrent cache and calls the evict callback with each one of them
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_cache_clear(Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			auto& shard = self.shards[i];
+			mutex_lock(shard.mtx);
+			cache_clear(shard.cache);
+			mutex_unlock(shard.mtx);
+		}
+	}
+
+	// returns the statistics of the given concurrent cache summed over all the shards, note that it's only a snapshot
+	template<typename TKey, typename TValue, typename THash>
+	inline static Cache_Stats
+	concurrent_cache_stats(const Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		Cache_Stats res{};
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			auto& shard = self.shards[i];
+			mutex_lock(shard.mtx);
+			auto stats = cache_stats(shard.cache);
+			mutex_unlock(shard.mtx);
+			res.hits += stats.hits;
+			res.misses += stats.misses;
+			res.evictions += stats.evictions;
+			res.count += stats.count;
+			res.size += stats.size;
+			res.capacity += stats.capacity;
+		}
+		return res;
+	}
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Handle_Table.h"
+#include "mn/Memory.h"
+#include "mn/Thread.h"
+#include "mn/Assert.h"
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+
+#if MN_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+namespace mn
+{
+	// log2 of the slots count of the first segment, segment i has 2^(BITS + i) slots so the segments never move and
+	// indices up to 2^32 fit in a fixed array of segments
+	constexpr size_t CONCURRENT_HANDLE_TABLE_SEGMENT_BITS = 10;
+	constexpr size_t CONCURRENT_HANDLE_TABLE_SEGMENTS_COUNT = 32 - CONCURRENT_HANDLE_TABLE_SEGMENT_BITS + 1;
+
+	// a thread safe handle table, get and exists don't take any locks, they validate the handle's generation before
+	// and after copying the value out (like a seqlock), insert and remove take a mutex which is amortized by the batched
+	// versions of them
+	// the slots are stored as a struct of arrays, the generations and the values live in separate segments which
+	// never move, so lookups only touch the generation and the value they need
+	// the generation of a slot is odd while it's free and even while it's alive, so stale handles never validate
+	// values are copied while other threads may be writing them so T should be trivially copyable
+	template<typename T>
+	struct IConcurrent_Handle_Table
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "concurrent handle table values should be trivially copyable");
+
+		Allocator allocator;
+		Mutex mtx;
+		// free slot indices, guarded by the mutex
+		Buf<uint32_t> free_indices;
+		std::atomic<uint32_t> slots_count;
+		std::atomic<size_t> count;
+		std::atomic<std::atomic<uint32_t>*> generations[CONCURRENT_HANDLE_TABLE_SEGMENTS_COUNT];
+		std::atomic<T*> values[CONCURRENT_HANDLE_TABLE_SEGMENTS_COUNT];
+	};
+
+	template<typename T>
+	using Concurrent_Handle_Table = IConcurrent_Handle_Table<T>*;
+
+	inline static size_t
+	_concurrent_handle_table_msb_index(uint64_t v)
+	{
+		#if MN_COMPILER_MSVC
+			unsigned long index = 0;
+			_BitScanReverse64(&index, v);
+			return size_t(index);
+		#else
+			return size_t(63 - __builtin_clzll(v));
+		#endif
+	}
+
+	// returns the segment index of the given slot index and its offset in that segment
+	inline static size_t
+	_concurrent_handle_table_segment(uint32_t index, size_t& offset)
+	{
+		auto v = uint64_t(index) + (uint64_t(1) << CONCURRENT_HANDLE_TABLE_SEGMENT_BITS);
+		auto msb = _concurrent_handle_table_msb_index(v);
+		offset = size_t(v - (uint64_t(1) << msb));
+		return msb - CONCURRENT_HANDLE_TABLE_SEGMENT_BITS;
+	}
+
+	// returns the generation of the given slot index, or nullptr if the slot doesn't exist
+	template<typename T>
+	inline static std::atomic<uint32_t>*
+	_concurrent_handle_table_generation(const IConcurrent_Handle_Table<T>* self, uint32_t index)
+	{
+		size_t offset = 0;
+		auto segment_index = _concurrent_handle_table_segment(index, offset);
+		auto segment = self->generations[segment_index].load(std::memory_order_acquire);
+		if (segment == nullptr)
+			return nullptr;
+		return segment + offset;
+	}
+
+	// returns the value of the given slot index, the slot should exist
+	template<typename T>
+	inline static T*
+	_concurrent_handle_table_value(const IConcurrent_Handle_Table<T>* self, uint32_t index)
+	{
+		size_t offset = 0;
+		auto segment_index = _concurrent_handle_table_segment(index, offset);
+		return self->values[segment_index].load(std::memory_order_acquire) + offset;
+	}
+
+	// returns a free slot index, it should be called while the mutex is locked
+	template<typename T>
+	inline static uint32_t
+	_concurrent_handle_table_slot_acquire(IConcurrent_Handle_Table<T>* self)
+	{
+		if (self->free_indices.count > 0)
+		{
+			auto index = buf_top(self->free_indices);
+			buf_pop(self->free_indices);
+			return index;
+		}
+
+		auto index = self->slots_count.load(std::memory_order_relaxed);
+		mn_assert_msg(index < UINT32_MAX, "concurrent handle table is full");
+
+		size_t offset = 0;
+		auto segment_index = _concurrent_handle_table_segment(index, offset);
+		if (offset == 0)
+		{
+			auto segment_count = size_t(1) << (CONCURRENT_HANDLE_TABLE_SEGMENT_BITS + segment_index);
+			auto generations = (std::atomic<uint32_t>*)alloc_from(
+				self->allocator,
+				sizeof(std::atomic<uint32_t>) * segment_count,
+				alignof(std::atomic<uint32_t>)
+			).ptr;
+			// free slots have odd generations
+			for (size_t i = 0; i < segment_count; ++i)
+				::new (generations + i) std::atomic<uint32_t>(1);
+			auto values = (T*)alloc_from(self->allocator, sizeof(T) * segment_count, alignof(T)).ptr;
+			self->values[segment_index].store(values, std::memory_order_release);
+			self->generations[segment_index].store(generations, std::memory_order_release);
+		}
+		self->slots_count.store(index + 1, std::memory_order_release);
+		return index;
+	}
+
+	// creates a new concurrent handle table
+	template<typename T>
+	inline static Concurrent_Handle_Table<T>
+	concurrent_handle_table_new(Allocator allocator = allocator_top())
+	{
+		auto self = (Concurrent_Handle_Table<T>)alloc_from(
+			allocator,
+			sizeof(IConcurrent_Handle_Table<T>),
+			alignof(IConcurrent_Handle_Table<T>)
+		).ptr;
+		::new (self) IConcurrent_Handle_Table<T>{};
+		self->allocator = allocator;
+		self->mtx = mutex_new("concurrent handle table mutex");
+		self->free_indices = buf_with_allocator<uint32_t>(allocator);
+		return self;
+	}
+
+	// frees the given concurrent handle table
+	template<typename T>
+	inline static void
+	concurrent_handle_table_free(Concurrent_Handle_Table<T> self)
+	{
+		auto allocator = self->allocator;
+		for (size_t i = 0; i < CONCURRENT_HANDLE_TABLE_SEGMENTS_COUNT; ++i)
+		{
+			auto generations = self->generations[i].load(std::memory_order_relaxed);
+			if (generations == nullptr)
+				break;
+			auto segment_count = size_t(1) << (CONCURRENT_HANDLE_TABLE_SEGMENT_BITS + i);
+			free_from(allocator, Block{generations, sizeof(std::atomic<uint32_t>) * segment_count});
+			free_from(allocator, Block{self->values[i].load(std::memory_order_relaxed), sizeof(T) * segment_count});
+		}
+		buf_free(self->free_indices);
+		mutex_free(self->mtx);
+		self->~IConcurrent_Handle_Table<T>();
+		free_from(allocator, Block{self, sizeof(IConcurrent_Handle_Table<T>)});
+	}
+
+	// destruct overload for concurrent handle table free
+	template<typename T>
+	inline static void
+	destruct(Concurrent_Handle_Table<T> self)
+	{
+		concurrent_handle_table_free(self);
+	}
+
+	// inserts the given values into the handle table while taking the lock only once, and writes the handle of each
+	// value into the given out handles array
+	template<typename T>
+	inline static void
+	concurrent_handle_table_insert_many(Concurrent_Handle_Table<T> self, const T* values, size_t count, uint64_t* out_handles)
+	{
+		mutex_lock(self->mtx);
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto index = _concurrent_handle_table_slot_acquire(self);
+			auto generation = _concurrent_handle_table_generation(self, index);
+			auto g = generation->load(std::memory_order_relaxed);
+			mn_assert(g % 2 == 1);
+
+			// the value is written while the slot's generation is odd, so concurrent readers of stale handles which
+			// copy it will fail their generation check after the copy
+			std::atomic_thread_fence(std::memory_order_release);
+			*_concurrent_handle_table_value(self, index) = values[i];
+			generation->store(g + 1, std::memory_order_release);
+
+			out_handles[i] = handle_table_index_to_uint64(Handle_Table_Index{g + 1, index});
+		}
+		self->count.fetch_add(count, std::memory_order_relaxed);
+		mutex_unlock(self->mtx);
+	}
+
+	// inserts a new value into the handle table and returns its associated handle
+	template<typename T>
+	inline static uint64_t
+	concurrent_handle_table_insert(Concurrent_Handle_Table<T> self, const T& v)
+	{
+		uint64_t handle = HANDLE_TABLE_INVLAID_INDEX;
+		concurrent_handle_table_insert_many(self, &v, 1, &handle);
+		return handle;
+	}
+
+	// removes the values associated with the given handles while taking the lock only once, stale handles and handles
+	// removed by another thread are ignored, returns the count of the removed values
+	template<typename T>
+	inline static size_t
+	concurrent_handle_table_remove_many(Concurrent_Handle_Table<T> self, const uint64_t* handles, size_t count)
+	{
+		size_t removed_count = 0;
+		mutex_lock(self->mtx);
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto h = handle_table_index_from_uint64(handles[i]);
+			if (h.generation % 2 == 1)
+				continue;
+			auto generation = _concurrent_handle_table_generation(self, h.index);
+			if (generation == nullptr)
+				continue;
+
+			// the lock-free readers can race with the removal so the generation is flipped atomically
+			auto g = h.generation;
+			if (generation->compare_exchange_strong(g, h.generation + 1, std::memory_order_acq_rel) == false)
+				continue;
+
+			buf_push(self->free_indices, h.index);
+			++removed_count;
+		}
+		self->count.fetch_sub(removed_count, std::memory_order_relaxed);
+		mutex_unlock(self->mtx);
+		return removed_count;
+	}
+
+	// removes the value associated with the given handle, returns false if the handle is stale
+	template<typename T>
+	inline static bool
+	concurrent_handle_table_remove(Concurrent_Handle_Table<T> self, uint64_t handle)
+	{
+		return concurrent_handle_table_remove_many(self, &handle, 1) == 1;
+	}
+
+	// checks whether the value associated with the given handle exists, it doesn't take any locks
+	template<typename T>
+	inline static bool
+	concurrent_handle_table_exists(Concurrent_Handle_Table<T> self, uint64_t handle)
+	{
+		auto h = handle_table_index_from_uint64(handle);
+		if (h.generation % 2 == 1)
+			return false;
+		auto generation = _concurrent_handle_table_generation(self, h.index);
+		return generation && generation->load(std::memory_order_acquire) == h.generation;
+	}
+
+	// copies the value associated with the given handle into the given out value, returns false if the handle is
+	// stale, it doesn't take any locks
+	template<typename T>
+	inline static bool
+	concurrent_handle_table_get(Concurrent_Handle_Table<T> self, uint64_t handle, T* out_value)
+	{
+		auto h = handle_table_index_from_uint64(handle);
+		if (h.generation % 2 == 1)
+			return false;
+		auto generation = _concurrent_handle_table_generation(self, h.index);
+		if (generation == nullptr || generation->load(std::memory_order_acquire) != h.generation)
+			return false;
+
+		T value = *_concurrent_handle_table_value(self, h.index);
+		// if the slot was removed (and maybe reused) while copying the generation will be different
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (generation->load(std::memory_order_relaxed) != h.generation)
+			return false;
+
+		*out_value = value;
+		return true;
+	}
+
+	// returns the count of the values in the given handle table, it's only a snapshot when called while inserting or
+	// removing
+	template<typename T>
+	inline static size_t
+	concurrent_handle_table_count(Concurrent_Handle_Table<T> self)
+	{
+		return self->count.load(std::memory_order_relaxed);
+	}
+
+	// calls the given function `fn(uint64_t handle, const T& value)` with a copy of each alive value, it doesn't take
+	// any locks so values inserted or removed while iterating may or may not be visited
+	template<typename T, typename TFunc>
+	inline static void
+	concurrent_handle_table_each(Concurrent_Handle_Table<T> self, TFunc&& fn)
+	{
+		auto slots_count = self->slots_count.load(std::memory_order_acquire);
+		uint32_t index = 0;
+		for (size_t i = 0; i < CONCURRENT_HANDLE_TABLE_SEGMENTS_COUNT && index < slots_count; ++i)
+		{
+			auto generations = self->generations[i].load(std::memory_order_acquire);
+			auto values = self->values[i].load(std::memory_order_acquire);
+			auto segment_count = size_t(1) << (CONCURRENT_HANDLE_TABLE_SEGMENT_BITS + i);
+			for (size_t j = 0; j < segment_count && index < slots_count; ++j, ++index)
+			{
+				auto g = generations[j].load(std::memory_order_acquire);
+				if (g % 2 == 1)
+					continue;
+
+				T value = values[j];
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (generations[j].load(std::memory_order_relaxed) != g)
+					continue;
+
+				fn(handle_table_index_to_uint64(Handle_Table_Index{g, index}), (const T&)value);
+			}
+		}
+	}
+}
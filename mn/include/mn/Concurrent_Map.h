@@ -0,0 +1,254 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Map.h"
+#include "mn/Thread.h"
+
+namespace mn
+{
+	// size of the cache line, the shards are separated by a padding of this size to avoid false sharing, padding is
+	// used instead of alignas since the allocators don't guarantee over aligned memory
+	constexpr size_t CONCURRENT_MAP_CACHE_LINE_SIZE = 64;
+
+	// a single shard of the concurrent map, which is a normal hash map guarded by a read-write mutex
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Concurrent_Map_Shard
+	{
+		Mutex_RW mtx;
+		Map<TKey, TValue, THash> map;
+		char _pad[CONCURRENT_MAP_CACHE_LINE_SIZE];
+	};
+
+	// a thread safe hash map, the keys are distributed over a fixed number of shards using their hash, each shard has
+	// its own lock and grows independently, so operations on different shards never contend and a resize only blocks
+	// the shard that's being resized
+	// note that there's no way to get a pointer into the map since another thread can move the value at any time,
+	// so values are copied out or accessed in a callback while the shard is locked
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Concurrent_Map
+	{
+		Allocator allocator;
+		Concurrent_Map_Shard<TKey, TValue, THash>* shards;
+		size_t shards_count;
+		// log2 of the shards count, used to select the shard from the most significant bits of the hash
+		size_t shards_bits;
+	};
+
+	// creates a new concurrent map with the given shards count which is rounded up to a power of 2, the shards count
+	// should be a few times the count of threads accessing the map
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Concurrent_Map<TKey, TValue, THash>
+	concurrent_map_new(size_t shards_count = 64, Allocator allocator = allocator_top())
+	{
+		mn_assert(shards_count > 0);
+
+		size_t shards_bits = 0;
+		while ((size_t(1) << shards_bits) < shards_count)
+			++shards_bits;
+		shards_count = size_t(1) << shards_bits;
+
+		Concurrent_Map<TKey, TValue, THash> self{};
+		self.allocator = allocator;
+		self.shards_count = shards_count;
+		self.shards_bits = shards_bits;
+		self.shards = (Concurrent_Map_Shard<TKey, TValue, THash>*)alloc_from(
+			allocator,
+			sizeof(Concurrent_Map_Shard<TKey, TValue, THash>) * shards_count,
+			alignof(Concurrent_Map_Shard<TKey, TValue, THash>)
+		).ptr;
+		for (size_t i = 0; i < shards_count; ++i)
+		{
+			auto shard = ::new (self.shards + i) Concurrent_Map_Shard<TKey, TValue, THash>{};
+			shard->mtx = mutex_rw_new("concurrent map shard mutex");
+			shard->map = map_with_allocator<TKey, TValue, THash>(allocator);
+		}
+		return self;
+	}
+
+	// frees the given concurrent map, note this doesn't free any complex data structure stored in the map
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static void
+	concurrent_map_free(Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_rw_free(self.shards[i].mtx);
+			map_free(self.shards[i].map);
+		}
+		free_from(self.allocator, Block{self.shards, sizeof(Concurrent_Map_Shard<TKey, TValue, THash>) * self.shards_count});
+		self.shards = nullptr;
+		self.shards_count = 0;
+	}
+
+	// destruct overload for the concurrent map, it destructs the keys and values as well
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static void
+	destruct(Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_rw_free(self.shards[i].mtx);
+			destruct(self.shards[i].map);
+		}
+		free_from(self.allocator, Block{self.shards, sizeof(Concurrent_Map_Shard<TKey, TValue, THash>) * self.shards_count});
+		self.shards = nullptr;
+		self.shards_count = 0;
+	}
+
+	// returns the shard of the given key
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Concurrent_Map_Shard<TKey, TValue, THash>&
+	_concurrent_map_shard(const Concurrent_Map<TKey, TValue, THash>& self, const TKey& key)
+	{
+		if (self.shards_bits == 0)
+			return self.shards[0];
+		// the shard is selected using the most significant bits of the mixed hash, while the shard's map uses
+		// the least significant bits, so the keys are evenly distributed in each shard's map
+		auto hash = _hash_ctrl_mix(THash()(key));
+		return self.shards[hash >> (sizeof(size_t) * 8 - self.shards_bits)];
+	}
+
+	// inserts the given key and value into the concurrent map, if the key exists its value will be overwritten, returns
+	// whether the key was inserted
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static bool
+	concurrent_map_insert(Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, const TValue& value)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_write_lock(shard.mtx);
+		auto count = shard.map.count;
+		map_insert(shard.map, key, value);
+		bool inserted = shard.map.count != count;
+		mutex_write_unlock(shard.mtx);
+		return inserted;
+	}
+
+	// searches for the given key and copies its value into the given out value, returns whether the key was found
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static bool
+	concurrent_map_lookup(const Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, TValue* out_value = nullptr)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_read_lock(shard.mtx);
+		auto it = map_lookup(shard.map, key);
+		if (it && out_value)
+			*out_value = it->value;
+		mutex_read_unlock(shard.mtx);
+		return it != nullptr;
+	}
+
+	// searches for the given key and calls the given function `fn(const TValue&)` with its value while the shard is read
+	// locked, returns whether the key was found
+	template<typename TKey, typename TValue, typename THash, typename TFunc>
+	inline static bool
+	concurrent_map_lookup_with(const Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, TFunc&& fn)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_read_lock(shard.mtx);
+		auto it = map_lookup(shard.map, key);
+		if (it)
+			fn((const TValue&)it->value);
+		mutex_read_unlock(shard.mtx);
+		return it != nullptr;
+	}
+
+	// inserts the given key if it doesn't exist with a zero/empty value, then calls the given function
+	// `fn(TValue& value, bool inserted)` while the shard is write locked, which makes read-modify-write operations
+	// (ex. counters) atomic, returns whether the key was inserted
+	template<typename TKey, typename TValue, typename THash, typename TFunc>
+	inline static bool
+	concurrent_map_upsert(Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, TFunc&& fn)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_write_lock(shard.mtx);
+		auto it = map_lookup(shard.map, key);
+		bool inserted = it == nullptr;
+		if (inserted)
+			it = map_insert(shard.map, key, TValue{});
+		fn(it->value, inserted);
+		mutex_write_unlock(shard.mtx);
+		return inserted;
+	}
+
+	// removes the given key from the concurrent map and moves its value into the given out value, returns whether the
+	// key was found and removed, note this doesn't free any complex data structure stored in the map
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static bool
+	concurrent_map_remove(Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, TValue* out_value = nullptr)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_write_lock(shard.mtx);
+		bool found = false;
+		if (auto it = map_lookup(shard.map, key))
+		{
+			if (out_value)
+				*out_value = it->value;
+			found = map_remove(shard.map, key);
+		}
+		mutex_write_unlock(shard.mtx);
+		return found;
+	}
+
+	// returns the count of elements in the concurrent map, note that it's only a snapshot which might be out of date
+	// if other threads are modifying the map
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static size_t
+	concurrent_map_count(const Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		size_t res = 0;
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			auto& shard = self.shards[i];
+			mutex_read_lock(shard.mtx);
+			res += shard.map.count;
+			mutex_read_unlock(shard.mtx);
+		}
+		return res;
+	}
+
+	// ensures that the concurrent map has capacity for the given count of elements, assuming they're evenly distributed
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static void
+	concurrent_map_reserve(Concurrent_Map<TKey, TValue, THash>& self, size_t added_count)
+	{
+		auto shard_added_count = (added_count + self.shards_count - 1) / self.shards_count;
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			auto& shard = self.shards[i];
+			mutex_write_lock(shard.mtx);
+			map_reserve(shard.map, shard_added_count);
+			mutex_write_unlock(shard.mtx);
+		}
+	}
+
+	// clears the given concurrent map, note this doesn't free any complex data structure stored in the map
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static void
+	concurrent_map_clear(Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			auto& shard = self.shards[i];
+			mutex_write_lock(shard.mtx);
+			map_clear(shard.map);
+			mutex_write_unlock(shard.mtx);
+		}
+	}
+
+	// calls the given function `fn(const TKey&, const TValue&)` for each element in the map, the shards are visited one
+	// at a time while being read locked, so each shard is seen in a consistent state but modifications to other shards
+	// might happen during the iteration, the function should not modify the map
+	template<typename TKey, typename TValue, typename THash, typename TFunc>
+	inline static void
+	concurrent_map_each(const Concurrent_Map<TKey, TValue, THash>& self, TFunc&& fn)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			auto& shard = self.shards[i];
+			mutex_read_lock(shard.mtx);
+			for (const auto& [key, value]: shard.map)
+				fn(key, value);
+			mutex_read_unlock(shard.mtx);
+		}
+	}
+}
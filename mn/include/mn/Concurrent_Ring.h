@@ -0,0 +1,415 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Memory.h"
+#include "mn/Thread.h"
+#include "mn/Assert.h"
+
+#include <atomic>
+#include <new>
+
+namespace mn
+{
+	// size of the cache line, the producer and consumer state are separated by a padding of this size to avoid false
+	// sharing, padding is used instead of alignas since the allocators don't guarantee over aligned memory
+	constexpr size_t RING_CACHE_LINE_SIZE = 64;
+
+	// used to block the consumer of a concurrent ring when it's empty, the producers only touch the futex when the
+	// consumer is actually waiting so the fast path doesn't do any system calls
+	struct Ring_Waiter
+	{
+		std::atomic<uint32_t> epoch;
+		std::atomic<uint32_t> waiting;
+	};
+
+	inline static void
+	_ring_waiter_notify(Ring_Waiter& self)
+	{
+		// pairs with the fence in _ring_waiter_wait, so either the producer sees the waiting flag or the consumer
+		// sees the pushed values
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (self.waiting.load(std::memory_order_relaxed))
+		{
+			self.epoch.fetch_add(1, std::memory_order_release);
+			futex_wake_one(self.epoch);
+		}
+	}
+
+	template<typename TFunc>
+	inline static void
+	_ring_waiter_wait(Ring_Waiter& self, TFunc&& is_ready)
+	{
+		while (is_ready() == false)
+		{
+			auto epoch = self.epoch.load(std::memory_order_acquire);
+			self.waiting.store(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (is_ready() == false)
+				futex_wait(self.epoch, epoch);
+			self.waiting.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// a fixed capacity lock free single producer single consumer ring buffer, exactly one thread can push and exactly
+	// one thread can pop at the same time, the capacity is rounded up to a power of 2
+	// like Buf the values are copied in and out of the ring memory so they should be trivially relocatable
+	template<typename T>
+	struct ISPSC_Ring
+	{
+		Allocator allocator;
+		T* ptr;
+		size_t mask;
+
+		// consumer state, the cached tail is the last tail seen by the consumer
+		char _pad0[RING_CACHE_LINE_SIZE];
+		std::atomic<size_t> head;
+		size_t cached_tail;
+
+		// producer state, the cached head is the last head seen by the producer
+		char _pad1[RING_CACHE_LINE_SIZE];
+		std::atomic<size_t> tail;
+		size_t cached_head;
+
+		char _pad2[RING_CACHE_LINE_SIZE];
+		Ring_Waiter waiter;
+		char _pad3[RING_CACHE_LINE_SIZE];
+	};
+
+	template<typename T>
+	using SPSC_Ring = ISPSC_Ring<T>*;
+
+	// creates a new single producer single consumer ring with the given capacity which is rounded up to a power of 2
+	template<typename T>
+	inline static SPSC_Ring<T>
+	spsc_ring_new(size_t capacity, Allocator allocator = allocator_top())
+	{
+		mn_assert(capacity > 0);
+		size_t cap = 1;
+		while (cap < capacity)
+			cap <<= 1;
+
+		auto self = (SPSC_Ring<T>)alloc_from(allocator, sizeof(ISPSC_Ring<T>), alignof(ISPSC_Ring<T>)).ptr;
+		::new (self) ISPSC_Ring<T>{};
+		self->allocator = allocator;
+		self->ptr = (T*)alloc_from(allocator, sizeof(T) * cap, alignof(T)).ptr;
+		self->mask = cap - 1;
+		return self;
+	}
+
+	// frees the given ring, the remaining values are not destructed
+	template<typename T>
+	inline static void
+	spsc_ring_free(SPSC_Ring<T> self)
+	{
+		auto allocator = self->allocator;
+		free_from(allocator, Block{self->ptr, sizeof(T) * (self->mask + 1)});
+		self->~ISPSC_Ring<T>();
+		free_from(allocator, Block{self, sizeof(ISPSC_Ring<T>)});
+	}
+
+	// destruct overload for spsc ring free
+	template<typename T>
+	inline static void
+	destruct(SPSC_Ring<T> self)
+	{
+		spsc_ring_free(self);
+	}
+
+	// returns the capacity of the given ring
+	template<typename T>
+	inline static size_t
+	spsc_ring_capacity(SPSC_Ring<T> self)
+	{
+		return self->mask + 1;
+	}
+
+	// returns the count of the values in the given ring, it's only a snapshot when called while pushing or popping
+	template<typename T>
+	inline static size_t
+	spsc_ring_count(SPSC_Ring<T> self)
+	{
+		auto head = self->head.load(std::memory_order_acquire);
+		auto tail = self->tail.load(std::memory_order_acquire);
+		return tail - head;
+	}
+
+	// pushes up to count values into the ring and returns the count of the pushed values, it should only be called
+	// from the producer thread
+	template<typename T>
+	inline static size_t
+	spsc_ring_push_many(SPSC_Ring<T> self, const T* values, size_t count)
+	{
+		auto cap = self->mask + 1;
+		auto tail = self->tail.load(std::memory_order_relaxed);
+		if (cap - (tail - self->cached_head) < count)
+			self->cached_head = self->head.load(std::memory_order_acquire);
+		auto free_count = cap - (tail - self->cached_head);
+		if (count > free_count)
+			count = free_count;
+		if (count == 0)
+			return 0;
+
+		for (size_t i = 0; i < count; ++i)
+			self->ptr[(tail + i) & self->mask] = values[i];
+		self->tail.store(tail + count, std::memory_order_release);
+		_ring_waiter_notify(self->waiter);
+		return count;
+	}
+
+	// pushes the given value into the ring and returns false if the ring is full, it should only be called from the
+	// producer thread
+	template<typename T>
+	inline static bool
+	spsc_ring_push(SPSC_Ring<T> self, const T& value)
+	{
+		return spsc_ring_push_many(self, &value, 1) == 1;
+	}
+
+	// pops up to count values from the ring into the given array and returns the count of the popped values, it
+	// should only be called from the consumer thread
+	template<typename T>
+	inline static size_t
+	spsc_ring_pop_many(SPSC_Ring<T> self, T* values, size_t count)
+	{
+		auto head = self->head.load(std::memory_order_relaxed);
+		if (self->cached_tail - head < count)
+			self->cached_tail = self->tail.load(std::memory_order_acquire);
+		auto available = self->cached_tail - head;
+		if (count > available)
+			count = available;
+		if (count == 0)
+			return 0;
+
+		for (size_t i = 0; i < count; ++i)
+			values[i] = self->ptr[(head + i) & self->mask];
+		self->head.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	// pops a value from the ring and returns false if the ring is empty, it should only be called from the consumer
+	// thread
+	template<typename T>
+	inline static bool
+	spsc_ring_pop(SPSC_Ring<T> self, T& value)
+	{
+		return spsc_ring_pop_many(self, &value, 1) == 1;
+	}
+
+	// pops up to count values from the ring, it blocks while the ring is empty so it pops at least 1 value, it should
+	// only be called from the consumer thread
+	template<typename T>
+	inline static size_t
+	spsc_ring_pop_many_wait(SPSC_Ring<T> self, T* values, size_t count)
+	{
+		mn_assert(count > 0);
+		size_t res = 0;
+		_ring_waiter_wait(self->waiter, [&] {
+			res = spsc_ring_pop_many(self, values, count);
+			return res > 0;
+		});
+		return res;
+	}
+
+	// pops a value from the ring, it blocks while the ring is empty, it should only be called from the consumer thread
+	template<typename T>
+	inline static T
+	spsc_ring_pop_wait(SPSC_Ring<T> self)
+	{
+		T value{};
+		spsc_ring_pop_many_wait(self, &value, 1);
+		return value;
+	}
+
+	// a single cell of the multi producer ring, the sequence tells the consumer that the value is written
+	template<typename T>
+	struct MPSC_Ring_Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	// a fixed capacity lock free multi producer single consumer ring buffer, any thread can push and exactly one thread
+	// can pop at the same time, the capacity is rounded up to a power of 2
+	// producers reserve cells by advancing the tail then publish each cell by setting its sequence, so a slow producer
+	// only delays the consumer from reading past its cells
+	template<typename T>
+	struct IMPSC_Ring
+	{
+		Allocator allocator;
+		MPSC_Ring_Cell<T>* cells;
+		size_t mask;
+
+		char _pad0[RING_CACHE_LINE_SIZE];
+		std::atomic<size_t> head;
+		char _pad1[RING_CACHE_LINE_SIZE];
+		std::atomic<size_t> tail;
+		char _pad2[RING_CACHE_LINE_SIZE];
+		Ring_Waiter waiter;
+		char _pad3[RING_CACHE_LINE_SIZE];
+	};
+
+	template<typename T>
+	using MPSC_Ring = IMPSC_Ring<T>*;
+
+	// creates a new multi producer single consumer ring with the given capacity which is rounded up to a power of 2
+	template<typename T>
+	inline static MPSC_Ring<T>
+	mpsc_ring_new(size_t capacity, Allocator allocator = allocator_top())
+	{
+		mn_assert(capacity > 0);
+		size_t cap = 1;
+		while (cap < capacity)
+			cap <<= 1;
+
+		auto self = (MPSC_Ring<T>)alloc_from(allocator, sizeof(IMPSC_Ring<T>), alignof(IMPSC_Ring<T>)).ptr;
+		::new (self) IMPSC_Ring<T>{};
+		self->allocator = allocator;
+		self->cells = (MPSC_Ring_Cell<T>*)alloc_from(
+			allocator,
+			sizeof(MPSC_Ring_Cell<T>) * cap,
+			alignof(MPSC_Ring_Cell<T>)
+		).ptr;
+		for (size_t i = 0; i < cap; ++i)
+			::new (&self->cells[i].sequence) std::atomic<size_t>(0);
+		self->mask = cap - 1;
+		return self;
+	}
+
+	// frees the given ring, the remaining values are not destructed
+	template<typename T>
+	inline static void
+	mpsc_ring_free(MPSC_Ring<T> self)
+	{
+		auto allocator = self->allocator;
+		free_from(allocator, Block{self->cells, sizeof(MPSC_Ring_Cell<T>) * (self->mask + 1)});
+		self->~IMPSC_Ring<T>();
+		free_from(allocator, Block{self, sizeof(IMPSC_Ring<T>)});
+	}
+
+	// destruct overload for mpsc ring free
+	template<typename T>
+	inline static void
+	destruct(MPSC_Ring<T> self)
+	{
+		mpsc_ring_free(self);
+	}
+
+	// returns the capacity of the given ring
+	template<typename T>
+	inline static size_t
+	mpsc_ring_capacity(MPSC_Ring<T> self)
+	{
+		return self->mask + 1;
+	}
+
+	// returns the count of the reserved values in the given ring, it's only a snapshot when called while pushing or
+	// popping
+	template<typename T>
+	inline static size_t
+	mpsc_ring_count(MPSC_Ring<T> self)
+	{
+		auto head = self->head.load(std::memory_order_acquire);
+		auto tail = self->tail.load(std::memory_order_acquire);
+		return tail > head ? tail - head : 0;
+	}
+
+	// pushes up to count values into the ring and returns the count of the pushed values, the values of a single call
+	// are contiguous in the ring, it can be called from any thread
+	template<typename T>
+	inline static size_t
+	mpsc_ring_push_many(MPSC_Ring<T> self, const T* values, size_t count)
+	{
+		auto cap = self->mask + 1;
+		auto tail = self->tail.load(std::memory_order_relaxed);
+		size_t n = 0;
+		while (true)
+		{
+			auto head = self->head.load(std::memory_order_acquire);
+			// the tail might be stale and behind the head, so it's reloaded
+			auto used = tail - head;
+			if (used > cap)
+			{
+				tail = self->tail.load(std::memory_order_relaxed);
+				continue;
+			}
+			n = cap - used;
+			if (n > count)
+				n = count;
+			if (n == 0)
+				return 0;
+			if (self->tail.compare_exchange_weak(tail, tail + n, std::memory_order_relaxed, std::memory_order_relaxed))
+				break;
+		}
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			auto& cell = self->cells[(tail + i) & self->mask];
+			cell.value = values[i];
+			cell.sequence.store(tail + i + 1, std::memory_order_release);
+		}
+		_ring_waiter_notify(self->waiter);
+		return n;
+	}
+
+	// pushes the given value into the ring and returns false if the ring is full, it can be called from any thread
+	template<typename T>
+	inline static bool
+	mpsc_ring_push(MPSC_Ring<T> self, const T& value)
+	{
+		return mpsc_ring_push_many(self, &value, 1) == 1;
+	}
+
+	// pops up to count published values from the ring into the given array and returns the count of the popped values,
+	// it should only be called from the consumer thread
+	template<typename T>
+	inline static size_t
+	mpsc_ring_pop_many(MPSC_Ring<T> self, T* values, size_t count)
+	{
+		auto head = self->head.load(std::memory_order_relaxed);
+		size_t n = 0;
+		for (; n < count; ++n)
+		{
+			auto& cell = self->cells[(head + n) & self->mask];
+			if (cell.sequence.load(std::memory_order_acquire) != head + n + 1)
+				break;
+			values[n] = cell.value;
+		}
+		if (n > 0)
+			self->head.store(head + n, std::memory_order_release);
+		return n;
+	}
+
+	// pops a value from the ring and returns false if the ring is empty, it should only be called from the consumer
+	// thread
+	template<typename T>
+	inline static bool
+	mpsc_ring_pop(MPSC_Ring<T> self, T& value)
+	{
+		return mpsc_ring_pop_many(self, &value, 1) == 1;
+	}
+
+	// pops up to count values from the ring, it blocks while the ring is empty so it pops at least 1 value, it should
+	// only be called from the consumer thread
+	template<typename T>
+	inline static size_t
+	mpsc_ring_pop_many_wait(MPSC_Ring<T> self, T* values, size_t count)
+	{
+		mn_assert(count > 0);
+		size_t res = 0;
+		_ring_waiter_wait(self->waiter, [&] {
+			res = mpsc_ring_pop_many(self, values, count);
+			return res > 0;
+		});
+		return res;
+	}
+
+	// pops a value from the ring, it blocks while the ring is empty, it should only be called from the consumer thread
+	template<typename T>
+	inline static T
+	mpsc_ring_pop_wait(MPSC_Ring<T> self)
+	{
+		T value{};
+		mpsc_ring_pop_many_wait(self, &value, 1);
+		return value;
+	}
+}
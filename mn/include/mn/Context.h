@@ -26,6 +26,11 @@ namespace mn
 		//tmp allocator
 		memory::Arena* _allocator_tmp;
 
+		//scratch allocators, more than one so that a function can always get a scratch arena which doesn't
+		//conflict with the allocators passed to it
+		inline static constexpr size_t SCRATCH_CAPACITY = 2;
+		memory::Arena* _allocator_scratch[SCRATCH_CAPACITY];
+
 		//Local tmp stream
 		Reader reader_tmp;
 	};
@@ -64,6 +69,11 @@ namespace mn
 		// returns the current thread's tmp memory allocator
 		MN_EXPORT Arena*
 		tmp();
+
+		// returns one of the current thread's scratch arenas which is not in the given conflicts list
+		// you should prefer using mn::scratch_begin which restores the arena automatically
+		MN_EXPORT Arena*
+		scratch(const Allocator* conflicts, size_t conflicts_count);
 	}
 
 	MN_EXPORT memory::Arena*
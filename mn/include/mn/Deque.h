@@ -15,7 +15,9 @@ namespace mn
 		size_t element_index;
 	};
 
-	// a double ended queue which allows you to push to either sides of the array
+	// a double ended queue which allows you to push to either sides of the array, the elements are stored in fixed size
+	// buckets which never move, the bucket size is a power of 2 so indexing is a shift and a mask, emptied buckets are
+	// kept and recycled to the other side of the deque so a deque used as a queue doesn't allocate in steady state
 	template<typename T>
 	struct Deque
 	{
@@ -25,57 +27,40 @@ namespace mn
 		size_t cap;
 		size_t bucket_count;
 		size_t bucket_cap;
+		// index of the first element
 		Deque_Index front;
+		// index of one past the last element
 		Deque_Index back;
 		size_t bucket_size;
+		// log2 of the bucket size
+		size_t bucket_shift;
 
 		T&
 		operator[](size_t ix)
 		{
 			mn_assert(ix < count);
-			size_t bucket_index = ix / bucket_size;
-			size_t element_index = ix % bucket_size;
-
-			bucket_index += front.bucket_index;
-			element_index += front.element_index;
-
-			bucket_index += element_index / bucket_size;
-			element_index = element_index % bucket_size;
-			return buckets[bucket_index][element_index];
+			ix += front.element_index;
+			return buckets[front.bucket_index + (ix >> bucket_shift)][ix & (bucket_size - 1)];
 		}
 
 		const T&
 		operator[](size_t ix) const
 		{
 			mn_assert(ix < count);
-			size_t bucket_index = ix / bucket_size;
-			size_t element_index = ix % bucket_size;
-
-			bucket_index += front.bucket_index;
-			element_index += front.element_index;
-
-			bucket_index += element_index / bucket_size;
-			element_index = element_index % bucket_size;
-			return buckets[bucket_index][element_index];
+			ix += front.element_index;
+			return buckets[front.bucket_index + (ix >> bucket_shift)][ix & (bucket_size - 1)];
 		}
 	};
 
-	// creates a new instance of a deque
+	// returns log2 of the bucket size of the given type, buckets are 4KB rounded down to a power of 2 elements
 	template<typename T>
-	inline static Deque<T>
-	deque_new()
+	inline static size_t
+	_deque_bucket_shift()
 	{
-		Deque<T> self{};
-		self.allocator = allocator_top();
-		self.buckets = nullptr;
-		self.count = 0;
-		self.cap = 0;
-		self.bucket_count = 0;
-		self.bucket_cap = 0;
-		self.front = { 0, 0 };
-		self.back = { 0, 0 };
-		self.bucket_size = sizeof(T) >= 4096 ? 1 : (4096 / sizeof(T));
-		return self;
+		size_t shift = 0;
+		while (sizeof(T) * (size_t(2) << shift) <= 4096)
+			++shift;
+		return shift;
 	}
 
 	// creates a new deque instance with the given allocator
@@ -92,10 +77,19 @@ namespace mn
 		self.bucket_cap = 0;
 		self.front = { 0, 0 };
 		self.back = { 0, 0 };
-		self.bucket_size = sizeof(T) >= 4096 ? 1 : (4096 / sizeof(T));
+		self.bucket_shift = _deque_bucket_shift<T>();
+		self.bucket_size = size_t(1) << self.bucket_shift;
 		return self;
 	}
 
+	// creates a new instance of a deque
+	template<typename T>
+	inline static Deque<T>
+	deque_new()
+	{
+		return deque_with_allocator<T>(allocator_top());
+	}
+
 	// frees the given deque instance
 	template<typename T>
 	inline static void
@@ -164,7 +158,7 @@ namespace mn
 
 	template<typename T>
 	inline static Deque_Index
-	deque_index_dec(Deque<T>& self, Deque_Index index)
+	deque_index_dec(const Deque<T>& self, Deque_Index index)
 	{
 		if (index.element_index == 0)
 		{
@@ -179,34 +173,102 @@ namespace mn
 		}
 	}
 
+	template<typename T>
+	inline static Deque_Index
+	_deque_index_add(const Deque<T>& self, Deque_Index index, size_t count)
+	{
+		auto ix = index.element_index + count;
+		return Deque_Index{ index.bucket_index + (ix >> self.bucket_shift), ix & (self.bucket_size - 1) };
+	}
+
+	template<typename T>
+	inline static Deque_Index
+	_deque_index_sub(const Deque<T>& self, Deque_Index index, size_t count)
+	{
+		auto ix = (index.bucket_index << self.bucket_shift) + index.element_index - count;
+		return Deque_Index{ ix >> self.bucket_shift, ix & (self.bucket_size - 1) };
+	}
+
 	template<typename T>
 	inline static void
-	deque_grow_back(Deque<T>& self)
+	_deque_buckets_reserve(Deque<T>& self)
 	{
-		if(self.cap > self.count && self.back.bucket_index < self.bucket_count && deque_index_can_inc(self, self.back))
+		if (self.bucket_count < self.bucket_cap)
 			return;
 
-		T* bucket = (T*)alloc_from(self.allocator, sizeof(T) * self.bucket_size, alignof(T)).ptr;
+		size_t cap = self.bucket_cap == 0 ? 8 : self.bucket_cap * 2;
+		T** new_bucket_array = (T**)alloc_from(self.allocator, cap * sizeof(T*), alignof(T*)).ptr;
+		if (self.buckets != nullptr)
+		{
+			::memcpy(new_bucket_array, self.buckets, self.bucket_count * sizeof(T*));
+			free_from(self.allocator, Block{ self.buckets, self.bucket_cap * sizeof(T*) });
+		}
+		self.buckets = new_bucket_array;
+		self.bucket_cap = cap;
+	}
 
-		// then we need to resize this array
-		if (self.bucket_count >= self.bucket_cap)
+	// makes sure that there's a bucket for the back index
+	template<typename T>
+	inline static void
+	deque_grow_back(Deque<T>& self)
+	{
+		if (self.back.bucket_index < self.bucket_count)
+			return;
+
+		if (self.front.bucket_index > 0)
 		{
-			size_t cap = self.bucket_cap == 0 ? 8 : self.bucket_cap * 2;
-			T** new_bucket_array = (T**)alloc_from(self.allocator, cap * sizeof(T*), alignof(T*)).ptr;
-			if (self.buckets != nullptr)
-			{
-				::memcpy(new_bucket_array, self.buckets, self.bucket_count * sizeof(T*));
-				free_from(self.allocator, Block{ self.buckets, self.bucket_cap * sizeof(T*) });
-			}
-			self.buckets = new_bucket_array;
-			self.bucket_cap = cap;
+			// recycle the first empty bucket by rotating it to the back
+			T* bucket = self.buckets[0];
+			::memmove(self.buckets, self.buckets + 1, (self.bucket_count - 1) * sizeof(T*));
+			self.buckets[self.bucket_count - 1] = bucket;
+			--self.front.bucket_index;
+			--self.back.bucket_index;
+			return;
 		}
 
-		self.buckets[self.bucket_count] = bucket;
+		_deque_buckets_reserve(self);
+		self.buckets[self.bucket_count] = (T*)alloc_from(self.allocator, sizeof(T) * self.bucket_size, alignof(T)).ptr;
 		self.cap += self.bucket_size;
 		++self.bucket_count;
 	}
 
+	// makes sure that there's a bucket for the index before the front index
+	template<typename T>
+	inline static void
+	deque_grow_front(Deque<T>& self)
+	{
+		if (self.front.element_index > 0 || self.front.bucket_index > 0)
+			return;
+
+		// the last bucket is empty if it's after the back bucket or it's the back bucket and back is at its start
+		auto last_used_bucket = self.back.element_index > 0 ? self.back.bucket_index : self.back.bucket_index - 1;
+		if (self.count > 0 && self.bucket_count > 0 && last_used_bucket + 1 < self.bucket_count)
+		{
+			// recycle the last empty bucket by rotating it to the front
+			T* bucket = self.buckets[self.bucket_count - 1];
+			::memmove(self.buckets + 1, self.buckets, (self.bucket_count - 1) * sizeof(T*));
+			self.buckets[0] = bucket;
+		}
+		else if (self.count == 0 && self.bucket_count > 0)
+		{
+			// empty deque, just start from the end of the first bucket
+			self.front = { 1, 0 };
+			self.back = { 1, 0 };
+			return;
+		}
+		else
+		{
+			_deque_buckets_reserve(self);
+			::memmove(self.buckets + 1, self.buckets, self.bucket_count * sizeof(T*));
+			self.buckets[0] = (T*)alloc_from(self.allocator, sizeof(T) * self.bucket_size, alignof(T)).ptr;
+			self.cap += self.bucket_size;
+			++self.bucket_count;
+		}
+
+		++self.front.bucket_index;
+		++self.back.bucket_index;
+	}
+
 	// pushes the given value to the back of the deque
 	template<typename T>
 	inline static void
@@ -230,41 +292,6 @@ namespace mn
 		return p;
 	}
 
-	template<typename T>
-	inline static void
-	deque_grow_front(Deque<T>& self)
-	{
-		if (self.cap > self.count && deque_index_can_dec(self, self.front))
-			return;
-
-		T* bucket = (T*)alloc_from(self.allocator, sizeof(T) * self.bucket_size, alignof(T)).ptr;
-
-		if (self.bucket_count < self.bucket_cap)
-		{
-			::memmove(self.buckets + 1, self.buckets, self.bucket_count * sizeof(T*));
-		}
-		else
-		{
-			size_t cap = self.bucket_cap == 0 ? 8 : self.bucket_cap * 2;
-			T** new_bucket_array = (T**)alloc_from(self.allocator, cap * sizeof(T*), alignof(T*)).ptr;
-			if (self.buckets)
-			{
-				::memcpy(new_bucket_array + 1, self.buckets, self.bucket_count * sizeof(T*));
-				free_from(self.allocator, Block{ self.buckets, self.bucket_cap * sizeof(T*) });
-			}
-			self.buckets = new_bucket_array;
-			self.bucket_cap = cap;
-		}
-
-		self.buckets[0] = bucket;
-		self.cap += self.bucket_size;
-		++self.bucket_count;
-
-		++self.front.bucket_index;
-		++self.back.bucket_index;
-		deque_grow_back(self);
-	}
-
 	// pushes the given value to the front of the deque
 	template<typename T>
 	inline static void
@@ -288,6 +315,116 @@ namespace mn
 		return p;
 	}
 
+	// pushes the given range of values to the back of the deque, it copies whole bucket chunks at once
+	template<typename T>
+	inline static void
+	deque_push_back_many(Deque<T>& self, const T* values, size_t count)
+	{
+		while (count > 0)
+		{
+			deque_grow_back(self);
+			auto chunk = self.bucket_size - self.back.element_index;
+			if (chunk > count)
+				chunk = count;
+			::memcpy(&self.buckets[self.back.bucket_index][self.back.element_index], values, chunk * sizeof(T));
+			self.back = _deque_index_add(self, self.back, chunk);
+			self.count += chunk;
+			values += chunk;
+			count -= chunk;
+		}
+	}
+
+	// pushes the given range of values to the front of the deque keeping their order, so values[0] becomes the front
+	// of the deque, it copies whole bucket chunks at once
+	template<typename T>
+	inline static void
+	deque_push_front_many(Deque<T>& self, const T* values, size_t count)
+	{
+		while (count > 0)
+		{
+			deque_grow_front(self);
+			auto chunk = self.front.element_index > 0 ? self.front.element_index : self.bucket_size;
+			if (chunk > count)
+				chunk = count;
+			self.front = _deque_index_sub(self, self.front, chunk);
+			::memcpy(&self.buckets[self.front.bucket_index][self.front.element_index], values + count - chunk, chunk * sizeof(T));
+			self.count += chunk;
+			count -= chunk;
+		}
+	}
+
+	// resets the indices of an empty deque so all of its buckets are available for pushing back
+	template<typename T>
+	inline static void
+	_deque_reset_if_empty(Deque<T>& self)
+	{
+		if (self.count == 0)
+		{
+			self.front = { 0, 0 };
+			self.back = { 0, 0 };
+		}
+	}
+
+	// pops up to count values off the front of the deque into the given array (if it's not null), and returns the count
+	// of the popped values
+	template<typename T>
+	inline static size_t
+	deque_pop_front_many(Deque<T>& self, T* values, size_t count)
+	{
+		if (count > self.count)
+			count = self.count;
+		auto res = count;
+		while (count > 0)
+		{
+			auto chunk = self.bucket_size - self.front.element_index;
+			if (chunk > count)
+				chunk = count;
+			if (values)
+			{
+				::memcpy(values, &self.buckets[self.front.bucket_index][self.front.element_index], chunk * sizeof(T));
+				values += chunk;
+			}
+			self.front = _deque_index_add(self, self.front, chunk);
+			self.count -= chunk;
+			count -= chunk;
+		}
+		_deque_reset_if_empty(self);
+		return res;
+	}
+
+	// pops up to count values off the back of the deque into the given array (if it's not null) keeping their order,
+	// so the last value in the array is the old back of the deque, and returns the count of the popped values
+	template<typename T>
+	inline static size_t
+	deque_pop_back_many(Deque<T>& self, T* values, size_t count)
+	{
+		if (count > self.count)
+			count = self.count;
+		auto res = count;
+		while (count > 0)
+		{
+			auto chunk = self.back.element_index > 0 ? self.back.element_index : self.bucket_size;
+			if (chunk > count)
+				chunk = count;
+			self.back = _deque_index_sub(self, self.back, chunk);
+			if (values)
+				::memcpy(values + count - chunk, &self.buckets[self.back.bucket_index][self.back.element_index], chunk * sizeof(T));
+			self.count -= chunk;
+			count -= chunk;
+		}
+		_deque_reset_if_empty(self);
+		return res;
+	}
+
+	// removes all the elements of the given deque, it keeps the buckets for reuse
+	template<typename T>
+	inline static void
+	deque_clear(Deque<T>& self)
+	{
+		self.count = 0;
+		_deque_reset_if_empty(self);
+	}
+
 	// removes an element off the back of the given deque
 	template<typename T>
 	inline static void
@@ -297,6 +434,7 @@ namespace mn
 			return;
 		self.back = deque_index_dec(self, self.back);
 		--self.count;
+		_deque_reset_if_empty(self);
 	}
 
 	// removes an element off the front of the given deque
@@ -308,6 +446,7 @@ namespace mn
 			return;
 		self.front = deque_index_inc(self, self.front);
 		--self.count;
+		_deque_reset_if_empty(self);
 	}
 
 	// returns a reference to the front of the given deque
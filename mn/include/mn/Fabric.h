@@ -1014,4 +1014,84 @@ namespace mn
 		else
 			_multi_threaded_compute(f, workgroup_num, total_size, tile_size, std::forward<TFunc>(fn));
 	}
+
+	// count of values which are hashed by a single compute workgroup in set_from_buf
+	constexpr size_t SET_FROM_BUF_TILE_SIZE = 16 * 1024;
+
+	// creates a new hash set which takes ownership of the given buf, the values hashes are computed in parallel on the
+	// given fabric (or on the calling thread if it's nullptr), then the table is sized once and the values are inserted
+	// using the precomputed hashes so nothing is rehashed while building, duplicate values are removed and the later
+	// value replaces the earlier one like set_insert does, note that the replaced values are not destructed
+	// the hash functor is called from the fabric workers so it should be thread safe
+	template<typename T, typename THash = Hash<T>>
+	inline static Set<T, THash>
+	set_from_buf(Buf<T>& values, Fabric f = nullptr)
+	{
+		auto self = set_with_allocator<T, THash>(values.allocator);
+		self.values = values;
+		values = Buf<T>{};
+		if (self.values.count == 0)
+			return self;
+
+		auto& hashes = self._hashes;
+		buf_resize(hashes, self.values.count);
+
+		compute(f, {self.values.count, 1, 1}, {SET_FROM_BUF_TILE_SIZE, 1, 1}, [&](Compute_Args args) {
+			THash hasher;
+			auto begin = args.global_invocation_id.x;
+			auto end = begin + args.tile_size.x;
+			for (size_t i = begin; i < end; ++i)
+				hashes.ptr[i] = hasher(self.values.ptr[i]);
+		});
+
+		set_reserve(self, self.values.count);
+
+		// the unique values are compacted to the front of the values buf as they're inserted, a value is always moved
+		// to an index at or before its own so it never overwrites a value which isn't inserted yet
+		constexpr size_t PREFETCH_DISTANCE = 8;
+		auto groups_mask = (self._ctrl.count / HASH_GROUP_SIZE) - 1;
+		for (size_t i = 0; i < self.values.count; ++i)
+		{
+			#if ARCH_X86
+				// the hashes are known ahead so we can bring the control bytes of the upcoming values into the cache
+				if (i + PREFETCH_DISTANCE < self.values.count)
+				{
+					auto group_index = (_hash_ctrl_mix(hashes.ptr[i + PREFETCH_DISTANCE]) >> 7) & groups_mask;
+					_mm_prefetch((const char*)(self._ctrl.ptr + group_index * HASH_GROUP_SIZE), _MM_HINT_T0);
+				}
+			#endif
+
+			const auto& value = self.values.ptr[i];
+			auto res = _set_find_slot_for_insert_hashed(self, value, hashes.ptr[i]);
+			mn_assert(res.index < self._ctrl.count);
+
+			if ((self._ctrl.ptr[res.index] & 0x80) == 0)
+			{
+				self.values.ptr[self._slots.ptr[res.index]] = value;
+				continue;
+			}
+
+			mn_assert_msg(self.count < UINT32_MAX, "hash table slots use 32-bit indices");
+			_hash_ctrl_set_used(self._ctrl, res.index, res.hash);
+			self._slots.ptr[res.index] = uint32_t(self.count);
+			if (self.count != i)
+			{
+				self.values.ptr[self.count] = value;
+				hashes.ptr[self.count] = hashes.ptr[i];
+			}
+			++self.count;
+		}
+		self.values.count = self.count;
+		hashes.count = self.count;
+		return self;
+	}
+
+	// creates a new hash map which takes ownership of the given buf of key value pairs, the keys are hashed in parallel
+	// on the given fabric (or on the calling thread if it's nullptr), check set_from_buf for the details
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Map<TKey, TValue, THash>
+	map_from_buf(Buf<Key_Value<TKey, TValue>>& items, Fabric f = nullptr)
+	{
+		return set_from_buf<Key_Value<TKey, TValue>, Key_Value_Hash<TKey, TValue, THash>>(items, f);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,373 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Map.h"
+#include "mn/Str.h"
+#include "mn/File.h"
+#include "mn/Stream.h"
+#include "mn/Result.h"
+
+namespace mn
+{
+	// bloom filter file magic number 'MNBF'
+	constexpr static uint32_t BLOOM_FILTER_MAGIC = 0x46424E4D;
+	constexpr static uint32_t BLOOM_FILTER_VERSION = 1;
+	// count of 32-bit words in a bloom filter block, every key sets a single bit in each word of its block
+	constexpr static size_t BLOOM_FILTER_BLOCK_WORDS = 8;
+
+	// bloom filter blob header, all the offsets are relative to the start of the blob
+	struct Bloom_Filter_Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t blocks_count;
+		// count of the inserted keys, including the duplicates
+		uint64_t count;
+		uint64_t blocks_offset;
+		// size of the whole blob in bytes
+		uint64_t size;
+	};
+
+	// a split block bloom filter, each key is mapped to a single 256-bit block (half a cache line) and sets one bit in
+	// each of its 8 words, so a probe touches a single cache line and is checked using two SIMD compares, it has no
+	// false negatives and it can't remove keys, the filter is stored in a single position independent blob which can
+	// be written to a stream and memory mapped back, filters loaded from files are read only
+	// the keys are hashed using mn's Hash<T> functors so the same functor should be used for building and probing
+	struct Bloom_Filter
+	{
+		Bloom_Filter_Header* header;
+		uint32_t* blocks;
+		// the owned memory of the blob in case it was created or copied into memory
+		Block data;
+		Allocator allocator;
+		// the mapped file in case it was loaded using bloom_filter_load
+		Mapped_File* file;
+	};
+
+	// mixes the given key hash, since a lot of our hash functions are identity functions (ints and pointers)
+	inline static uint64_t
+	_filter_hash_mix(size_t hash)
+	{
+		return _hash_mix(uint64_t(hash) ^ 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL);
+	}
+
+	// maps the given hash into [0, count) using the high part of the 128-bit product
+	inline static uint64_t
+	_filter_reduce(uint64_t hash, uint64_t count)
+	{
+		_hash_mul128(hash, count);
+		return count;
+	}
+
+	// computes the bit which the given key sets in each word of its block
+	inline static void
+	_bloom_filter_mask(uint32_t key, uint32_t* mask)
+	{
+		constexpr uint32_t SALT[BLOOM_FILTER_BLOCK_WORDS] = {
+			0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+			0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+		};
+		for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+			mask[i] = uint32_t(1) << ((key * SALT[i]) >> 27);
+	}
+
+	// creates a new bloom filter which is sized to hold the given count of keys with the given false positive rate
+	MN_EXPORT Bloom_Filter
+	bloom_filter_new(size_t expected_count, double false_positive_rate = 0.01, Allocator allocator = allocator_top());
+
+	// frees the given bloom filter
+	MN_EXPORT void
+	bloom_filter_free(Bloom_Filter& self);
+
+	// destruct overload for bloom filter free
+	inline static void
+	destruct(Bloom_Filter& self)
+	{
+		bloom_filter_free(self);
+	}
+
+	// removes all the keys from the given bloom filter
+	MN_EXPORT void
+	bloom_filter_clear(Bloom_Filter& self);
+
+	// validates the given bloom filter blob
+	MN_EXPORT Err
+	_bloom_filter_validate(Block data);
+
+	// creates a bloom filter which views the given blob without copying it, the blob should outlive the filter, and
+	// the filter is read only if the blob is
+	MN_EXPORT Result<Bloom_Filter>
+	bloom_filter_from_block(Block data);
+
+	// memory maps the given bloom filter file in read only mode
+	MN_EXPORT Result<Bloom_Filter>
+	bloom_filter_load(const Str& filename);
+
+	// memory maps the given bloom filter file in read only mode
+	inline static Result<Bloom_Filter>
+	bloom_filter_load(const char* filename)
+	{
+		return bloom_filter_load(str_lit(filename));
+	}
+
+	// returns the blob of the given bloom filter which you can write to a file and load later using bloom_filter_load
+	inline static Block
+	bloom_filter_block(const Bloom_Filter& self)
+	{
+		return Block{self.header, self.header ? size_t(self.header->size) : 0};
+	}
+
+	// writes the blob of the given bloom filter to the given stream, returns whether the whole blob was written
+	inline static bool
+	bloom_filter_write(const Bloom_Filter& self, Stream out)
+	{
+		auto data = bloom_filter_block(self);
+		return stream_write(out, data) == data.size;
+	}
+
+	// returns the count of the keys which were inserted into the given bloom filter
+	inline static size_t
+	bloom_filter_count(const Bloom_Filter& self)
+	{
+		return self.header ? size_t(self.header->count) : 0;
+	}
+
+	// inserts the key with the given hash into the bloom filter
+	inline static void
+	bloom_filter_insert_hash(Bloom_Filter& self, size_t hash)
+	{
+		mn_assert_msg(self.file == nullptr, "bloom filters loaded from files are read only");
+
+		auto h = _filter_hash_mix(hash);
+		auto block = self.blocks + _filter_reduce(h, self.header->blocks_count) * BLOOM_FILTER_BLOCK_WORDS;
+		alignas(16) uint32_t mask[BLOOM_FILTER_BLOCK_WORDS];
+		_bloom_filter_mask(uint32_t(h), mask);
+
+		#if ARCH_X86
+			auto b0 = _mm_loadu_si128((const __m128i*)block);
+			auto b1 = _mm_loadu_si128((const __m128i*)(block + 4));
+			_mm_storeu_si128((__m128i*)block, _mm_or_si128(b0, _mm_load_si128((const __m128i*)mask)));
+			_mm_storeu_si128((__m128i*)(block + 4), _mm_or_si128(b1, _mm_load_si128((const __m128i*)(mask + 4))));
+		#else
+			for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+				block[i] |= mask[i];
+		#endif
+		++self.header->count;
+	}
+
+	// returns whether the key with the given hash might be in the bloom filter, false means that it's definitely not
+	inline static bool
+	bloom_filter_contains_hash(const Bloom_Filter& self, size_t hash)
+	{
+		auto h = _filter_hash_mix(hash);
+		auto block = self.blocks + _filter_reduce(h, self.header->blocks_count) * BLOOM_FILTER_BLOCK_WORDS;
+		alignas(16) uint32_t mask[BLOOM_FILTER_BLOCK_WORDS];
+		_bloom_filter_mask(uint32_t(h), mask);
+
+		#if ARCH_X86
+			// the key is missing if any of its bits is unset in the block
+			auto b0 = _mm_loadu_si128((const __m128i*)block);
+			auto b1 = _mm_loadu_si128((const __m128i*)(block + 4));
+			auto missing = _mm_or_si128(
+				_mm_andnot_si128(b0, _mm_load_si128((const __m128i*)mask)),
+				_mm_andnot_si128(b1, _mm_load_si128((const __m128i*)(mask + 4)))
+			);
+			return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+		#else
+			uint32_t missing = 0;
+			for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+				missing |= mask[i] & ~block[i];
+			return missing == 0;
+		#endif
+	}
+
+	// inserts the given key into the bloom filter, the key is hashed using the given hash functor
+	template<typename T, typename THash = Hash<T>>
+	inline static void
+	bloom_filter_insert(Bloom_Filter& self, const T& key)
+	{
+		bloom_filter_insert_hash(self, THash()(key));
+	}
+
+	// returns whether the given key might be in the bloom filter, false means that it's definitely not, the key can be
+	// of any type which has the same hash as the inserted keys (ex. a `Str_View` for `Str` keys)
+	template<typename T, typename THash = Hash<T>>
+	inline static bool
+	bloom_filter_contains(const Bloom_Filter& self, const T& key)
+	{
+		return bloom_filter_contains_hash(self, THash()(key));
+	}
+
+	// cuckoo filter file magic number 'MNCF'
+	constexpr static uint32_t CUCKOO_FILTER_MAGIC = 0x46434E4D;
+	constexpr static uint32_t CUCKOO_FILTER_VERSION = 1;
+	// count of the 16-bit fingerprints in a cuckoo filter bucket, a bucket is a single 64-bit word
+	constexpr static size_t CUCKOO_FILTER_BUCKET_SIZE = 4;
+
+	// cuckoo filter blob header, all the offsets are relative to the start of the blob
+	struct Cuckoo_Filter_Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		// count of the buckets which is a power of 2
+		uint64_t buckets_count;
+		uint64_t count;
+		// when the filter is full the last evicted fingerprint is kept here so no key is lost, 0 means there's none
+		uint64_t victim_index;
+		uint32_t victim_fingerprint;
+		// state of the random generator which selects the evicted fingerprints
+		uint32_t random_state;
+		uint64_t buckets_offset;
+		// size of the whole blob in bytes
+		uint64_t size;
+	};
+
+	// a cuckoo filter, each key is stored as a 16-bit fingerprint in one of two candidate buckets, unlike the bloom
+	// filter it supports removing keys, a probe loads 2 buckets and checks all their fingerprints at once using SWAR,
+	// the false positive rate is about 8 / 2^16 when the filter is full (95% load), inserting duplicates of the same
+	// key more than 8 times will fill its buckets, the filter is stored in a single position independent blob which
+	// can be written to a stream and memory mapped back, filters loaded from files are read only
+	struct Cuckoo_Filter
+	{
+		Cuckoo_Filter_Header* header;
+		uint64_t* buckets;
+		// the owned memory of the blob in case it was created or copied into memory
+		Block data;
+		Allocator allocator;
+		// the mapped file in case it was loaded using cuckoo_filter_load
+		Mapped_File* file;
+	};
+
+	// returns the fingerprint of the given mixed hash, 0 is reserved for the empty entries
+	inline static uint16_t
+	_cuckoo_filter_fingerprint(uint64_t h)
+	{
+		auto fingerprint = uint16_t(h);
+		return fingerprint ? fingerprint : 1;
+	}
+
+	// returns the other candidate bucket of the given fingerprint, it's symmetric so it works for both buckets
+	inline static uint64_t
+	_cuckoo_filter_alt_index(uint64_t index, uint16_t fingerprint, uint64_t buckets_count)
+	{
+		return (index ^ (uint64_t(fingerprint) * 0xc6a4a7935bd1e995ULL >> 16)) & (buckets_count - 1);
+	}
+
+	// returns a mask with the most significant bit of each 16-bit lane in the given bucket which equals the given
+	// fingerprint
+	inline static uint64_t
+	_cuckoo_filter_bucket_match(uint64_t bucket, uint16_t fingerprint)
+	{
+		constexpr uint64_t LO = 0x0001000100010001ULL;
+		constexpr uint64_t HI = 0x8000800080008000ULL;
+		auto x = bucket ^ (uint64_t(fingerprint) * LO);
+		return (x - LO) & ~x & HI;
+	}
+
+	// creates a new cuckoo filter which is sized to hold the given count of keys
+	MN_EXPORT Cuckoo_Filter
+	cuckoo_filter_new(size_t expected_count, Allocator allocator = allocator_top());
+
+	// frees the given cuckoo filter
+	MN_EXPORT void
+	cuckoo_filter_free(Cuckoo_Filter& self);
+
+	// destruct overload for cuckoo filter free
+	inline static void
+	destruct(Cuckoo_Filter& self)
+	{
+		cuckoo_filter_free(self);
+	}
+
+	// removes all the keys from the given cuckoo filter
+	MN_EXPORT void
+	cuckoo_filter_clear(Cuckoo_Filter& self);
+
+	// inserts the key with the given hash into the cuckoo filter, returns false if the filter is full
+	MN_EXPORT bool
+	cuckoo_filter_insert_hash(Cuckoo_Filter& self, size_t hash);
+
+	// removes the key with the given hash from the cuckoo filter, returns whether it was found, removing a key which
+	// wasn't inserted might remove another key with the same fingerprint
+	MN_EXPORT bool
+	cuckoo_filter_remove_hash(Cuckoo_Filter& self, size_t hash);
+
+	// validates the given cuckoo filter blob
+	MN_EXPORT Err
+	_cuckoo_filter_validate(Block data);
+
+	// creates a cuckoo filter which views the given blob without copying it, the blob should outlive the filter, and
+	// the filter is read only if the blob is
+	MN_EXPORT Result<Cuckoo_Filter>
+	cuckoo_filter_from_block(Block data);
+
+	// memory maps the given cuckoo filter file in read only mode
+	MN_EXPORT Result<Cuckoo_Filter>
+	cuckoo_filter_load(const Str& filename);
+
+	// memory maps the given cuckoo filter file in read only mode
+	inline static Result<Cuckoo_Filter>
+	cuckoo_filter_load(const char* filename)
+	{
+		return cuckoo_filter_load(str_lit(filename));
+	}
+
+	// returns the blob of the given cuckoo filter which you can write to a file and load later using cuckoo_filter_load
+	inline static Block
+	cuckoo_filter_block(const Cuckoo_Filter& self)
+	{
+		return Block{self.header, self.header ? size_t(self.header->size) : 0};
+	}
+
+	// writes the blob of the given cuckoo filter to the given stream, returns whether the whole blob was written
+	inline static bool
+	cuckoo_filter_write(const Cuckoo_Filter& self, Stream out)
+	{
+		auto data = cuckoo_filter_block(self);
+		return stream_write(out, data) == data.size;
+	}
+
+	// returns the count of the keys in the given cuckoo filter
+	inline static size_t
+	cuckoo_filter_count(const Cuckoo_Filter& self)
+	{
+		return self.header ? size_t(self.header->count) : 0;
+	}
+
+	// returns whether the key with the given hash might be in the cuckoo filter, false means that it's definitely not
+	inline static bool
+	cuckoo_filter_contains_hash(const Cuckoo_Filter& self, size_t hash)
+	{
+		auto h = _filter_hash_mix(hash);
+		auto fingerprint = _cuckoo_filter_fingerprint(h);
+		auto i1 = (h >> 32) & (self.header->buckets_count - 1);
+		auto i2 = _cuckoo_filter_alt_index(i1, fingerprint, self.header->buckets_count);
+		if (_cuckoo_filter_bucket_match(self.buckets[i1], fingerprint) | _cuckoo_filter_bucket_match(self.buckets[i2], fingerprint))
+			return true;
+		return self.header->victim_fingerprint == fingerprint && (self.header->victim_index == i1 || self.header->victim_index == i2);
+	}
+
+	// inserts the given key into the cuckoo filter, returns false if the filter is full
+	template<typename T, typename THash = Hash<T>>
+	inline static bool
+	cuckoo_filter_insert(Cuckoo_Filter& self, const T& key)
+	{
+		return cuckoo_filter_insert_hash(self, THash()(key));
+	}
+
+	// removes the given key from the cuckoo filter, returns whether it was found
+	template<typename T, typename THash = Hash<T>>
+	inline static bool
+	cuckoo_filter_remove(Cuckoo_Filter& self, const T& key)
+	{
+		return cuckoo_filter_remove_hash(self, THash()(key));
+	}
+
+	// returns whether the given key might be in the cuckoo filter, false means that it's definitely not
+	template<typename T, typename THash = Hash<T>>
+	inline static bool
+	cuckoo_filter_contains(const Cuckoo_Filter& self, const T& key)
+	{
+		return cuckoo_filter_contains_hash(self, THash()(key));
+	}
+}
@@ -4,6 +4,7 @@
 #include <fmt/ostream.h>
 
 #include "mn/Str.h"
+#include "mn/Small_Str.h"
 #include "mn/Buf.h"
 #include "mn/Map.h"
 #include "mn/File.h"
@@ -23,6 +24,32 @@ namespace fmt
 		}
 	};
 
+	template<>
+	struct formatter<mn::Str_View> {
+		template <typename ParseContext>
+		constexpr auto parse(ParseContext &ctx) { return ctx.begin(); }
+
+		template <typename FormatContext>
+		auto format(const mn::Str_View &str, FormatContext &ctx) {
+			if (str.count == 0)
+				return ctx.out();
+			return format_to(ctx.out(), "{}", fmt::string_view(str.ptr, str.count));
+		}
+	};
+
+	template<>
+	struct formatter<mn::Small_Str> {
+		template <typename ParseContext>
+		constexpr auto parse(ParseContext &ctx) { return ctx.begin(); }
+
+		template <typename FormatContext>
+		auto format(const mn::Small_Str &str, FormatContext &ctx) {
+			if (mn::small_str_count(str) == 0)
+				return ctx.out();
+			return format_to(ctx.out(), "{}", mn::small_str_ptr(str));
+		}
+	};
+
 	template<typename T>
 	struct formatter<mn::Buf<T>> {
 		template <typename ParseContext>
@@ -123,6 +150,34 @@ namespace mn
 		return strf(str_tmp(), format_str, args...);
 	}
 
+	// appends the formatted string to the end of the given out small string, you should the returned value back into the
+	// given small string
+	template<typename ... Args>
+	[[nodiscard]] inline static Small_Str
+	strf(Small_Str out, const char* format_str, const Args& ... args)
+	{
+		fmt::memory_buffer buf;
+		fmt::format_to(buf, format_str, args...);
+		small_str_push(out, Str_View{buf.data(), buf.size()});
+		return out;
+	}
+
+	// creates a new small string using the given allocator for the spilled characters containing the formatted string
+	template<typename ... Args>
+	[[nodiscard]] inline static Small_Str
+	small_strf(Allocator allocator, const char* format_str, const Args& ... args)
+	{
+		return strf(small_str_new(allocator), format_str, args...);
+	}
+
+	// creates a new small string using the top/default allocator containing the formatted string
+	template<typename ... Args>
+	[[nodiscard]] inline static Small_Str
+	small_strf(const char* format_str, const Args& ... args)
+	{
+		return strf(small_str_new(), format_str, args...);
+	}
+
 	// prints the formatted string to the given stream
 	template<typename ... Args>
 	inline static size_t
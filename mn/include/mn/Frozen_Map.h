@@ -0,0 +1,273 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Map.h"
+#include "mn/Str.h"
+#include "mn/File.h"
+#include "mn/Stream.h"
+#include "mn/Result.h"
+
+#include <type_traits>
+
+namespace mn
+{
+	// frozen map file magic number 'MNFM'
+	constexpr static uint32_t FROZEN_MAP_MAGIC = 0x4D464E4D;
+	constexpr static uint32_t FROZEN_MAP_VERSION = 1;
+
+	// frozen map blob header, all the offsets are relative to the start of the blob
+	struct Frozen_Map_Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		// count of the keys in the map which is also the count of the slots
+		uint64_t count;
+		// count of the buckets of the perfect hash function, each bucket has a 32-bit pilot
+		uint64_t buckets_count;
+		// seed of the key hash function
+		uint64_t seed;
+		// size of a single value in bytes
+		uint64_t value_size;
+		uint64_t pilots_offset;
+		uint64_t slots_offset;
+		uint64_t values_offset;
+		uint64_t keys_offset;
+		// size of the whole blob in bytes
+		uint64_t size;
+	};
+
+	// a frozen map slot, the key is stored null terminated in the keys section of the blob
+	struct Frozen_Map_Slot
+	{
+		uint64_t key_offset;
+		uint64_t key_count;
+	};
+
+	// an immutable string map which is stored in a single position independent blob, the keys are mapped to the slots
+	// using a minimal perfect hash function (hash and displace) so a lookup is a single hash, a bucket pilot load,
+	// and a single key compare, the blob can be written to disk and memory mapped back with zero parsing so multiple
+	// processes share the same page cache, the values should be trivially copyable
+	template<typename TValue>
+	struct Frozen_Map
+	{
+		static_assert(std::is_trivially_copyable_v<TValue>, "frozen map values should be trivially copyable");
+		static_assert(alignof(TValue) <= 8, "frozen map values should be at most 8 bytes aligned");
+
+		const Frozen_Map_Header* header;
+		const uint32_t* pilots;
+		const Frozen_Map_Slot* slots;
+		const TValue* values;
+		const char* keys;
+		// the owned memory of the blob in case it was built or loaded into memory
+		Block data;
+		Allocator allocator;
+		// the mapped file in case it was loaded using frozen_map_load
+		Mapped_File* file;
+	};
+
+	// builds a frozen map blob out of the given keys and values (count * value_size bytes), it fails if the keys are
+	// not unique
+	MN_EXPORT Result<Block>
+	_frozen_map_build(const Str_View* keys, const void* values, size_t count, size_t value_size, Allocator allocator);
+
+	// validates the given frozen map blob, including the bounds of every slot key
+	MN_EXPORT Err
+	_frozen_map_validate(Block data, size_t value_size);
+
+	inline static uint64_t
+	_frozen_map_reduce(uint64_t hash, uint64_t count)
+	{
+		// maps the hash into [0, count) using the high part of the 128-bit product which avoids the division
+		_hash_mul128(hash, count);
+		return count;
+	}
+
+	inline static uint64_t
+	_frozen_map_bucket(uint64_t hash, uint64_t buckets_count)
+	{
+		return _frozen_map_reduce(hash, buckets_count);
+	}
+
+	inline static uint64_t
+	_frozen_map_position(uint64_t hash, uint32_t pilot, uint64_t count)
+	{
+		// the bucket is selected by the high bits of the hash, so it's remixed with the pilot to spread the keys of the
+		// same bucket over the whole table
+		return _frozen_map_reduce(_hash_mix(hash ^ (uint64_t(pilot) * 0xc6a4a7935bd1e995ULL), 0x9e3779b97f4a7c15ULL), count);
+	}
+
+	template<typename TValue>
+	inline static Frozen_Map<TValue>
+	_frozen_map_from_data(Block data)
+	{
+		auto base = (const uint8_t*)data.ptr;
+		Frozen_Map<TValue> self{};
+		self.header = (const Frozen_Map_Header*)base;
+		self.pilots = (const uint32_t*)(base + self.header->pilots_offset);
+		self.slots = (const Frozen_Map_Slot*)(base + self.header->slots_offset);
+		self.values = (const TValue*)(base + self.header->values_offset);
+		self.keys = (const char*)(base + self.header->keys_offset);
+		return self;
+	}
+
+	// freezes the given map into a frozen map which is allocated from the given allocator
+	template<typename TValue, typename THash>
+	inline static Result<Frozen_Map<TValue>>
+	frozen_map_build(const Map<Str, TValue, THash>& map, Allocator allocator = allocator_top())
+	{
+		auto scratch = scratch_begin({allocator});
+		auto keys = buf_with_allocator<Str_View>(scratch.arena);
+		auto values = buf_with_allocator<TValue>(scratch.arena);
+		buf_reserve(keys, map.count);
+		buf_reserve(values, map.count);
+		for (const auto& [key, value]: map)
+		{
+			buf_push(keys, str_view(key));
+			buf_push(values, value);
+		}
+
+		auto [data, err] = _frozen_map_build(keys.ptr, values.ptr, keys.count, sizeof(TValue), allocator);
+		if (err)
+			return err;
+
+		auto self = _frozen_map_from_data<TValue>(data);
+		self.data = data;
+		self.allocator = allocator;
+		return self;
+	}
+
+	// creates a frozen map which views the given blob without copying it, the blob should outlive the frozen map
+	template<typename TValue>
+	inline static Result<Frozen_Map<TValue>>
+	frozen_map_from_block(Block data)
+	{
+		if (auto err = _frozen_map_validate(data, sizeof(TValue)))
+			return err;
+		return _frozen_map_from_data<TValue>(data);
+	}
+
+	// memory maps the given frozen map file in read only mode
+	template<typename TValue>
+	inline static Result<Frozen_Map<TValue>>
+	frozen_map_load(const Str& filename)
+	{
+		auto file = file_mmap(filename, 0, 0, IO_MODE_READ, OPEN_MODE_OPEN_ONLY, SHARE_MODE_READ);
+		if (file == nullptr)
+			return Err{"failed to map frozen map file '{}'", filename};
+
+		if (auto err = _frozen_map_validate(file->data, sizeof(TValue)))
+		{
+			file_unmap(file);
+			return err;
+		}
+
+		auto self = _frozen_map_from_data<TValue>(file->data);
+		self.file = file;
+		return self;
+	}
+
+	// memory maps the given frozen map file in read only mode
+	template<typename TValue>
+	inline static Result<Frozen_Map<TValue>>
+	frozen_map_load(const char* filename)
+	{
+		return frozen_map_load<TValue>(str_lit(filename));
+	}
+
+	// frees the given frozen map
+	template<typename TValue>
+	inline static void
+	frozen_map_free(Frozen_Map<TValue>& self)
+	{
+		if (self.file)
+			file_unmap(self.file);
+		else if (self.data.ptr)
+			free_from(self.allocator, self.data);
+		self = Frozen_Map<TValue>{};
+	}
+
+	// destruct overload for frozen map free
+	template<typename TValue>
+	inline static void
+	destruct(Frozen_Map<TValue>& self)
+	{
+		frozen_map_free(self);
+	}
+
+	// returns the blob of the given frozen map which you can write to a file and load later using frozen_map_load
+	template<typename TValue>
+	inline static Block
+	frozen_map_block(const Frozen_Map<TValue>& self)
+	{
+		return Block{(void*)self.header, self.header ? size_t(self.header->size) : 0};
+	}
+
+	// writes the blob of the given frozen map to the given stream, returns whether the whole blob was written
+	template<typename TValue>
+	inline static bool
+	frozen_map_write(const Frozen_Map<TValue>& self, Stream out)
+	{
+		auto data = frozen_map_block(self);
+		return stream_write(out, data) == data.size;
+	}
+
+	// returns the count of the keys in the given frozen map
+	template<typename TValue>
+	inline static size_t
+	frozen_map_count(const Frozen_Map<TValue>& self)
+	{
+		return self.header ? size_t(self.header->count) : 0;
+	}
+
+	// returns a pointer to the value of the given key or nullptr if it doesn't exist
+	template<typename TValue>
+	inline static const TValue*
+	frozen_map_lookup(const Frozen_Map<TValue>& self, Str_View key)
+	{
+		if (self.header == nullptr || self.header->count == 0)
+			return nullptr;
+
+		auto hash = uint64_t(hash_bytes(key.ptr, key.count, self.header->seed));
+		auto pilot = self.pilots[_frozen_map_bucket(hash, self.header->buckets_count)];
+		auto index = _frozen_map_position(hash, pilot, self.header->count);
+		const auto& slot = self.slots[index];
+		if (slot.key_count != key.count || ::memcmp(self.keys + slot.key_offset, key.ptr, key.count) != 0)
+			return nullptr;
+		return self.values + index;
+	}
+
+	// returns a pointer to the value of the given key or nullptr if it doesn't exist
+	template<typename TValue>
+	inline static const TValue*
+	frozen_map_lookup(const Frozen_Map<TValue>& self, const Str& key)
+	{
+		return frozen_map_lookup(self, str_view(key));
+	}
+
+	// returns a pointer to the value of the given key or nullptr if it doesn't exist
+	template<typename TValue>
+	inline static const TValue*
+	frozen_map_lookup(const Frozen_Map<TValue>& self, const char* key)
+	{
+		return frozen_map_lookup(self, str_view(key));
+	}
+
+	// returns the key of the slot at the given index, slots are in the range [0, frozen_map_count)
+	template<typename TValue>
+	inline static Str_View
+	frozen_map_key(const Frozen_Map<TValue>& self, size_t index)
+	{
+		mn_assert(index < frozen_map_count(self));
+		const auto& slot = self.slots[index];
+		return Str_View{self.keys + slot.key_offset, size_t(slot.key_count)};
+	}
+
+	// returns the value of the slot at the given index, slots are in the range [0, frozen_map_count)
+	template<typename TValue>
+	inline static const TValue&
+	frozen_map_value(const Frozen_Map<TValue>& self, size_t index)
+	{
+		mn_assert(index < frozen_map_count(self));
+		return self.values[index];
+	}
+}
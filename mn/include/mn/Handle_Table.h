@@ -91,38 +91,66 @@ namespace mn
 		handle_table_free(self);
 	}
 
-	// inserts a new value into the handle table and returns its associated handle
-	template<typename T>
-	inline static uint64_t
-	handle_table_insert(Handle_Table<T>& self, T v)
+	// allocates a map entry which points to the given items index, and returns its handle index
+	inline static Handle_Table_Index
+	_handle_table_map_acquire(mn::Buf<Handle_Table_Entry>& map, uint32_t& free_list_head, uint32_t items_index)
 	{
 		Handle_Table_Index h{UINT32_MAX, UINT32_MAX};
 		// no already free indices so create new one
-		if (self._free_list_head == UINT32_MAX)
+		if (free_list_head == UINT32_MAX)
 		{
-			h.index = uint32_t(self._map.count);
+			h.index = uint32_t(map.count);
 			h.generation = 0;
 
 			Handle_Table_Entry entry;
-			entry.items_index = uint32_t(self.items.count);
+			entry.items_index = items_index;
 			entry.generation = 0;
-			mn::buf_push(self._map, entry);
+			mn::buf_push(map, entry);
 		}
 		else
 		{
 			// load the item from the map
-			auto& entry = self._map[self._free_list_head];
+			auto& entry = map[free_list_head];
 
 			// fill out the result index
-			h.index = self._free_list_head;
+			h.index = free_list_head;
 			h.generation = entry.generation;
 
 			// pop the free list head
-			self._free_list_head = entry.items_index;
+			free_list_head = entry.items_index;
 
 			//update the items_index
-			entry.items_index = uint32_t(self.items.count);
+			entry.items_index = items_index;
 		}
+		return h;
+	}
+
+	// releases the map entry of the given handle index into the free list, and returns the items index it was pointing
+	// to, or UINT32_MAX if the handle is invalid
+	inline static uint32_t
+	_handle_table_map_release(mn::Buf<Handle_Table_Entry>& map, uint32_t& free_list_head, Handle_Table_Index h)
+	{
+		auto& entry = map[h.index];
+		mn_assert(entry.generation == h.generation);
+		if (entry.generation != h.generation)
+			return UINT32_MAX;
+
+		auto items_index = entry.items_index;
+		// increment the generation of the removed item
+		++entry.generation;
+		// push the free list head to the removed item
+		entry.items_index = free_list_head;
+		// replace the free list head with the item index
+		free_list_head = h.index;
+		return items_index;
+	}
+
+	// inserts a new value into the handle table and returns its associated handle
+	template<typename T>
+	inline static uint64_t
+	handle_table_insert(Handle_Table<T>& self, T v)
+	{
+		auto h = _handle_table_map_acquire(self._map, self._free_list_head, uint32_t(self.items.count));
 		mn::buf_push(self.items, Handle_Table_Item<T>{v, h.index});
 		return handle_table_index_to_uint64(h);
 	}
@@ -132,29 +160,20 @@ namespace mn
 	inline static void
 	handle_table_remove(Handle_Table<T>& self, uint64_t v)
 	{
-		auto h = handle_table_index_from_uint64(v);
-		auto& entry = self._map[h.index];
-		mn_assert(entry.generation == h.generation);
-		if (entry.generation != h.generation)
+		auto items_index = _handle_table_map_release(self._map, self._free_list_head, handle_table_index_from_uint64(v));
+		if (items_index == UINT32_MAX)
 			return;
 
-		if (entry.items_index + 1 != self.items.count)
+		if (items_index + 1 != self.items.count)
 		{
 			// load the item to be removed
-			auto& item = self.items[entry.items_index];
+			auto& item = self.items[items_index];
 			// replace it with the last item
 			item = self.items[self.items.count - 1];
 			// update the last item index in the map
-			self._map[item.map_index].items_index = entry.items_index;
+			self._map[item.map_index].items_index = items_index;
 		}
 
-		// increment the generation of the removed item
-		++self._map[h.index].generation;
-		// push the free list head to the removed item
-		self._map[h.index].items_index = self._free_list_head;
-		// replace the free list head with the item index
-		self._free_list_head = h.index;
-
 		mn::buf_pop(self.items);
 	}
 
@@ -180,4 +199,114 @@ namespace mn
 			ptr = &self.items[entry.items_index].item;
 		return *ptr;
 	}
-}
\ No newline at end of file
+
+	// handle table which stores its values in a dense array separate from their map indices (struct of arrays), so
+	// components which are iterated in tight loops only touch the values memory, values are moved around on removal
+	// so the order isn't stable
+	template<typename T>
+	struct Handle_Table_SoA
+	{
+		mn::Buf<T> values;
+		// the map index of each value, parallel to the values array
+		mn::Buf<uint32_t> _values_map_index;
+		mn::Buf<Handle_Table_Entry> _map;
+		// used to index the index free list in the map
+		uint32_t _free_list_head;
+	};
+
+	// creates a new struct of arrays handle table
+	template<typename T>
+	inline static Handle_Table_SoA<T>
+	handle_table_soa_new(Allocator allocator = allocator_top())
+	{
+		Handle_Table_SoA<T> self{};
+		self.values = mn::buf_with_allocator<T>(allocator);
+		self._values_map_index = mn::buf_with_allocator<uint32_t>(allocator);
+		self._map = mn::buf_with_allocator<Handle_Table_Entry>(allocator);
+		self._free_list_head = UINT32_MAX;
+		return self;
+	}
+
+	// frees the given struct of arrays handle table
+	template<typename T>
+	inline static void
+	handle_table_soa_free(Handle_Table_SoA<T>& self)
+	{
+		mn::buf_free(self.values);
+		mn::buf_free(self._values_map_index);
+		mn::buf_free(self._map);
+	}
+
+	// destruct overload for struct of arrays handle table free
+	template<typename T>
+	inline static void
+	destruct(Handle_Table_SoA<T>& self)
+	{
+		handle_table_soa_free(self);
+	}
+
+	// inserts a new value into the handle table and returns its associated handle
+	template<typename T>
+	inline static uint64_t
+	handle_table_soa_insert(Handle_Table_SoA<T>& self, const T& v)
+	{
+		auto h = _handle_table_map_acquire(self._map, self._free_list_head, uint32_t(self.values.count));
+		mn::buf_push(self.values, v);
+		mn::buf_push(self._values_map_index, h.index);
+		return handle_table_index_to_uint64(h);
+	}
+
+	// removes the value associated with the handle from the given handle table, the last value is moved into its place
+	template<typename T>
+	inline static void
+	handle_table_soa_remove(Handle_Table_SoA<T>& self, uint64_t v)
+	{
+		auto items_index = _handle_table_map_release(self._map, self._free_list_head, handle_table_index_from_uint64(v));
+		if (items_index == UINT32_MAX)
+			return;
+
+		auto last_index = self.values.count - 1;
+		if (items_index != last_index)
+		{
+			self.values[items_index] = self.values[last_index];
+			self._values_map_index[items_index] = self._values_map_index[last_index];
+			self._map[self._values_map_index[items_index]].items_index = items_index;
+		}
+
+		mn::buf_pop(self.values);
+		mn::buf_pop(self._values_map_index);
+	}
+
+	// checks whether the value associated with the given handle exists
+	template<typename T>
+	inline static bool
+	handle_table_soa_exists(const Handle_Table_SoA<T>& self, uint64_t v)
+	{
+		auto h = handle_table_index_from_uint64(v);
+		if (h.index >= self._map.count)
+			return false;
+		return self._map[h.index].generation == h.generation;
+	}
+
+	// returns a pointer to the value associated with the given handle, or nullptr if it doesn't exist, the pointer is
+	// invalidated by the next insert or remove
+	template<typename T>
+	inline static T*
+	handle_table_soa_get(Handle_Table_SoA<T>& self, uint64_t v)
+	{
+		if (handle_table_soa_exists(self, v) == false)
+			return nullptr;
+		auto h = handle_table_index_from_uint64(v);
+		return &self.values[self._map[h.index].items_index];
+	}
+
+	// returns the handle of the value at the given index in the values array, it's used to get the handle of values
+	// while iterating over them
+	template<typename T>
+	inline static uint64_t
+	handle_table_soa_handle(const Handle_Table_SoA<T>& self, size_t values_index)
+	{
+		auto map_index = self._values_map_index[values_index];
+		return handle_table_index_to_uint64(Handle_Table_Index{self._map[map_index].generation, map_index});
+	}
+}
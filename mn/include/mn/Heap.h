@@ -0,0 +1,426 @@
+#pragma once
+
+#include "mn/Buf.h"
+#include "mn/Handle_Table.h"
+#include "mn/Assert.h"
+
+namespace mn
+{
+	// moves the item at the given index up the d-ary heap until its parent is not greater than it, the given moved
+	// function `moved(size_t index)` is called for each item which is written to a new index, returns the final index
+	template<size_t D, typename T, typename TLess, typename TMoved>
+	inline static size_t
+	_heap_sift_up(T* items, size_t index, TLess&& less, TMoved&& moved)
+	{
+		T value = items[index];
+		while (index > 0)
+		{
+			auto parent = (index - 1) / D;
+			if (less(value, items[parent]) == false)
+				break;
+			items[index] = items[parent];
+			moved(index);
+			index = parent;
+		}
+		items[index] = value;
+		moved(index);
+		return index;
+	}
+
+	// moves the item at the given index down the d-ary heap until none of its children are less than it, the given
+	// moved function `moved(size_t index)` is called for each item which is written to a new index, returns the final
+	// index
+	template<size_t D, typename T, typename TLess, typename TMoved>
+	inline static size_t
+	_heap_sift_down(T* items, size_t count, size_t index, TLess&& less, TMoved&& moved)
+	{
+		T value = items[index];
+		while (true)
+		{
+			auto first_child = index * D + 1;
+			if (first_child >= count)
+				break;
+
+			// the D children are adjacent in memory, with D = 4 and small items they share a single cache line
+			auto last_child = first_child + D < count ? first_child + D : count;
+			auto min_child = first_child;
+			for (auto child = first_child + 1; child < last_child; ++child)
+				if (less(items[child], items[min_child]))
+					min_child = child;
+
+			if (less(items[min_child], value) == false)
+				break;
+			items[index] = items[min_child];
+			moved(index);
+			index = min_child;
+		}
+		items[index] = value;
+		moved(index);
+		return index;
+	}
+
+	// rearranges the given items into a d-ary min heap (according to TLess) in O(n)
+	template<size_t D = 4, typename T, typename TLess = Less<T>>
+	inline static void
+	heapify(T* items, size_t count, TLess less = TLess())
+	{
+		static_assert(D >= 2, "heap arity should be at least 2");
+		if (count < 2)
+			return;
+		auto i = (count - 2) / D + 1;
+		while (i-- > 0)
+			_heap_sift_down<D>(items, count, i, less, [](size_t) {});
+	}
+
+	// a d-ary min heap (according to TLess) which is stored in a buf, the top is the least item, the default arity of 4
+	// makes the heap shallower than a binary heap and puts the siblings in the same cache line, which makes pop faster
+	// for the usual small items
+	template<typename T, typename TLess = Less<T>, size_t D = 4>
+	struct Heap
+	{
+		static_assert(D >= 2, "heap arity should be at least 2");
+
+		Buf<T> items;
+	};
+
+	// creates a new heap
+	template<typename T, typename TLess = Less<T>, size_t D = 4>
+	inline static Heap<T, TLess, D>
+	heap_new()
+	{
+		Heap<T, TLess, D> self{};
+		self.items = buf_new<T>();
+		return self;
+	}
+
+	// creates a new heap with the given allocator
+	template<typename T, typename TLess = Less<T>, size_t D = 4>
+	inline static Heap<T, TLess, D>
+	heap_with_allocator(Allocator allocator)
+	{
+		Heap<T, TLess, D> self{};
+		self.items = buf_with_allocator<T>(allocator);
+		return self;
+	}
+
+	// creates a new heap which takes ownership of the given buf and heapifies it in place in O(n)
+	template<typename T, typename TLess = Less<T>, size_t D = 4>
+	inline static Heap<T, TLess, D>
+	heap_from_buf(Buf<T>& items)
+	{
+		Heap<T, TLess, D> self{};
+		self.items = items;
+		items = Buf<T>{};
+		heapify<D>(self.items.ptr, self.items.count, TLess());
+		return self;
+	}
+
+	// frees the given heap
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	heap_free(Heap<T, TLess, D>& self)
+	{
+		buf_free(self.items);
+	}
+
+	// destruct overload for heap free, it destructs the items as well
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	destruct(Heap<T, TLess, D>& self)
+	{
+		destruct(self.items);
+	}
+
+	// clones the given heap using the given allocator
+	template<typename T, typename TLess, size_t D>
+	inline static Heap<T, TLess, D>
+	heap_clone(const Heap<T, TLess, D>& other, Allocator allocator = allocator_top())
+	{
+		Heap<T, TLess, D> self{};
+		self.items = buf_with_allocator<T>(allocator);
+		buf_resize(self.items, other.items.count);
+		for (size_t i = 0; i < other.items.count; ++i)
+			self.items[i] = clone(other.items[i]);
+		return self;
+	}
+
+	// clone overload for heap
+	template<typename T, typename TLess, size_t D>
+	inline static Heap<T, TLess, D>
+	clone(const Heap<T, TLess, D>& other)
+	{
+		return heap_clone(other);
+	}
+
+	// returns the count of the items in the given heap
+	template<typename T, typename TLess, size_t D>
+	inline static size_t
+	heap_count(const Heap<T, TLess, D>& self)
+	{
+		return self.items.count;
+	}
+
+	// returns whether the given heap is empty
+	template<typename T, typename TLess, size_t D>
+	inline static bool
+	heap_empty(const Heap<T, TLess, D>& self)
+	{
+		return self.items.count == 0;
+	}
+
+	// ensures that the given heap has the capacity for the given added count of items
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	heap_reserve(Heap<T, TLess, D>& self, size_t added_count)
+	{
+		buf_reserve(self.items, added_count);
+	}
+
+	// clears the given heap, it keeps its memory
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	heap_clear(Heap<T, TLess, D>& self)
+	{
+		buf_clear(self.items);
+	}
+
+	// pushes the given item into the heap in O(log n)
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	heap_push(Heap<T, TLess, D>& self, const T& v)
+	{
+		buf_push(self.items, v);
+		_heap_sift_up<D>(self.items.ptr, self.items.count - 1, TLess(), [](size_t) {});
+	}
+
+	// returns the least item in the given heap
+	template<typename T, typename TLess, size_t D>
+	inline static const T&
+	heap_top(const Heap<T, TLess, D>& self)
+	{
+		mn_assert(self.items.count > 0);
+		return self.items[0];
+	}
+
+	// removes and returns the least item in the given heap in O(log n)
+	template<typename T, typename TLess, size_t D>
+	inline static T
+	heap_pop(Heap<T, TLess, D>& self)
+	{
+		mn_assert(self.items.count > 0);
+		T top = self.items[0];
+		self.items[0] = buf_top(self.items);
+		buf_pop(self.items);
+		if (self.items.count > 1)
+			_heap_sift_down<D>(self.items.ptr, self.items.count, 0, TLess(), [](size_t) {});
+		return top;
+	}
+
+	// indexed heap item, it stores the map index of the item to be able to update its position when it moves
+	template<typename T>
+	struct Indexed_Heap_Item
+	{
+		T value;
+		uint32_t map_index;
+	};
+
+	// an indexed d-ary min heap (priority queue) which hands out handles to the pushed items, the handles can be used
+	// to update the priority of an item (ex. decrease key in Dijkstra's algorithm) or remove it in O(log n), the handles
+	// have the same format and generation check as the Handle_Table handles
+	template<typename T, typename TLess = Less<T>, size_t D = 4>
+	struct Indexed_Heap
+	{
+		static_assert(D >= 2, "heap arity should be at least 2");
+
+		Buf<Indexed_Heap_Item<T>> items;
+		// maps the handle index to the item's position in the heap
+		Buf<Handle_Table_Entry> _map;
+		// used to index the index free list in the map
+		uint32_t _free_list_head;
+	};
+
+	// creates a new indexed heap with the given allocator
+	template<typename T, typename TLess = Less<T>, size_t D = 4>
+	inline static Indexed_Heap<T, TLess, D>
+	indexed_heap_with_allocator(Allocator allocator)
+	{
+		Indexed_Heap<T, TLess, D> self{};
+		self.items = buf_with_allocator<Indexed_Heap_Item<T>>(allocator);
+		self._map = buf_with_allocator<Handle_Table_Entry>(allocator);
+		self._free_list_head = UINT32_MAX;
+		return self;
+	}
+
+	// creates a new indexed heap
+	template<typename T, typename TLess = Less<T>, size_t D = 4>
+	inline static Indexed_Heap<T, TLess, D>
+	indexed_heap_new()
+	{
+		return indexed_heap_with_allocator<T, TLess, D>(allocator_top());
+	}
+
+	// frees the given indexed heap
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	indexed_heap_free(Indexed_Heap<T, TLess, D>& self)
+	{
+		buf_free(self.items);
+		buf_free(self._map);
+	}
+
+	// destruct overload for indexed heap free, it destructs the items as well
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	destruct(Indexed_Heap<T, TLess, D>& self)
+	{
+		for (auto& item: self.items)
+			destruct(item.value);
+		indexed_heap_free(self);
+	}
+
+	// returns the count of the items in the given indexed heap
+	template<typename T, typename TLess, size_t D>
+	inline static size_t
+	indexed_heap_count(const Indexed_Heap<T, TLess, D>& self)
+	{
+		return self.items.count;
+	}
+
+	// returns whether the given indexed heap is empty
+	template<typename T, typename TLess, size_t D>
+	inline static bool
+	indexed_heap_empty(const Indexed_Heap<T, TLess, D>& self)
+	{
+		return self.items.count == 0;
+	}
+
+	template<typename T, typename TLess, size_t D>
+	inline static size_t
+	_indexed_heap_sift_up(Indexed_Heap<T, TLess, D>& self, size_t index)
+	{
+		return _heap_sift_up<D>(
+			self.items.ptr,
+			index,
+			[](const Indexed_Heap_Item<T>& a, const Indexed_Heap_Item<T>& b) { return TLess()(a.value, b.value); },
+			[&](size_t i) { self._map[self.items[i].map_index].items_index = uint32_t(i); }
+		);
+	}
+
+	template<typename T, typename TLess, size_t D>
+	inline static size_t
+	_indexed_heap_sift_down(Indexed_Heap<T, TLess, D>& self, size_t index)
+	{
+		return _heap_sift_down<D>(
+			self.items.ptr,
+			self.items.count,
+			index,
+			[](const Indexed_Heap_Item<T>& a, const Indexed_Heap_Item<T>& b) { return TLess()(a.value, b.value); },
+			[&](size_t i) { self._map[self.items[i].map_index].items_index = uint32_t(i); }
+		);
+	}
+
+	// returns the heap position of the item associated with the given handle, or UINT32_MAX if it doesn't exist
+	template<typename T, typename TLess, size_t D>
+	inline static uint32_t
+	_indexed_heap_position(const Indexed_Heap<T, TLess, D>& self, uint64_t handle)
+	{
+		auto h = handle_table_index_from_uint64(handle);
+		if (h.index >= self._map.count || self._map[h.index].generation != h.generation)
+			return UINT32_MAX;
+		return self._map[h.index].items_index;
+	}
+
+	// pushes the given item into the indexed heap in O(log n) and returns its handle
+	template<typename T, typename TLess, size_t D>
+	inline static uint64_t
+	indexed_heap_push(Indexed_Heap<T, TLess, D>& self, const T& v)
+	{
+		auto h = _handle_table_map_acquire(self._map, self._free_list_head, uint32_t(self.items.count));
+		buf_push(self.items, Indexed_Heap_Item<T>{v, h.index});
+		_indexed_heap_sift_up(self, self.items.count - 1);
+		return handle_table_index_to_uint64(h);
+	}
+
+	// checks whether the item associated with the given handle is still in the indexed heap
+	template<typename T, typename TLess, size_t D>
+	inline static bool
+	indexed_heap_exists(const Indexed_Heap<T, TLess, D>& self, uint64_t handle)
+	{
+		return _indexed_heap_position(self, handle) != UINT32_MAX;
+	}
+
+	// returns the item associated with the given handle
+	template<typename T, typename TLess, size_t D>
+	inline static const T&
+	indexed_heap_get(const Indexed_Heap<T, TLess, D>& self, uint64_t handle)
+	{
+		auto position = _indexed_heap_position(self, handle);
+		mn_assert(position != UINT32_MAX);
+		return self.items[position].value;
+	}
+
+	// returns the least item in the given indexed heap
+	template<typename T, typename TLess, size_t D>
+	inline static const T&
+	indexed_heap_top(const Indexed_Heap<T, TLess, D>& self)
+	{
+		mn_assert(self.items.count > 0);
+		return self.items[0].value;
+	}
+
+	// returns the handle of the least item in the given indexed heap
+	template<typename T, typename TLess, size_t D>
+	inline static uint64_t
+	indexed_heap_top_handle(const Indexed_Heap<T, TLess, D>& self)
+	{
+		mn_assert(self.items.count > 0);
+		auto map_index = self.items[0].map_index;
+		return handle_table_index_to_uint64(Handle_Table_Index{self._map[map_index].generation, map_index});
+	}
+
+	// removes the item associated with the given handle from the indexed heap in O(log n) and returns it
+	template<typename T, typename TLess, size_t D>
+	inline static T
+	indexed_heap_remove(Indexed_Heap<T, TLess, D>& self, uint64_t handle)
+	{
+		auto position = _handle_table_map_release(self._map, self._free_list_head, handle_table_index_from_uint64(handle));
+		mn_assert(position != UINT32_MAX);
+
+		T value = self.items[position].value;
+		auto last = buf_top(self.items);
+		buf_pop(self.items);
+		if (position < self.items.count)
+		{
+			// the last item replaces the removed one, and it can go either up or down from there
+			self.items[position] = last;
+			if (_indexed_heap_sift_up(self, position) == position)
+				_indexed_heap_sift_down(self, position);
+		}
+		return value;
+	}
+
+	// removes and returns the least item in the given indexed heap in O(log n)
+	template<typename T, typename TLess, size_t D>
+	inline static T
+	indexed_heap_pop(Indexed_Heap<T, TLess, D>& self)
+	{
+		return indexed_heap_remove(self, indexed_heap_top_handle(self));
+	}
+
+	// updates the item associated with the given handle and restores the heap order in O(log n), the new item can be
+	// less (decrease key) or greater than the old one
+	template<typename T, typename TLess, size_t D>
+	inline static void
+	indexed_heap_update(Indexed_Heap<T, TLess, D>& self, uint64_t handle, const T& v)
+	{
+		auto position = _indexed_heap_position(self, handle);
+		mn_assert(position != UINT32_MAX);
+
+		bool decreased = TLess()(v, self.items[position].value);
+		self.items[position].value = v;
+		if (decreased)
+			_indexed_heap_sift_up(self, position);
+		else
+			_indexed_heap_sift_down(self, position);
+	}
+}
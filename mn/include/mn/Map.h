@@ -5,6 +5,16 @@
 #include "mn/Buf.h"
 #include "mn/Assert.h"
 
+#include <string.h>
+
+#if ARCH_X86
+#include <emmintrin.h>
+#endif
+
+#if MN_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
 namespace mn
 {
 	// a key value pair, used in hash map implementation
@@ -206,6 +216,129 @@ namespace mn
 		return murmur_hash(block.ptr, block.size, seed);
 	}
 
+	// multiplies two 64-bit numbers into a 128-bit result and returns it in the given low and high parts
+	inline static void
+	_hash_mul128(uint64_t& lo, uint64_t& hi)
+	{
+	#if defined(__SIZEOF_INT128__)
+		__uint128_t r = __uint128_t(lo) * hi;
+		lo = uint64_t(r);
+		hi = uint64_t(r >> 64);
+	#elif MN_COMPILER_MSVC && defined(_M_X64)
+		lo = _umul128(lo, hi, &hi);
+	#else
+		uint64_t ha = lo >> 32, hb = hi >> 32, la = uint32_t(lo), lb = uint32_t(hi);
+		uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+		uint64_t t = rl + (rm0 << 32);
+		uint64_t c = t < rl;
+		lo = t + (rm1 << 32);
+		c += lo < t;
+		hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+	#endif
+	}
+
+	// folds the 128-bit product of the two numbers into 64-bit
+	inline static uint64_t
+	_hash_mix(uint64_t a, uint64_t b)
+	{
+		_hash_mul128(a, b);
+		return a ^ b;
+	}
+
+	inline static uint64_t
+	_hash_read8(const uint8_t* p)
+	{
+		uint64_t v;
+		::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline static uint64_t
+	_hash_read4(const uint8_t* p)
+	{
+		uint32_t v;
+		::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	// hashes a block of bytes using wyhash algorithm, it consumes 48 bytes per iteration in 3 independent lanes
+	// and loads short keys (<= 16 bytes) with at most 4 overlapping reads without any per byte loop, which makes it
+	// much faster than murmur hash for both short keys (identifiers, json keys) and large blocks
+	// note that the result is the same on all machines with the same endianness, so it's safe to persist it
+	inline static size_t
+	hash_bytes(const void* ptr, size_t len, size_t seed = 0)
+	{
+		constexpr uint64_t SECRET[4] = {
+			0xa0761d6478bd642fULL,
+			0xe7037ed1a0b428dbULL,
+			0x8ebc6af09c88c6dbULL,
+			0x589965cc75374cc3ULL,
+		};
+
+		auto p = (const uint8_t*)ptr;
+		uint64_t s = uint64_t(seed);
+		s ^= _hash_mix(s ^ SECRET[0], SECRET[1]);
+
+		uint64_t a = 0, b = 0;
+		if (len <= 16)
+		{
+			if (len >= 4)
+			{
+				auto offset = (len >> 3) << 2;
+				a = (_hash_read4(p) << 32) | _hash_read4(p + offset);
+				b = (_hash_read4(p + len - 4) << 32) | _hash_read4(p + len - 4 - offset);
+			}
+			else if (len > 0)
+			{
+				a = (uint64_t(p[0]) << 16) | (uint64_t(p[len >> 1]) << 8) | uint64_t(p[len - 1]);
+			}
+		}
+		else
+		{
+			size_t i = len;
+			if (i > 48)
+			{
+				uint64_t s1 = s, s2 = s;
+				do
+				{
+					s = _hash_mix(_hash_read8(p) ^ SECRET[1], _hash_read8(p + 8) ^ s);
+					s1 = _hash_mix(_hash_read8(p + 16) ^ SECRET[2], _hash_read8(p + 24) ^ s1);
+					s2 = _hash_mix(_hash_read8(p + 32) ^ SECRET[3], _hash_read8(p + 40) ^ s2);
+					p += 48;
+					i -= 48;
+				} while (i > 48);
+				s ^= s1 ^ s2;
+			}
+
+			while (i > 16)
+			{
+				s = _hash_mix(_hash_read8(p) ^ SECRET[1], _hash_read8(p + 8) ^ s);
+				p += 16;
+				i -= 16;
+			}
+
+			a = _hash_read8(p + i - 16);
+			b = _hash_read8(p + i - 8);
+		}
+
+		a ^= SECRET[1];
+		b ^= s;
+		_hash_mul128(a, b);
+		return size_t(_hash_mix(a ^ SECRET[0] ^ len, b ^ SECRET[1]));
+	}
+
+	// hashes a block of bytes using wyhash algorithm
+	inline static size_t
+	hash_bytes(const Block& block, size_t seed = 0)
+	{
+		return hash_bytes(block.ptr, block.size, seed);
+	}
+
+	// returns a random seed which is generated once per process, use it with hash_bytes to make the hash values
+	// unpredictable to protect hash maps with untrusted keys against hash flooding attacks
+	MN_EXPORT size_t
+	hash_seed();
+
 	// hash specialization for float values
 	template<>
 	struct Hash<float>
@@ -213,7 +346,7 @@ namespace mn
 		inline size_t
 		operator()(float value) const
 		{
-			return value != 0.0f ? murmur_hash(&value, sizeof(float)) : 0;
+			return value != 0.0f ? hash_bytes(&value, sizeof(float)) : 0;
 		}
 	};
 
@@ -224,7 +357,7 @@ namespace mn
 		inline size_t
 		operator()(double value) const
 		{
-			return value != 0.0f ? murmur_hash(&value, sizeof(double)) : 0;
+			return value != 0.0f ? hash_bytes(&value, sizeof(double)) : 0;
 		}
 	};
 
@@ -250,8 +383,42 @@ namespace mn
 			THash hasher;
 			return hasher(val.key);
 		}
+
+		// hashes a lookup probe which is equivalent to a key (ex. const char* for Str keys), used in the
+		// heterogeneous lookup functions like map_lookup_as
+		template<typename TProbe>
+		inline size_t
+		operator()(const TProbe& probe) const
+		{
+			THash hasher;
+			return hasher(probe);
+		}
 	};
 
+	// compares a stored value with a lookup probe, it's used by the hash table to support heterogeneous lookup
+	template<typename T, typename TProbe>
+	inline static bool
+	_hash_probe_equal(const T& value, const TProbe& probe)
+	{
+		return value == probe;
+	}
+
+	// compares a stored key value with a lookup probe of the key
+	template<typename TKey, typename TValue, typename TProbe>
+	inline static bool
+	_hash_probe_equal(const Key_Value<TKey, TValue>& value, const TProbe& probe)
+	{
+		return value.key == probe;
+	}
+
+	// compares two key values
+	template<typename TKey, typename TValue>
+	inline static bool
+	_hash_probe_equal(const Key_Value<TKey, TValue>& value, const Key_Value<TKey, TValue>& probe)
+	{
+		return value == probe;
+	}
+
 	// mixes two hash values together
 	inline static size_t
 	hash_mix(size_t a, size_t b)
@@ -270,77 +437,93 @@ namespace mn
 	}
 
 
-	// hash table slot flags
-	enum HASH_FLAGS: uint8_t { HASH_EMPTY, HASH_USED, HASH_DELETED };
-
-	// hash table slot with the index and hash
-	struct Hash_Slot
+	// hash table control byte values, used slots store the 7 lower bits of the mixed hash, so the
+	// most significant bit is only set for the empty and deleted slots
+	enum HASH_CTRL: uint8_t
 	{
-		// most signficant 2 bits = HASH_FLAGS enum
-		// remaining bits = index
-		size_t index;
-		size_t hash;
+		HASH_CTRL_EMPTY = 0x80,
+		HASH_CTRL_DELETED = 0xFE,
 	};
 
-	// returns the flags of the given hash slot
-	inline static HASH_FLAGS
-	hash_slot_flags(Hash_Slot s)
-	{
-		if constexpr (sizeof(size_t) == 8)
-			return HASH_FLAGS((s.index & 0xC000000000000000) >> 62);
-		else if constexpr (sizeof(size_t) == 4)
-			return HASH_FLAGS((s.index & 0xC0000000) >> 30);
-	}
+	// hash table control bytes are scanned in groups of this size (one SSE2 register)
+	constexpr size_t HASH_GROUP_SIZE = 16;
 
-	// returns the index of the given hash slot
+	// mixes the bits of the given hash, since a lot of our hash functions are identity functions (ints and pointers)
+	// and the table uses the hash bits directly to select the group and the control byte
 	inline static size_t
-	hash_slot_index(Hash_Slot s)
-	{
-		if constexpr (sizeof(size_t) == 8)
-			return size_t(s.index & 0x3FFFFFFFFFFFFFFF);
-		else if constexpr (sizeof(size_t) == 4)
-			return size_t(s.index & 0x3FFFFFFF);
-	}
-
-	// sets the flags of the given hash slot
-	inline static Hash_Slot
-	hash_slot_set_flags(Hash_Slot s, HASH_FLAGS f)
+	_hash_ctrl_mix(size_t h)
 	{
 		if constexpr (sizeof(size_t) == 8)
 		{
-			s.index &= ~0xC000000000000000;
-			s.index |= (size_t(f) << 62);
+			h ^= h >> 32;
+			h *= 0x9E3779B97F4A7C15;
+			h ^= h >> 29;
+			return h;
 		}
 		else if constexpr (sizeof(size_t) == 4)
 		{
-			s.index &= ~0xC0000000;
-			s.index |= (size_t(f) << 30);
+			h ^= h >> 16;
+			h *= 0x85EBCA6B;
+			h ^= h >> 13;
+			return h;
 		}
-		return s;
 	}
 
-	// sets the index of the given hash slot
-	inline static Hash_Slot
-	hash_slot_set_index(Hash_Slot s, size_t index)
+	// returns the index of the lowest set bit in the given non zero mask
+	inline static uint32_t
+	_hash_mask_lowest_bit(uint32_t mask)
 	{
-		if constexpr (sizeof(size_t) == 8)
-		{
-			s.index &= ~0x3FFFFFFFFFFFFFFF;
-			s.index |= (size_t(index) & 0x3FFFFFFFFFFFFFFF);
-		}
-		else if constexpr (sizeof(size_t) == 4)
-		{
-			s.index &= ~0x3FFFFFFF;
-			s.index |= (size_t(index) & 0x3FFFFFFF);
-		}
-		return s;
+		#if MN_COMPILER_MSVC
+			unsigned long index = 0;
+			_BitScanForward(&index, mask);
+			return uint32_t(index);
+		#else
+			return uint32_t(__builtin_ctz(mask));
+		#endif
+	}
+
+	// returns a bit mask of the control bytes in the given group which are equal to the given tag
+	inline static uint32_t
+	_hash_group_match(const uint8_t* group, uint8_t tag)
+	{
+		#if ARCH_X86
+			auto ctrl = _mm_loadu_si128((const __m128i*)group);
+			return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(char(tag)))));
+		#else
+			uint32_t res = 0;
+			for (size_t i = 0; i < HASH_GROUP_SIZE; ++i)
+				if (group[i] == tag)
+					res |= (1U << i);
+			return res;
+		#endif
+	}
+
+	// returns a bit mask of the empty or deleted control bytes in the given group
+	inline static uint32_t
+	_hash_group_match_empty_or_deleted(const uint8_t* group)
+	{
+		#if ARCH_X86
+			auto ctrl = _mm_loadu_si128((const __m128i*)group);
+			return uint32_t(_mm_movemask_epi8(ctrl));
+		#else
+			uint32_t res = 0;
+			for (size_t i = 0; i < HASH_GROUP_SIZE; ++i)
+				if (group[i] & 0x80)
+					res |= (1U << i);
+			return res;
+		#endif
 	}
 
-	// a hash set
+	// a hash set, the table is a swiss table like layout where each slot has a control byte, control bytes are
+	// scanned 16 at a time to find the candidate slots, each slot is a 32-bit index of the value in the dense values
+	// array which makes iteration as fast as iterating a Buf, the full hashes are kept in a dense array parallel to
+	// the values which is only touched when rehashing and removing so lookups only touch ctrl, slot and value
 	template<typename T, typename THash = Hash<T>>
 	struct Set
 	{
-		Buf<Hash_Slot> _slots;
+		Buf<uint8_t> _ctrl;
+		Buf<uint32_t> _slots;
+		Buf<size_t> _hashes;
 		Buf<T> values;
 		size_t count;
 		size_t _deleted_count;
@@ -355,7 +538,9 @@ namespace mn
 	set_new()
 	{
 		Set<T, THash> self{};
-		self._slots = buf_new<Hash_Slot>();
+		self._ctrl = buf_new<uint8_t>();
+		self._slots = buf_new<uint32_t>();
+		self._hashes = buf_new<size_t>();
 		self.values = buf_new<T>();
 		return self;
 	}
@@ -366,7 +551,9 @@ namespace mn
 	set_with_allocator(Allocator allocator)
 	{
 		Set<T, THash> self{};
-		self._slots = buf_with_allocator<Hash_Slot>(allocator);
+		self._ctrl = buf_with_allocator<uint8_t>(allocator);
+		self._slots = buf_with_allocator<uint32_t>(allocator);
+		self._hashes = buf_with_allocator<size_t>(allocator);
 		self.values = buf_with_allocator<T>(allocator);
 		return self;
 	}
@@ -376,7 +563,9 @@ namespace mn
 	inline static void
 	set_free(Set<T, THash>& self)
 	{
+		buf_free(self._ctrl);
 		buf_free(self._slots);
+		buf_free(self._hashes);
 		buf_free(self.values);
 		self.count = 0;
 		self._deleted_count = 0;
@@ -387,7 +576,9 @@ namespace mn
 	inline static void
 	destruct(Set<T, THash>& self)
 	{
+		buf_free(self._ctrl);
 		buf_free(self._slots);
+		buf_free(self._hashes);
 		destruct(self.values);
 		self.count = 0;
 		self._deleted_count = 0;
@@ -398,7 +589,8 @@ namespace mn
 	inline static void
 	set_clear(Set<T, THash>& self)
 	{
-		buf_fill(self._slots, Hash_Slot{});
+		buf_fill(self._ctrl, uint8_t(HASH_CTRL_EMPTY));
+		buf_clear(self._hashes);
 		buf_clear(self.values);
 		self.count = 0;
 		self._deleted_count = 0;
@@ -409,7 +601,7 @@ namespace mn
 	inline static size_t
 	set_capacity(Set<T, THash>& self)
 	{
-		return self._slots.count;
+		return self._ctrl.count;
 	}
 
 	struct _Hash_Search_Result
@@ -418,148 +610,191 @@ namespace mn
 		size_t index;
 	};
 
-	template<typename T, typename THash = Hash<T>>
+	// searches for the given key with the given precomputed hash and returns its slot index, if the key doesn't exist
+	// it returns the slot index where it should be inserted (reusing the first deleted slot in the probe sequence), if
+	// the table is full it returns the capacity
+	template<typename T, typename THash, typename TProbe>
 	inline static _Hash_Search_Result
-	_set_find_slot_for_insert(const Buf<Hash_Slot>& _slots, const Buf<T>& values, const T& key, size_t* external_hash)
+	_set_find_slot_for_insert_hashed(const Set<T, THash>& self, const TProbe& key, size_t hash)
 	{
 		_Hash_Search_Result res{};
-		if (external_hash)
-			res.hash = *external_hash;
-		else
-			res.hash = THash()(key);
+		res.hash = hash;
 
-		auto cap = _slots.count;
+		auto cap = self._ctrl.count;
+		res.index = cap;
 		if (cap == 0) return res;
 
-		auto index = res.hash & (cap - 1);
-		auto ix = index;
+		auto mixed_hash = _hash_ctrl_mix(res.hash);
+		auto tag = uint8_t(mixed_hash & 0x7F);
+		auto groups_mask = (cap / HASH_GROUP_SIZE) - 1;
+		auto group_index = (mixed_hash >> 7) & groups_mask;
 
-		size_t first_deleted_slot_index = 0;
-		bool found_first_deleted_slot = false;
+		size_t first_available_slot_index = cap;
 
-		// linear probing
-		while(true)
+		// triangular probing over the groups which visits every group exactly once
+		for (size_t probe = 0; probe <= groups_mask; ++probe)
 		{
-			auto slot = _slots[ix];
-			auto slot_hash = slot.hash;
-			auto slot_index = hash_slot_index(slot);
-			auto slot_flags = hash_slot_flags(slot);
-			switch (slot_flags)
-			{
-			// this position is not empty but if it's the same value then we return it
-			case HASH_FLAGS::HASH_USED:
+			auto base = group_index * HASH_GROUP_SIZE;
+			auto group = self._ctrl.ptr + base;
+
+			auto match = _hash_group_match(group, tag);
+			while (match)
 			{
-				if (slot_hash == res.hash && values[slot_index] == key)
+				auto ix = base + _hash_mask_lowest_bit(match);
+				if (_hash_probe_equal(self.values.ptr[self._slots.ptr[ix]], key))
 				{
 					res.index = ix;
 					return res;
 				}
-				break;
-			}
-			// this is an empty slot then we can use it
-			case HASH_FLAGS::HASH_EMPTY:
-			{
-				// we didn't find the key, so check the first deleted slot if we found one then
-				// reuse it
-				if (found_first_deleted_slot)
-				{
-					res.index = first_deleted_slot_index;
-				}
-				// we didn't find the key, so use the first empty slot
-				else
-				{
-					res.index = ix;
-				}
-				return res;
-				break;
-			}
-			// this is a deleted slot we'll remember it just in case we wanted to resuse it
-			case HASH_FLAGS::HASH_DELETED:
-			{
-				if (found_first_deleted_slot == false)
-				{
-					first_deleted_slot_index = ix;
-					found_first_deleted_slot = true;
-				}
-				break;
-			}
-			default: mn_unreachable(); return _Hash_Search_Result{};
+				match &= match - 1;
 			}
 
-			// the position is not empty and the key is not the same
-			++ix;
-			ix &= (cap - 1);
+			auto available = _hash_group_match_empty_or_deleted(group);
+			if (available && first_available_slot_index == cap)
+				first_available_slot_index = base + _hash_mask_lowest_bit(available);
 
-			// if we went full circle then we just return the cap to signal no index has been found
-			if (ix == index)
-			{
-				ix = cap;
+			// an empty slot ends the probe sequence since the key would've been inserted there
+			if (_hash_group_match(group, HASH_CTRL_EMPTY))
 				break;
-			}
+
+			group_index = (group_index + probe + 1) & groups_mask;
 		}
 
-		res.index = ix;
+		res.index = first_available_slot_index;
 		return res;
 	}
 
-	template<typename T, typename THash = Hash<T>>
+	// searches for the given key and returns its slot index, if the key doesn't exist it returns the slot index
+	// where it should be inserted, if the table is full it returns the capacity
+	template<typename T, typename THash, typename TProbe>
 	inline static _Hash_Search_Result
-	_set_find_slot_for_lookup(const Set<T, THash>& self, const T& key)
+	_set_find_slot_for_insert(const Set<T, THash>& self, const TProbe& key)
+	{
+		return _set_find_slot_for_insert_hashed(self, key, THash()(key));
+	}
+
+	// searches for the given key and returns its slot index, if the key doesn't exist it returns the capacity
+	template<typename T, typename THash, typename TProbe>
+	inline static _Hash_Search_Result
+	_set_find_slot_for_lookup(const Set<T, THash>& self, const TProbe& key)
 	{
 		_Hash_Search_Result res{};
 		res.hash = THash()(key);
 
-		auto cap = self._slots.count;
+		auto cap = self._ctrl.count;
+		res.index = cap;
 		if (cap == 0) return res;
 
-		auto index = res.hash & (cap - 1);
-		auto ix = index;
+		auto mixed_hash = _hash_ctrl_mix(res.hash);
+		auto tag = uint8_t(mixed_hash & 0x7F);
+		auto groups_mask = (cap / HASH_GROUP_SIZE) - 1;
+		auto group_index = (mixed_hash >> 7) & groups_mask;
 
-		// linear probing
-		while(true)
+		for (size_t probe = 0; probe <= groups_mask; ++probe)
 		{
-			auto slot = self._slots[ix];
-			auto slot_hash = slot.hash;
-			auto slot_index = hash_slot_index(slot);
-			auto slot_flags = hash_slot_flags(slot);
+			auto base = group_index * HASH_GROUP_SIZE;
+			auto group = self._ctrl.ptr + base;
 
-			// if the cell is empty then we didn't find the value
-			if (slot_flags == HASH_FLAGS::HASH_EMPTY)
+			auto match = _hash_group_match(group, tag);
+			while (match)
 			{
-				ix = cap;
-				break;
+				auto ix = base + _hash_mask_lowest_bit(match);
+				if (_hash_probe_equal(self.values.ptr[self._slots.ptr[ix]], key))
+				{
+					res.index = ix;
+					return res;
+				}
+				match &= match - 1;
 			}
 
-			// if the cell is used and it's the same value then we found it
-			if (slot_flags == HASH_FLAGS::HASH_USED &&
-				slot_hash == res.hash &&
-				self.values[slot_index] == key)
-			{
+			if (_hash_group_match(group, HASH_CTRL_EMPTY))
 				break;
-			}
 
-			// the position is not used or the key is not the same
-			++ix;
-			ix &= (cap - 1);
+			group_index = (group_index + probe + 1) & groups_mask;
+		}
+
+		return res;
+	}
 
-			// if we went full circle then we just return the cap to signal no index has been found
-			if (ix == index)
+	// finds the slot which points to the given value index, the value should be in the table with the given hash
+	template<typename T, typename THash>
+	inline static size_t
+	_set_find_slot_of_index(const Set<T, THash>& self, size_t hash, size_t index)
+	{
+		auto cap = self._ctrl.count;
+		auto mixed_hash = _hash_ctrl_mix(hash);
+		auto tag = uint8_t(mixed_hash & 0x7F);
+		auto groups_mask = (cap / HASH_GROUP_SIZE) - 1;
+		auto group_index = (mixed_hash >> 7) & groups_mask;
+
+		for (size_t probe = 0; probe <= groups_mask; ++probe)
+		{
+			auto base = group_index * HASH_GROUP_SIZE;
+			auto match = _hash_group_match(self._ctrl.ptr + base, tag);
+			while (match)
 			{
-				ix = cap;
-				break;
+				auto ix = base + _hash_mask_lowest_bit(match);
+				if (self._slots.ptr[ix] == index)
+					return ix;
+				match &= match - 1;
 			}
+			group_index = (group_index + probe + 1) & groups_mask;
+		}
+
+		mn_unreachable();
+		return cap;
+	}
+
+	// finds an empty slot for the given hash, it's used in rehashing where all the keys are known to be unique
+	inline static size_t
+	_hash_find_empty_slot(const Buf<uint8_t>& ctrl, size_t hash)
+	{
+		auto cap = ctrl.count;
+		auto mixed_hash = _hash_ctrl_mix(hash);
+		auto groups_mask = (cap / HASH_GROUP_SIZE) - 1;
+		auto group_index = (mixed_hash >> 7) & groups_mask;
+
+		for (size_t probe = 0; probe <= groups_mask; ++probe)
+		{
+			auto base = group_index * HASH_GROUP_SIZE;
+			auto available = _hash_group_match_empty_or_deleted(ctrl.ptr + base);
+			if (available)
+				return base + _hash_mask_lowest_bit(available);
+			group_index = (group_index + probe + 1) & groups_mask;
 		}
 
-		res.index = ix;
+		mn_unreachable();
+		return cap;
+	}
+
+	// rounds the given count up to the next power of 2
+	inline static size_t
+	_hash_next_power_of_2(size_t x)
+	{
+		size_t res = 1;
+		while (res < x)
+			res <<= 1;
 		return res;
 	}
 
+	// sets the control byte of the given slot to the tag of the given hash
+	inline static void
+	_hash_ctrl_set_used(Buf<uint8_t>& ctrl, size_t ix, size_t hash)
+	{
+		ctrl.ptr[ix] = uint8_t(_hash_ctrl_mix(hash) & 0x7F);
+	}
+
 	template<typename T, typename THash = Hash<T>>
 	inline static void
 	_set_reserve_exact(Set<T, THash>& self, size_t new_count)
 	{
-		auto new_slots = buf_with_allocator<Hash_Slot>(self._slots.allocator);
-		buf_resize_fill(new_slots, new_count, Hash_Slot{});
+		// the capacity should be a power of 2 multiple of the group size
+		new_count = new_count < HASH_GROUP_SIZE ? HASH_GROUP_SIZE : _hash_next_power_of_2(new_count);
+
+		auto new_ctrl = buf_with_allocator<uint8_t>(self._ctrl.allocator);
+		buf_resize_fill(new_ctrl, new_count, uint8_t(HASH_CTRL_EMPTY));
+		auto new_slots = buf_with_allocator<uint32_t>(self._slots.allocator);
+		buf_resize(new_slots, new_count);
 
 		self._deleted_count = 0;
 		// if 12/16th of table is occupied, grow
@@ -569,23 +804,18 @@ namespace mn
 		// if table is only 4/16th full, shrink
 		self._used_count_shrink_threshold = new_count >> 2;
 
-		// do a rehash
-		if (self.count != 0)
+		// do a rehash, we reuse the stored hashes so we don't need to hash the values again
+		for (size_t i = 0; i < self.count; ++i)
 		{
-			for (size_t i = 0; i < self._slots.count; ++i)
-			{
-				auto slot = self._slots[i];
-				auto flags = hash_slot_flags(slot);
-				if (flags == HASH_FLAGS::HASH_USED)
-				{
-					auto index = hash_slot_index(slot);
-					auto res = _set_find_slot_for_insert<T, THash>(new_slots, self.values, self.values[index], &slot.hash);
-					new_slots[res.index] = slot;
-				}
-			}
+			auto hash = self._hashes.ptr[i];
+			auto ix = _hash_find_empty_slot(new_ctrl, hash);
+			_hash_ctrl_set_used(new_ctrl, ix, hash);
+			new_slots.ptr[ix] = uint32_t(i);
 		}
 
+		buf_free(self._ctrl);
 		buf_free(self._slots);
+		self._ctrl = new_ctrl;
 		self._slots = new_slots;
 	}
 
@@ -593,13 +823,13 @@ namespace mn
 	inline static void
 	_set_maintain_space_complexity(Set<T, THash>& self)
 	{
-		if (self._slots.count == 0)
+		if (self._ctrl.count == 0)
 		{
-			_set_reserve_exact(self, 8);
+			_set_reserve_exact(self, HASH_GROUP_SIZE);
 		}
 		else if (self.count + 1 > self._used_count_threshold)
 		{
-			_set_reserve_exact(self, self._slots.count * 2);
+			_set_reserve_exact(self, self._ctrl.count * 2);
 		}
 	}
 
@@ -614,56 +844,57 @@ namespace mn
 		auto new_cap = self.count + added_count;
 		new_cap *= 4;
 		new_cap = new_cap / 3 + 1;
-		if (new_cap > self._used_count_threshold)
+		// only rehash if the table would grow, the capacity is rounded up to a power of 2 so comparing against the
+		// current capacity avoids rehashing into a table of the same size
+		if (new_cap > self._ctrl.count)
 		{
 			_set_reserve_exact(self, new_cap);
 		}
 	}
 
-	// inserts an element into the hash set and returns an iterator to it
+	// inserts an element with the given precomputed hash into the hash set and returns an iterator to it, the hash
+	// should be equal to `THash()(key)`, it's used by the bulk construction functions which compute the hashes ahead
 	template<typename T, typename THash = Hash<T>>
 	inline static const T*
-	set_insert(Set<T, THash>& self, const T& key)
+	set_insert_hashed(Set<T, THash>& self, const T& key, size_t hash)
 	{
 		_set_maintain_space_complexity(self);
 
-		auto res = _set_find_slot_for_insert<T, THash>(self._slots, self.values, key, nullptr);
+		auto res = _set_find_slot_for_insert_hashed(self, key, hash);
+		mn_assert(res.index < self._ctrl.count);
 
-		auto& slot = self._slots[res.index];
-		auto flags = hash_slot_flags(slot);
-		switch(flags)
+		auto& ctrl = self._ctrl.ptr[res.index];
+		auto& slot = self._slots.ptr[res.index];
+		switch(ctrl)
 		{
-		case HASH_FLAGS::HASH_EMPTY:
+		case HASH_CTRL_EMPTY:
+		case HASH_CTRL_DELETED:
 		{
-			slot = hash_slot_set_flags(slot, HASH_FLAGS::HASH_USED);
-			slot = hash_slot_set_index(slot, self.count);
-			slot.hash = res.hash;
+			mn_assert_msg(self.count < UINT32_MAX, "hash table slots use 32-bit indices");
+			if (ctrl == HASH_CTRL_DELETED)
+				--self._deleted_count;
+			_hash_ctrl_set_used(self._ctrl, res.index, res.hash);
+			slot = uint32_t(self.count);
 			++self.count;
+			buf_push(self._hashes, res.hash);
 			return buf_push(self.values, key);
 		}
-		case HASH_FLAGS::HASH_DELETED:
-		{
-			slot = hash_slot_set_flags(slot, HASH_FLAGS::HASH_USED);
-			slot = hash_slot_set_index(slot, self.count);
-			slot.hash = res.hash;
-			++self.count;
-			--self._deleted_count;
-			return buf_push(self.values, key);
-		}
-		case HASH_FLAGS::HASH_USED:
-		{
-			auto index = hash_slot_index(slot);
-			self.values[index] = key;
-			return &self.values[index];
-		}
 		default:
 		{
-			mn_unreachable();
-			return nullptr;
+			self.values[slot] = key;
+			return &self.values[slot];
 		}
 		}
 	}
 
+	// inserts an element into the hash set and returns an iterator to it
+	template<typename T, typename THash = Hash<T>>
+	inline static const T*
+	set_insert(Set<T, THash>& self, const T& key)
+	{
+		return set_insert_hashed(self, key, THash()(key));
+	}
+
 	// searches for the given key in the hash set and returns an iterator to it, if the key doesn't exist it will return
 	// nullptr
 	template<typename T, typename THash = Hash<T>>
@@ -671,50 +902,88 @@ namespace mn
 	set_lookup(const Set<T, THash>& self, const T& key)
 	{
 		auto res = _set_find_slot_for_lookup(self, key);
-		if (res.index == self._slots.count)
+		if (res.index == self._ctrl.count)
+			return nullptr;
+		auto index = self._slots.ptr[res.index];
+		return (const T*)(self.values.ptr + index);
+	}
+
+	// searches for an element which is equal to the given probe and returns an iterator to it, if it doesn't exist it
+	// will return nullptr, the probe can be of any type which the hash functor accepts and which can be compared to the
+	// elements using ==, and it should have the same hash as its equal element, ex. looking up a `Set<Str>` using
+	// a `const char*` or a `Str_View` without allocating a string
+	template<typename T, typename THash, typename TProbe>
+	inline static const T*
+	set_lookup_as(const Set<T, THash>& self, const TProbe& probe)
+	{
+		auto res = _set_find_slot_for_lookup(self, probe);
+		if (res.index == self._ctrl.count)
 			return nullptr;
-		auto& slot = self._slots[res.index];
-		auto index = hash_slot_index(slot);
+		auto index = self._slots.ptr[res.index];
 		return (const T*)(self.values.ptr + index);
 	}
 
+	// searches for an element which is equal to the given probe and returns an iterator to it, if it doesn't exist
+	// it will insert the element returned by `make_value(probe)` which should be equal to the probe, this is useful
+	// to only allocate the element when it's not in the set
+	// ex. `set_insert_if_absent(strings, str_view(begin, end), [&](Str_View v) { return str_from_substr(v.ptr, v.ptr + v.count); })`
+	template<typename T, typename THash, typename TProbe, typename TMake>
+	inline static const T*
+	set_insert_if_absent(Set<T, THash>& self, const TProbe& probe, TMake&& make_value)
+	{
+		_set_maintain_space_complexity(self);
+
+		auto res = _set_find_slot_for_insert(self, probe);
+		mn_assert(res.index < self._ctrl.count);
+
+		auto ctrl = self._ctrl.ptr[res.index];
+		if ((ctrl & 0x80) == 0)
+			return self.values.ptr + self._slots.ptr[res.index];
+
+		mn_assert_msg(self.count < UINT32_MAX, "hash table slots use 32-bit indices");
+		if (ctrl == HASH_CTRL_DELETED)
+			--self._deleted_count;
+		_hash_ctrl_set_used(self._ctrl, res.index, res.hash);
+		self._slots.ptr[res.index] = uint32_t(self.count);
+		++self.count;
+		buf_push(self._hashes, res.hash);
+		return buf_push(self.values, make_value(probe));
+	}
+
 	// remove the given value from the hash set, and returns whether it found and removed the element
 	template<typename T, typename THash = Hash<T>>
 	inline static bool
 	set_remove(Set<T, THash>& self, const T& key)
 	{
 		auto res = _set_find_slot_for_lookup(self, key);
-		if (res.index == self._slots.count)
+		if (res.index == self._ctrl.count)
 			return false;
-		auto& slot = self._slots[res.index];
-		auto index = hash_slot_index(slot);
-		slot = hash_slot_set_flags(slot, HASH_FLAGS::HASH_DELETED);
+		size_t index = self._slots.ptr[res.index];
+		self._ctrl.ptr[res.index] = HASH_CTRL_DELETED;
 
-		if (index == self.count - 1)
-		{
-			buf_remove(self.values, index);
-		}
-		else
+		// fixup the index of the last element after swap, the slot is found using the stored hash so the
+		// last element isn't compared against other elements
+		if (index != self.count - 1)
 		{
-			// fixup the index of the last element after swap
-			auto last_res = _set_find_slot_for_lookup(self, self.values[self.count - 1]);
-			self._slots[last_res.index] = hash_slot_set_index(self._slots[last_res.index], index);
-			buf_remove(self.values, index);
+			auto last_slot = _set_find_slot_of_index(self, self._hashes.ptr[self.count - 1], self.count - 1);
+			self._slots.ptr[last_slot] = uint32_t(index);
 		}
+		buf_remove(self._hashes, index);
+		buf_remove(self.values, index);
 
 		--self.count;
 		++self._deleted_count;
 
 		// rehash because of size is too low
-		if (self.count < self._used_count_shrink_threshold && self._slots.count > 8)
+		if (self.count < self._used_count_shrink_threshold && self._ctrl.count > HASH_GROUP_SIZE)
 		{
-			_set_reserve_exact(self, self._slots.count >> 1);
+			_set_reserve_exact(self, self._ctrl.count >> 1);
 			buf_shrink_to_fit(self.values);
 		}
 		// rehash because of too many deleted values
 		else if (self._deleted_count > self._deleted_count_threshold)
 		{
-			_set_reserve_exact(self, self._slots.count);
+			_set_reserve_exact(self, self._ctrl.count);
 		}
 		return true;
 	}
@@ -725,7 +994,9 @@ namespace mn
 	set_clone(const Set<T, THash>& other, Allocator allocator = allocator_top())
 	{
 		Set<T, THash> self = other;
+		self._ctrl = buf_memcpy_clone(other._ctrl, allocator);
 		self._slots = buf_memcpy_clone(other._slots, allocator);
+		self._hashes = buf_memcpy_clone(other._hashes, allocator);
 		self.values = buf_clone(other.values, allocator);
 		return self;
 	}
@@ -737,7 +1008,9 @@ namespace mn
 	set_memcpy_clone(const Set<T, THash>& other, Allocator allocator = allocator_top())
 	{
 		Set<T, THash> self = other;
+		self._ctrl = buf_memcpy_clone(other._ctrl, allocator);
 		self._slots = buf_memcpy_clone(other._slots, allocator);
+		self._hashes = buf_memcpy_clone(other._hashes, allocator);
 		self.values = buf_memcpy_clone(other.values, allocator);
 		return self;
 	}
@@ -858,6 +1131,35 @@ namespace mn
 		return (Key_Value<const TKey, TValue>*)set_lookup(self, Key_Value<TKey, TValue>{key, {}});
 	}
 
+	// searches for a key which is equal to the given probe, if it doesn't exist it will return nullptr, the probe can be
+	// of any type which the key hash functor accepts and which can be compared to the keys using ==, and it should have
+	// the same hash as its equal key, ex. looking up a `Map<Str, V>` using a `const char*` or a `Str_View`
+	template<typename TKey, typename TValue, typename THash, typename TProbe>
+	inline static Key_Value<const TKey, TValue>*
+	map_lookup_as(Map<TKey, TValue, THash>& self, const TProbe& probe)
+	{
+		return (Key_Value<const TKey, TValue>*)set_lookup_as(self, probe);
+	}
+
+	// searches for a key which is equal to the given probe, if it doesn't exist it will return nullptr
+	template<typename TKey, typename TValue, typename THash, typename TProbe>
+	inline static const Key_Value<const TKey, TValue>*
+	map_lookup_as(const Map<TKey, TValue, THash>& self, const TProbe& probe)
+	{
+		return (const Key_Value<const TKey, TValue>*)set_lookup_as(self, probe);
+	}
+
+	// searches for a key which is equal to the given probe, if it doesn't exist it will insert the key returned by
+	// `make_key(probe)` with a zero/empty value, which is useful to only allocate the key when it's not in the map
+	template<typename TKey, typename TValue, typename THash, typename TProbe, typename TMake>
+	inline static Key_Value<const TKey, TValue>*
+	map_insert_if_absent(Map<TKey, TValue, THash>& self, const TProbe& probe, TMake&& make_key)
+	{
+		return (Key_Value<const TKey, TValue>*)set_insert_if_absent(self, probe, [&](const TProbe& p) {
+			return Key_Value<TKey, TValue>{make_key(p), TValue{}};
+		});
+	}
+
 	// remove the given value from the hash map, and returns whether it found and removed the element
 	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
 	inline static bool
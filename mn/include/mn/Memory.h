@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <utility>
+#include <initializer_list>
 #include <new>
 #include <string.h>
 
@@ -159,12 +160,12 @@ namespace mn
 		return alloc_construct<memory::Arena>(block_size, meta);
 	}
 
-	// creates a new buddy allocator with the given heap size and meta allocator
+	// creates a new buddy allocator with the given heap size, meta allocator, and flags (combination of BUDDY_FLAGS)
 	// read more about buddy allocator in Buddy.h
 	inline static memory::Buddy*
-	allocator_buddy_new(size_t heap_size = 1ULL * 1024ULL * 1024ULL, Allocator meta = memory::virtual_mem())
+	allocator_buddy_new(size_t heap_size = 1ULL * 1024ULL * 1024ULL, Allocator meta = memory::virtual_mem(), uint32_t flags = memory::BUDDY_FLAGS_NONE)
 	{
-		return alloc_construct<memory::Buddy>(heap_size, meta);
+		return alloc_construct<memory::Buddy>(heap_size, meta, flags);
 	}
 
 	// frees the given allocator
@@ -192,4 +193,67 @@ namespace mn
 		::memcpy(self.ptr, other.ptr, other.size);
 		return self;
 	}
+
+	// a scoped scratch arena, it's restored to its checkpoint when it goes out of scope (or when scratch_end is called)
+	// ex.
+	// ```C++
+	// Str
+	// func(Allocator allocator)
+	// {
+	// 	auto scratch = mn::scratch_begin({allocator});
+	// 	auto parts = mn::buf_with_allocator<Str>(scratch.arena);
+	// 	...
+	// 	return result_allocated_using(allocator);
+	// }
+	// ```
+	struct Scratch
+	{
+		memory::Arena* arena;
+		memory::Arena::State checkpoint;
+
+		Scratch(memory::Arena* arena_, memory::Arena::State checkpoint_)
+			: arena(arena_),
+			  checkpoint(checkpoint_)
+		{}
+
+		Scratch(const Scratch&) = delete;
+
+		Scratch(Scratch&& other)
+			: arena(other.arena),
+			  checkpoint(other.checkpoint)
+		{
+			other.arena = nullptr;
+		}
+
+		Scratch&
+		operator=(const Scratch&) = delete;
+
+		Scratch&
+		operator=(Scratch&&) = delete;
+
+		~Scratch()
+		{
+			if (arena)
+				arena->restore(checkpoint);
+		}
+	};
+
+	// starts a scratch scope using one of the current thread's scratch arenas which is not in the conflicts list
+	// you should pass the allocators which the calling function receives, since they might be scratch arenas of an outer
+	// scope and allocating from the same arena would overwrite their memory when this scope is restored
+	inline static Scratch
+	scratch_begin(std::initializer_list<Allocator> conflicts = {})
+	{
+		auto arena = memory::scratch(conflicts.begin(), conflicts.size());
+		return Scratch{arena, arena->checkpoint()};
+	}
+
+	// ends the given scratch scope early, restoring its arena back to the checkpoint
+	inline static void
+	scratch_end(Scratch& self)
+	{
+		if (self.arena)
+			self.arena->restore(self.checkpoint);
+		self.arena = nullptr;
+	}
 }
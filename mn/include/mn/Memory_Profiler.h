@@ -0,0 +1,62 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Context.h"
+#include "mn/Stream.h"
+
+#include <stddef.h>
+
+namespace mn
+{
+	// a low overhead sampling heap profiler which is fed by the memory profiling hooks
+	// it samples allocations using a poisson process over the allocated bytes (on average one sample every
+	// sample_rate bytes), captures the callstack of the sampled allocations only, and aggregates the live
+	// samples by their call site, frees are checked against a lock free table of the sampled pointers so
+	// non sampled allocations and frees never take a lock, which makes it cheap enough to leave on in production
+	typedef struct IMemory_Profiler* Memory_Profiler;
+
+	// sampled memory statistics, note that these are raw sample numbers and not estimates of the actual heap
+	struct Memory_Profiler_Stats
+	{
+		// count of the currently live sampled allocations
+		size_t live_count;
+		// size in bytes of the currently live sampled allocations
+		size_t live_size;
+		// count of all the sampled allocations since the profiler was created
+		size_t total_count;
+		// size in bytes of all the sampled allocations since the profiler was created
+		size_t total_size;
+		// count of the samples which were dropped because the sample table was full
+		size_t dropped_count;
+	};
+
+	// creates a new sampling heap profiler with the given average sampling rate in bytes
+	MN_EXPORT Memory_Profiler
+	memory_profiler_new(size_t sample_rate = 512ULL * 1024ULL);
+
+	// frees the given memory profiler, make sure it's not installed as the memory profile interface anymore
+	MN_EXPORT void
+	memory_profiler_free(Memory_Profiler self);
+
+	// destruct overload for memory profiler free
+	inline static void
+	destruct(Memory_Profiler self)
+	{
+		memory_profiler_free(self);
+	}
+
+	// returns a memory profile interface which feeds the given profiler, you can install it using
+	// memory_profile_interface_set
+	MN_EXPORT Memory_Profile_Interface
+	memory_profiler_interface(Memory_Profiler self);
+
+	// returns the sampled memory statistics of the given profiler
+	MN_EXPORT Memory_Profiler_Stats
+	memory_profiler_stats(Memory_Profiler self);
+
+	// writes the live samples aggregated by call site to the given stream in the legacy pprof heap profile
+	// text format (heap_v2), the sampling rate is embedded in the header so that pprof can unsample the numbers
+	// ex. `pprof --text ./my_program heap.prof`
+	MN_EXPORT void
+	memory_profiler_report(Memory_Profiler self, Stream out);
+}
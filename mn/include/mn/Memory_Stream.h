@@ -9,6 +9,9 @@ namespace mn
 	// an in memory byte stream
 	typedef struct IMemory_Stream* Memory_Stream;
 
+	// memory pool handle, check mn/Pool.h
+	typedef struct IPool* Pool;
+
 	// some forward declaration because this language require this kind of thing
 
 	MN_EXPORT void
@@ -22,6 +25,13 @@ namespace mn
 		Str str;
 		int64_t cursor;
 
+		// chunked mode, the content lives in fixed size chunks taken from chunk_pool instead of str, the chunks
+		// array only holds pointers to the chunks so growing the stream never copies the already written bytes
+		Pool chunk_pool;
+		Buf<char*> chunks;
+		size_t chunk_size;
+		size_t chunked_count;
+
 		MN_EXPORT virtual void
 		dispose() override;
 
@@ -51,7 +61,7 @@ namespace mn
 				this->cursor = 0;
 				return 0;
 			case STREAM_CURSOR_END:
-				this->cursor = this->str.count;
+				this->cursor = this->size();
 				return this->cursor;
 			default:
 				mn_unreachable();
@@ -60,10 +70,27 @@ namespace mn
 		}
 	};
 
+	// initializes the given memory stream in place with the given allocator, it's used by the memory stream
+	// constructors and by the types which embed a memory stream
+	MN_EXPORT void
+	_memory_stream_init(Memory_Stream self, Allocator allocator);
+
 	// creates a new memory stream with the given allocator
 	MN_EXPORT Memory_Stream
 	memory_stream_new(Allocator allocator = allocator_top());
 
+	// creates a new chunked memory stream which stores its content in an array of fixed size chunks of
+	// the given size, writes never reallocate or move the already written bytes
+	MN_EXPORT Memory_Stream
+	memory_stream_chunked_new(size_t chunk_size = 64ULL * 1024ULL, Allocator allocator = allocator_top());
+
+	// returns whether the given memory stream is chunked
+	inline static bool
+	memory_stream_is_chunked(Memory_Stream self)
+	{
+		return self->chunk_pool != nullptr;
+	}
+
 	// frees the given memory stream
 	MN_EXPORT void
 	memory_stream_free(Memory_Stream self);
@@ -126,6 +153,8 @@ namespace mn
 	// retursn the memory block starting from the cursor with the given size(in bytes) advancing
 	// towards the end of the stream
 	// memory_stream_block_ahead([abcd|efghe], 2) -> [ef]
+	// in chunked streams the block must not cross a chunk boundary and a size of 0 returns the
+	// rest of the current chunk, use memory_stream_blocks_ahead for spans that cross chunks
 	MN_EXPORT Block
 	memory_stream_block_ahead(Memory_Stream self, size_t size);
 
@@ -135,14 +164,27 @@ namespace mn
 	MN_EXPORT Block
 	memory_stream_block_behind(Memory_Stream self, size_t size);
 
+	// returns an iovec like view of the memory starting from the cursor with the given size(in bytes),
+	// each block is a contiguous piece of the stream (a single block for non chunked streams), a size
+	// of 0 means the rest of the stream, the cursor is not moved
+	MN_EXPORT Buf<Block>
+	memory_stream_blocks_ahead(Memory_Stream self, size_t size = 0, Allocator allocator = memory::tmp());
+
 	// pipes data into the memory stream with the given size, returns the amount of written bytes
 	MN_EXPORT size_t
 	memory_stream_pipe(Memory_Stream self, Stream stream, size_t size);
 
-	// returns a pointer to the content of the memory stream
+	// pipes data from the memory stream starting at the cursor into the given stream without
+	// flattening chunks, a size of 0 means the rest of the stream, advances the cursor and returns
+	// the amount of written bytes
+	MN_EXPORT size_t
+	memory_stream_pipe_to(Memory_Stream self, Stream stream, size_t size = 0);
+
+	// returns a pointer to the content of the memory stream, only valid for non chunked streams
 	inline static const char*
 	memory_stream_ptr(Memory_Stream self)
 	{
+		mn_assert_msg(memory_stream_is_chunked(self) == false, "chunked Memory_Stream has no contiguous content");
 		return self->str.ptr;
 	}
 
@@ -150,6 +192,22 @@ namespace mn
 	inline static Str
 	memory_stream_str(Memory_Stream self)
 	{
+		if (memory_stream_is_chunked(self))
+		{
+			auto res = str_with_allocator(self->str.allocator);
+			buf_reserve(res, self->chunked_count + 1);
+			for (size_t i = 0; i < self->chunks.count; ++i)
+			{
+				size_t offset = i * self->chunk_size;
+				if (offset >= self->chunked_count)
+					break;
+				size_t size = self->chunked_count - offset;
+				str_block_push(res, Block{self->chunks[i], size < self->chunk_size ? size : self->chunk_size});
+			}
+			memory_stream_clear(self);
+			return res;
+		}
+
 		Str res = self->str;
 		self->str = str_with_allocator(self->str.allocator);
 		self->cursor = 0;
@@ -0,0 +1,906 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Memory.h"
+#include "mn/Map.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+#include <utility>
+
+namespace mn
+{
+	// key value ordering, it orders the key value pairs by their keys only
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	struct Key_Value_Less
+	{
+		inline bool
+		operator()(const Key_Value<TKey, TValue>& a, const Key_Value<TKey, TValue>& b) const
+		{
+			return TLess()(a.key, b.key);
+		}
+
+		template<typename TProbe>
+		inline bool
+		operator()(const Key_Value<TKey, TValue>& a, const TProbe& b) const
+		{
+			return TLess()(a.key, b);
+		}
+
+		template<typename TProbe>
+		inline bool
+		operator()(const TProbe& a, const Key_Value<TKey, TValue>& b) const
+		{
+			return TLess()(a, b.key);
+		}
+	};
+
+	// target size in bytes of the items of a single b-tree node
+	constexpr size_t ORDERED_NODE_ITEMS_SIZE = 512;
+
+	// returns the count of items in a single b-tree node, it's always odd (2 * t - 1) so a full node splits into
+	// two nodes with t - 1 items and a median item which goes up into the parent
+	template<typename T>
+	constexpr size_t
+	_ordered_node_capacity()
+	{
+		size_t res = ORDERED_NODE_ITEMS_SIZE / sizeof(T);
+		if (res < 3)
+			res = 3;
+		if (res > 255)
+			res = 255;
+		if (res % 2 == 0)
+			--res;
+		return res;
+	}
+
+	// a b-tree node, leaf nodes are allocated without the children array
+	template<typename T>
+	struct Ordered_Node
+	{
+		constexpr static size_t CAPACITY = _ordered_node_capacity<T>();
+		constexpr static size_t MIN_COUNT = CAPACITY / 2;
+
+		Ordered_Node* parent;
+		// index of this node in its parent's children array
+		uint16_t position;
+		uint16_t count;
+		bool is_leaf;
+		T items[CAPACITY];
+	};
+
+	// a b-tree internal node which has the children array after the items
+	template<typename T>
+	struct Ordered_Internal_Node: Ordered_Node<T>
+	{
+		Ordered_Node<T>* children[Ordered_Node<T>::CAPACITY + 1];
+	};
+
+	// an ordered set iterator which visits the items in order, it's invalidated by insert and remove
+	template<typename T, typename TItem>
+	struct Ordered_Iterator
+	{
+		Ordered_Node<T>* node;
+		size_t index;
+
+		TItem&
+		operator*() const
+		{
+			return (TItem&)node->items[index];
+		}
+
+		TItem*
+		operator->() const
+		{
+			return (TItem*)&node->items[index];
+		}
+
+		Ordered_Iterator&
+		operator++()
+		{
+			if (node->is_leaf == false)
+			{
+				// the next item is the leftmost item in the right subtree
+				node = ((Ordered_Internal_Node<T>*)node)->children[index + 1];
+				while (node->is_leaf == false)
+					node = ((Ordered_Internal_Node<T>*)node)->children[0];
+				index = 0;
+				return *this;
+			}
+
+			++index;
+			// climb up until we find an ancestor which has an item after the subtree we came from
+			while (index >= node->count)
+			{
+				if (node->parent == nullptr)
+				{
+					node = nullptr;
+					index = 0;
+					break;
+				}
+				index = node->position;
+				node = node->parent;
+			}
+			return *this;
+		}
+
+		bool
+		operator==(const Ordered_Iterator& other) const
+		{
+			return node == other.node && index == other.index;
+		}
+
+		bool
+		operator!=(const Ordered_Iterator& other) const
+		{
+			return !operator==(other);
+		}
+	};
+
+	// an ordered set implemented as a b-tree, each node holds a few hundred bytes of items which are binary searched
+	// so lookups touch only O(log n) cache friendly nodes, insert and remove are O(log n) without moving the rest of
+	// the items, and iteration visits the items in order
+	// note that the items are moved around in memory using memcpy like Buf so pointers to items are invalidated by
+	// insert and remove
+	template<typename T, typename TLess = Less<T>>
+	struct Ordered_Set
+	{
+		Allocator allocator;
+		Ordered_Node<T>* root;
+		size_t count;
+	};
+
+	// creates a new ordered set instance with the top/default allocator
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Set<T, TLess>
+	ordered_set_new()
+	{
+		Ordered_Set<T, TLess> self{};
+		self.allocator = allocator_top();
+		return self;
+	}
+
+	// creates a new ordered set instance with the given allocator
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Set<T, TLess>
+	ordered_set_with_allocator(Allocator allocator)
+	{
+		Ordered_Set<T, TLess> self{};
+		self.allocator = allocator;
+		return self;
+	}
+
+	template<typename T>
+	inline static Ordered_Node<T>**
+	_ordered_node_children(Ordered_Node<T>* node)
+	{
+		return ((Ordered_Internal_Node<T>*)node)->children;
+	}
+
+	template<typename T>
+	inline static Ordered_Node<T>*
+	_ordered_node_new(Allocator allocator, bool is_leaf)
+	{
+		auto size = is_leaf ? sizeof(Ordered_Node<T>) : sizeof(Ordered_Internal_Node<T>);
+		auto node = (Ordered_Node<T>*)alloc_from(allocator, size, alignof(Ordered_Internal_Node<T>)).ptr;
+		node->parent = nullptr;
+		node->position = 0;
+		node->count = 0;
+		node->is_leaf = is_leaf;
+		return node;
+	}
+
+	template<typename T>
+	inline static void
+	_ordered_node_free(Allocator allocator, Ordered_Node<T>* node)
+	{
+		auto size = node->is_leaf ? sizeof(Ordered_Node<T>) : sizeof(Ordered_Internal_Node<T>);
+		free_from(allocator, Block{node, size});
+	}
+
+	template<typename T>
+	inline static void
+	_ordered_node_free_all(Allocator allocator, Ordered_Node<T>* node, bool destruct_items)
+	{
+		if (node->is_leaf == false)
+		{
+			auto children = _ordered_node_children(node);
+			for (size_t i = 0; i <= node->count; ++i)
+				_ordered_node_free_all(allocator, children[i], destruct_items);
+		}
+		if (destruct_items)
+		{
+			for (size_t i = 0; i < node->count; ++i)
+				destruct(node->items[i]);
+		}
+		_ordered_node_free(allocator, node);
+	}
+
+	template<typename T>
+	inline static void
+	_ordered_node_set_child(Ordered_Node<T>* node, size_t index, Ordered_Node<T>* child)
+	{
+		_ordered_node_children(node)[index] = child;
+		child->parent = node;
+		child->position = uint16_t(index);
+	}
+
+	// updates the position of the children in the range [begin, end) after they were moved
+	template<typename T>
+	inline static void
+	_ordered_node_fix_children(Ordered_Node<T>* node, size_t begin, size_t end)
+	{
+		auto children = _ordered_node_children(node);
+		for (size_t i = begin; i < end; ++i)
+		{
+			children[i]->parent = node;
+			children[i]->position = uint16_t(i);
+		}
+	}
+
+	// moves the items in the range [index, count) of the given node by the given offset (-1 or 1)
+	template<typename T>
+	inline static void
+	_ordered_node_shift_items(Ordered_Node<T>* node, size_t index, int offset)
+	{
+		::memmove((void*)(node->items + index + offset), (const void*)(node->items + index), sizeof(T) * (node->count - index));
+	}
+
+	// moves the children in the range [index, count] of the given node by the given offset (-1 or 1)
+	template<typename T>
+	inline static void
+	_ordered_node_shift_children(Ordered_Node<T>* node, size_t index, int offset)
+	{
+		auto children = _ordered_node_children(node);
+		::memmove(children + index + offset, children + index, sizeof(Ordered_Node<T>*) * (node->count + 1 - index));
+	}
+
+	// returns the index of the first item in the node which is not less than the given probe
+	template<typename T, typename TLess, typename TProbe>
+	inline static size_t
+	_ordered_node_lower_bound(const Ordered_Node<T>* node, const TProbe& probe)
+	{
+		size_t begin = 0, count = node->count;
+		while (count > 0)
+		{
+			auto half = count / 2;
+			if (TLess()(node->items[begin + half], probe))
+			{
+				begin += half + 1;
+				count -= half + 1;
+			}
+			else
+			{
+				count = half;
+			}
+		}
+		return begin;
+	}
+
+	// returns the index of the first item in the node which is greater than the given probe
+	template<typename T, typename TLess, typename TProbe>
+	inline static size_t
+	_ordered_node_upper_bound(const Ordered_Node<T>* node, const TProbe& probe)
+	{
+		size_t begin = 0, count = node->count;
+		while (count > 0)
+		{
+			auto half = count / 2;
+			if (TLess()(probe, node->items[begin + half]) == false)
+			{
+				begin += half + 1;
+				count -= half + 1;
+			}
+			else
+			{
+				count = half;
+			}
+		}
+		return begin;
+	}
+
+	// splits the full child at the given index into two nodes and moves its median item into the given node
+	template<typename T, typename TLess>
+	inline static void
+	_ordered_set_split_child(Ordered_Set<T, TLess>& self, Ordered_Node<T>* node, size_t index)
+	{
+		constexpr size_t MIN_COUNT = Ordered_Node<T>::MIN_COUNT;
+
+		auto left = _ordered_node_children(node)[index];
+		mn_assert(left->count == Ordered_Node<T>::CAPACITY);
+		auto right = _ordered_node_new<T>(self.allocator, left->is_leaf);
+
+		right->count = uint16_t(MIN_COUNT);
+		::memcpy((void*)right->items, (const void*)(left->items + MIN_COUNT + 1), sizeof(T) * MIN_COUNT);
+		if (left->is_leaf == false)
+		{
+			::memcpy(_ordered_node_children(right), _ordered_node_children(left) + MIN_COUNT + 1, sizeof(Ordered_Node<T>*) * (MIN_COUNT + 1));
+			_ordered_node_fix_children(right, 0, MIN_COUNT + 1);
+		}
+		left->count = uint16_t(MIN_COUNT);
+
+		_ordered_node_shift_children(node, index + 1, 1);
+		_ordered_node_shift_items(node, index, 1);
+		::memcpy((void*)(node->items + index), (const void*)(left->items + MIN_COUNT), sizeof(T));
+		++node->count;
+		_ordered_node_set_child(node, index + 1, right);
+		_ordered_node_fix_children(node, index + 2, node->count + 1);
+	}
+
+	// merges the child at index + 1 and the item at index into the child at index
+	template<typename T, typename TLess>
+	inline static Ordered_Node<T>*
+	_ordered_set_merge_children(Ordered_Set<T, TLess>& self, Ordered_Node<T>* node, size_t index)
+	{
+		auto children = _ordered_node_children(node);
+		auto left = children[index];
+		auto right = children[index + 1];
+
+		::memcpy((void*)(left->items + left->count), (const void*)(node->items + index), sizeof(T));
+		::memcpy((void*)(left->items + left->count + 1), (const void*)right->items, sizeof(T) * right->count);
+		if (left->is_leaf == false)
+		{
+			::memcpy(_ordered_node_children(left) + left->count + 1, _ordered_node_children(right), sizeof(Ordered_Node<T>*) * (right->count + 1));
+			_ordered_node_fix_children(left, left->count + 1, left->count + right->count + 2);
+		}
+		left->count += right->count + 1;
+
+		_ordered_node_shift_items(node, index + 1, -1);
+		_ordered_node_shift_children(node, index + 2, -1);
+		--node->count;
+		_ordered_node_fix_children(node, index + 1, node->count + 1);
+		_ordered_node_free(self.allocator, right);
+
+		// the tree shrinks in height when the root loses its last item
+		if (node == self.root && node->count == 0)
+		{
+			self.root = left;
+			left->parent = nullptr;
+			left->position = 0;
+			_ordered_node_free(self.allocator, node);
+		}
+		return left;
+	}
+
+	// makes sure that the child at the given index has more than the minimum count of items so we can remove an item
+	// from it, by borrowing an item from one of its siblings or merging it with one of them, returns the child
+	template<typename T, typename TLess>
+	inline static Ordered_Node<T>*
+	_ordered_set_fill_child(Ordered_Set<T, TLess>& self, Ordered_Node<T>* node, size_t index)
+	{
+		constexpr size_t MIN_COUNT = Ordered_Node<T>::MIN_COUNT;
+
+		auto children = _ordered_node_children(node);
+		auto child = children[index];
+		if (child->count > MIN_COUNT)
+			return child;
+
+		if (index > 0 && children[index - 1]->count > MIN_COUNT)
+		{
+			// rotate an item from the left sibling through the parent
+			auto left = children[index - 1];
+			_ordered_node_shift_items(child, 0, 1);
+			::memcpy((void*)child->items, (const void*)(node->items + index - 1), sizeof(T));
+			::memcpy((void*)(node->items + index - 1), (const void*)(left->items + left->count - 1), sizeof(T));
+			if (child->is_leaf == false)
+			{
+				_ordered_node_shift_children(child, 0, 1);
+				_ordered_node_set_child(child, 0, _ordered_node_children(left)[left->count]);
+				_ordered_node_fix_children(child, 1, child->count + 2);
+			}
+			--left->count;
+			++child->count;
+			return child;
+		}
+
+		if (index < node->count && children[index + 1]->count > MIN_COUNT)
+		{
+			// rotate an item from the right sibling through the parent
+			auto right = children[index + 1];
+			::memcpy((void*)(child->items + child->count), (const void*)(node->items + index), sizeof(T));
+			::memcpy((void*)(node->items + index), (const void*)right->items, sizeof(T));
+			if (child->is_leaf == false)
+				_ordered_node_set_child(child, child->count + 1, _ordered_node_children(right)[0]);
+			_ordered_node_shift_items(right, 1, -1);
+			if (right->is_leaf == false)
+			{
+				_ordered_node_shift_children(right, 1, -1);
+				_ordered_node_fix_children(right, 0, right->count);
+			}
+			--right->count;
+			++child->count;
+			return child;
+		}
+
+		if (index < node->count)
+			return _ordered_set_merge_children(self, node, index);
+		else
+			return _ordered_set_merge_children(self, node, index - 1);
+	}
+
+	// removes the rightmost (or leftmost) item from the subtree of the given node and moves it into the given item
+	template<typename T, typename TLess>
+	inline static void
+	_ordered_set_remove_edge(Ordered_Set<T, TLess>& self, Ordered_Node<T>* node, bool rightmost, T* out_item)
+	{
+		while (node->is_leaf == false)
+			node = _ordered_set_fill_child(self, node, rightmost ? node->count : 0);
+
+		if (rightmost)
+		{
+			::memcpy((void*)out_item, (const void*)(node->items + node->count - 1), sizeof(T));
+		}
+		else
+		{
+			::memcpy((void*)out_item, (const void*)node->items, sizeof(T));
+			_ordered_node_shift_items(node, 1, -1);
+		}
+		--node->count;
+	}
+
+	// frees the given ordered set
+	template<typename T, typename TLess = Less<T>>
+	inline static void
+	ordered_set_free(Ordered_Set<T, TLess>& self)
+	{
+		if (self.root)
+			_ordered_node_free_all(self.allocator, self.root, false);
+		self.root = nullptr;
+		self.count = 0;
+	}
+
+	// destruct overload for the ordered set, it destructs the items as well
+	template<typename T, typename TLess = Less<T>>
+	inline static void
+	destruct(Ordered_Set<T, TLess>& self)
+	{
+		if (self.root)
+			_ordered_node_free_all(self.allocator, self.root, true);
+		self.root = nullptr;
+		self.count = 0;
+	}
+
+	// clears the given ordered set
+	template<typename T, typename TLess = Less<T>>
+	inline static void
+	ordered_set_clear(Ordered_Set<T, TLess>& self)
+	{
+		ordered_set_free(self);
+	}
+
+	// inserts an item into the ordered set, if an equal item exists it will be overwritten, returns a pointer to it
+	template<typename T, typename TLess = Less<T>>
+	inline static const T*
+	ordered_set_insert(Ordered_Set<T, TLess>& self, const T& item)
+	{
+		if (self.root == nullptr)
+			self.root = _ordered_node_new<T>(self.allocator, true);
+
+		// nodes are split on the way down so the leaf always has space and the splits never propagate up
+		if (self.root->count == Ordered_Node<T>::CAPACITY)
+		{
+			auto root = _ordered_node_new<T>(self.allocator, false);
+			_ordered_node_set_child(root, 0, self.root);
+			self.root = root;
+			_ordered_set_split_child(self, root, 0);
+		}
+
+		auto node = self.root;
+		while (true)
+		{
+			auto index = _ordered_node_lower_bound<T, TLess>(node, item);
+			if (index < node->count && TLess()(item, node->items[index]) == false)
+			{
+				node->items[index] = item;
+				return node->items + index;
+			}
+
+			if (node->is_leaf)
+			{
+				_ordered_node_shift_items(node, index, 1);
+				node->items[index] = item;
+				++node->count;
+				++self.count;
+				return node->items + index;
+			}
+
+			auto child = _ordered_node_children(node)[index];
+			if (child->count == Ordered_Node<T>::CAPACITY)
+			{
+				_ordered_set_split_child(self, node, index);
+				if (TLess()(node->items[index], item))
+				{
+					++index;
+				}
+				else if (TLess()(item, node->items[index]) == false)
+				{
+					node->items[index] = item;
+					return node->items + index;
+				}
+			}
+			node = _ordered_node_children(node)[index];
+		}
+	}
+
+	// searches for the given probe in the ordered set and returns a pointer to the equal item, returns nullptr if it
+	// doesn't exist
+	template<typename T, typename TLess, typename TProbe>
+	inline static const T*
+	ordered_set_lookup(const Ordered_Set<T, TLess>& self, const TProbe& probe)
+	{
+		auto node = self.root;
+		while (node)
+		{
+			auto index = _ordered_node_lower_bound<T, TLess>(node, probe);
+			if (index < node->count && TLess()(probe, node->items[index]) == false)
+				return node->items + index;
+			if (node->is_leaf)
+				break;
+			node = _ordered_node_children(node)[index];
+		}
+		return nullptr;
+	}
+
+	// removes the item which equals the given probe from the ordered set, returns whether the item was found and removed
+	// note that this function doesn't destruct the removed item
+	template<typename T, typename TLess, typename TProbe>
+	inline static bool
+	ordered_set_remove(Ordered_Set<T, TLess>& self, const TProbe& probe)
+	{
+		constexpr size_t MIN_COUNT = Ordered_Node<T>::MIN_COUNT;
+
+		// nodes are refilled on the way down so the node we remove from always has more than the minimum items
+		auto node = self.root;
+		while (node)
+		{
+			auto index = _ordered_node_lower_bound<T, TLess>(node, probe);
+			bool found = index < node->count && TLess()(probe, node->items[index]) == false;
+
+			if (node->is_leaf)
+			{
+				if (found == false)
+					return false;
+				_ordered_node_shift_items(node, index + 1, -1);
+				--node->count;
+				--self.count;
+				if (self.root->count == 0)
+				{
+					_ordered_node_free(self.allocator, self.root);
+					self.root = nullptr;
+				}
+				return true;
+			}
+
+			auto children = _ordered_node_children(node);
+			if (found)
+			{
+				// replace the item with its predecessor or successor from a child which can afford to lose an item
+				if (children[index]->count > MIN_COUNT)
+				{
+					_ordered_set_remove_edge(self, children[index], true, node->items + index);
+					--self.count;
+					return true;
+				}
+				else if (children[index + 1]->count > MIN_COUNT)
+				{
+					_ordered_set_remove_edge(self, children[index + 1], false, node->items + index);
+					--self.count;
+					return true;
+				}
+				// both children are minimal so merge them with the item and remove it from the merged node
+				node = _ordered_set_merge_children(self, node, index);
+			}
+			else
+			{
+				node = _ordered_set_fill_child(self, node, index);
+			}
+		}
+		return false;
+	}
+
+	// returns an iterator to the first item which is not less than the given probe
+	template<typename T, typename TLess, typename TProbe>
+	inline static Ordered_Iterator<T, const T>
+	ordered_set_lower_bound(const Ordered_Set<T, TLess>& self, const TProbe& probe)
+	{
+		Ordered_Iterator<T, const T> res{};
+		auto node = self.root;
+		while (node)
+		{
+			auto index = _ordered_node_lower_bound<T, TLess>(node, probe);
+			if (index < node->count)
+			{
+				res = Ordered_Iterator<T, const T>{node, index};
+				if (TLess()(probe, node->items[index]) == false)
+					break;
+			}
+			if (node->is_leaf)
+				break;
+			node = _ordered_node_children(node)[index];
+		}
+		return res;
+	}
+
+	// returns an iterator to the first item which is greater than the given probe
+	template<typename T, typename TLess, typename TProbe>
+	inline static Ordered_Iterator<T, const T>
+	ordered_set_upper_bound(const Ordered_Set<T, TLess>& self, const TProbe& probe)
+	{
+		Ordered_Iterator<T, const T> res{};
+		auto node = self.root;
+		while (node)
+		{
+			auto index = _ordered_node_upper_bound<T, TLess>(node, probe);
+			if (index < node->count)
+				res = Ordered_Iterator<T, const T>{node, index};
+			if (node->is_leaf)
+				break;
+			node = _ordered_node_children(node)[index];
+		}
+		return res;
+	}
+
+	// returns an iterator to the smallest item in the ordered set
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Iterator<T, const T>
+	ordered_set_begin(const Ordered_Set<T, TLess>& self)
+	{
+		auto node = self.root;
+		if (node == nullptr || node->count == 0)
+			return Ordered_Iterator<T, const T>{};
+		while (node->is_leaf == false)
+			node = _ordered_node_children(node)[0];
+		return Ordered_Iterator<T, const T>{node, 0};
+	}
+
+	// returns an iterator to the end of the ordered set
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Iterator<T, const T>
+	ordered_set_end(const Ordered_Set<T, TLess>&)
+	{
+		return Ordered_Iterator<T, const T>{};
+	}
+
+	// begin overload for ordered set
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Iterator<T, const T>
+	begin(const Ordered_Set<T, TLess>& self)
+	{
+		return ordered_set_begin(self);
+	}
+
+	// end overload for ordered set
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Iterator<T, const T>
+	end(const Ordered_Set<T, TLess>& self)
+	{
+		return ordered_set_end(self);
+	}
+
+	// creates an ordered set from the given sorted unique items in O(n) by building the tree bottom up, the nodes are
+	// filled evenly so the tree has the minimum height
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Set<T, TLess>
+	ordered_set_from_sorted(const T* items, size_t count, Allocator allocator = allocator_top())
+	{
+		constexpr size_t CAPACITY = Ordered_Node<T>::CAPACITY;
+
+		auto self = ordered_set_with_allocator<T, TLess>(allocator);
+		if (count == 0)
+			return self;
+
+		#ifndef NDEBUG
+		for (size_t i = 1; i < count; ++i)
+			mn_assert_msg(TLess()(items[i - 1], items[i]), "ordered set items should be sorted and unique");
+		#endif
+
+		auto scratch = scratch_begin({allocator});
+		auto nodes = buf_with_allocator<Ordered_Node<T>*>(scratch.arena);
+		auto separators = buf_with_allocator<const T*>(scratch.arena);
+
+		// the leaves level, every pair of adjacent leaves is separated by an item which goes into the parent level
+		size_t leaves_count = (count + CAPACITY + 1) / (CAPACITY + 1);
+		size_t leaves_items_count = count - (leaves_count - 1);
+		size_t cursor = 0;
+		buf_reserve(nodes, leaves_count);
+		buf_reserve(separators, leaves_count);
+		for (size_t i = 0; i < leaves_count; ++i)
+		{
+			auto leaf = _ordered_node_new<T>(allocator, true);
+			leaf->count = uint16_t(leaves_items_count / leaves_count + (i < leaves_items_count % leaves_count ? 1 : 0));
+			for (size_t j = 0; j < leaf->count; ++j)
+				leaf->items[j] = items[cursor + j];
+			cursor += leaf->count;
+			buf_push(nodes, leaf);
+			if (i + 1 < leaves_count)
+				buf_push(separators, items + cursor++);
+		}
+
+		// the internal levels, each one groups the nodes of the level below until there's a single root
+		auto next_nodes = buf_with_allocator<Ordered_Node<T>*>(scratch.arena);
+		auto next_separators = buf_with_allocator<const T*>(scratch.arena);
+		while (nodes.count > 1)
+		{
+			buf_clear(next_nodes);
+			buf_clear(next_separators);
+
+			size_t parents_count = (nodes.count + CAPACITY) / (CAPACITY + 1);
+			size_t child_index = 0;
+			for (size_t i = 0; i < parents_count; ++i)
+			{
+				auto parent = _ordered_node_new<T>(allocator, false);
+				size_t children_count = nodes.count / parents_count + (i < nodes.count % parents_count ? 1 : 0);
+				for (size_t j = 0; j < children_count; ++j)
+				{
+					_ordered_node_set_child(parent, j, nodes[child_index]);
+					if (j + 1 < children_count)
+						parent->items[j] = *separators[child_index];
+					++child_index;
+				}
+				parent->count = uint16_t(children_count - 1);
+				buf_push(next_nodes, parent);
+				if (i + 1 < parents_count)
+					buf_push(next_separators, separators[child_index - 1]);
+			}
+
+			std::swap(nodes, next_nodes);
+			std::swap(separators, next_separators);
+		}
+
+		self.root = nodes[0];
+		self.count = count;
+		return self;
+	}
+
+	// creates an ordered set from the given sorted unique items
+	template<typename T, typename TLess = Less<T>>
+	inline static Ordered_Set<T, TLess>
+	ordered_set_from_sorted(const Buf<T>& items, Allocator allocator = allocator_top())
+	{
+		return ordered_set_from_sorted<T, TLess>(items.ptr, items.count, allocator);
+	}
+
+
+	// an ordered map, it's an ordered set of key value pairs which are ordered by their keys
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	using Ordered_Map = Ordered_Set<Key_Value<TKey, TValue>, Key_Value_Less<TKey, TValue, TLess>>;
+
+	// an ordered map iterator, it visits the key value pairs in order of their keys
+	template<typename TKey, typename TValue>
+	using Ordered_Map_Iterator = Ordered_Iterator<Key_Value<TKey, TValue>, Key_Value<const TKey, TValue>>;
+
+	// creates a new ordered map instance with the top/default allocator
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map<TKey, TValue, TLess>
+	ordered_map_new()
+	{
+		return ordered_set_new<Key_Value<TKey, TValue>, Key_Value_Less<TKey, TValue, TLess>>();
+	}
+
+	// creates a new ordered map instance with the given allocator
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map<TKey, TValue, TLess>
+	ordered_map_with_allocator(Allocator allocator)
+	{
+		return ordered_set_with_allocator<Key_Value<TKey, TValue>, Key_Value_Less<TKey, TValue, TLess>>(allocator);
+	}
+
+	// frees the given ordered map
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static void
+	ordered_map_free(Ordered_Map<TKey, TValue, TLess>& self)
+	{
+		ordered_set_free(self);
+	}
+
+	// clears the given ordered map
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static void
+	ordered_map_clear(Ordered_Map<TKey, TValue, TLess>& self)
+	{
+		ordered_set_clear(self);
+	}
+
+	// inserts the given key value pair into the ordered map, if the key exists its value will be overwritten, returns
+	// a pointer to the key value pair
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Key_Value<const TKey, TValue>*
+	ordered_map_insert(Ordered_Map<TKey, TValue, TLess>& self, const TKey& key, const TValue& value)
+	{
+		return (Key_Value<const TKey, TValue>*)ordered_set_insert(self, Key_Value<TKey, TValue>{key, value});
+	}
+
+	// searches for the given key (or an equivalent probe) in the ordered map and returns a pointer to the key value
+	// pair, returns nullptr if it doesn't exist
+	template<typename TKey, typename TValue, typename TLess, typename TProbe>
+	inline static const Key_Value<const TKey, TValue>*
+	ordered_map_lookup(const Ordered_Map<TKey, TValue, TLess>& self, const TProbe& key)
+	{
+		return (const Key_Value<const TKey, TValue>*)ordered_set_lookup(self, key);
+	}
+
+	// searches for the given key (or an equivalent probe) in the ordered map and returns a pointer to the key value
+	// pair, returns nullptr if it doesn't exist
+	template<typename TKey, typename TValue, typename TLess, typename TProbe>
+	inline static Key_Value<const TKey, TValue>*
+	ordered_map_lookup(Ordered_Map<TKey, TValue, TLess>& self, const TProbe& key)
+	{
+		return (Key_Value<const TKey, TValue>*)ordered_set_lookup(self, key);
+	}
+
+	// removes the given key from the ordered map, returns whether the key was found and removed
+	// note that this function doesn't destruct the removed key value pair
+	template<typename TKey, typename TValue, typename TLess, typename TProbe>
+	inline static bool
+	ordered_map_remove(Ordered_Map<TKey, TValue, TLess>& self, const TProbe& key)
+	{
+		return ordered_set_remove(self, key);
+	}
+
+	// returns an iterator to the first key value pair whose key is not less than the given key
+	template<typename TKey, typename TValue, typename TLess, typename TProbe>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_lower_bound(const Ordered_Map<TKey, TValue, TLess>& self, const TProbe& key)
+	{
+		auto it = ordered_set_lower_bound(self, key);
+		return Ordered_Map_Iterator<TKey, TValue>{it.node, it.index};
+	}
+
+	// returns an iterator to the first key value pair whose key is greater than the given key
+	template<typename TKey, typename TValue, typename TLess, typename TProbe>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_upper_bound(const Ordered_Map<TKey, TValue, TLess>& self, const TProbe& key)
+	{
+		auto it = ordered_set_upper_bound(self, key);
+		return Ordered_Map_Iterator<TKey, TValue>{it.node, it.index};
+	}
+
+	// returns an iterator to the key value pair with the smallest key in the ordered map
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_begin(const Ordered_Map<TKey, TValue, TLess>& self)
+	{
+		auto it = ordered_set_begin(self);
+		return Ordered_Map_Iterator<TKey, TValue>{it.node, it.index};
+	}
+
+	// returns an iterator to the end of the ordered map
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_end(const Ordered_Map<TKey, TValue, TLess>&)
+	{
+		return Ordered_Map_Iterator<TKey, TValue>{};
+	}
+
+	// begin overload for ordered map
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	begin(const Ordered_Map<TKey, TValue, TLess>& self)
+	{
+		return ordered_map_begin(self);
+	}
+
+	// end overload for ordered map
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	end(const Ordered_Map<TKey, TValue, TLess>& self)
+	{
+		return ordered_map_end(self);
+	}
+
+	// creates an ordered map from the given key value pairs which are sorted by their unique keys
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map<TKey, TValue, TLess>
+	ordered_map_from_sorted(const Key_Value<TKey, TValue>* items, size_t count, Allocator allocator = allocator_top())
+	{
+		return ordered_set_from_sorted<Key_Value<TKey, TValue>, Key_Value_Less<TKey, TValue, TLess>>(items, count, allocator);
+	}
+
+	// creates an ordered map from the given key value pairs which are sorted by their unique keys
+	template<typename TKey, typename TValue, typename TLess = Less<TKey>>
+	inline static Ordered_Map<TKey, TValue, TLess>
+	ordered_map_from_sorted(const Buf<Key_Value<TKey, TValue>>& items, Allocator allocator = allocator_top())
+	{
+		return ordered_set_from_sorted<Key_Value<TKey, TValue>, Key_Value_Less<TKey, TValue, TLess>>(items.ptr, items.count, allocator);
+	}
+}
@@ -33,4 +33,8 @@ namespace mn
 	// puts back the given memory into the pool to be reused later
 	MN_EXPORT void
 	pool_put(Pool pool, void* ptr);
+
+	// returns the memory usage stats of the given pool, the reserved size is the memory of the pool buckets
+	MN_EXPORT memory::Stats
+	pool_stats(Pool pool);
 }
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "mn/Buf.h"
+
+namespace mn
+{
+	// allocator of the small buf which owns the inline storage, it forwards the allocations to the parent allocator and
+	// ignores the free of the inline storage, which lets all the buf functions grow the small buf as a normal buf
+	template<typename T, size_t N>
+	struct Small_Buf_Allocator: memory::Interface
+	{
+		Allocator parent;
+		alignas(T) unsigned char storage[N * sizeof(T)];
+
+		Block
+		alloc(size_t size, uint8_t alignment) override
+		{
+			return parent->alloc(size, alignment);
+		}
+
+		void
+		free(Block block) override
+		{
+			if (block.ptr != storage)
+				parent->free(block);
+		}
+	};
+
+	// a buf which stores up to N elements inline and only allocates from its allocator when it grows beyond that,
+	// it's a Buf so it works with all the buf functions (buf_push, buf_insert, buf_concat, etc.)
+	// note that the buf points into the small buf itself, so it shouldn't be memcpy'ed around (ex. stored in a Buf which
+	// relocates its elements on growth), copies using the copy constructor are fine
+	template<typename T, size_t N>
+	struct Small_Buf: Buf<T>
+	{
+		static_assert(N > 0, "small buf inline capacity should be greater than 0");
+
+		Small_Buf_Allocator<T, N> _inline;
+
+		Small_Buf(Allocator allocator = allocator_top())
+			: Buf<T>{}
+		{
+			_inline.parent = allocator;
+			this->allocator = &_inline;
+			this->ptr = (T*)_inline.storage;
+			this->count = 0;
+			this->cap = N;
+		}
+
+		// shallow copies the given small buf like Buf copies, the inline elements are copied into this small buf's
+		// storage and the spilled elements memory is shared
+		Small_Buf(const Small_Buf& other)
+			: Buf<T>{}
+		{
+			_inline.parent = other._inline.parent;
+			this->allocator = &_inline;
+			this->count = other.count;
+			if (other.ptr == (const T*)other._inline.storage)
+			{
+				::memcpy(_inline.storage, other._inline.storage, sizeof(T) * other.count);
+				this->ptr = (T*)_inline.storage;
+				this->cap = N;
+			}
+			else
+			{
+				this->ptr = other.ptr;
+				this->cap = other.cap;
+			}
+		}
+
+		Small_Buf&
+		operator=(const Small_Buf& other)
+		{
+			if (this != &other)
+			{
+				this->~Small_Buf();
+				::new (this) Small_Buf(other);
+			}
+			return *this;
+		}
+	};
+
+	// creates a new small buf using the default allocator for the spilled elements
+	template<typename T, size_t N>
+	inline static Small_Buf<T, N>
+	small_buf_new()
+	{
+		return Small_Buf<T, N>(allocator_top());
+	}
+
+	// creates a new small buf using the given allocator for the spilled elements
+	template<typename T, size_t N>
+	inline static Small_Buf<T, N>
+	small_buf_with_allocator(Allocator allocator)
+	{
+		return Small_Buf<T, N>(allocator);
+	}
+
+	// returns whether the elements of the given small buf are stored inline
+	template<typename T, size_t N>
+	inline static bool
+	small_buf_is_inline(const Small_Buf<T, N>& self)
+	{
+		return self.ptr == (const T*)self._inline.storage;
+	}
+
+	// frees the given small buf, and resets it back to its inline storage
+	template<typename T, size_t N>
+	inline static void
+	small_buf_free(Small_Buf<T, N>& self)
+	{
+		if (self.cap && self.ptr != (T*)self._inline.storage)
+			free_from(self._inline.parent, Block{self.ptr, self.cap * sizeof(T)});
+		self.allocator = &self._inline;
+		self.ptr = (T*)self._inline.storage;
+		self.count = 0;
+		self.cap = N;
+	}
+
+	// destruct overload for the small buf, it destructs the elements then frees the small buf
+	template<typename T, size_t N>
+	inline static void
+	destruct(Small_Buf<T, N>& self)
+	{
+		for (size_t i = 0; i < self.count; ++i)
+			destruct(self[i]);
+		small_buf_free(self);
+	}
+
+	// clones the given small buf using the given allocator for the spilled elements, it calls clone on each element
+	template<typename T, size_t N>
+	inline static Small_Buf<T, N>
+	small_buf_clone(const Small_Buf<T, N>& other, Allocator allocator = allocator_top())
+	{
+		auto self = small_buf_with_allocator<T, N>(allocator);
+		buf_resize(self, other.count);
+		for (size_t i = 0; i < other.count; ++i)
+			self[i] = clone(other[i]);
+		return self;
+	}
+
+	// clone overload for the small buf
+	template<typename T, size_t N>
+	inline static Small_Buf<T, N>
+	clone(const Small_Buf<T, N>& other)
+	{
+		return small_buf_clone(other);
+	}
+}
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Str.h"
+#include "mn/Map.h"
+
+#include <string.h>
+
+namespace mn
+{
+	// the heap representation of the small string
+	struct Small_Str_Heap
+	{
+		char* ptr;
+		size_t count;
+		// capacity in bytes excluding the null terminator, its most significant byte holds the heap flag
+		size_t cap;
+	};
+
+	// size in bytes of the inline storage of the small string
+	constexpr size_t SMALL_STR_INLINE_SIZE = sizeof(Small_Str_Heap);
+	// count of characters which can be stored inline, the last inline byte is the tag byte which stores the remaining
+	// inline capacity, so when the inline storage is full the tag is 0 and it works as the null terminator
+	constexpr size_t SMALL_STR_INLINE_CAPACITY = SMALL_STR_INLINE_SIZE - 1;
+	// the tag byte is the most significant byte of the heap capacity (on little endian machines), inline tags are
+	// always less than this flag
+	constexpr uint8_t SMALL_STR_HEAP_FLAG = 0x80;
+	constexpr size_t SMALL_STR_HEAP_CAP_FLAG = size_t(SMALL_STR_HEAP_FLAG) << (sizeof(size_t) * 8 - 8);
+
+	// a null terminated string which stores up to 23 characters (11 on 32-bit) inline without any allocation, and
+	// switches to heap memory from its allocator when it grows beyond that, it has the same size as Str and can be
+	// memcpy'ed around so it's suitable as a key in hash maps with a lot of short keys
+	struct Small_Str
+	{
+		Allocator allocator;
+		union
+		{
+			Small_Str_Heap _heap;
+			char _inline[SMALL_STR_INLINE_SIZE];
+		};
+	};
+
+	inline static uint8_t
+	_small_str_tag(const Small_Str& self)
+	{
+		return ((const uint8_t*)&self._heap)[SMALL_STR_INLINE_SIZE - 1];
+	}
+
+	inline static void
+	_small_str_inline_set_count(Small_Str& self, size_t count)
+	{
+		mn_assert(count <= SMALL_STR_INLINE_CAPACITY);
+		self._inline[count] = '\0';
+		self._inline[SMALL_STR_INLINE_SIZE - 1] = char(SMALL_STR_INLINE_CAPACITY - count);
+	}
+
+	// returns whether the given small string is stored inline
+	inline static bool
+	small_str_is_inline(const Small_Str& self)
+	{
+		return (_small_str_tag(self) & SMALL_STR_HEAP_FLAG) == 0;
+	}
+
+	// returns the count of characters in the given small string
+	inline static size_t
+	small_str_count(const Small_Str& self)
+	{
+		if (small_str_is_inline(self))
+			return SMALL_STR_INLINE_CAPACITY - _small_str_tag(self);
+		return self._heap.count;
+	}
+
+	// returns the capacity of the given small string in characters excluding the null terminator
+	inline static size_t
+	small_str_capacity(const Small_Str& self)
+	{
+		if (small_str_is_inline(self))
+			return SMALL_STR_INLINE_CAPACITY;
+		return self._heap.cap & ~SMALL_STR_HEAP_CAP_FLAG;
+	}
+
+	// returns a pointer to the null terminated characters of the given small string
+	inline static const char*
+	small_str_ptr(const Small_Str& self)
+	{
+		if (small_str_is_inline(self))
+			return self._inline;
+		return self._heap.ptr;
+	}
+
+	// returns a pointer to the null terminated characters of the given small string
+	inline static char*
+	small_str_ptr(Small_Str& self)
+	{
+		if (small_str_is_inline(self))
+			return self._inline;
+		return self._heap.ptr;
+	}
+
+	// returns a view of the characters of the given small string
+	inline static Str_View
+	str_view(const Small_Str& self)
+	{
+		return Str_View{small_str_ptr(self), small_str_count(self)};
+	}
+
+	// creates a new empty small string with the given allocator which is used only when it grows beyond the inline
+	// capacity
+	inline static Small_Str
+	small_str_new(Allocator allocator = allocator_top())
+	{
+		Small_Str self{};
+		self.allocator = allocator;
+		_small_str_inline_set_count(self, 0);
+		return self;
+	}
+
+	// frees the given small string
+	inline static void
+	small_str_free(Small_Str& self)
+	{
+		if (small_str_is_inline(self) == false)
+			free_from(self.allocator, Block{self._heap.ptr, small_str_capacity(self) + 1});
+		self._heap = Small_Str_Heap{};
+		_small_str_inline_set_count(self, 0);
+	}
+
+	// destruct overload for small string free
+	inline static void
+	destruct(Small_Str& self)
+	{
+		small_str_free(self);
+	}
+
+	// ensures that the given small string has the capacity for the given added count of characters
+	inline static void
+	small_str_reserve(Small_Str& self, size_t added_count)
+	{
+		auto count = small_str_count(self);
+		auto cap = small_str_capacity(self);
+		if (count + added_count <= cap)
+			return;
+
+		auto new_cap = cap + cap / 2;
+		if (new_cap < count + added_count)
+			new_cap = count + added_count;
+
+		if (self.allocator == nullptr)
+			self.allocator = allocator_top();
+		auto block = alloc_from(self.allocator, new_cap + 1, alignof(char));
+		::memcpy(block.ptr, small_str_ptr(self), count + 1);
+		if (small_str_is_inline(self) == false)
+			free_from(self.allocator, Block{self._heap.ptr, cap + 1});
+
+		self._heap.ptr = (char*)block.ptr;
+		self._heap.count = count;
+		self._heap.cap = new_cap | SMALL_STR_HEAP_CAP_FLAG;
+	}
+
+	// resizes the given small string to the given count of characters and null terminates it, the new characters are
+	// not initialized
+	inline static void
+	small_str_resize(Small_Str& self, size_t count)
+	{
+		auto old_count = small_str_count(self);
+		if (count > old_count)
+			small_str_reserve(self, count - old_count);
+
+		if (small_str_is_inline(self))
+		{
+			_small_str_inline_set_count(self, count);
+		}
+		else
+		{
+			self._heap.count = count;
+			self._heap.ptr[count] = '\0';
+		}
+	}
+
+	// clears the given small string, it keeps its memory
+	inline static void
+	small_str_clear(Small_Str& self)
+	{
+		small_str_resize(self, 0);
+	}
+
+	// appends the given string view to the end of the given small string
+	inline static void
+	small_str_push(Small_Str& self, Str_View str)
+	{
+		if (str.count == 0)
+			return;
+		auto old_count = small_str_count(self);
+		small_str_resize(self, old_count + str.count);
+		::memcpy(small_str_ptr(self) + old_count, str.ptr, str.count);
+	}
+
+	// appends the given c string to the end of the given small string
+	inline static void
+	small_str_push(Small_Str& self, const char* str)
+	{
+		small_str_push(self, str_view(str));
+	}
+
+	// appends the given string to the end of the given small string
+	inline static void
+	small_str_push(Small_Str& self, const Str& str)
+	{
+		small_str_push(self, str_view(str));
+	}
+
+	// appends the given small string to the end of the given small string
+	inline static void
+	small_str_push(Small_Str& self, const Small_Str& str)
+	{
+		small_str_push(self, str_view(str));
+	}
+
+	// creates a new small string from the given string view
+	inline static Small_Str
+	small_str_from_view(Str_View str, Allocator allocator = allocator_top())
+	{
+		auto self = small_str_new(allocator);
+		small_str_push(self, str);
+		return self;
+	}
+
+	// creates a new small string from the given c string
+	inline static Small_Str
+	small_str_from_c(const char* str, Allocator allocator = allocator_top())
+	{
+		return small_str_from_view(str_view(str), allocator);
+	}
+
+	// creates a new small string from the given string
+	inline static Small_Str
+	small_str_from_str(const Str& str, Allocator allocator = allocator_top())
+	{
+		return small_str_from_view(str_view(str), allocator);
+	}
+
+	// creates a new string from the given small string
+	inline static Str
+	str_from_small_str(const Small_Str& str, Allocator allocator = allocator_top())
+	{
+		return str_from_view(str_view(str), allocator);
+	}
+
+	// clones the given small string using the given allocator
+	inline static Small_Str
+	small_str_clone(const Small_Str& other, Allocator allocator = allocator_top())
+	{
+		return small_str_from_view(str_view(other), allocator);
+	}
+
+	// clone overload for small string
+	inline static Small_Str
+	clone(const Small_Str& other)
+	{
+		return small_str_clone(other);
+	}
+
+	// small string hasher, it hashes the same way as Str and Str_View so it can be looked up using them
+	template<>
+	struct Hash<Small_Str>
+	{
+		inline size_t
+		operator()(const Small_Str& str) const
+		{
+			return Hash<Str_View>()(str_view(str));
+		}
+
+		inline size_t
+		operator()(Str_View str) const
+		{
+			return Hash<Str_View>()(str);
+		}
+
+		inline size_t
+		operator()(const Str& str) const
+		{
+			return Hash<Str_View>()(str_view(str));
+		}
+
+		inline size_t
+		operator()(const char* str) const
+		{
+			return Hash<Str_View>()(str_view(str));
+		}
+	};
+
+	inline static bool
+	operator==(const Small_Str& a, const Small_Str& b)
+	{
+		return str_view(a) == str_view(b);
+	}
+
+	inline static bool
+	operator!=(const Small_Str& a, const Small_Str& b)
+	{
+		return !(a == b);
+	}
+
+	inline static bool
+	operator<(const Small_Str& a, const Small_Str& b)
+	{
+		auto va = str_view(a), vb = str_view(b);
+		auto count = va.count < vb.count ? va.count : vb.count;
+		auto res = count ? ::memcmp(va.ptr, vb.ptr, count) : 0;
+		return res < 0 || (res == 0 && va.count < vb.count);
+	}
+
+	inline static bool
+	operator==(const Small_Str& a, Str_View b)
+	{
+		return str_view(a) == b;
+	}
+
+	inline static bool
+	operator!=(const Small_Str& a, Str_View b)
+	{
+		return !(a == b);
+	}
+
+	inline static bool
+	operator==(const Small_Str& a, const Str& b)
+	{
+		return str_view(a) == str_view(b);
+	}
+
+	inline static bool
+	operator!=(const Small_Str& a, const Str& b)
+	{
+		return !(a == b);
+	}
+
+	inline static bool
+	operator==(const Small_Str& a, const char* b)
+	{
+		return str_view(a) == str_view(b);
+	}
+
+	inline static bool
+	operator!=(const Small_Str& a, const char* b)
+	{
+		return !(a == b);
+	}
+}
@@ -0,0 +1,633 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Buf.h"
+#include "mn/Str.h"
+#include "mn/Heap.h"
+#include "mn/Memory.h"
+#include "mn/Defer.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+#include <type_traits>
+
+#if ARCH_X86
+#include <emmintrin.h>
+#endif
+
+namespace mn
+{
+	// below this count the partitions are sorted using insertion sort
+	constexpr size_t SORT_INSERTION_THRESHOLD = 24;
+	// above this count the pivot is selected using the median of 3 medians (ninther)
+	constexpr size_t SORT_NINTHER_THRESHOLD = 128;
+	// max count of moves done by the partial insertion sort before giving up
+	constexpr size_t SORT_PARTIAL_INSERTION_LIMIT = 8;
+
+	template<typename T>
+	inline static void
+	_sort_swap(T& a, T& b)
+	{
+		T tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	template<typename T, typename TLess>
+	inline static void
+	_sort2(T* a, T* b, TLess& less)
+	{
+		if (less(*b, *a))
+			_sort_swap(*a, *b);
+	}
+
+	template<typename T, typename TLess>
+	inline static void
+	_sort3(T* a, T* b, T* c, TLess& less)
+	{
+		_sort2(a, b, less);
+		_sort2(b, c, less);
+		_sort2(a, b, less);
+	}
+
+	// insertion sort, if unguarded is true then there must be an item before begin which isn't greater than any item
+	// in the range, so the inner loop doesn't need to check the range start
+	template<bool unguarded, typename T, typename TLess>
+	inline static void
+	_sort_insertion(T* begin, T* end, TLess& less)
+	{
+		if (begin == end)
+			return;
+
+		for (auto cur = begin + 1; cur != end; ++cur)
+		{
+			auto sift = cur;
+			auto sift_1 = cur - 1;
+			if (less(*sift, *sift_1))
+			{
+				T tmp = *sift;
+				do
+				{
+					*sift-- = *sift_1;
+				} while ((unguarded || sift != begin) && less(tmp, *--sift_1));
+				*sift = tmp;
+			}
+		}
+	}
+
+	// insertion sort which gives up after a few moves, returns whether the range was sorted
+	template<typename T, typename TLess>
+	inline static bool
+	_sort_partial_insertion(T* begin, T* end, TLess& less)
+	{
+		if (begin == end)
+			return true;
+
+		size_t limit = 0;
+		for (auto cur = begin + 1; cur != end; ++cur)
+		{
+			if (limit > SORT_PARTIAL_INSERTION_LIMIT)
+				return false;
+
+			auto sift = cur;
+			auto sift_1 = cur - 1;
+			if (less(*sift, *sift_1))
+			{
+				T tmp = *sift;
+				do
+				{
+					*sift-- = *sift_1;
+				} while (sift != begin && less(tmp, *--sift_1));
+				*sift = tmp;
+				limit += size_t(cur - sift);
+			}
+		}
+		return true;
+	}
+
+	// heap sort which is used when the quick sort keeps choosing bad pivots, so the worst case is O(n log n)
+	template<typename T, typename TLess>
+	inline static void
+	_sort_heap(T* begin, T* end, TLess& less)
+	{
+		auto greater = [&](const T& a, const T& b) { return less(b, a); };
+		auto count = size_t(end - begin);
+		heapify<2>(begin, count, greater);
+		for (auto i = count; i > 1; --i)
+		{
+			_sort_swap(begin[0], begin[i - 1]);
+			_heap_sift_down<2>(begin, i - 1, 0, greater, [](size_t) {});
+		}
+	}
+
+	// partitions the range around the pivot at begin, the items equal to the pivot go to the right partition, returns
+	// the pivot position and whether the range was already partitioned
+	template<typename T, typename TLess>
+	inline static T*
+	_sort_partition_right(T* begin, T* end, TLess& less, bool& already_partitioned)
+	{
+		T pivot = *begin;
+		auto first = begin;
+		auto last = end;
+
+		// the median of 3 pivot selection guarantees that there's an item which isn't less than the pivot
+		while (less(*++first, pivot)) {}
+
+		// if it's the first item then there's no guarantee for the other side
+		if (first - 1 == begin)
+			while (first < last && less(*--last, pivot) == false) {}
+		else
+			while (less(*--last, pivot) == false) {}
+
+		already_partitioned = first >= last;
+
+		while (first < last)
+		{
+			_sort_swap(*first, *last);
+			while (less(*++first, pivot)) {}
+			while (less(*--last, pivot) == false) {}
+		}
+
+		auto pivot_pos = first - 1;
+		*begin = *pivot_pos;
+		*pivot_pos = pivot;
+		return pivot_pos;
+	}
+
+	// partitions the range around the pivot at begin, the items equal to the pivot go to the left partition, it's used
+	// when the pivot is equal to the item before the range, so all the equal items are put in place at once which
+	// makes sorting ranges with a lot of duplicates linear
+	template<typename T, typename TLess>
+	inline static T*
+	_sort_partition_left(T* begin, T* end, TLess& less)
+	{
+		T pivot = *begin;
+		auto first = begin;
+		auto last = end;
+
+		while (less(pivot, *--last)) {}
+
+		if (last + 1 == end)
+			while (first < last && less(pivot, *++first) == false) {}
+		else
+			while (less(pivot, *++first) == false) {}
+
+		while (first < last)
+		{
+			_sort_swap(*first, *last);
+			while (less(pivot, *--last)) {}
+			while (less(pivot, *++first) == false) {}
+		}
+
+		auto pivot_pos = last;
+		*begin = *pivot_pos;
+		*pivot_pos = pivot;
+		return pivot_pos;
+	}
+
+	// pattern defeating quick sort loop, it recurses into the left partition and loops on the right one
+	template<typename T, typename TLess>
+	inline static void
+	_sort_pdq(T* begin, T* end, TLess& less, int bad_allowed, bool leftmost)
+	{
+		while (true)
+		{
+			auto size = size_t(end - begin);
+			if (size < SORT_INSERTION_THRESHOLD)
+			{
+				if (leftmost)
+					_sort_insertion<false>(begin, end, less);
+				else
+					_sort_insertion<true>(begin, end, less);
+				return;
+			}
+
+			// choose the pivot as the median of 3 or the pseudo median of 9 and move it to begin
+			auto s2 = size / 2;
+			if (size > SORT_NINTHER_THRESHOLD)
+			{
+				_sort3(begin, begin + s2, end - 1, less);
+				_sort3(begin + 1, begin + (s2 - 1), end - 2, less);
+				_sort3(begin + 2, begin + (s2 + 1), end - 3, less);
+				_sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), less);
+				_sort_swap(*begin, *(begin + s2));
+			}
+			else
+			{
+				_sort3(begin + s2, begin, end - 1, less);
+			}
+
+			// if the item before the range is equal to the pivot then all the items equal to the pivot are in their
+			// final place after partition left
+			if (leftmost == false && less(*(begin - 1), *begin) == false)
+			{
+				begin = _sort_partition_left(begin, end, less) + 1;
+				continue;
+			}
+
+			bool already_partitioned = false;
+			auto pivot_pos = _sort_partition_right(begin, end, less, already_partitioned);
+
+			auto l_size = size_t(pivot_pos - begin);
+			auto r_size = size_t(end - (pivot_pos + 1));
+			bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+			if (highly_unbalanced)
+			{
+				// too many bad pivots so switch to heap sort
+				if (--bad_allowed == 0)
+				{
+					_sort_heap(begin, end, less);
+					return;
+				}
+
+				// shuffle some items around to break the patterns which cause the bad pivots
+				if (l_size >= SORT_INSERTION_THRESHOLD)
+				{
+					_sort_swap(*begin, *(begin + l_size / 4));
+					_sort_swap(*(pivot_pos - 1), *(pivot_pos - l_size / 4));
+					if (l_size > SORT_NINTHER_THRESHOLD)
+					{
+						_sort_swap(*(begin + 1), *(begin + (l_size / 4 + 1)));
+						_sort_swap(*(begin + 2), *(begin + (l_size / 4 + 2)));
+						_sort_swap(*(pivot_pos - 2), *(pivot_pos - (l_size / 4 + 1)));
+						_sort_swap(*(pivot_pos - 3), *(pivot_pos - (l_size / 4 + 2)));
+					}
+				}
+
+				if (r_size >= SORT_INSERTION_THRESHOLD)
+				{
+					_sort_swap(*(pivot_pos + 1), *(pivot_pos + (1 + r_size / 4)));
+					_sort_swap(*(end - 1), *(end - r_size / 4));
+					if (r_size > SORT_NINTHER_THRESHOLD)
+					{
+						_sort_swap(*(pivot_pos + 2), *(pivot_pos + (2 + r_size / 4)));
+						_sort_swap(*(pivot_pos + 3), *(pivot_pos + (3 + r_size / 4)));
+						_sort_swap(*(end - 2), *(end - (1 + r_size / 4)));
+						_sort_swap(*(end - 3), *(end - (2 + r_size / 4)));
+					}
+				}
+			}
+			else
+			{
+				// a balanced partition with no swaps is a hint that the range is already sorted
+				if (already_partitioned &&
+					_sort_partial_insertion(begin, pivot_pos, less) &&
+					_sort_partial_insertion(pivot_pos + 1, end, less))
+				{
+					return;
+				}
+			}
+
+			_sort_pdq(begin, pivot_pos, less, bad_allowed, leftmost);
+			begin = pivot_pos + 1;
+			leftmost = false;
+		}
+	}
+
+	// sorts the given items in place using pattern defeating quick sort, it's O(n log n) in the worst case, linear for
+	// sorted, reverse sorted and a lot of duplicate items, and it's not stable
+	template<typename T, typename TLess = Less<T>>
+	inline static void
+	sort(T* ptr, size_t count, TLess less = TLess())
+	{
+		if (count < 2)
+			return;
+
+		int bad_allowed = 0;
+		for (auto n = count; n > 1; n >>= 1)
+			++bad_allowed;
+		_sort_pdq(ptr, ptr + count, less, bad_allowed, true);
+	}
+
+	// sorts the given buf in place using pattern defeating quick sort, it's not stable
+	template<typename T, typename TLess = Less<T>>
+	inline static void
+	buf_sort(Buf<T>& self, TLess less = TLess())
+	{
+		sort(self.ptr, self.count, less);
+	}
+
+	// merges the two sorted ranges [a, a + a_count) and [b, b + b_count) into out, it prefers the left items when equal
+	template<typename T, typename TLess>
+	inline static void
+	_sort_merge(const T* a, size_t a_count, const T* b, size_t b_count, T* out, TLess& less)
+	{
+		size_t i = 0, j = 0, k = 0;
+		while (i < a_count && j < b_count)
+		{
+			if (less(b[j], a[i]))
+				out[k++] = b[j++];
+			else
+				out[k++] = a[i++];
+		}
+		while (i < a_count)
+			out[k++] = a[i++];
+		while (j < b_count)
+			out[k++] = b[j++];
+	}
+
+	// sorts the given items in place using a bottom up merge sort which keeps the order of the equal items, the merge
+	// buffer is allocated from the tmp allocator
+	template<typename T, typename TLess = Less<T>>
+	inline static void
+	stable_sort(T* ptr, size_t count, TLess less = TLess())
+	{
+		constexpr size_t RUN_SIZE = 16;
+		for (size_t i = 0; i < count; i += RUN_SIZE)
+			_sort_insertion<false>(ptr + i, ptr + (i + RUN_SIZE < count ? i + RUN_SIZE : count), less);
+		if (count <= RUN_SIZE)
+			return;
+
+		auto tmp = buf_with_allocator<T>(memory::tmp());
+		buf_resize(tmp, count);
+		mn_defer(buf_free(tmp));
+
+		auto src = ptr;
+		auto dst = tmp.ptr;
+		for (size_t width = RUN_SIZE; width < count; width *= 2)
+		{
+			for (size_t i = 0; i < count; i += 2 * width)
+			{
+				auto a_count = i + width < count ? width : count - i;
+				auto b_count = i + a_count + width < count ? width : count - (i + a_count);
+				_sort_merge(src + i, a_count, src + i + a_count, b_count, dst + i, less);
+			}
+			auto t = src;
+			src = dst;
+			dst = t;
+		}
+
+		if (src != ptr)
+			::memcpy((void*)ptr, src, count * sizeof(T));
+	}
+
+	// sorts the given buf in place and keeps the order of the equal items, the merge buffer is allocated from the tmp
+	// allocator
+	template<typename T, typename TLess = Less<T>>
+	inline static void
+	buf_stable_sort(Buf<T>& self, TLess less = TLess())
+	{
+		stable_sort(self.ptr, self.count, less);
+	}
+
+	// returns whether the given buf is sorted
+	template<typename T, typename TLess = Less<T>>
+	inline static bool
+	buf_is_sorted(const Buf<T>& self, TLess less = TLess())
+	{
+		for (size_t i = 1; i < self.count; ++i)
+			if (less(self[i], self[i - 1]))
+				return false;
+		return true;
+	}
+
+	// converts the given radix sort key to an unsigned integer with the same order, signed integers have their sign
+	// bit flipped, negative floats have all their bits flipped and positive floats have their sign bit flipped
+	template<typename TKey>
+	inline static auto
+	_radix_sort_bits(TKey key)
+	{
+		static_assert(std::is_arithmetic_v<TKey>, "radix sort keys should be integers or floats");
+		if constexpr (std::is_same_v<TKey, bool>)
+		{
+			return uint8_t(key);
+		}
+		else if constexpr (std::is_floating_point_v<TKey>)
+		{
+			using Bits = std::conditional_t<sizeof(TKey) == 4, uint32_t, uint64_t>;
+			static_assert(sizeof(TKey) == sizeof(Bits), "unsupported radix sort float key");
+			Bits bits = 0;
+			::memcpy(&bits, &key, sizeof(bits));
+			constexpr Bits sign = Bits(1) << (sizeof(Bits) * 8 - 1);
+			return (bits & sign) ? Bits(~bits) : Bits(bits | sign);
+		}
+		else
+		{
+			using Bits = std::make_unsigned_t<TKey>;
+			if constexpr (std::is_signed_v<TKey>)
+				return Bits(Bits(key) ^ (Bits(1) << (sizeof(Bits) * 8 - 1)));
+			else
+				return Bits(key);
+		}
+	}
+
+	// sorts the given items in place using LSD radix sort on the keys returned by the given function
+	// `key(const T&) -> integer or float`, it's O(n) and stable, the passes where all the keys have the same digit are
+	// skipped, the scatter buffer is allocated from the tmp allocator
+	template<typename T, typename TKeyFunc>
+	inline static void
+	radix_sort(T* ptr, size_t count, TKeyFunc&& key)
+	{
+		using Bits = decltype(_radix_sort_bits(key(*ptr)));
+		constexpr size_t PASSES_COUNT = sizeof(Bits);
+		if (count < 2)
+			return;
+
+		// count all the digits histograms in a single pass
+		auto histograms = buf_with_allocator<size_t>(memory::tmp());
+		buf_resize_fill(histograms, PASSES_COUNT * 256, size_t(0));
+		mn_defer(buf_free(histograms));
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto bits = _radix_sort_bits(key(ptr[i]));
+			for (size_t pass = 0; pass < PASSES_COUNT; ++pass)
+				++histograms[pass * 256 + ((bits >> (pass * 8)) & 0xFF)];
+		}
+
+		auto tmp = buf_with_allocator<T>(memory::tmp());
+		buf_resize(tmp, count);
+		mn_defer(buf_free(tmp));
+
+		auto src = ptr;
+		auto dst = tmp.ptr;
+		for (size_t pass = 0; pass < PASSES_COUNT; ++pass)
+		{
+			auto histogram = histograms.ptr + pass * 256;
+			auto first_digit = (_radix_sort_bits(key(src[0])) >> (pass * 8)) & 0xFF;
+			if (histogram[first_digit] == count)
+				continue;
+
+			size_t offset = 0;
+			for (size_t digit = 0; digit < 256; ++digit)
+			{
+				auto digit_count = histogram[digit];
+				histogram[digit] = offset;
+				offset += digit_count;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				auto digit = (_radix_sort_bits(key(src[i])) >> (pass * 8)) & 0xFF;
+				dst[histogram[digit]++] = src[i];
+			}
+
+			auto t = src;
+			src = dst;
+			dst = t;
+		}
+
+		if (src != ptr)
+			::memcpy((void*)ptr, src, count * sizeof(T));
+	}
+
+	// sorts the given buf of integers or floats in place using LSD radix sort
+	template<typename T>
+	inline static void
+	buf_radix_sort(Buf<T>& self)
+	{
+		radix_sort(self.ptr, self.count, [](const T& v) { return v; });
+	}
+
+	// sorts the given buf in place using LSD radix sort on the keys returned by the given function
+	// `key(const T&) -> integer or float`, it's stable
+	template<typename T, typename TKeyFunc>
+	inline static void
+	buf_radix_sort(Buf<T>& self, TKeyFunc&& key)
+	{
+		radix_sort(self.ptr, self.count, key);
+	}
+
+	// sorts the given buf of strings in place by their bytes using MSD radix sort
+	MN_EXPORT void
+	buf_radix_sort(Buf<Str>& self);
+
+	// sorts the given buf of string views in place by their bytes using MSD radix sort
+	MN_EXPORT void
+	buf_radix_sort(Buf<Str_View>& self);
+
+	// count of items below which the sorted integer search switches from binary search to a linear SIMD scan
+	constexpr size_t SORT_SIMD_SEARCH_WINDOW = 16;
+
+	// returns the count of the items in the given sorted window which are less than the given value if strict, or not
+	// greater than it otherwise, the uint32 items are compared as signed after flipping their sign bit
+	template<bool strict, typename T>
+	inline static size_t
+	_sort_simd_count_less(const T* ptr, size_t count, T v)
+	{
+		static_assert(sizeof(T) == 4 && std::is_integral_v<T>, "simd search only supports 32-bit integers");
+		size_t result = 0;
+		size_t i = 0;
+		#if ARCH_X86
+			constexpr int32_t bias = std::is_signed_v<T> ? 0 : INT32_MIN;
+			auto key = _mm_set1_epi32(int32_t(v) ^ bias);
+			auto bias_lanes = _mm_set1_epi32(bias);
+			auto acc = _mm_setzero_si128();
+			for (; i + 4 <= count; i += 4)
+			{
+				auto items = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(ptr + i)), bias_lanes);
+				// the comparison lanes are -1 when true so subtracting them counts the matches
+				if constexpr (strict)
+					acc = _mm_sub_epi32(acc, _mm_cmplt_epi32(items, key));
+				else
+					acc = _mm_add_epi32(acc, _mm_cmpgt_epi32(items, key));
+			}
+			alignas(16) int32_t lanes[4];
+			_mm_store_si128((__m128i*)lanes, acc);
+			if constexpr (strict)
+				result = size_t(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+			else
+				result = i + size_t(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+		#endif
+		for (; i < count; ++i)
+		{
+			if constexpr (strict)
+				result += ptr[i] < v;
+			else
+				result += (v < ptr[i]) == false;
+		}
+		return result;
+	}
+
+	// returns the index of the first item in the given sorted items which isn't less than the given value, or count if
+	// there's none, the binary search is branchless so the compiler emits conditional moves instead of unpredictable
+	// branches, and sorted 32-bit integer arrays finish the search with a SIMD scan
+	template<typename T, typename TValue, typename TLess = Less<T>>
+	inline static size_t
+	lower_bound(const T* ptr, size_t count, const TValue& v, TLess less = TLess())
+	{
+		if (count == 0)
+			return 0;
+
+		// the simd scan converts the value to T, so other value types use the comparator to avoid truncating them
+		constexpr bool simd =
+			sizeof(T) == 4 &&
+			std::is_integral_v<T> &&
+			std::is_same_v<TLess, Less<T>> &&
+			std::is_same_v<std::decay_t<TValue>, T>;
+
+		auto base = ptr;
+		auto n = count;
+		while (n > (simd ? SORT_SIMD_SEARCH_WINDOW : 1))
+		{
+			auto half = n / 2;
+			base = less(base[half], v) ? base + half : base;
+			n -= half;
+		}
+
+		if constexpr (simd)
+			return size_t(base - ptr) + _sort_simd_count_less<true>(base, n, T(v));
+		else
+			return size_t(base - ptr) + less(*base, v);
+	}
+
+	// returns the index of the first item in the given sorted items which is greater than the given value, or count if
+	// there's none, it's branchless like lower_bound
+	template<typename T, typename TValue, typename TLess = Less<T>>
+	inline static size_t
+	upper_bound(const T* ptr, size_t count, const TValue& v, TLess less = TLess())
+	{
+		if (count == 0)
+			return 0;
+
+		// the simd scan converts the value to T, so other value types use the comparator to avoid truncating them
+		constexpr bool simd =
+			sizeof(T) == 4 &&
+			std::is_integral_v<T> &&
+			std::is_same_v<TLess, Less<T>> &&
+			std::is_same_v<std::decay_t<TValue>, T>;
+
+		auto base = ptr;
+		auto n = count;
+		while (n > (simd ? SORT_SIMD_SEARCH_WINDOW : 1))
+		{
+			auto half = n / 2;
+			base = less(v, base[half]) ? base : base + half;
+			n -= half;
+		}
+
+		if constexpr (simd)
+			return size_t(base - ptr) + _sort_simd_count_less<false>(base, n, T(v));
+		else
+			return size_t(base - ptr) + (less(v, *base) == false);
+	}
+
+	// returns the index of the first item in the given sorted buf which isn't less than the given value, or the buf
+	// count if there's none
+	template<typename T, typename TValue, typename TLess = Less<T>>
+	inline static size_t
+	buf_lower_bound(const Buf<T>& self, const TValue& v, TLess less = TLess())
+	{
+		return lower_bound(self.ptr, self.count, v, less);
+	}
+
+	// returns the index of the first item in the given sorted buf which is greater than the given value, or the buf
+	// count if there's none
+	template<typename T, typename TValue, typename TLess = Less<T>>
+	inline static size_t
+	buf_upper_bound(const Buf<T>& self, const TValue& v, TLess less = TLess())
+	{
+		return upper_bound(self.ptr, self.count, v, less);
+	}
+
+	// searches the given sorted buf for the given value and returns its index, or SIZE_MAX if it's not found
+	template<typename T, typename TValue, typename TLess = Less<T>>
+	inline static size_t
+	buf_binary_search(const Buf<T>& self, const TValue& v, TLess less = TLess())
+	{
+		auto index = lower_bound(self.ptr, self.count, v, less);
+		if (index < self.count && less(v, self.ptr[index]) == false)
+			return index;
+		return SIZE_MAX;
+	}
+}
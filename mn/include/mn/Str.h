@@ -525,13 +525,74 @@ namespace mn
 		return str_clone(other);
 	}
 
+	// a non owning view of a sequence of characters (pointer + count), which is not necessarily null terminated
+	// it's mainly used to lookup string keys in hash tables without allocating or calling strlen
+	struct Str_View
+	{
+		const char* ptr;
+		size_t count;
+	};
+
+	// creates a view of the given c string
+	inline static Str_View
+	str_view(const char* str)
+	{
+		return Str_View{str, str ? ::strlen(str) : 0};
+	}
+
+	// creates a view of the given sub string
+	inline static Str_View
+	str_view(const char* begin, const char* end)
+	{
+		mn_assert_msg(end >= begin, "Invalid SubStr");
+		return Str_View{begin, size_t(end - begin)};
+	}
+
+	// creates a view of the given string
+	inline static Str_View
+	str_view(const Str& str)
+	{
+		return Str_View{str.ptr, str.count};
+	}
+
+	// creates a new string from the given view
+	inline static Str
+	str_from_view(Str_View view, Allocator allocator = allocator_top())
+	{
+		return str_from_substr(view.ptr, view.ptr + view.count, allocator);
+	}
+
 	template<>
 	struct Hash<Str>
 	{
 		inline size_t
 		operator()(const Str& str) const
 		{
-			return str.count ? murmur_hash(str.ptr, str.count) : 0;
+			return str.count ? hash_bytes(str.ptr, str.count) : 0;
+		}
+
+		// hashes a view the same way as its equal string, used in heterogeneous lookup (ex. map_lookup_as)
+		inline size_t
+		operator()(Str_View str) const
+		{
+			return str.count ? hash_bytes(str.ptr, str.count) : 0;
+		}
+
+		// hashes a c string the same way as its equal string, used in heterogeneous lookup (ex. map_lookup_as)
+		inline size_t
+		operator()(const char* str) const
+		{
+			return operator()(str_view(str));
+		}
+	};
+
+	template<>
+	struct Hash<Str_View>
+	{
+		inline size_t
+		operator()(Str_View str) const
+		{
+			return str.count ? hash_bytes(str.ptr, str.count) : 0;
 		}
 	};
 
@@ -677,4 +738,513 @@ namespace mn
 	{
 		return str_cmp(a, b.ptr) >= 0;
 	}
+
+
+	inline static bool
+	operator==(Str_View a, Str_View b)
+	{
+		return a.count == b.count && (a.count == 0 || ::memcmp(a.ptr, b.ptr, a.count) == 0);
+	}
+
+	inline static bool
+	operator!=(Str_View a, Str_View b)
+	{
+		return !(a == b);
+	}
+
+	inline static bool
+	operator==(const Str& a, Str_View b)
+	{
+		return str_view(a) == b;
+	}
+
+	inline static bool
+	operator!=(const Str& a, Str_View b)
+	{
+		return !(str_view(a) == b);
+	}
+
+	inline static bool
+	operator==(Str_View a, const Str& b)
+	{
+		return a == str_view(b);
+	}
+
+	inline static bool
+	operator!=(Str_View a, const Str& b)
+	{
+		return !(a == str_view(b));
+	}
+
+	inline static bool
+	operator==(Str_View a, const char* b)
+	{
+		return a == str_view(b);
+	}
+
+	inline static bool
+	operator!=(Str_View a, const char* b)
+	{
+		return !(a == str_view(b));
+	}
+
+	// returns a pointer to the first character of the view, used in range for loops
+	inline static const char*
+	begin(Str_View self)
+	{
+		return self.ptr;
+	}
+
+	// returns a pointer to one past the last character of the view, used in range for loops
+	inline static const char*
+	end(Str_View self)
+	{
+		return self.ptr + self.count;
+	}
+
+	// returns whether the view is empty
+	inline static bool
+	str_view_empty(Str_View self)
+	{
+		return self.count == 0;
+	}
+
+	// returns a sub view which starts at the given index with the given count, the count is clamped to the end of the
+	// view, and starting at the end of the view returns an empty view
+	inline static Str_View
+	str_view_sub(Str_View self, size_t start, size_t count = size_t(-1))
+	{
+		mn_assert_msg(start <= self.count, "Invalid SubStr");
+		auto rest = self.count - start;
+		return Str_View{self.ptr + start, count < rest ? count : rest};
+	}
+
+	// compares two views lexicographically and returns 0 if they are equal, 1 if a > b, and -1 if a < b
+	inline static int
+	str_view_cmp(Str_View a, Str_View b)
+	{
+		auto count = a.count < b.count ? a.count : b.count;
+		int res = count ? ::memcmp(a.ptr, b.ptr, count) : 0;
+		if (res != 0)
+			return res < 0 ? -1 : 1;
+		if (a.count == b.count)
+			return 0;
+		return a.count < b.count ? -1 : 1;
+	}
+
+	inline static bool
+	operator<(Str_View a, Str_View b)
+	{
+		return str_view_cmp(a, b) < 0;
+	}
+
+	inline static bool
+	operator<=(Str_View a, Str_View b)
+	{
+		return str_view_cmp(a, b) <= 0;
+	}
+
+	inline static bool
+	operator>(Str_View a, Str_View b)
+	{
+		return str_view_cmp(a, b) > 0;
+	}
+
+	inline static bool
+	operator>=(Str_View a, Str_View b)
+	{
+		return str_view_cmp(a, b) >= 0;
+	}
+
+	// searches for the given target in the view starting from the given index, returns the index of the first match or
+	// size_t(-1) if it's not found
+	MN_EXPORT size_t
+	str_view_find(Str_View self, Str_View target, size_t start = 0);
+
+	// searches for the given target in the view starting from the given index, returns the index of the first match or
+	// size_t(-1) if it's not found
+	inline static size_t
+	str_view_find(Str_View self, const char* target, size_t start = 0)
+	{
+		return str_view_find(self, str_view(target), start);
+	}
+
+	// searches for the given character in the view starting from the given index, returns the index of the first match
+	// or size_t(-1) if it's not found
+	inline static size_t
+	str_view_find(Str_View self, char c, size_t start = 0)
+	{
+		if (start >= self.count)
+			return size_t(-1);
+		auto it = (const char*)::memchr(self.ptr + start, c, self.count - start);
+		if (it == nullptr)
+			return size_t(-1);
+		return size_t(it - self.ptr);
+	}
+
+	// searches for the last occurrence of the given target in the view, returns its index or size_t(-1) if it's not
+	// found
+	MN_EXPORT size_t
+	str_view_find_last(Str_View self, Str_View target);
+
+	// searches for the last occurrence of the given target in the view, returns its index or size_t(-1) if it's not
+	// found
+	inline static size_t
+	str_view_find_last(Str_View self, const char* target)
+	{
+		return str_view_find_last(self, str_view(target));
+	}
+
+	// returns whether the view starts with the given prefix
+	inline static bool
+	str_view_prefix(Str_View self, Str_View prefix)
+	{
+		return prefix.count <= self.count && (prefix.count == 0 || ::memcmp(self.ptr, prefix.ptr, prefix.count) == 0);
+	}
+
+	// returns whether the view starts with the given prefix
+	inline static bool
+	str_view_prefix(Str_View self, const char* prefix)
+	{
+		return str_view_prefix(self, str_view(prefix));
+	}
+
+	// returns whether the view ends with the given suffix
+	inline static bool
+	str_view_suffix(Str_View self, Str_View suffix)
+	{
+		return suffix.count <= self.count &&
+			(suffix.count == 0 || ::memcmp(self.ptr + self.count - suffix.count, suffix.ptr, suffix.count) == 0);
+	}
+
+	// returns whether the view ends with the given suffix
+	inline static bool
+	str_view_suffix(Str_View self, const char* suffix)
+	{
+		return str_view_suffix(self, str_view(suffix));
+	}
+
+	// returns a view without the runes at the left which when passed to the given function it will return true
+	template<typename TFunc>
+	inline static Str_View
+	str_view_trim_left_pred(Str_View self, TFunc&& f)
+	{
+		auto it = begin(self);
+		for (; it < end(self); it = rune_next(it))
+			if (f(rune_read(it)) == false)
+				break;
+		if (it > end(self))
+			it = end(self);
+		return str_view(it, end(self));
+	}
+
+	// returns a view without the runes at the right which when passed to the given function it will return true
+	template<typename TFunc>
+	inline static Str_View
+	str_view_trim_right_pred(Str_View self, TFunc&& f)
+	{
+		auto it = end(self);
+		while (it > begin(self))
+		{
+			auto prev = rune_prev(it);
+			if (prev < begin(self) || f(rune_read(prev)) == false)
+				break;
+			it = prev;
+		}
+		return str_view(begin(self), it);
+	}
+
+	// returns a view without the runes at both ends which when passed to the given function it will return true
+	template<typename TFunc>
+	inline static Str_View
+	str_view_trim_pred(Str_View self, TFunc&& f)
+	{
+		return str_view_trim_right_pred(str_view_trim_left_pred(self, f), f);
+	}
+
+	inline static bool
+	_str_view_has_rune(Str_View self, Rune r)
+	{
+		for (auto it = begin(self); it < end(self); it = rune_next(it))
+			if (rune_read(it) == r)
+				return true;
+		return false;
+	}
+
+	// returns a view without the runes of the cutset at the left, the default cutset is the whitespaces
+	inline static Str_View
+	str_view_trim_left(Str_View self, Str_View cutset = str_view("\n\t\r\v "))
+	{
+		return str_view_trim_left_pred(self, [cutset](Rune r) { return _str_view_has_rune(cutset, r); });
+	}
+
+	// returns a view without the runes of the cutset at the right, the default cutset is the whitespaces
+	inline static Str_View
+	str_view_trim_right(Str_View self, Str_View cutset = str_view("\n\t\r\v "))
+	{
+		return str_view_trim_right_pred(self, [cutset](Rune r) { return _str_view_has_rune(cutset, r); });
+	}
+
+	// returns a view without the runes of the cutset at both ends, the default cutset is the whitespaces
+	inline static Str_View
+	str_view_trim(Str_View self, Str_View cutset = str_view("\n\t\r\v "))
+	{
+		return str_view_trim_pred(self, [cutset](Rune r) { return _str_view_has_rune(cutset, r); });
+	}
+
+	// splits the view by the given delimiter into views of the original string, the returned buf is allocated from the
+	// given allocator but the pieces aren't copied
+	MN_EXPORT Buf<Str_View>
+	str_view_split(Str_View self, Str_View delim, bool skip_empty, Allocator allocator = memory::tmp());
+
+	// splits the view by the given delimiter into views of the original string, the returned buf is allocated from the
+	// given allocator but the pieces aren't copied
+	inline static Buf<Str_View>
+	str_view_split(Str_View self, const char* delim, bool skip_empty, Allocator allocator = memory::tmp())
+	{
+		return str_view_split(self, str_view(delim), skip_empty, allocator);
+	}
+
+	// an iterator over the pieces of a split string, the pieces are found lazily while iterating
+	struct Str_Split_Iterator
+	{
+		Str_View str;
+		Str_View delim;
+		bool skip_empty;
+		bool done;
+		// index of the rest of the string after the current piece and its delimiter
+		size_t index;
+		Str_View piece;
+
+		void
+		_advance()
+		{
+			while (index <= str.count)
+			{
+				auto delim_index = str_view_find(str, delim, index);
+				auto piece_end = delim_index == size_t(-1) ? str.count : delim_index;
+				piece = Str_View{str.ptr + index, piece_end - index};
+				index = delim_index == size_t(-1) ? str.count + 1 : delim_index + delim.count;
+				if (skip_empty == false || piece.count > 0)
+					return;
+			}
+			done = true;
+			piece = Str_View{};
+		}
+
+		Str_Split_Iterator&
+		operator++()
+		{
+			_advance();
+			return *this;
+		}
+
+		Str_Split_Iterator
+		operator++(int)
+		{
+			auto tmp = *this;
+			_advance();
+			return tmp;
+		}
+
+		bool
+		operator==(const Str_Split_Iterator& other) const
+		{
+			if (done || other.done)
+				return done == other.done;
+			return piece.ptr == other.piece.ptr && index == other.index;
+		}
+
+		bool
+		operator!=(const Str_Split_Iterator& other) const
+		{
+			return !operator==(other);
+		}
+
+		const Str_View&
+		operator*() const
+		{
+			return piece;
+		}
+
+		const Str_View*
+		operator->() const
+		{
+			return &piece;
+		}
+	};
+
+	// a lazily split string, which is used to make range for loops work over the split pieces
+	struct Str_Split
+	{
+		Str_View str;
+		Str_View delim;
+		bool skip_empty;
+
+		Str_Split_Iterator
+		begin() const
+		{
+			Str_Split_Iterator res{};
+			res.str = str;
+			res.delim = delim;
+			res.skip_empty = skip_empty;
+			res._advance();
+			return res;
+		}
+
+		Str_Split_Iterator
+		end() const
+		{
+			Str_Split_Iterator res{};
+			res.done = true;
+			return res;
+		}
+	};
+
+	// returns a range suitable for usage in range for loops which splits the given view by the given delimiter lazily
+	// without any allocation, it yields the same pieces as str_split
+	// ex. `for (auto line: str_split_iter(str_view(content), "\n", true))`
+	inline static Str_Split
+	str_split_iter(Str_View self, Str_View delim, bool skip_empty = false)
+	{
+		mn_assert_msg(delim.count > 0, "empty split delimiter");
+		return Str_Split{self, delim, skip_empty};
+	}
+
+	// returns a range suitable for usage in range for loops which splits the given view by the given delimiter lazily
+	// without any allocation, it yields the same pieces as str_split
+	inline static Str_Split
+	str_split_iter(Str_View self, const char* delim, bool skip_empty = false)
+	{
+		return str_split_iter(self, str_view(delim), skip_empty);
+	}
+
+	// string hasher which uses the process random seed (see hash_seed), use it for maps with untrusted keys
+	// (ex. `Map<Str, int, Str_Seeded_Hash>`) to protect against hash flooding attacks
+	struct Str_Seeded_Hash
+	{
+		inline size_t
+		operator()(Str_View str) const
+		{
+			return str.count ? hash_bytes(str.ptr, str.count, hash_seed()) : 0;
+		}
+
+		inline size_t
+		operator()(const Str& str) const
+		{
+			return operator()(str_view(str));
+		}
+
+		inline size_t
+		operator()(const char* str) const
+		{
+			return operator()(str_view(str));
+		}
+	};
+
+	// a string with its hash cached alongside it, so it's hashed only once no matter how many maps it's inserted into
+	// or looked up in, its hash is the same as the hash of the equal Str so it can be looked up using a Str or Str_View
+	struct Str_Hashed
+	{
+		Str str;
+		size_t hash;
+	};
+
+	// creates a hashed string from the given string and takes ownership of it
+	inline static Str_Hashed
+	str_hashed(Str str)
+	{
+		return Str_Hashed{str, Hash<Str>()(str)};
+	}
+
+	// frees the given hashed string
+	inline static void
+	str_hashed_free(Str_Hashed& self)
+	{
+		str_free(self.str);
+		self.hash = 0;
+	}
+
+	// destruct overload for hashed string free
+	inline static void
+	destruct(Str_Hashed& self)
+	{
+		str_hashed_free(self);
+	}
+
+	template<>
+	struct Hash<Str_Hashed>
+	{
+		inline size_t
+		operator()(const Str_Hashed& str) const
+		{
+			return str.hash;
+		}
+
+		inline size_t
+		operator()(Str_View str) const
+		{
+			return Hash<Str_View>()(str);
+		}
+
+		inline size_t
+		operator()(const Str& str) const
+		{
+			return Hash<Str>()(str);
+		}
+
+		inline size_t
+		operator()(const char* str) const
+		{
+			return Hash<Str_View>()(str_view(str));
+		}
+	};
+
+	inline static bool
+	operator==(const Str_Hashed& a, const Str_Hashed& b)
+	{
+		return a.hash == b.hash && a.str == b.str;
+	}
+
+	inline static bool
+	operator!=(const Str_Hashed& a, const Str_Hashed& b)
+	{
+		return !(a == b);
+	}
+
+	inline static bool
+	operator==(const Str_Hashed& a, Str_View b)
+	{
+		return str_view(a.str) == b;
+	}
+
+	inline static bool
+	operator!=(const Str_Hashed& a, Str_View b)
+	{
+		return !(a == b);
+	}
+
+	inline static bool
+	operator==(const Str_Hashed& a, const Str& b)
+	{
+		return a.str == b;
+	}
+
+	inline static bool
+	operator!=(const Str_Hashed& a, const Str& b)
+	{
+		return !(a == b);
+	}
+
+	inline static bool
+	operator==(const Str_Hashed& a, const char* b)
+	{
+		return a.str == b;
+	}
+
+	inline static bool
+	operator!=(const Str_Hashed& a, const char* b)
+	{
+		return !(a == b);
+	}
 }
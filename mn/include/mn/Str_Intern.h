@@ -63,4 +63,68 @@ namespace mn
 	// interns the given a string and returns the string pointer to the interned string
 	MN_EXPORT const char*
 	str_intern(Str_Intern& self, const char* begin, const char* end);
-}
\ No newline at end of file
+
+	// invalid symbol id of the concurrent string interner, returned when a string is not interned
+	constexpr uint32_t STR_INTERN_INVALID_ID = UINT32_MAX;
+
+	// thread safe string interner which maps each unique string to a stable 32-bit symbol id, ids are dense and given
+	// in the order of interning (0, 1, 2, ...) so they can index into side tables, strings are stored null terminated
+	// and contiguously in an arena with their hashes, lookup of already interned strings (and id to string) is lock
+	// free, only interning new strings takes a lock
+	typedef struct IConcurrent_Str_Intern* Concurrent_Str_Intern;
+
+	// creates a new concurrent string interner, its internal memory is allocated from the given allocator
+	MN_EXPORT Concurrent_Str_Intern
+	concurrent_str_intern_new(Allocator allocator = allocator_top());
+
+	// frees the given concurrent string interner
+	MN_EXPORT void
+	concurrent_str_intern_free(Concurrent_Str_Intern self);
+
+	// destruct overload for concurrent string intern free
+	inline static void
+	destruct(Concurrent_Str_Intern self)
+	{
+		concurrent_str_intern_free(self);
+	}
+
+	// interns the given string and returns its symbol id
+	MN_EXPORT uint32_t
+	concurrent_str_intern(Concurrent_Str_Intern self, Str_View str);
+
+	// interns the given string and returns its symbol id
+	inline static uint32_t
+	concurrent_str_intern(Concurrent_Str_Intern self, const char* str)
+	{
+		return concurrent_str_intern(self, str_view(str));
+	}
+
+	// interns the given string and returns its symbol id
+	inline static uint32_t
+	concurrent_str_intern(Concurrent_Str_Intern self, const Str& str)
+	{
+		return concurrent_str_intern(self, str_view(str));
+	}
+
+	// returns the symbol id of the given string if it's interned, or STR_INTERN_INVALID_ID otherwise, it doesn't take
+	// any locks
+	MN_EXPORT uint32_t
+	concurrent_str_intern_lookup(Concurrent_Str_Intern self, Str_View str);
+
+	// returns the symbol id of the given string if it's interned, or STR_INTERN_INVALID_ID otherwise, it doesn't take
+	// any locks
+	inline static uint32_t
+	concurrent_str_intern_lookup(Concurrent_Str_Intern self, const char* str)
+	{
+		return concurrent_str_intern_lookup(self, str_view(str));
+	}
+
+	// returns the interned string of the given symbol id, the returned view is null terminated and valid until the
+	// interner is freed, it doesn't take any locks
+	MN_EXPORT Str_View
+	concurrent_str_intern_str(Concurrent_Str_Intern self, uint32_t id);
+
+	// returns the count of the interned strings
+	MN_EXPORT size_t
+	concurrent_str_intern_count(Concurrent_Str_Intern self);
+}
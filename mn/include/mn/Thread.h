@@ -5,6 +5,7 @@
 #include "mn/OS.h"
 
 #include <stdint.h>
+#include <atomic>
 
 #define mn_mutex_new_with_srcloc(name) mn::mutex_new_with_srcloc([&](const char* func_name) -> const mn::Source_Location* { const static mn::Source_Location srcloc { name, func_name, __FILE__, __LINE__, 0 }; return &srcloc; }(__FUNCTION__))
 #define mn_mutex_rw_new_with_srcloc(name) mn::mutex_rw_new_with_srcloc([&](const char* func_name) -> const mn::Source_Location* { const static mn::Source_Location srcloc { name, func_name, __FILE__, __LINE__, 0 }; return &srcloc; }(__FUNCTION__))
@@ -14,9 +15,6 @@ namespace mn
 	// mutex handle
 	typedef struct IMutex* Mutex;
 
-	MN_EXPORT Mutex
-	_leak_allocator_mutex();
-
 	// creates a new mutex with the given source location info, which is useful for debugging and profiling
 	MN_EXPORT Mutex
 	mutex_new_with_srcloc(const Source_Location* srcloc);
@@ -293,4 +291,17 @@ namespace mn
 			waitgroup_wait(handle);
 		}
 	};
+
+	// blocks the calling thread while the given value is equal to the expected value, it's a thin wrapper over the os
+	// futex (WaitOnAddress on windows), it may return spuriously so you should recheck your condition in a loop
+	MN_EXPORT void
+	futex_wait(const std::atomic<uint32_t>& value, uint32_t expected);
+
+	// wakes up one of the threads waiting on the given value
+	MN_EXPORT void
+	futex_wake_one(std::atomic<uint32_t>& value);
+
+	// wakes up all the threads waiting on the given value
+	MN_EXPORT void
+	futex_wake_all(std::atomic<uint32_t>& value);
 }
@@ -31,6 +31,7 @@ namespace mn::memory
 			size_t total_mem;
 			size_t used_mem;
 			size_t highwater_mem;
+			size_t allocations_count;
 		};
 
 		Interface* meta;
@@ -44,6 +45,11 @@ namespace mn::memory
 		size_t used_mem;
 		// peak memory usage in bytes
 		size_t highwater_mem;
+		// count of the allocations in the used memory
+		size_t allocations_count;
+		// count and size in bytes of all the allocations done since the arena was created
+		size_t total_allocations_count;
+		size_t total_allocations_size;
 		// determines the threshold amount of temporary memory between the current and previous highwater
 		// that will trigger a readjust (free/realloc), default value is 4MB
 		size_t clear_all_readjust_threshold;
@@ -87,6 +93,11 @@ namespace mn::memory
 
 		MN_EXPORT void
 		restore(State state);
+
+		// returns the memory usage stats of the arena, the live size is the used memory and the reserved size is the
+		// total memory
+		MN_EXPORT Stats
+		stats() const override;
 	};
 }
 
@@ -4,8 +4,28 @@
 #include "mn/memory/Interface.h"
 #include "mn/memory/Virtual.h"
 
+#include <stdint.h>
+
+namespace mn
+{
+	typedef struct IMutex* Mutex;
+}
+
 namespace mn::memory
 {
+	// buddy allocator behaviour flags, you can combine them using bitwise or
+	enum BUDDY_FLAGS: uint32_t
+	{
+		// a single fixed heap, allocations fail once it's exhausted, and no locking is done
+		BUDDY_FLAGS_NONE = 0,
+		// adds a new heap (of the same heap size) when the existing heaps can't satisfy an allocation
+		// and releases heaps back to the meta allocator once they become empty, one empty heap is kept
+		// as a spare so that a workload around a heap boundary doesn't map/unmap heaps on every call
+		BUDDY_FLAGS_GROWABLE = 1 << 0,
+		// guards alloc/free with a mutex so that the allocator can be shared between threads
+		BUDDY_FLAGS_THREAD_SAFE = 1 << 1,
+	};
+
 	// a general purpose buddy allocator, which acts as a containerized malloc
 	// implementation, with a log(N) complexity for both alloc and free
 	struct Buddy : Interface
@@ -16,10 +36,77 @@ namespace mn::memory
 			Node* next;
 		};
 
+		// a single power of 2 sized region of memory which is managed as a binary tree of blocks
+		struct Heap
+		{
+			// the entire memory of the heap including the book keeping data
+			Block memory;
+
+			// Each bucket corresponds to a certain allocation size and stores a free list
+			// for that size. The bucket at index 0 corresponds to an allocation size of
+			// max_alloc (i.e. the whole heap)
+			//
+			// Free lists are stored as circular doubly-linked lists. Every possible
+			// allocation size has an associated free list that is threaded through all
+			// currently free blocks of that size.
+			Node* buckets;
+
+			// bitmap of the non empty buckets, bit i is set if buckets[i] free list is not empty
+			// it's used to find the smallest free block that fits a request without scanning
+			// every bucket's free list
+			uint64_t buckets_mask;
+
+			// This array represents a linearized binary tree of bits. Every possible
+			// allocation larger than MIN_ALLOC has a node in this tree (and therefore a
+			// bit in this array).
+			//
+			// Given the index for a node, lineraized binary trees allow you to traverse to
+			// the parent node or the child nodes just by doing simple arithmetic on the
+			// index:
+			// - Move to parent:         index = (index - 1) / 2;
+			// - Move to left child:     index = index * 2 + 1;
+			// - Move to right child:    index = index * 2 + 2;
+			// - Move to sibling:        index = ((index - 1) ^ 1) + 1;
+			//
+			// Each node in this tree can be in one of several states:
+			//
+			// - UNUSED (both children are UNUSED)
+			// - SPLIT (one child is UNUSED and the other child isn't)
+			// - USED (neither children are UNUSED)
+			//
+			// These states take two bits to store. However, it turns out we have enough
+			// information to distinguish between UNUSED and USED from context, so we only
+			// need to store SPLIT or not, which only takes a single bit.
+			//
+			// Note that we don't need to store any nodes for allocations of size MIN_ALLOC
+			// since we only ever care about parent nodes.
+			uint8_t* node_is_split;
+
+			// This is the starting address of the address range for this heap. Every
+			// returned allocation will be an offset of this pointer from 0 to MAX_ALLOC.
+			uint8_t* base_ptr;
+
+			// count of the live allocations in this heap, when it reaches 0 the heap is empty
+			size_t allocations_count;
+		};
+
 		Interface* meta;
-		Block memory;
 
-		// maximum allocation size is set to (2**max_alloc_log2)
+		// combination of BUDDY_FLAGS
+		uint32_t flags;
+
+		// mutex which guards the allocator in case of BUDDY_FLAGS_THREAD_SAFE, nullptr otherwise
+		Mutex mtx;
+
+		// array of heaps sorted by their base address, so the owner heap of a block is found
+		// using binary search
+		Heap** heaps;
+		size_t heaps_count;
+		size_t heaps_cap;
+		// count of the heaps with no live allocations, at most 1 empty heap is kept
+		size_t empty_heaps_count;
+
+		// maximum allocation size is set to (2**max_alloc_log2) which is also the heap size
 		size_t max_alloc_log2;
 		size_t max_alloc;
 
@@ -31,63 +118,21 @@ namespace mn::memory
 		// found with "(size_t)1 << (MAX_ALLOC_LOG2 - bucket)"
 		size_t bucket_max;
 
-		// Each bucket corresponds to a certain allocation size and stores a free list
-		// for that size. The bucket at index 0 corresponds to an allocation size of
-		// MAX_ALLOC (i.e. the whole address space)
-		Node*  buckets;
-		// Free lists are stored as circular doubly-linked lists. Every possible
-		// allocation size has an associated free list that is threaded through all
-		// currently free blocks of that size.
-		//
-		// We could initialize the allocator by giving it one free block the size of
-		// the entire address space. However, this would cause us to instantly reserve
-		// half of the entire address space on the first allocation, since the first
-		// split would store a free list entry at the start of the right child of the
-		// root. Instead, we have the tree start out small and grow the size of the
-		// tree as we use more memory. The size of the tree is tracked by this value
-		size_t bucket_count;
-
-		// This array represents a linearized binary tree of bits. Every possible
-		// allocation larger than MIN_ALLOC has a node in this tree (and therefore a
-		// bit in this array).
-		//
-		// Given the index for a node, lineraized binary trees allow you to traverse to
-		// the parent node or the child nodes just by doing simple arithmetic on the
-		// index:
-		// - Move to parent:         index = (index - 1) / 2;
-		// - Move to left child:     index = index * 2 + 1;
-		// - Move to right child:    index = index * 2 + 2;
-		// - Move to sibling:        index = ((index - 1) ^ 1) + 1;
-		//
-		// Each node in this tree can be in one of several states:
-		//
-		// - UNUSED (both children are UNUSED)
-		// - SPLIT (one child is UNUSED and the other child isn't)
-		// - USED (neither children are UNUSED)
-		//
-		// These states take two bits to store. However, it turns out we have enough
-		// information to distinguish between UNUSED and USED from context, so we only
-		// need to store SPLIT or not, which only takes a single bit.
-		//
-		// Note that we don't need to store any nodes for allocations of size MIN_ALLOC
-		// since we only ever care about parent nodes.
-		uint8_t* node_is_split;
-
-		// This is the starting address of the address range for this allocator. Every
-		// returned allocation will be an offset of this pointer from 0 to MAX_ALLOC.
-		uint8_t* base_ptr;
-
-		// This is the maximum address that has ever been used by the allocator. It's
-		// used to know when to call "brk" to request more memory from the kernel.
-		uint8_t* max_ptr;
+		// size in bytes and count of the live allocations, and the peak of the live size
+		size_t used_mem;
+		size_t allocations_count;
+		size_t highwater_mem;
+		// count and size in bytes of all the allocations done since the allocator was created
+		size_t total_allocations_count;
+		size_t total_allocations_size;
 
 		// creates a new instance of buddy allocator
 		MN_EXPORT
-		Buddy(size_t heap_size, Interface* meta = virtual_mem());
+		Buddy(size_t heap_size, Interface* meta = virtual_mem(), uint32_t flags = BUDDY_FLAGS_NONE);
 
 		// frees the given instance of the allocator
 		MN_EXPORT
-		~Buddy();
+		~Buddy() override;
 
 		// allocates a block with the given size and alignement
 		MN_EXPORT Block
@@ -96,5 +141,10 @@ namespace mn::memory
 		// frees the given block, in case the block is empty it does nothing
 		MN_EXPORT void
 		free(Block block) override;
+
+		// returns the memory usage stats of the allocator, the reserved size is the total size of the heaps
+		// so the waste includes the internal fragmentation of rounding the allocations up to powers of 2
+		MN_EXPORT Stats
+		stats() const override;
 	};
 }
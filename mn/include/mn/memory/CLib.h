@@ -12,6 +12,8 @@ namespace mn::memory
 	// a wrapper around system's libc allocator
 	struct CLib : Interface
 	{
+		Atomic_Stats atomic_stats;
+
 		// uses malloc to allocate the given block
 		MN_EXPORT Block
 		alloc(size_t size, uint8_t alignment) override;
@@ -19,6 +21,10 @@ namespace mn::memory
 		// frees the given block, if the block is empty it does nothing
 		MN_EXPORT void
 		free(Block block) override;
+
+		// returns the stats of the memory allocated through this allocator (not the entire process heap)
+		MN_EXPORT Stats
+		stats() const override;
 	};
 
 	// returns the global instance of the libc allocator
@@ -35,6 +35,10 @@ namespace mn::memory
 		// frees the given block of memory, and untracks it, if the block is empty it does nothing
 		MN_EXPORT void
 		free(Block block) override;
+
+		// returns the live memory stats of the allocator
+		MN_EXPORT Stats
+		stats() const override;
 	};
 
 	// returns the global instance of the fast leak allocator
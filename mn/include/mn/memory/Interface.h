@@ -2,16 +2,133 @@
 
 #include "mn/Base.h"
 
+#include <atomic>
+
 #include <stdint.h>
 #include <stddef.h>
 
 namespace mn::memory
 {
+	// memory usage statistics of an allocator, the values which an allocator can't track are left as 0
+	struct Stats
+	{
+		// size in bytes of the currently live allocations
+		size_t live_size;
+		// count of the currently live allocations
+		size_t live_count;
+		// peak of the live size in bytes
+		size_t peak_size;
+		// count of all the allocations done since the allocator was created
+		size_t total_count;
+		// size in bytes of all the allocations done since the allocator was created
+		size_t total_size;
+		// size in bytes of the memory held by the allocator from its meta allocator (or the OS), the difference
+		// between it and the live size is the memory wasted in fragmentation and unused capacity
+		size_t reserved_size;
+	};
+
 	// memory allocators interface, all memory allocators should implement this interface
 	struct Interface
 	{
 		virtual ~Interface() = default;
 		virtual Block alloc(size_t size, uint8_t alignment) = 0;
 		virtual void free(Block block) = 0;
+		// returns the memory usage statistics of the allocator, by default it returns empty stats
+		virtual Stats stats() const { return Stats{}; }
+	};
+
+	// size of the cache line, the stats shards are separated by a padding of this size to avoid false sharing
+	constexpr size_t ATOMIC_STATS_CACHE_LINE_SIZE = 64;
+	// count of the stats shards, threads are assigned to shards in a round robin fashion
+	constexpr size_t ATOMIC_STATS_SHARDS_COUNT = 16;
+	// the peak size is refreshed every this many allocations of a shard (power of 2)
+	constexpr size_t ATOMIC_STATS_PEAK_PERIOD = 256;
+
+	// thread safe stats counters which are used by the global allocators since they're shared between threads,
+	// the counters are sharded per thread and summed when loaded so that the alloc/free hot path doesn't contend
+	// on a single cache line, the peak size is sampled so it's an approximation
+	struct Atomic_Stats
+	{
+		struct Shard
+		{
+			// live counters could underflow in a single shard if the memory is freed by another thread
+			// but the wrapped around sum of all the shards is still correct
+			std::atomic<size_t> live_size;
+			std::atomic<size_t> live_count;
+			std::atomic<size_t> total_count;
+			std::atomic<size_t> total_size;
+			char _pad[ATOMIC_STATS_CACHE_LINE_SIZE];
+		};
+
+		char _pad[ATOMIC_STATS_CACHE_LINE_SIZE];
+		Shard shards[ATOMIC_STATS_SHARDS_COUNT];
+		mutable std::atomic<size_t> peak_size;
+
+		static Shard&
+		_shard(Atomic_Stats* self)
+		{
+			static std::atomic<size_t> next_index;
+			thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % ATOMIC_STATS_SHARDS_COUNT;
+			return self->shards[index];
+		}
+
+		void
+		on_alloc(size_t size)
+		{
+			auto& shard = _shard(this);
+			shard.live_size.fetch_add(size, std::memory_order_relaxed);
+			shard.live_count.fetch_add(1, std::memory_order_relaxed);
+			auto total_count = shard.total_count.fetch_add(1, std::memory_order_relaxed) + 1;
+			shard.total_size.fetch_add(size, std::memory_order_relaxed);
+
+			if (total_count % ATOMIC_STATS_PEAK_PERIOD == 0)
+				_update_peak(_live_size());
+		}
+
+		void
+		on_free(size_t size)
+		{
+			auto& shard = _shard(this);
+			shard.live_size.fetch_sub(size, std::memory_order_relaxed);
+			shard.live_count.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		Stats
+		load() const
+		{
+			Stats res{};
+			for (const auto& shard: shards)
+			{
+				res.live_size += shard.live_size.load(std::memory_order_relaxed);
+				res.live_count += shard.live_count.load(std::memory_order_relaxed);
+				res.total_count += shard.total_count.load(std::memory_order_relaxed);
+				res.total_size += shard.total_size.load(std::memory_order_relaxed);
+			}
+			// the shards are read one by one so the sum might be a transient negative value
+			if (int64_t(res.live_size) < 0)
+				res.live_size = 0;
+			if (int64_t(res.live_count) < 0)
+				res.live_count = 0;
+			res.peak_size = _update_peak(res.live_size);
+			return res;
+		}
+
+		size_t
+		_live_size() const
+		{
+			size_t res = 0;
+			for (const auto& shard: shards)
+				res += shard.live_size.load(std::memory_order_relaxed);
+			return int64_t(res) < 0 ? 0 : res;
+		}
+
+		size_t
+		_update_peak(size_t live_size) const
+		{
+			auto peak = peak_size.load(std::memory_order_relaxed);
+			while (live_size > peak && peak_size.compare_exchange_weak(peak, live_size, std::memory_order_relaxed) == false)
+			{}
+			return live_size > peak ? live_size : peak;
+		}
 	};
 }
@@ -6,6 +6,8 @@
 #include "mn/Str.h"
 #include "mn/Thread.h"
 
+#include <atomic>
+
 #include <stdint.h>
 #include <stddef.h>
 
@@ -14,9 +16,13 @@ namespace mn::memory
 	// a full leak detector with call stack traces, which tracks allocations and their locations. if the program exists
 	// without freeing a block of memory it will report the leak to stderr along with the allocation location in terms
 	// of call stack and filenames and lines of each call
+	// live allocations are tracked in shards selected by the allocation address, each shard is guarded by its own
+	// spin lock so that threads allocating concurrently rarely contend on the same list
 	struct Leak: Interface
 	{
 		constexpr static inline int CALLSTACK_MAX_FRAMES = 20;
+		constexpr static inline size_t SHARDS_COUNT = 64;
+
 		struct Node
 		{
 			size_t size;
@@ -25,10 +31,22 @@ namespace mn::memory
 			Node* prev;
 		};
 
-		Node* head;
-		Mutex mtx;
+		// a list of live allocations, aligned to cache line to avoid false sharing between shards
+		struct alignas(64) Shard
+		{
+			std::atomic<bool> locked;
+			Node* head;
+		};
+
+		Shard shards[SHARDS_COUNT];
 		bool report_on_destruct;
 
+		// controls how often the allocation call stack is captured, a value of N captures the call stack of every
+		// Nth allocation of each thread, 1 captures all the call stacks (default), and 0 disables the capture
+		// capturing the call stack is the most expensive part of the allocation, so sampling it makes the leak
+		// detector usable under heavy load at the cost of some leaks being reported without call stacks
+		std::atomic<size_t> callstack_sample_rate;
+
 		// creates a new instance of the leak detector allocator
 		MN_EXPORT
 		Leak();
@@ -17,6 +17,11 @@ namespace mn::memory
 		Block memory;
 		uint8_t* alloc_head;
 		size_t allocations_count;
+		// peak memory usage in bytes
+		size_t highwater_mem;
+		// count and size in bytes of all the allocations done since the stack was created
+		size_t total_allocations_count;
+		size_t total_allocations_size;
 
 		// creates a new stack allocator instance with the given size in bytes and the meta allocator (defaults to clib)
 		MN_EXPORT
@@ -38,5 +43,9 @@ namespace mn::memory
 		// resets the entire stack back to its initial state, thus freeing the entire memory
 		MN_EXPORT void
 		free_all();
+
+		// returns the memory usage stats of the stack, the reserved size is the entire stack size
+		MN_EXPORT Stats
+		stats() const override;
 	};
 }
@@ -12,6 +12,8 @@ namespace mn::memory
 	// virtual memory allocator which allocates memory directly from the OS's virtual table
 	struct Virtual : Interface
 	{
+		Atomic_Stats atomic_stats;
+
 		~Virtual() = default;
 
 		// allocates and commits a new memory block with the given size and alignment
@@ -21,6 +23,10 @@ namespace mn::memory
 		// frees the given memory block, if the block is empty it does nothing
 		MN_EXPORT void
 		free(Block block) override;
+
+		// returns the stats of the memory allocated through this allocator
+		MN_EXPORT Stats
+		stats() const override;
 	};
 
 	// returns the global virtual memory allocator instance
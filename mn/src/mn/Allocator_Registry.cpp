@@ -0,0 +1,84 @@
+#include "mn/Allocator_Registry.h"
+#include "mn/Thread.h"
+#include "mn/Defer.h"
+
+namespace mn
+{
+	struct Allocator_Registry
+	{
+		Mutex mtx;
+		Buf<Allocator_Registry_Entry> entries;
+
+		Allocator_Registry()
+		{
+			mtx = mutex_new("allocator registry mutex");
+			entries = buf_with_allocator<Allocator_Registry_Entry>(memory::clib());
+		}
+
+		~Allocator_Registry()
+		{
+			destruct(entries);
+			mutex_free(mtx);
+		}
+	};
+
+	inline static Allocator_Registry*
+	_allocator_registry()
+	{
+		static Allocator_Registry _registry;
+		return &_registry;
+	}
+
+	// API
+	void
+	allocator_register(Allocator allocator, const char* name)
+	{
+		auto self = _allocator_registry();
+		mutex_lock(self->mtx);
+		mn_defer(mutex_unlock(self->mtx));
+
+		for (auto& entry: self->entries)
+		{
+			if (entry.allocator == allocator)
+			{
+				str_clear(entry.name);
+				str_push(entry.name, name);
+				return;
+			}
+		}
+
+		buf_push(self->entries, Allocator_Registry_Entry{str_from_c(name, memory::clib()), allocator, memory::Stats{}});
+	}
+
+	void
+	allocator_unregister(Allocator allocator)
+	{
+		auto self = _allocator_registry();
+		mutex_lock(self->mtx);
+		mn_defer(mutex_unlock(self->mtx));
+
+		for (size_t i = 0; i < self->entries.count; ++i)
+		{
+			if (self->entries[i].allocator == allocator)
+			{
+				allocator_registry_entry_free(self->entries[i]);
+				buf_remove_ordered(self->entries, i);
+				return;
+			}
+		}
+	}
+
+	Buf<Allocator_Registry_Entry>
+	allocator_registry_snapshot(Allocator allocator)
+	{
+		auto self = _allocator_registry();
+		mutex_lock(self->mtx);
+		mn_defer(mutex_unlock(self->mtx));
+
+		auto res = buf_with_allocator<Allocator_Registry_Entry>(allocator);
+		buf_reserve(res, self->entries.count);
+		for (const auto& entry: self->entries)
+			buf_push(res, Allocator_Registry_Entry{str_from_c(entry.name.ptr, allocator), entry.allocator, entry.allocator->stats()});
+		return res;
+	}
+}
@@ -0,0 +1,556 @@
+#include "mn/Bitset.h"
+#include "mn/Sort.h"
+#include "mn/Memory.h"
+
+#if ARCH_X86
+#include <emmintrin.h>
+#endif
+
+namespace mn
+{
+	enum BITSET_OP
+	{
+		BITSET_OP_AND,
+		BITSET_OP_OR,
+		BITSET_OP_XOR,
+		BITSET_OP_ANDNOT,
+	};
+
+	// dst[i] = dst[i] op src[i], two words at a time using SSE2
+	template<BITSET_OP op>
+	inline static void
+	_bitset_words_op(uint64_t* dst, const uint64_t* src, size_t count)
+	{
+		size_t i = 0;
+		#if ARCH_X86
+			for (; i + 2 <= count; i += 2)
+			{
+				auto a = _mm_loadu_si128((const __m128i*)(dst + i));
+				auto b = _mm_loadu_si128((const __m128i*)(src + i));
+				__m128i r;
+				if constexpr (op == BITSET_OP_AND)
+					r = _mm_and_si128(a, b);
+				else if constexpr (op == BITSET_OP_OR)
+					r = _mm_or_si128(a, b);
+				else if constexpr (op == BITSET_OP_XOR)
+					r = _mm_xor_si128(a, b);
+				else
+					r = _mm_andnot_si128(b, a);
+				_mm_storeu_si128((__m128i*)(dst + i), r);
+			}
+		#endif
+		for (; i < count; ++i)
+		{
+			if constexpr (op == BITSET_OP_AND)
+				dst[i] &= src[i];
+			else if constexpr (op == BITSET_OP_OR)
+				dst[i] |= src[i];
+			else if constexpr (op == BITSET_OP_XOR)
+				dst[i] ^= src[i];
+			else
+				dst[i] &= ~src[i];
+		}
+	}
+
+	inline static size_t
+	_bitset_words_popcount(const uint64_t* words, size_t count)
+	{
+		// multiple accumulators break the dependency chain between the popcount instructions
+		size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			c0 += _bitset_popcount(words[i + 0]);
+			c1 += _bitset_popcount(words[i + 1]);
+			c2 += _bitset_popcount(words[i + 2]);
+			c3 += _bitset_popcount(words[i + 3]);
+		}
+		for (; i < count; ++i)
+			c0 += _bitset_popcount(words[i]);
+		return c0 + c1 + c2 + c3;
+	}
+
+	inline static size_t
+	_bitset_words_count(size_t bits_count)
+	{
+		return (bits_count + 63) / 64;
+	}
+
+	inline static Roaring_Container
+	_roaring_container_new(uint16_t key, Allocator allocator)
+	{
+		Roaring_Container self{};
+		self.key = key;
+		self.array = buf_with_allocator<uint16_t>(allocator);
+		self.bitmap = buf_with_allocator<uint64_t>(allocator);
+		return self;
+	}
+
+	inline static void
+	_roaring_container_free(Roaring_Container& self)
+	{
+		buf_free(self.array);
+		buf_free(self.bitmap);
+	}
+
+	inline static void
+	_roaring_container_to_bitmap(Roaring_Container& self)
+	{
+		buf_resize_fill(self.bitmap, ROARING_BITMAP_WORDS_COUNT, uint64_t(0));
+		for (auto low: self.array)
+			self.bitmap[low >> 6] |= uint64_t(1) << (low & 63);
+		buf_free(self.array);
+	}
+
+	inline static void
+	_roaring_container_to_array(Roaring_Container& self)
+	{
+		buf_clear(self.array);
+		buf_reserve(self.array, self.count);
+		for (size_t i = 0; i < self.bitmap.count; ++i)
+		{
+			auto word = self.bitmap[i];
+			while (word)
+			{
+				buf_push(self.array, uint16_t(i * 64 + _bitset_ctz(word)));
+				word &= word - 1;
+			}
+		}
+		buf_free(self.bitmap);
+	}
+
+	// converts the container to the representation which fits its count
+	inline static void
+	_roaring_container_normalize(Roaring_Container& self)
+	{
+		if (self.bitmap.count > 0 && self.count <= ROARING_ARRAY_MAX_COUNT)
+			_roaring_container_to_array(self);
+		else if (self.bitmap.count == 0 && self.count > ROARING_ARRAY_MAX_COUNT)
+			_roaring_container_to_bitmap(self);
+	}
+
+	// returns the index of the container with the given key, or the index where it should be inserted
+	inline static size_t
+	_roaring_find(const Roaring_Bitset& self, uint16_t key)
+	{
+		return lower_bound(self.containers.ptr, self.containers.count, key, [](const Roaring_Container& c, uint16_t k) {
+			return c.key < k;
+		});
+	}
+
+	// writes the container as a bitmap into the given words
+	inline static void
+	_roaring_container_expand(const Roaring_Container& self, uint64_t* words)
+	{
+		if (self.bitmap.count > 0)
+		{
+			::memcpy(words, self.bitmap.ptr, sizeof(uint64_t) * ROARING_BITMAP_WORDS_COUNT);
+		}
+		else
+		{
+			::memset(words, 0, sizeof(uint64_t) * ROARING_BITMAP_WORDS_COUNT);
+			for (auto low: self.array)
+				words[low >> 6] |= uint64_t(1) << (low & 63);
+		}
+	}
+
+	// merges two sorted arrays, emitting the items which are only in a, only in b, or in both according to the op
+	template<BITSET_OP op>
+	inline static void
+	_roaring_array_merge(const Buf<uint16_t>& a, const Buf<uint16_t>& b, Buf<uint16_t>& out)
+	{
+		constexpr bool emit_a = op == BITSET_OP_OR || op == BITSET_OP_XOR || op == BITSET_OP_ANDNOT;
+		constexpr bool emit_b = op == BITSET_OP_OR || op == BITSET_OP_XOR;
+		constexpr bool emit_both = op == BITSET_OP_AND || op == BITSET_OP_OR;
+
+		size_t i = 0, j = 0;
+		while (i < a.count && j < b.count)
+		{
+			if (a[i] < b[j])
+			{
+				if (emit_a)
+					buf_push(out, a[i]);
+				++i;
+			}
+			else if (b[j] < a[i])
+			{
+				if (emit_b)
+					buf_push(out, b[j]);
+				++j;
+			}
+			else
+			{
+				if (emit_both)
+					buf_push(out, a[i]);
+				++i;
+				++j;
+			}
+		}
+		if (emit_a)
+			buf_concat(out, a.ptr + i, a.ptr + a.count);
+		if (emit_b)
+			buf_concat(out, b.ptr + j, b.ptr + b.count);
+	}
+
+	// applies the given op to two containers with the same key, the result might be empty
+	template<BITSET_OP op>
+	inline static Roaring_Container
+	_roaring_container_op(const Roaring_Container& a, const Roaring_Container& b, uint64_t* scratch, Allocator allocator)
+	{
+		auto res = _roaring_container_new(a.key, allocator);
+		bool a_array = a.bitmap.count == 0;
+		bool b_array = b.bitmap.count == 0;
+
+		if (a_array && b_array)
+		{
+			_roaring_array_merge<op>(a.array, b.array, res.array);
+			res.count = uint32_t(res.array.count);
+		}
+		else if (op == BITSET_OP_AND && (a_array || b_array))
+		{
+			// the result is at most as big as the array so probe the bitmap with the array items
+			const auto& array = a_array ? a : b;
+			const auto& bitmap = a_array ? b : a;
+			for (auto low: array.array)
+				if ((bitmap.bitmap[low >> 6] >> (low & 63)) & 1)
+					buf_push(res.array, low);
+			res.count = uint32_t(res.array.count);
+		}
+		else
+		{
+			buf_resize(res.bitmap, ROARING_BITMAP_WORDS_COUNT);
+			_roaring_container_expand(a, res.bitmap.ptr);
+			if (b_array)
+			{
+				_roaring_container_expand(b, scratch);
+				_bitset_words_op<op>(res.bitmap.ptr, scratch, ROARING_BITMAP_WORDS_COUNT);
+			}
+			else
+			{
+				_bitset_words_op<op>(res.bitmap.ptr, b.bitmap.ptr, ROARING_BITMAP_WORDS_COUNT);
+			}
+			res.count = uint32_t(_bitset_words_popcount(res.bitmap.ptr, ROARING_BITMAP_WORDS_COUNT));
+		}
+
+		_roaring_container_normalize(res);
+		return res;
+	}
+
+	inline static Roaring_Container
+	_roaring_container_clone(const Roaring_Container& other, Allocator allocator)
+	{
+		Roaring_Container self{};
+		self.key = other.key;
+		self.count = other.count;
+		self.array = buf_memcpy_clone(other.array, allocator);
+		self.bitmap = buf_memcpy_clone(other.bitmap, allocator);
+		return self;
+	}
+
+	template<BITSET_OP op>
+	inline static Roaring_Bitset
+	_roaring_bitset_op(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator)
+	{
+		constexpr bool keep_a = op == BITSET_OP_OR || op == BITSET_OP_XOR || op == BITSET_OP_ANDNOT;
+		constexpr bool keep_b = op == BITSET_OP_OR || op == BITSET_OP_XOR;
+
+		auto self = roaring_bitset_new(allocator);
+		auto scratch = buf_with_allocator<uint64_t>(memory::tmp());
+		buf_resize(scratch, ROARING_BITMAP_WORDS_COUNT);
+		mn_defer(buf_free(scratch));
+
+		size_t i = 0, j = 0;
+		while (i < a.containers.count || j < b.containers.count)
+		{
+			if (j == b.containers.count || (i < a.containers.count && a.containers[i].key < b.containers[j].key))
+			{
+				if (keep_a)
+					buf_push(self.containers, _roaring_container_clone(a.containers[i], allocator));
+				++i;
+			}
+			else if (i == a.containers.count || b.containers[j].key < a.containers[i].key)
+			{
+				if (keep_b)
+					buf_push(self.containers, _roaring_container_clone(b.containers[j], allocator));
+				++j;
+			}
+			else
+			{
+				auto res = _roaring_container_op<op>(a.containers[i], b.containers[j], scratch.ptr, allocator);
+				if (res.count > 0)
+					buf_push(self.containers, res);
+				else
+					_roaring_container_free(res);
+				++i;
+				++j;
+			}
+		}
+		return self;
+	}
+
+	// API
+	Bitset
+	bitset_new(size_t count, Allocator allocator)
+	{
+		Bitset self{};
+		self.words = buf_with_allocator<uint64_t>(allocator);
+		bitset_resize(self, count);
+		return self;
+	}
+
+	void
+	bitset_free(Bitset& self)
+	{
+		buf_free(self.words);
+		self.count = 0;
+	}
+
+	Bitset
+	bitset_clone(const Bitset& other, Allocator allocator)
+	{
+		Bitset self{};
+		self.words = buf_memcpy_clone(other.words, allocator);
+		self.count = other.count;
+		return self;
+	}
+
+	void
+	bitset_resize(Bitset& self, size_t count)
+	{
+		auto old_words_count = self.words.count;
+		auto words_count = _bitset_words_count(count);
+		buf_resize(self.words, words_count);
+		if (words_count > old_words_count)
+			::memset(self.words.ptr + old_words_count, 0, sizeof(uint64_t) * (words_count - old_words_count));
+
+		// keep the bits beyond the count unset so the bulk operations and popcount don't need to mask them
+		if (count < self.count && (count & 63))
+			self.words[words_count - 1] &= (uint64_t(1) << (count & 63)) - 1;
+		self.count = count;
+	}
+
+	void
+	bitset_clear(Bitset& self)
+	{
+		if (self.words.count > 0)
+			::memset(self.words.ptr, 0, sizeof(uint64_t) * self.words.count);
+	}
+
+	size_t
+	bitset_popcount(const Bitset& self)
+	{
+		return _bitset_words_popcount(self.words.ptr, self.words.count);
+	}
+
+	size_t
+	bitset_find_next(const Bitset& self, size_t start)
+	{
+		if (start >= self.count)
+			return BITSET_NPOS;
+
+		auto i = start >> 6;
+		auto word = self.words[i] & (~uint64_t(0) << (start & 63));
+		while (true)
+		{
+			if (word)
+				return i * 64 + _bitset_ctz(word);
+			if (++i == self.words.count)
+				return BITSET_NPOS;
+			word = self.words[i];
+		}
+	}
+
+	void
+	bitset_and(Bitset& self, const Bitset& other)
+	{
+		auto count = self.words.count < other.words.count ? self.words.count : other.words.count;
+		_bitset_words_op<BITSET_OP_AND>(self.words.ptr, other.words.ptr, count);
+		if (self.words.count > count)
+			::memset(self.words.ptr + count, 0, sizeof(uint64_t) * (self.words.count - count));
+	}
+
+	void
+	bitset_or(Bitset& self, const Bitset& other)
+	{
+		if (self.count < other.count)
+			bitset_resize(self, other.count);
+		_bitset_words_op<BITSET_OP_OR>(self.words.ptr, other.words.ptr, other.words.count);
+	}
+
+	void
+	bitset_xor(Bitset& self, const Bitset& other)
+	{
+		if (self.count < other.count)
+			bitset_resize(self, other.count);
+		_bitset_words_op<BITSET_OP_XOR>(self.words.ptr, other.words.ptr, other.words.count);
+	}
+
+	void
+	bitset_andnot(Bitset& self, const Bitset& other)
+	{
+		auto count = self.words.count < other.words.count ? self.words.count : other.words.count;
+		_bitset_words_op<BITSET_OP_ANDNOT>(self.words.ptr, other.words.ptr, count);
+	}
+
+	Roaring_Bitset
+	roaring_bitset_new(Allocator allocator)
+	{
+		Roaring_Bitset self{};
+		self.allocator = allocator;
+		self.containers = buf_with_allocator<Roaring_Container>(allocator);
+		return self;
+	}
+
+	void
+	roaring_bitset_free(Roaring_Bitset& self)
+	{
+		for (auto& container: self.containers)
+			_roaring_container_free(container);
+		buf_free(self.containers);
+	}
+
+	Roaring_Bitset
+	roaring_bitset_clone(const Roaring_Bitset& other, Allocator allocator)
+	{
+		auto self = roaring_bitset_new(allocator);
+		buf_reserve(self.containers, other.containers.count);
+		for (const auto& container: other.containers)
+			buf_push(self.containers, _roaring_container_clone(container, allocator));
+		return self;
+	}
+
+	void
+	roaring_bitset_clear(Roaring_Bitset& self)
+	{
+		for (auto& container: self.containers)
+			_roaring_container_free(container);
+		buf_clear(self.containers);
+	}
+
+	bool
+	roaring_bitset_add(Roaring_Bitset& self, uint32_t v)
+	{
+		auto key = uint16_t(v >> 16);
+		auto low = uint16_t(v & 0xFFFF);
+
+		auto index = _roaring_find(self, key);
+		if (index == self.containers.count)
+			buf_push(self.containers, _roaring_container_new(key, self.allocator));
+		else if (self.containers[index].key != key)
+			buf_insert(self.containers, index, _roaring_container_new(key, self.allocator));
+
+		auto& container = self.containers[index];
+		if (container.bitmap.count > 0)
+		{
+			auto& word = container.bitmap[low >> 6];
+			auto bit = uint64_t(1) << (low & 63);
+			if (word & bit)
+				return false;
+			word |= bit;
+		}
+		else
+		{
+			auto pos = lower_bound(container.array.ptr, container.array.count, low);
+			if (pos == container.array.count)
+				buf_push(container.array, low);
+			else if (container.array[pos] == low)
+				return false;
+			else
+				buf_insert(container.array, pos, low);
+		}
+		++container.count;
+		_roaring_container_normalize(container);
+		return true;
+	}
+
+	bool
+	roaring_bitset_remove(Roaring_Bitset& self, uint32_t v)
+	{
+		auto key = uint16_t(v >> 16);
+		auto low = uint16_t(v & 0xFFFF);
+
+		auto index = _roaring_find(self, key);
+		if (index == self.containers.count || self.containers[index].key != key)
+			return false;
+
+		auto& container = self.containers[index];
+		if (container.bitmap.count > 0)
+		{
+			auto& word = container.bitmap[low >> 6];
+			auto bit = uint64_t(1) << (low & 63);
+			if ((word & bit) == 0)
+				return false;
+			word &= ~bit;
+		}
+		else
+		{
+			auto pos = lower_bound(container.array.ptr, container.array.count, low);
+			if (pos == container.array.count || container.array[pos] != low)
+				return false;
+			buf_remove_ordered(container.array, pos);
+		}
+
+		--container.count;
+		if (container.count == 0)
+		{
+			_roaring_container_free(container);
+			buf_remove_ordered(self.containers, index);
+		}
+		else
+		{
+			_roaring_container_normalize(container);
+		}
+		return true;
+	}
+
+	bool
+	roaring_bitset_contains(const Roaring_Bitset& self, uint32_t v)
+	{
+		auto key = uint16_t(v >> 16);
+		auto low = uint16_t(v & 0xFFFF);
+
+		auto index = _roaring_find(self, key);
+		if (index == self.containers.count || self.containers[index].key != key)
+			return false;
+
+		const auto& container = self.containers[index];
+		if (container.bitmap.count > 0)
+			return (container.bitmap[low >> 6] >> (low & 63)) & 1;
+
+		auto pos = lower_bound(container.array.ptr, container.array.count, low);
+		return pos < container.array.count && container.array[pos] == low;
+	}
+
+	size_t
+	roaring_bitset_count(const Roaring_Bitset& self)
+	{
+		size_t res = 0;
+		for (const auto& container: self.containers)
+			res += container.count;
+		return res;
+	}
+
+	Roaring_Bitset
+	roaring_bitset_and(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator)
+	{
+		return _roaring_bitset_op<BITSET_OP_AND>(a, b, allocator);
+	}
+
+	Roaring_Bitset
+	roaring_bitset_or(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator)
+	{
+		return _roaring_bitset_op<BITSET_OP_OR>(a, b, allocator);
+	}
+
+	Roaring_Bitset
+	roaring_bitset_xor(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator)
+	{
+		return _roaring_bitset_op<BITSET_OP_XOR>(a, b, allocator);
+	}
+
+	Roaring_Bitset
+	roaring_bitset_andnot(const Roaring_Bitset& a, const Roaring_Bitset& b, Allocator allocator)
+	{
+		return _roaring_bitset_op<BITSET_OP_ANDNOT>(a, b, allocator);
+	}
+}
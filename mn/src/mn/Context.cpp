@@ -65,6 +65,8 @@ namespace mn
 		self->_allocator_stack_count = 1;
 
 		self->_allocator_tmp = alloc_construct_from<memory::Arena>(memory::clib(), 4ULL * 1024ULL * 1024ULL, memory::clib());
+		for (size_t i = 0; i < Context::SCRATCH_CAPACITY; ++i)
+			self->_allocator_scratch[i] = alloc_construct_from<memory::Arena>(memory::clib(), 64ULL * 1024ULL, memory::clib());
 
 		self->reader_tmp = reader_new(nullptr, memory::clib());
 	}
@@ -73,6 +75,8 @@ namespace mn
 	context_free(Context* self)
 	{
 		free_destruct_from(memory::clib(), self->_allocator_tmp);
+		for (size_t i = 0; i < Context::SCRATCH_CAPACITY; ++i)
+			free_destruct_from(memory::clib(), self->_allocator_scratch[i]);
 		reader_free(self->reader_tmp);
 	}
 
@@ -120,6 +124,32 @@ namespace mn
 		{
 			return context_local()->_allocator_tmp;
 		}
+
+		Arena*
+		scratch(const Allocator* conflicts, size_t conflicts_count)
+		{
+			auto self = context_local();
+			for (size_t i = 0; i < Context::SCRATCH_CAPACITY; ++i)
+			{
+				auto arena = self->_allocator_scratch[i];
+
+				bool conflicting = false;
+				for (size_t j = 0; j < conflicts_count; ++j)
+				{
+					if (conflicts[j] == arena)
+					{
+						conflicting = true;
+						break;
+					}
+				}
+
+				if (conflicting == false)
+					return arena;
+			}
+
+			mn_unreachable_msg("all the scratch arenas conflict with the given allocators");
+			return nullptr;
+		}
 	}
 
 	memory::Arena*
@@ -0,0 +1,407 @@
+#include "mn/Filter.h"
+#include "mn/Memory.h"
+
+#include <math.h>
+
+namespace mn
+{
+	// the filters data starts at a cache line boundary of the blob
+	constexpr static uint64_t FILTER_DATA_OFFSET = 64;
+	// max count of fingerprints which are relocated by a single cuckoo filter insert before it gives up
+	constexpr static size_t CUCKOO_FILTER_MAX_KICKS = 500;
+
+	// estimates the false positive rate of a split block bloom filter with the given bits per key, the count of keys
+	// in a block follows a poisson distribution so the rate is averaged over the possible block loads
+	inline static double
+	_bloom_filter_false_positive_rate(double bits_per_key)
+	{
+		constexpr double BLOCK_BITS = BLOOM_FILTER_BLOCK_WORDS * 32;
+		auto lambda = BLOCK_BITS / bits_per_key;
+		auto max_keys = size_t(lambda + 10 * sqrt(lambda) + 10);
+
+		double res = 0;
+		// probability of the block having exactly i keys, starting from exp(-lambda) for i = 0
+		double p = exp(-lambda);
+		for (size_t i = 0; i <= max_keys; ++i)
+		{
+			if (i > 0)
+				p *= lambda / double(i);
+			// each key sets a bit in each word, and the probe checks a single bit in each word
+			auto word_bit_set_rate = 1.0 - pow(31.0 / 32.0, double(i));
+			res += p * pow(word_bit_set_rate, double(BLOOM_FILTER_BLOCK_WORDS));
+		}
+		return res;
+	}
+
+	inline static Block
+	_filter_blob_new(uint64_t data_size, Allocator allocator)
+	{
+		auto data = alloc_from(allocator, size_t(FILTER_DATA_OFFSET + data_size), 64);
+		::memset(data.ptr, 0, data.size);
+		return data;
+	}
+
+	inline static uint32_t
+	_cuckoo_filter_random(Cuckoo_Filter_Header* header)
+	{
+		// xorshift32
+		auto x = header->random_state;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		header->random_state = x;
+		return x;
+	}
+
+	// returns the index of the lowest lane in the given bucket match mask, only the lowest lane of the mask is exact
+	inline static size_t
+	_cuckoo_filter_lowest_lane(uint64_t match)
+	{
+		mn_assert(match != 0);
+		size_t lane = 0;
+		while ((match & (uint64_t(0x8000) << (lane * 16))) == 0)
+			++lane;
+		return lane;
+	}
+
+	inline static uint16_t
+	_cuckoo_filter_lane_get(uint64_t bucket, size_t lane)
+	{
+		return uint16_t(bucket >> (lane * 16));
+	}
+
+	inline static void
+	_cuckoo_filter_lane_set(uint64_t& bucket, size_t lane, uint16_t fingerprint)
+	{
+		bucket &= ~(uint64_t(0xFFFF) << (lane * 16));
+		bucket |= uint64_t(fingerprint) << (lane * 16);
+	}
+
+	// puts the fingerprint into an empty entry of the given bucket, returns false if the bucket is full
+	inline static bool
+	_cuckoo_filter_bucket_insert(uint64_t& bucket, uint16_t fingerprint)
+	{
+		auto empty = _cuckoo_filter_bucket_match(bucket, 0);
+		if (empty == 0)
+			return false;
+		_cuckoo_filter_lane_set(bucket, _cuckoo_filter_lowest_lane(empty), fingerprint);
+		return true;
+	}
+
+	// removes a single copy of the fingerprint from the given bucket, returns false if it's not there
+	inline static bool
+	_cuckoo_filter_bucket_remove(uint64_t& bucket, uint16_t fingerprint)
+	{
+		auto match = _cuckoo_filter_bucket_match(bucket, fingerprint);
+		if (match == 0)
+			return false;
+		_cuckoo_filter_lane_set(bucket, _cuckoo_filter_lowest_lane(match), 0);
+		return true;
+	}
+
+	// inserts the fingerprint into one of its buckets, if both are full it relocates random fingerprints to their
+	// alternative buckets, if that fails the last evicted fingerprint becomes the victim so no key is lost
+	inline static void
+	_cuckoo_filter_insert_fingerprint(Cuckoo_Filter& self, uint64_t i1, uint16_t fingerprint)
+	{
+		auto header = self.header;
+		auto i2 = _cuckoo_filter_alt_index(i1, fingerprint, header->buckets_count);
+		if (_cuckoo_filter_bucket_insert(self.buckets[i1], fingerprint) ||
+			_cuckoo_filter_bucket_insert(self.buckets[i2], fingerprint))
+			return;
+
+		auto index = (_cuckoo_filter_random(header) & 1) ? i1 : i2;
+		for (size_t i = 0; i < CUCKOO_FILTER_MAX_KICKS; ++i)
+		{
+			auto lane = size_t(_cuckoo_filter_random(header) % CUCKOO_FILTER_BUCKET_SIZE);
+			auto evicted = _cuckoo_filter_lane_get(self.buckets[index], lane);
+			_cuckoo_filter_lane_set(self.buckets[index], lane, fingerprint);
+			fingerprint = evicted;
+			index = _cuckoo_filter_alt_index(index, fingerprint, header->buckets_count);
+			if (_cuckoo_filter_bucket_insert(self.buckets[index], fingerprint))
+				return;
+		}
+
+		header->victim_index = index;
+		header->victim_fingerprint = fingerprint;
+	}
+
+	inline static Bloom_Filter
+	_bloom_filter_from_data(Block data)
+	{
+		Bloom_Filter self{};
+		self.header = (Bloom_Filter_Header*)data.ptr;
+		self.blocks = (uint32_t*)((uint8_t*)data.ptr + self.header->blocks_offset);
+		return self;
+	}
+
+	inline static Cuckoo_Filter
+	_cuckoo_filter_from_data(Block data)
+	{
+		Cuckoo_Filter self{};
+		self.header = (Cuckoo_Filter_Header*)data.ptr;
+		self.buckets = (uint64_t*)((uint8_t*)data.ptr + self.header->buckets_offset);
+		return self;
+	}
+
+	// API
+	Bloom_Filter
+	bloom_filter_new(size_t expected_count, double false_positive_rate, Allocator allocator)
+	{
+		mn_assert(false_positive_rate > 0 && false_positive_rate < 1);
+		if (expected_count == 0)
+			expected_count = 1;
+
+		// search for the smallest bits per key which achieves the false positive rate, the rate decreases as the
+		// bits per key increase
+		double min_bits = 1, max_bits = 64;
+		for (size_t i = 0; i < 32; ++i)
+		{
+			auto bits = (min_bits + max_bits) / 2;
+			if (_bloom_filter_false_positive_rate(bits) > false_positive_rate)
+				min_bits = bits;
+			else
+				max_bits = bits;
+		}
+
+		constexpr uint64_t BLOCK_BITS = BLOOM_FILTER_BLOCK_WORDS * 32;
+		auto bits_count = uint64_t(ceil(max_bits * double(expected_count)));
+		auto blocks_count = (bits_count + BLOCK_BITS - 1) / BLOCK_BITS;
+		auto blocks_size = blocks_count * BLOOM_FILTER_BLOCK_WORDS * sizeof(uint32_t);
+
+		Bloom_Filter self{};
+		self.allocator = allocator;
+		self.data = _filter_blob_new(blocks_size, allocator);
+		self.header = (Bloom_Filter_Header*)self.data.ptr;
+		self.header->magic = BLOOM_FILTER_MAGIC;
+		self.header->version = BLOOM_FILTER_VERSION;
+		self.header->blocks_count = blocks_count;
+		self.header->blocks_offset = FILTER_DATA_OFFSET;
+		self.header->size = self.data.size;
+		self.blocks = (uint32_t*)((uint8_t*)self.data.ptr + FILTER_DATA_OFFSET);
+		return self;
+	}
+
+	void
+	bloom_filter_free(Bloom_Filter& self)
+	{
+		if (self.file)
+			file_unmap(self.file);
+		else if (self.data.ptr)
+			free_from(self.allocator, self.data);
+		self = Bloom_Filter{};
+	}
+
+	void
+	bloom_filter_clear(Bloom_Filter& self)
+	{
+		mn_assert_msg(self.file == nullptr, "bloom filters loaded from files are read only");
+		::memset(self.blocks, 0, size_t(self.header->blocks_count * BLOOM_FILTER_BLOCK_WORDS * sizeof(uint32_t)));
+		self.header->count = 0;
+	}
+
+	Err
+	_bloom_filter_validate(Block data)
+	{
+		if (data.ptr == nullptr || data.size < sizeof(Bloom_Filter_Header))
+			return Err{"bloom filter blob is too small"};
+		if ((uintptr_t)data.ptr % alignof(Bloom_Filter_Header) != 0)
+			return Err{"bloom filter blob is not aligned"};
+
+		auto header = (const Bloom_Filter_Header*)data.ptr;
+		if (header->magic != BLOOM_FILTER_MAGIC)
+			return Err{"invalid bloom filter magic number"};
+		if (header->version != BLOOM_FILTER_VERSION)
+			return Err{"unsupported bloom filter version {}, expected {}", header->version, BLOOM_FILTER_VERSION};
+		if (header->size > data.size)
+			return Err{"bloom filter blob is truncated, size {}, expected {}", data.size, header->size};
+
+		constexpr uint64_t BLOCK_SIZE = BLOOM_FILTER_BLOCK_WORDS * sizeof(uint32_t);
+		if (header->blocks_count == 0 || header->blocks_count > header->size / BLOCK_SIZE)
+			return Err{"invalid bloom filter blocks count"};
+		if (header->blocks_offset < sizeof(Bloom_Filter_Header) ||
+			header->blocks_offset % alignof(uint32_t) != 0 ||
+			header->blocks_offset > header->size ||
+			header->blocks_count * BLOCK_SIZE > header->size - header->blocks_offset)
+			return Err{"invalid bloom filter layout"};
+
+		return Err{};
+	}
+
+	Result<Bloom_Filter>
+	bloom_filter_from_block(Block data)
+	{
+		if (auto err = _bloom_filter_validate(data))
+			return err;
+		return _bloom_filter_from_data(data);
+	}
+
+	Result<Bloom_Filter>
+	bloom_filter_load(const Str& filename)
+	{
+		auto file = file_mmap(filename, 0, 0, IO_MODE_READ, OPEN_MODE_OPEN_ONLY, SHARE_MODE_READ);
+		if (file == nullptr)
+			return Err{"failed to map bloom filter file '{}'", filename};
+
+		if (auto err = _bloom_filter_validate(file->data))
+		{
+			file_unmap(file);
+			return err;
+		}
+
+		auto self = _bloom_filter_from_data(file->data);
+		self.file = file;
+		return self;
+	}
+
+	Cuckoo_Filter
+	cuckoo_filter_new(size_t expected_count, Allocator allocator)
+	{
+		// cuckoo filters with 4 entries per bucket can reach 95% load before the inserts start failing
+		auto buckets_count = uint64_t(ceil(double(expected_count) / (CUCKOO_FILTER_BUCKET_SIZE * 0.95)));
+		buckets_count = _hash_next_power_of_2(buckets_count < 2 ? 2 : buckets_count);
+
+		Cuckoo_Filter self{};
+		self.allocator = allocator;
+		self.data = _filter_blob_new(buckets_count * sizeof(uint64_t), allocator);
+		self.header = (Cuckoo_Filter_Header*)self.data.ptr;
+		self.header->magic = CUCKOO_FILTER_MAGIC;
+		self.header->version = CUCKOO_FILTER_VERSION;
+		self.header->buckets_count = buckets_count;
+		self.header->random_state = 0x9E3779B9;
+		self.header->buckets_offset = FILTER_DATA_OFFSET;
+		self.header->size = self.data.size;
+		self.buckets = (uint64_t*)((uint8_t*)self.data.ptr + FILTER_DATA_OFFSET);
+		return self;
+	}
+
+	void
+	cuckoo_filter_free(Cuckoo_Filter& self)
+	{
+		if (self.file)
+			file_unmap(self.file);
+		else if (self.data.ptr)
+			free_from(self.allocator, self.data);
+		self = Cuckoo_Filter{};
+	}
+
+	void
+	cuckoo_filter_clear(Cuckoo_Filter& self)
+	{
+		mn_assert_msg(self.file == nullptr, "cuckoo filters loaded from files are read only");
+		::memset(self.buckets, 0, size_t(self.header->buckets_count * sizeof(uint64_t)));
+		self.header->count = 0;
+		self.header->victim_index = 0;
+		self.header->victim_fingerprint = 0;
+	}
+
+	bool
+	cuckoo_filter_insert_hash(Cuckoo_Filter& self, size_t hash)
+	{
+		mn_assert_msg(self.file == nullptr, "cuckoo filters loaded from files are read only");
+
+		// the victim has no place in the filter, so the filter is full until a key is removed
+		if (self.header->victim_fingerprint != 0)
+			return false;
+
+		auto h = _filter_hash_mix(hash);
+		auto fingerprint = _cuckoo_filter_fingerprint(h);
+		auto index = (h >> 32) & (self.header->buckets_count - 1);
+		_cuckoo_filter_insert_fingerprint(self, index, fingerprint);
+		++self.header->count;
+		return true;
+	}
+
+	bool
+	cuckoo_filter_remove_hash(Cuckoo_Filter& self, size_t hash)
+	{
+		mn_assert_msg(self.file == nullptr, "cuckoo filters loaded from files are read only");
+
+		auto header = self.header;
+		auto h = _filter_hash_mix(hash);
+		auto fingerprint = _cuckoo_filter_fingerprint(h);
+		auto i1 = (h >> 32) & (header->buckets_count - 1);
+		auto i2 = _cuckoo_filter_alt_index(i1, fingerprint, header->buckets_count);
+
+		if (header->victim_fingerprint == fingerprint && (header->victim_index == i1 || header->victim_index == i2))
+		{
+			header->victim_fingerprint = 0;
+			header->victim_index = 0;
+			--header->count;
+			return true;
+		}
+
+		if (_cuckoo_filter_bucket_remove(self.buckets[i1], fingerprint) == false &&
+			_cuckoo_filter_bucket_remove(self.buckets[i2], fingerprint) == false)
+			return false;
+		--header->count;
+
+		// there's a free entry now so try to put the victim back
+		if (header->victim_fingerprint != 0)
+		{
+			auto victim_index = header->victim_index;
+			auto victim_fingerprint = uint16_t(header->victim_fingerprint);
+			header->victim_fingerprint = 0;
+			header->victim_index = 0;
+			_cuckoo_filter_insert_fingerprint(self, victim_index, victim_fingerprint);
+		}
+		return true;
+	}
+
+	Err
+	_cuckoo_filter_validate(Block data)
+	{
+		if (data.ptr == nullptr || data.size < sizeof(Cuckoo_Filter_Header))
+			return Err{"cuckoo filter blob is too small"};
+		if ((uintptr_t)data.ptr % alignof(Cuckoo_Filter_Header) != 0)
+			return Err{"cuckoo filter blob is not aligned"};
+
+		auto header = (const Cuckoo_Filter_Header*)data.ptr;
+		if (header->magic != CUCKOO_FILTER_MAGIC)
+			return Err{"invalid cuckoo filter magic number"};
+		if (header->version != CUCKOO_FILTER_VERSION)
+			return Err{"unsupported cuckoo filter version {}, expected {}", header->version, CUCKOO_FILTER_VERSION};
+		if (header->size > data.size)
+			return Err{"cuckoo filter blob is truncated, size {}, expected {}", data.size, header->size};
+
+		if (header->buckets_count == 0 ||
+			(header->buckets_count & (header->buckets_count - 1)) != 0 ||
+			header->buckets_count > header->size / sizeof(uint64_t))
+			return Err{"invalid cuckoo filter buckets count"};
+		if (header->buckets_offset < sizeof(Cuckoo_Filter_Header) ||
+			header->buckets_offset % alignof(uint64_t) != 0 ||
+			header->buckets_offset > header->size ||
+			header->buckets_count * sizeof(uint64_t) > header->size - header->buckets_offset ||
+			header->victim_index >= header->buckets_count ||
+			header->victim_fingerprint > UINT16_MAX)
+			return Err{"invalid cuckoo filter layout"};
+
+		return Err{};
+	}
+
+	Result<Cuckoo_Filter>
+	cuckoo_filter_from_block(Block data)
+	{
+		if (auto err = _cuckoo_filter_validate(data))
+			return err;
+		return _cuckoo_filter_from_data(data);
+	}
+
+	Result<Cuckoo_Filter>
+	cuckoo_filter_load(const Str& filename)
+	{
+		auto file = file_mmap(filename, 0, 0, IO_MODE_READ, OPEN_MODE_OPEN_ONLY, SHARE_MODE_READ);
+		if (file == nullptr)
+			return Err{"failed to map cuckoo filter file '{}'", filename};
+
+		if (auto err = _cuckoo_filter_validate(file->data))
+		{
+			file_unmap(file);
+			return err;
+		}
+
+		auto self = _cuckoo_filter_from_data(file->data);
+		self.file = file;
+		return self;
+	}
+}
@@ -0,0 +1,290 @@
+#include "mn/Frozen_Map.h"
+#include "mn/Memory.h"
+#include "mn/Sort.h"
+
+namespace mn
+{
+	// max count of the seeds tried before giving up on building the perfect hash function, a seed only fails when
+	// two distinct keys have the same 64-bit hash or a bucket can't be placed which is very unlikely
+	constexpr uint64_t FROZEN_MAP_MAX_SEEDS = 32;
+
+	inline static uint64_t
+	_frozen_map_align(uint64_t offset)
+	{
+		return (offset + 7) & ~uint64_t(7);
+	}
+
+	inline static bool
+	_frozen_map_bit_test(const Buf<uint64_t>& bits, uint64_t index)
+	{
+		return (bits[index >> 6] >> (index & 63)) & 1;
+	}
+
+	inline static void
+	_frozen_map_bit_flip(Buf<uint64_t>& bits, uint64_t index)
+	{
+		bits[index >> 6] ^= uint64_t(1) << (index & 63);
+	}
+
+	// searches for the pilot of each bucket which maps its keys into free slots, buckets are processed in descending
+	// size order since the big buckets are hard to place when the table is almost full, returns false if a bucket
+	// can't be placed (ex. two keys with the same hash) and the caller should retry with another seed
+	inline static bool
+	_frozen_map_search_pilots(
+		const Buf<uint64_t>& hashes,
+		uint64_t buckets_count,
+		Buf<uint32_t>& pilots,
+		Buf<uint64_t>& positions,
+		Allocator allocator)
+	{
+		auto count = hashes.count;
+
+		// sort the keys by bucket using counting sort
+		auto bucket_start = buf_with_allocator<size_t>(allocator);
+		buf_resize_fill(bucket_start, buckets_count + 1, size_t(0));
+		for (auto hash: hashes)
+			++bucket_start[_frozen_map_bucket(hash, buckets_count) + 1];
+		size_t max_bucket_size = 0;
+		for (size_t i = 0; i < buckets_count; ++i)
+		{
+			if (bucket_start[i + 1] > max_bucket_size)
+				max_bucket_size = bucket_start[i + 1];
+			bucket_start[i + 1] += bucket_start[i];
+		}
+
+		auto bucket_keys = buf_with_allocator<uint64_t>(allocator);
+		buf_resize(bucket_keys, count);
+		{
+			auto cursor = buf_with_allocator<size_t>(allocator);
+			buf_resize(cursor, buckets_count);
+			::memcpy(cursor.ptr, bucket_start.ptr, sizeof(size_t) * buckets_count);
+			for (auto hash: hashes)
+				bucket_keys[cursor[_frozen_map_bucket(hash, buckets_count)]++] = hash;
+		}
+
+		// order the buckets by their size in descending order using counting sort
+		auto size_start = buf_with_allocator<size_t>(allocator);
+		buf_resize_fill(size_start, max_bucket_size + 2, size_t(0));
+		for (size_t i = 0; i < buckets_count; ++i)
+			++size_start[max_bucket_size - (bucket_start[i + 1] - bucket_start[i]) + 1];
+		for (size_t i = 0; i <= max_bucket_size; ++i)
+			size_start[i + 1] += size_start[i];
+		auto buckets_order = buf_with_allocator<uint64_t>(allocator);
+		buf_resize(buckets_order, buckets_count);
+		for (size_t i = 0; i < buckets_count; ++i)
+			buckets_order[size_start[max_bucket_size - (bucket_start[i + 1] - bucket_start[i])]++] = i;
+
+		auto taken = buf_with_allocator<uint64_t>(allocator);
+		buf_resize_fill(taken, (count + 63) / 64, uint64_t(0));
+		auto bucket_positions = buf_with_allocator<uint64_t>(allocator);
+		buf_resize(bucket_positions, max_bucket_size);
+
+		// the last buckets need count / free_slots tries on average, so the limit is proportional to the count
+		uint64_t pilots_limit = count * 32 + 1024;
+		if (pilots_limit > UINT32_MAX)
+			pilots_limit = UINT32_MAX;
+
+		for (auto bucket: buckets_order)
+		{
+			auto begin = bucket_start[bucket];
+			auto end = bucket_start[bucket + 1];
+			if (begin == end)
+				break;
+
+			bool found = false;
+			for (uint64_t pilot = 0; pilot < pilots_limit; ++pilot)
+			{
+				size_t placed = 0;
+				for (auto i = begin; i < end; ++i)
+				{
+					auto position = _frozen_map_position(bucket_keys[i], uint32_t(pilot), count);
+					if (_frozen_map_bit_test(taken, position))
+						break;
+					_frozen_map_bit_flip(taken, position);
+					bucket_positions[placed++] = position;
+				}
+
+				if (placed == end - begin)
+				{
+					pilots[bucket] = uint32_t(pilot);
+					found = true;
+					break;
+				}
+
+				for (size_t i = 0; i < placed; ++i)
+					_frozen_map_bit_flip(taken, bucket_positions[i]);
+			}
+
+			if (found == false)
+				return false;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto hash = hashes[i];
+			positions[i] = _frozen_map_position(hash, pilots[_frozen_map_bucket(hash, buckets_count)], count);
+		}
+		return true;
+	}
+
+	// returns whether the given keys has a duplicate, the keys are sorted by their hash so only the keys with equal
+	// hashes are compared
+	inline static bool
+	_frozen_map_has_duplicates(const Str_View* keys, const Buf<uint64_t>& hashes, Allocator allocator)
+	{
+		auto order = buf_with_allocator<uint64_t>(allocator);
+		buf_resize(order, hashes.count);
+		for (size_t i = 0; i < order.count; ++i)
+			order[i] = i;
+		radix_sort(order.ptr, order.count, [&](uint64_t i) { return hashes[i]; });
+
+		for (size_t i = 1; i < order.count; ++i)
+		{
+			for (size_t j = i; j > 0 && hashes[order[j - 1]] == hashes[order[i]]; --j)
+			{
+				const auto& a = keys[order[i]];
+				const auto& b = keys[order[j - 1]];
+				if (a.count == b.count && (a.count == 0 || ::memcmp(a.ptr, b.ptr, a.count) == 0))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	// API
+	Result<Block>
+	_frozen_map_build(const Str_View* keys, const void* values, size_t count, size_t value_size, Allocator allocator)
+	{
+		auto scratch = scratch_begin({allocator});
+
+		// 4 keys per bucket on average which costs a single byte per key for the pilots
+		uint64_t buckets_count = count > 0 ? (count + 3) / 4 : 1;
+		auto hashes = buf_with_allocator<uint64_t>(scratch.arena);
+		buf_resize(hashes, count);
+		auto pilots = buf_with_allocator<uint32_t>(scratch.arena);
+		buf_resize(pilots, buckets_count);
+		auto positions = buf_with_allocator<uint64_t>(scratch.arena);
+		buf_resize(positions, count);
+
+		// duplicate keys have the same hash for every seed so no seed would work for them
+		for (size_t i = 0; i < count; ++i)
+			hashes[i] = hash_bytes(keys[i].ptr, keys[i].count, 0);
+		{
+			auto checkpoint = scratch.arena->checkpoint();
+			bool has_duplicates = _frozen_map_has_duplicates(keys, hashes, scratch.arena);
+			scratch.arena->restore(checkpoint);
+			if (has_duplicates)
+				return Err{"frozen map keys should be unique"};
+		}
+
+		uint64_t seed = 0;
+		for (; seed < FROZEN_MAP_MAX_SEEDS; ++seed)
+		{
+			if (seed > 0)
+			{
+				for (size_t i = 0; i < count; ++i)
+					hashes[i] = hash_bytes(keys[i].ptr, keys[i].count, seed);
+			}
+			::memset(pilots.ptr, 0, sizeof(uint32_t) * pilots.count);
+
+			auto checkpoint = scratch.arena->checkpoint();
+			bool ok = _frozen_map_search_pilots(hashes, buckets_count, pilots, positions, scratch.arena);
+			scratch.arena->restore(checkpoint);
+			if (ok)
+				break;
+		}
+
+		if (seed == FROZEN_MAP_MAX_SEEDS)
+			return Err{"failed to build the frozen map perfect hash function after {} seeds", FROZEN_MAP_MAX_SEEDS};
+
+		size_t keys_size = 0;
+		for (size_t i = 0; i < count; ++i)
+			keys_size += keys[i].count + 1;
+
+		Frozen_Map_Header header{};
+		header.magic = FROZEN_MAP_MAGIC;
+		header.version = FROZEN_MAP_VERSION;
+		header.count = count;
+		header.buckets_count = buckets_count;
+		header.seed = seed;
+		header.value_size = value_size;
+		header.pilots_offset = _frozen_map_align(sizeof(header));
+		header.slots_offset = _frozen_map_align(header.pilots_offset + sizeof(uint32_t) * buckets_count);
+		header.values_offset = _frozen_map_align(header.slots_offset + sizeof(Frozen_Map_Slot) * count);
+		header.keys_offset = _frozen_map_align(header.values_offset + value_size * count);
+		header.size = _frozen_map_align(header.keys_offset + keys_size);
+
+		auto data = alloc_from(allocator, header.size, alignof(Frozen_Map_Header));
+		auto base = (uint8_t*)data.ptr;
+		::memset(base, 0, header.size);
+		::memcpy(base, &header, sizeof(header));
+		::memcpy(base + header.pilots_offset, pilots.ptr, sizeof(uint32_t) * buckets_count);
+
+		auto slots = (Frozen_Map_Slot*)(base + header.slots_offset);
+		auto out_values = base + header.values_offset;
+		auto out_keys = (char*)(base + header.keys_offset);
+		uint64_t key_offset = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto position = positions[i];
+			slots[position].key_offset = key_offset;
+			slots[position].key_count = keys[i].count;
+			if (keys[i].count > 0)
+				::memcpy(out_keys + key_offset, keys[i].ptr, keys[i].count);
+			key_offset += keys[i].count + 1;
+			::memcpy(out_values + position * value_size, (const uint8_t*)values + i * value_size, value_size);
+		}
+
+		return data;
+	}
+
+	Err
+	_frozen_map_validate(Block data, size_t value_size)
+	{
+		if (data.ptr == nullptr || data.size < sizeof(Frozen_Map_Header))
+			return Err{"frozen map blob is too small"};
+		if ((uintptr_t)data.ptr % alignof(Frozen_Map_Header) != 0)
+			return Err{"frozen map blob is not aligned"};
+
+		auto header = (const Frozen_Map_Header*)data.ptr;
+		if (header->magic != FROZEN_MAP_MAGIC)
+			return Err{"invalid frozen map magic number"};
+		if (header->version != FROZEN_MAP_VERSION)
+			return Err{"unsupported frozen map version {}, expected {}", header->version, FROZEN_MAP_VERSION};
+		if (header->value_size != value_size)
+			return Err{"frozen map value size mismatch {}, expected {}", header->value_size, value_size};
+		if (header->size > data.size)
+			return Err{"frozen map blob is truncated, size {}, expected {}", data.size, header->size};
+		if (header->buckets_count == 0)
+			return Err{"invalid frozen map buckets count"};
+
+		// make sure that the sections are ordered within the blob, then compare the counts against the space between
+		// the sections using divisions so that nothing overflows
+		if (header->pilots_offset < sizeof(Frozen_Map_Header) ||
+			header->pilots_offset > header->slots_offset ||
+			header->slots_offset > header->values_offset ||
+			header->values_offset > header->keys_offset ||
+			header->keys_offset > header->size ||
+			header->pilots_offset % alignof(uint32_t) != 0 ||
+			header->slots_offset % alignof(Frozen_Map_Slot) != 0 ||
+			header->values_offset % 8 != 0)
+			return Err{"invalid frozen map layout"};
+		if (header->buckets_count > (header->slots_offset - header->pilots_offset) / sizeof(uint32_t) ||
+			header->count > (header->values_offset - header->slots_offset) / sizeof(Frozen_Map_Slot) ||
+			(value_size > 0 && header->count > (header->keys_offset - header->values_offset) / value_size))
+			return Err{"invalid frozen map count"};
+
+		// lookups read the slot keys without any bounds checks, so every slot key should be within the keys section
+		// including its null terminator
+		auto keys_size = header->size - header->keys_offset;
+		auto slots = (const Frozen_Map_Slot*)((const uint8_t*)data.ptr + header->slots_offset);
+		for (uint64_t i = 0; i < header->count; ++i)
+		{
+			const auto& slot = slots[i];
+			if (slot.key_offset >= keys_size || slot.key_count >= keys_size - slot.key_offset)
+				return Err{"frozen map slot {} key is out of bounds", i};
+		}
+
+		return Err{};
+	}
+}
@@ -369,17 +369,12 @@ namespace mn::json
 
 				if (auto value = _parser_parse_value(self); !self.err)
 				{
-					auto key_str = str_from_substr(key.begin, key.end);
-					if (auto it = map_lookup(*object.as_object, key_str))
-					{
-						str_free(key_str);
-						value_free(it->value);
-						it->value = value;
-					}
-					else
-					{
-						map_insert(*object.as_object, key_str, value);
-					}
+					// a single probe, the key string is only allocated if the key is not in the object yet
+					auto it = map_insert_if_absent(*object.as_object, str_view(key.begin, key.end), [](Str_View k) {
+						return str_from_substr(k.ptr, k.ptr + k.count);
+					});
+					value_free(it->value);
+					it->value = value;
 				}
 				else
 				{
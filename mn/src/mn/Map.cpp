@@ -0,0 +1,23 @@
+#include "mn/Map.h"
+#include "mn/UUID.h"
+
+namespace mn
+{
+	inline static size_t
+	_hash_seed_generate()
+	{
+		// uuids are generated from the OS random source
+		auto id = uuid_generate();
+		uint64_t seed = 0;
+		::memcpy(&seed, id.bytes, sizeof(seed));
+		return size_t(hash_bytes(id.bytes, sizeof(id.bytes), size_t(seed)));
+	}
+
+	// API
+	size_t
+	hash_seed()
+	{
+		static const size_t seed = _hash_seed_generate();
+		return seed;
+	}
+}
@@ -0,0 +1,401 @@
+#include "mn/Memory_Profiler.h"
+#include "mn/Memory.h"
+#include "mn/Map.h"
+#include "mn/Thread.h"
+#include "mn/Debug.h"
+#include "mn/Fmt.h"
+#include "mn/File.h"
+#include "mn/Defer.h"
+#include "mn/Assert.h"
+
+#include <atomic>
+#include <chrono>
+
+#include <math.h>
+
+namespace mn
+{
+	constexpr size_t MEMORY_PROFILER_CALLSTACK_MAX_FRAMES = 32;
+	// the sample table is fixed in size because it's probed without locks, so it can't be reallocated
+	constexpr size_t MEMORY_PROFILER_SLOTS_COUNT = 1ULL << 16;
+
+	static void* const MEMORY_PROFILER_SLOT_EMPTY = nullptr;
+	static void* const MEMORY_PROFILER_SLOT_DELETED = (void*)uintptr_t(1);
+
+	struct Memory_Profiler_Site
+	{
+		void* callstack[MEMORY_PROFILER_CALLSTACK_MAX_FRAMES];
+		size_t callstack_count;
+		size_t live_count;
+		size_t live_size;
+		size_t total_count;
+		size_t total_size;
+	};
+
+	struct Memory_Profiler_Sample
+	{
+		size_t size;
+		size_t site_index;
+	};
+
+	struct IMemory_Profiler
+	{
+		size_t sample_rate;
+		Mutex mtx;
+
+		// open addressing table of the sampled pointers, it's read without locks in the free path
+		// and only written while holding the mutex
+		std::atomic<void*>* slots;
+		Memory_Profiler_Sample* samples;
+		// count of the live + deleted slots
+		size_t slots_used;
+		std::atomic<size_t> live_count;
+
+		Buf<Memory_Profiler_Site> sites;
+		Map<size_t, size_t> sites_index;
+
+		size_t live_size;
+		size_t total_count;
+		size_t total_size;
+		size_t dropped_count;
+	};
+
+	// per thread sampling state, the countdown is shared between profiler instances since only one profile
+	// interface can be installed at a time
+	thread_local bool _MEMORY_PROFILER_INSIDE = false;
+	thread_local bool _MEMORY_PROFILER_THREAD_INIT = false;
+	thread_local uint64_t _MEMORY_PROFILER_RNG = 0;
+	thread_local size_t _MEMORY_PROFILER_BYTES_UNTIL_SAMPLE = 0;
+
+	inline static uint64_t
+	_memory_profiler_rand()
+	{
+		// xorshift64*
+		_MEMORY_PROFILER_RNG ^= _MEMORY_PROFILER_RNG >> 12;
+		_MEMORY_PROFILER_RNG ^= _MEMORY_PROFILER_RNG << 25;
+		_MEMORY_PROFILER_RNG ^= _MEMORY_PROFILER_RNG >> 27;
+		return _MEMORY_PROFILER_RNG * 0x2545F4914F6CDD1DULL;
+	}
+
+	// returns the distance in bytes until the next sample, the distances are exponentially distributed
+	// which makes the samples a poisson process over the allocated bytes with the given mean
+	inline static size_t
+	_memory_profiler_next_sample_distance(size_t sample_rate)
+	{
+		if (_MEMORY_PROFILER_THREAD_INIT == false)
+		{
+			auto seed = uint64_t(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+			seed ^= uint64_t(uintptr_t(&_MEMORY_PROFILER_RNG));
+			_MEMORY_PROFILER_RNG = seed ? seed : 0x9E3779B97F4A7C15ULL;
+			_MEMORY_PROFILER_THREAD_INIT = true;
+		}
+
+		// uniform in (0, 1]
+		double u = double((_memory_profiler_rand() >> 11) + 1) * (1.0 / 9007199254740992.0);
+		double distance = -::log(u) * double(sample_rate);
+		return distance < 1.0 ? 1 : size_t(distance);
+	}
+
+	inline static size_t
+	_memory_profiler_slot_hash(void* ptr)
+	{
+		uint64_t h = uint64_t(uintptr_t(ptr)) >> 4;
+		h *= 0x9E3779B97F4A7C15ULL;
+		return size_t(h >> 16) & (MEMORY_PROFILER_SLOTS_COUNT - 1);
+	}
+
+	// searches the sample table for the given pointer without taking any lock, returns MEMORY_PROFILER_SLOTS_COUNT
+	// if it's not found
+	inline static size_t
+	_memory_profiler_slot_find(IMemory_Profiler* self, void* ptr)
+	{
+		auto ix = _memory_profiler_slot_hash(ptr);
+		for (size_t i = 0; i < MEMORY_PROFILER_SLOTS_COUNT; ++i)
+		{
+			auto slot_ptr = self->slots[ix].load(std::memory_order_acquire);
+			if (slot_ptr == ptr)
+				return ix;
+			if (slot_ptr == MEMORY_PROFILER_SLOT_EMPTY)
+				break;
+			ix = (ix + 1) & (MEMORY_PROFILER_SLOTS_COUNT - 1);
+		}
+		return MEMORY_PROFILER_SLOTS_COUNT;
+	}
+
+	inline static void
+	_memory_profiler_sample_remove(IMemory_Profiler* self, size_t ix)
+	{
+		auto& sample = self->samples[ix];
+		auto& site = self->sites[sample.site_index];
+		--site.live_count;
+		site.live_size -= sample.size;
+		self->live_size -= sample.size;
+		self->live_count.fetch_sub(1, std::memory_order_relaxed);
+		self->slots[ix].store(MEMORY_PROFILER_SLOT_DELETED, std::memory_order_release);
+	}
+
+	// inserts the given pointer into the sample table, the pointer should not exist in the table
+	inline static size_t
+	_memory_profiler_slot_insert(IMemory_Profiler* self, void* ptr)
+	{
+		auto ix = _memory_profiler_slot_hash(ptr);
+		while (true)
+		{
+			auto slot_ptr = self->slots[ix].load(std::memory_order_relaxed);
+			if (slot_ptr == MEMORY_PROFILER_SLOT_EMPTY || slot_ptr == MEMORY_PROFILER_SLOT_DELETED)
+			{
+				if (slot_ptr == MEMORY_PROFILER_SLOT_EMPTY)
+					++self->slots_used;
+				return ix;
+			}
+			ix = (ix + 1) & (MEMORY_PROFILER_SLOTS_COUNT - 1);
+		}
+	}
+
+	// removes the deleted slots by reinserting the live ones, a concurrent free might miss its sample while this is
+	// happening, in that case the sample is removed later when the same address gets sampled again
+	inline static void
+	_memory_profiler_slots_rebuild(IMemory_Profiler* self)
+	{
+		struct Live_Sample
+		{
+			void* ptr;
+			Memory_Profiler_Sample sample;
+		};
+
+		auto live = buf_with_allocator<Live_Sample>(memory::clib());
+		mn_defer(buf_free(live));
+
+		for (size_t i = 0; i < MEMORY_PROFILER_SLOTS_COUNT; ++i)
+		{
+			auto slot_ptr = self->slots[i].load(std::memory_order_relaxed);
+			if (slot_ptr != MEMORY_PROFILER_SLOT_EMPTY && slot_ptr != MEMORY_PROFILER_SLOT_DELETED)
+				buf_push(live, Live_Sample{slot_ptr, self->samples[i]});
+			self->slots[i].store(MEMORY_PROFILER_SLOT_EMPTY, std::memory_order_relaxed);
+		}
+
+		self->slots_used = 0;
+		for (const auto& s: live)
+		{
+			auto ix = _memory_profiler_slot_insert(self, s.ptr);
+			self->samples[ix] = s.sample;
+			self->slots[ix].store(s.ptr, std::memory_order_release);
+		}
+	}
+
+	inline static size_t
+	_memory_profiler_site_find_or_insert(IMemory_Profiler* self, void** callstack, size_t callstack_count)
+	{
+		// sites are keyed by the callstack hash, in case of a collision with a different callstack we
+		// probe on to the next key, sites are never removed so the probe chain is never broken
+		auto hash = hash_bytes(callstack, callstack_count * sizeof(void*));
+		while (auto it = map_lookup(self->sites_index, hash))
+		{
+			const auto& other = self->sites[it->value];
+			if (other.callstack_count == callstack_count &&
+				::memcmp(other.callstack, callstack, callstack_count * sizeof(void*)) == 0)
+			{
+				return it->value;
+			}
+			++hash;
+		}
+
+		Memory_Profiler_Site site{};
+		::memcpy(site.callstack, callstack, callstack_count * sizeof(void*));
+		site.callstack_count = callstack_count;
+		buf_push(self->sites, site);
+		map_insert(self->sites_index, hash, self->sites.count - 1);
+		return self->sites.count - 1;
+	}
+
+	inline static void
+	_memory_profiler_sample(IMemory_Profiler* self, void* ptr, size_t size)
+	{
+		void* callstack[MEMORY_PROFILER_CALLSTACK_MAX_FRAMES];
+		auto callstack_count = callstack_capture(callstack, MEMORY_PROFILER_CALLSTACK_MAX_FRAMES);
+
+		mutex_lock(self->mtx);
+		mn_defer(mutex_unlock(self->mtx));
+
+		// the same address is in the table, which means that its free was missed while the table was being rebuilt
+		// so we consider it freed now
+		auto stale_ix = _memory_profiler_slot_find(self, ptr);
+		if (stale_ix != MEMORY_PROFILER_SLOTS_COUNT)
+			_memory_profiler_sample_remove(self, stale_ix);
+
+		if (self->live_count.load(std::memory_order_relaxed) + 1 > MEMORY_PROFILER_SLOTS_COUNT / 2)
+		{
+			++self->dropped_count;
+			return;
+		}
+
+		if (self->slots_used + 1 > MEMORY_PROFILER_SLOTS_COUNT - (MEMORY_PROFILER_SLOTS_COUNT >> 2))
+			_memory_profiler_slots_rebuild(self);
+
+		auto site_index = _memory_profiler_site_find_or_insert(self, callstack, callstack_count);
+		auto& site = self->sites[site_index];
+		++site.live_count;
+		site.live_size += size;
+		++site.total_count;
+		site.total_size += size;
+
+		self->live_size += size;
+		++self->total_count;
+		self->total_size += size;
+
+		auto ix = _memory_profiler_slot_insert(self, ptr);
+		self->samples[ix] = Memory_Profiler_Sample{size, site_index};
+		self->live_count.fetch_add(1, std::memory_order_relaxed);
+		self->slots[ix].store(ptr, std::memory_order_release);
+	}
+
+	static void
+	_memory_profiler_alloc(void* profiler, void* ptr, size_t size)
+	{
+		if (ptr == nullptr || _MEMORY_PROFILER_INSIDE)
+			return;
+
+		auto self = (IMemory_Profiler*)profiler;
+		if (_MEMORY_PROFILER_THREAD_INIT && _MEMORY_PROFILER_BYTES_UNTIL_SAMPLE > size)
+		{
+			_MEMORY_PROFILER_BYTES_UNTIL_SAMPLE -= size;
+			return;
+		}
+
+		bool first_time = _MEMORY_PROFILER_THREAD_INIT == false;
+		_MEMORY_PROFILER_BYTES_UNTIL_SAMPLE = _memory_profiler_next_sample_distance(self->sample_rate);
+		// the first allocation of each thread only initializes the countdown, otherwise it would always be sampled
+		if (first_time)
+			return;
+
+		_MEMORY_PROFILER_INSIDE = true;
+		_memory_profiler_sample(self, ptr, size);
+		_MEMORY_PROFILER_INSIDE = false;
+	}
+
+	static void
+	_memory_profiler_free(void* profiler, void* ptr, size_t)
+	{
+		if (ptr == nullptr || _MEMORY_PROFILER_INSIDE)
+			return;
+
+		auto self = (IMemory_Profiler*)profiler;
+		if (self->live_count.load(std::memory_order_relaxed) == 0)
+			return;
+
+		if (_memory_profiler_slot_find(self, ptr) == MEMORY_PROFILER_SLOTS_COUNT)
+			return;
+
+		_MEMORY_PROFILER_INSIDE = true;
+		mutex_lock(self->mtx);
+		// search again now that we have the lock, since the table might have been rebuilt
+		auto ix = _memory_profiler_slot_find(self, ptr);
+		if (ix != MEMORY_PROFILER_SLOTS_COUNT)
+			_memory_profiler_sample_remove(self, ix);
+		mutex_unlock(self->mtx);
+		_MEMORY_PROFILER_INSIDE = false;
+	}
+
+	// API
+	Memory_Profiler
+	memory_profiler_new(size_t sample_rate)
+	{
+		mn_assert(sample_rate > 0);
+
+		auto self = alloc_construct_from<IMemory_Profiler>(memory::clib());
+		self->sample_rate = sample_rate;
+		self->mtx = mutex_new("memory profiler mutex");
+
+		auto slots_block = alloc_from(memory::clib(), MEMORY_PROFILER_SLOTS_COUNT * sizeof(std::atomic<void*>), alignof(std::atomic<void*>));
+		self->slots = (std::atomic<void*>*)slots_block.ptr;
+		for (size_t i = 0; i < MEMORY_PROFILER_SLOTS_COUNT; ++i)
+			::new (self->slots + i) std::atomic<void*>(MEMORY_PROFILER_SLOT_EMPTY);
+
+		self->samples = (Memory_Profiler_Sample*)alloc_from(memory::clib(), MEMORY_PROFILER_SLOTS_COUNT * sizeof(Memory_Profiler_Sample), alignof(Memory_Profiler_Sample)).ptr;
+		self->slots_used = 0;
+		self->live_count = 0;
+
+		self->sites = buf_with_allocator<Memory_Profiler_Site>(memory::clib());
+		self->sites_index = map_with_allocator<size_t, size_t>(memory::clib());
+		return self;
+	}
+
+	void
+	memory_profiler_free(Memory_Profiler self)
+	{
+		if (self == nullptr)
+			return;
+
+		mutex_free(self->mtx);
+		free_from(memory::clib(), Block{self->slots, MEMORY_PROFILER_SLOTS_COUNT * sizeof(std::atomic<void*>)});
+		free_from(memory::clib(), Block{self->samples, MEMORY_PROFILER_SLOTS_COUNT * sizeof(Memory_Profiler_Sample)});
+		buf_free(self->sites);
+		map_free(self->sites_index);
+		free_destruct_from(memory::clib(), self);
+	}
+
+	Memory_Profile_Interface
+	memory_profiler_interface(Memory_Profiler self)
+	{
+		Memory_Profile_Interface res{};
+		res.self = self;
+		res.profile_alloc = _memory_profiler_alloc;
+		res.profile_free = _memory_profiler_free;
+		return res;
+	}
+
+	Memory_Profiler_Stats
+	memory_profiler_stats(Memory_Profiler self)
+	{
+		mutex_lock(self->mtx);
+		mn_defer(mutex_unlock(self->mtx));
+
+		Memory_Profiler_Stats res{};
+		res.live_count = self->live_count.load(std::memory_order_relaxed);
+		res.live_size = self->live_size;
+		res.total_count = self->total_count;
+		res.total_size = self->total_size;
+		res.dropped_count = self->dropped_count;
+		return res;
+	}
+
+	void
+	memory_profiler_report(Memory_Profiler self, Stream out)
+	{
+		// any allocation done while writing the report should not be sampled, otherwise we'll deadlock
+		bool was_inside = _MEMORY_PROFILER_INSIDE;
+		_MEMORY_PROFILER_INSIDE = true;
+		mn_defer(_MEMORY_PROFILER_INSIDE = was_inside);
+
+		mutex_lock(self->mtx);
+		{
+			mn_defer(mutex_unlock(self->mtx));
+
+			print_to(out, "heap profile: {}: {} [{}: {}] @ heap_v2/{}\n",
+				self->live_count.load(std::memory_order_relaxed), self->live_size,
+				self->total_count, self->total_size,
+				self->sample_rate
+			);
+
+			for (const auto& site: self->sites)
+			{
+				print_to(out, "{}: {} [{}: {}] @", site.live_count, site.live_size, site.total_count, site.total_size);
+				for (size_t i = 0; i < site.callstack_count; ++i)
+					print_to(out, " {:#x}", uintptr_t(site.callstack[i]));
+				print_to(out, "\n");
+			}
+		}
+
+		// pprof uses the mapped libraries section to symbolize the addresses
+		#if OS_LINUX
+		if (auto maps = file_open("/proc/self/maps", IO_MODE_READ, OPEN_MODE_OPEN_ONLY))
+		{
+			mn_defer(file_close(maps));
+			auto content = stream_sink(maps, memory::clib());
+			mn_defer(str_free(content));
+			print_to(out, "\nMAPPED_LIBRARIES:\n");
+			stream_write(out, block_from(content));
+		}
+		#endif
+	}
+}
@@ -1,12 +1,62 @@
 #include "mn/Memory_Stream.h"
+#include "mn/Pool.h"
 #include "mn/Assert.h"
+#include "mn/Defer.h"
 
 namespace mn
 {
+	// number of chunks allocated at once by the chunk pool
+	constexpr static size_t MEMORY_STREAM_CHUNK_BUCKET = 4;
+
+	inline static size_t
+	_memory_stream_chunked_capacity(Memory_Stream self)
+	{
+		return self->chunks.count * self->chunk_size;
+	}
+
+	inline static void
+	_memory_stream_chunked_reserve(Memory_Stream self, size_t size)
+	{
+		while (_memory_stream_chunked_capacity(self) < size)
+			buf_push(self->chunks, (char*)pool_get(self->chunk_pool));
+	}
+
+	// copies between the chunks starting at the given offset and the given block, the write flag
+	// determines the copy direction
+	inline static void
+	_memory_stream_chunked_copy(Memory_Stream self, size_t offset, Block data, bool write)
+	{
+		auto ptr = (char*)data.ptr;
+		auto size = data.size;
+		while (size > 0)
+		{
+			auto chunk = self->chunks[offset / self->chunk_size];
+			auto chunk_offset = offset % self->chunk_size;
+			auto chunk_size = self->chunk_size - chunk_offset;
+			if (chunk_size > size)
+				chunk_size = size;
+
+			if (write)
+				::memcpy(chunk + chunk_offset, ptr, chunk_size);
+			else
+				::memcpy(ptr, chunk + chunk_offset, chunk_size);
+
+			ptr += chunk_size;
+			offset += chunk_size;
+			size -= chunk_size;
+		}
+	}
+
+
 	//API
 	void
 	IMemory_Stream::dispose()
 	{
+		if (chunk_pool)
+		{
+			buf_free(chunks);
+			pool_free(chunk_pool);
+		}
 		str_free(str);
 		free_from(str.allocator, this);
 	}
@@ -15,12 +65,15 @@ namespace mn
 	IMemory_Stream::read(Block data)
 	{
 		mn_assert_msg(cursor >= 0, "Memory_Stream cursor is not valid");
-		mn_assert_msg(cursor <= int64_t(str.count), "Memory_Stream cursor is not valid");
-		size_t available_size = str.count - size_t(cursor);
+		mn_assert_msg(cursor <= size(), "Memory_Stream cursor is not valid");
+		size_t available_size = size_t(size() - cursor);
 		if(available_size)
 		{
 			available_size = available_size > data.size ? data.size : available_size;
-			::memcpy(data.ptr, str.ptr + cursor, available_size);
+			if (chunk_pool)
+				_memory_stream_chunked_copy(this, size_t(cursor), Block{data.ptr, available_size}, false);
+			else
+				::memcpy(data.ptr, str.ptr + cursor, available_size);
 			cursor += available_size;
 		}
 		return available_size;
@@ -30,6 +83,15 @@ namespace mn
 	IMemory_Stream::write(Block data)
 	{
 		mn_assert_msg(cursor >= 0, "Memory_Stream cursor is not valid");
+		if (chunk_pool)
+		{
+			_memory_stream_chunked_reserve(this, cursor + data.size);
+			_memory_stream_chunked_copy(this, size_t(cursor), data, true);
+			chunked_count = cursor + data.size;
+			cursor += data.size;
+			return data.size;
+		}
+
 		buf_resize(str, cursor + data.size);
 		::memcpy(str.ptr + cursor, data.ptr, data.size);
 		str_null_terminate(str);
@@ -40,16 +102,38 @@ namespace mn
 	int64_t
 	IMemory_Stream::size()
 	{
+		if (chunk_pool)
+			return int64_t(chunked_count);
 		return int64_t(str.count);
 	}
 
 
+	void
+	_memory_stream_init(Memory_Stream self, Allocator allocator)
+	{
+		self->str = str_with_allocator(allocator);
+		self->cursor = 0;
+		self->chunk_pool = nullptr;
+		self->chunks = buf_with_allocator<char*>(allocator);
+		self->chunk_size = 0;
+		self->chunked_count = 0;
+	}
+
 	Memory_Stream
 	memory_stream_new(Allocator allocator)
 	{
 		Memory_Stream self = alloc_construct_from<IMemory_Stream>(allocator);
-		self->str = str_with_allocator(allocator);
-		self->cursor = 0;
+		_memory_stream_init(self, allocator);
+		return self;
+	}
+
+	Memory_Stream
+	memory_stream_chunked_new(size_t chunk_size, Allocator allocator)
+	{
+		mn_assert(chunk_size > 0);
+		Memory_Stream self = memory_stream_new(allocator);
+		self->chunk_pool = pool_new(chunk_size, MEMORY_STREAM_CHUNK_BUCKET, allocator);
+		self->chunk_size = chunk_size;
 		return self;
 	}
 
@@ -74,13 +158,13 @@ namespace mn
 	int64_t
 	memory_stream_size(Memory_Stream self)
 	{
-		return self->str.count;
+		return self->size();
 	}
 
 	bool
 	memory_stream_eof(Memory_Stream self)
 	{
-		return self->cursor >= int64_t(self->str.count);
+		return self->cursor >= self->size();
 	}
 
 	int64_t
@@ -93,7 +177,7 @@ namespace mn
 	memory_stream_cursor_move(Memory_Stream self, int64_t offset)
 	{
 		mn_assert_msg(self->cursor + offset >= 0, "Memory_Stream cursor is not valid");
-		mn_assert_msg(size_t(self->cursor + offset) <= self->str.count, "Memory_Stream cursor is not valid");
+		mn_assert_msg(self->cursor + offset <= self->size(), "Memory_Stream cursor is not valid");
 		self->cursor += offset;
 	}
 
@@ -101,7 +185,7 @@ namespace mn
 	memory_stream_cursor_set(Memory_Stream self, int64_t abs)
 	{
 		mn_assert(abs >= 0);
-		mn_assert(size_t(abs) <= self->str.count);
+		mn_assert(abs <= self->size());
 		self->cursor = abs;
 	}
 
@@ -114,18 +198,23 @@ namespace mn
 	void
 	memory_stream_cursor_to_end(Memory_Stream self)
 	{
-		self->cursor = self->str.count;
+		self->cursor = self->size();
 	}
 
 	void
 	memory_stream_reserve(Memory_Stream self, size_t size)
 	{
-		buf_reserve(self->str, size);
+		if (self->chunk_pool)
+			_memory_stream_chunked_reserve(self, size);
+		else
+			buf_reserve(self->str, size);
 	}
 
 	size_t
 	memory_stream_capacity(Memory_Stream self)
 	{
+		if (self->chunk_pool)
+			return _memory_stream_chunked_capacity(self);
 		return self->str.cap;
 	}
 
@@ -133,12 +222,28 @@ namespace mn
 	memory_stream_clear(Memory_Stream self)
 	{
 		str_clear(self->str);
+		self->chunked_count = 0;
 		self->cursor = 0;
 	}
 
 	Block
 	memory_stream_block_ahead(Memory_Stream self, size_t size)
 	{
+		if (self->chunk_pool)
+		{
+			size_t chunk_offset = size_t(self->cursor) % self->chunk_size;
+			size_t chunk_available = self->chunk_size - chunk_offset;
+			size_t available = self->chunked_count - size_t(self->cursor);
+			if (chunk_available > available)
+				chunk_available = available;
+			if(size == 0)
+				size = chunk_available;
+			mn_assert_msg(size <= chunk_available, "block crosses a Memory_Stream chunk boundary");
+			if (size == 0)
+				return Block{};
+			return Block { self->chunks[size_t(self->cursor) / self->chunk_size] + chunk_offset, size };
+		}
+
 		if(size == 0)
 			size = self->str.count - self->cursor;
 		mn_assert(size <= self->str.count - self->cursor);
@@ -148,15 +253,80 @@ namespace mn
 	Block
 	memory_stream_block_behind(Memory_Stream self, size_t size)
 	{
+		if (self->chunk_pool)
+		{
+			if(size == 0)
+				size = size_t(self->cursor) < self->chunk_size ? size_t(self->cursor) : self->chunk_size;
+			mn_assert(size <= size_t(self->cursor));
+			mn_assert_msg(size <= self->chunk_size, "block crosses a Memory_Stream chunk boundary");
+			if (size == 0)
+				return Block{};
+			return Block { self->chunks[0], size };
+		}
+
 		if(size == 0)
 			size = self->cursor;
 		mn_assert(size <= size_t(self->cursor));
 		return Block { self->str.ptr, size };
 	}
 
+	Buf<Block>
+	memory_stream_blocks_ahead(Memory_Stream self, size_t size, Allocator allocator)
+	{
+		auto res = buf_with_allocator<Block>(allocator);
+		size_t available = size_t(self->size() - self->cursor);
+		if (size == 0)
+			size = available;
+		mn_assert(size <= available);
+
+		if (self->chunk_pool == nullptr)
+		{
+			if (size > 0)
+				buf_push(res, Block{ self->str.ptr + self->cursor, size });
+			return res;
+		}
+
+		size_t offset = size_t(self->cursor);
+		while (size > 0)
+		{
+			size_t chunk_offset = offset % self->chunk_size;
+			size_t chunk_size = self->chunk_size - chunk_offset;
+			if (chunk_size > size)
+				chunk_size = size;
+			buf_push(res, Block{ self->chunks[offset / self->chunk_size] + chunk_offset, chunk_size });
+			offset += chunk_size;
+			size -= chunk_size;
+		}
+		return res;
+	}
+
 	size_t
 	memory_stream_pipe(Memory_Stream self, Stream stream, size_t size)
 	{
+		if (self->chunk_pool)
+		{
+			_memory_stream_chunked_reserve(self, self->cursor + size);
+			size_t res = 0;
+			while (size > 0)
+			{
+				auto chunk = self->chunks[size_t(self->cursor) / self->chunk_size];
+				size_t chunk_offset = size_t(self->cursor) % self->chunk_size;
+				size_t chunk_size = self->chunk_size - chunk_offset;
+				if (chunk_size > size)
+					chunk_size = size;
+
+				size_t read_size = stream_read(stream, Block { chunk + chunk_offset, chunk_size });
+				self->cursor += read_size;
+				size -= read_size;
+				res += read_size;
+				if (read_size < chunk_size)
+					break;
+			}
+			if (size_t(self->cursor) > self->chunked_count)
+				self->chunked_count = self->cursor;
+			return res;
+		}
+
 		if(self->str.count - self->cursor < size)
 			memory_stream_reserve(self, size);
 
@@ -165,4 +335,22 @@ namespace mn
 		self->cursor += read_size;
 		return read_size;
 	}
-}
\ No newline at end of file
+
+	size_t
+	memory_stream_pipe_to(Memory_Stream self, Stream stream, size_t size)
+	{
+		auto blocks = memory_stream_blocks_ahead(self, size, allocator_top());
+		mn_defer(buf_free(blocks));
+
+		size_t res = 0;
+		for (auto block: blocks)
+		{
+			size_t write_size = stream_copy(stream, block);
+			res += write_size;
+			if (write_size < block.size)
+				break;
+		}
+		self->cursor += res;
+		return res;
+	}
+}
@@ -10,6 +10,9 @@ namespace mn
 		Allocator arena;
 		void* head;
 		size_t element_size;
+		size_t live_count;
+		size_t highwater_count;
+		size_t total_count;
 	};
 
 	Pool
@@ -24,6 +27,9 @@ namespace mn
 		self->arena = allocator_arena_new(element_size * bucket_size, meta_allocator);
 		self->head = nullptr;
 		self->element_size = element_size;
+		self->live_count = 0;
+		self->highwater_count = 0;
+		self->total_count = 0;
 		return self;
 	}
 
@@ -39,6 +45,11 @@ namespace mn
 	void*
 	pool_get(Pool self)
 	{
+		++self->live_count;
+		++self->total_count;
+		if (self->live_count > self->highwater_count)
+			self->highwater_count = self->live_count;
+
 		if(self->head != nullptr)
 		{
 			void* result = self->head;
@@ -73,5 +84,19 @@ namespace mn
 		uintptr_t* sptr = (uintptr_t*)ptr;
 		*sptr = (uintptr_t)self->head;
 		self->head = ptr;
+		--self->live_count;
+	}
+
+	memory::Stats
+	pool_stats(Pool self)
+	{
+		memory::Stats res{};
+		res.live_size = self->live_count * self->element_size;
+		res.live_count = self->live_count;
+		res.peak_size = self->highwater_count * self->element_size;
+		res.total_count = self->total_count;
+		res.total_size = self->total_count * self->element_size;
+		res.reserved_size = ((memory::Arena*)self->arena)->total_mem;
+		return res;
 	}
 }
\ No newline at end of file
@@ -22,8 +22,7 @@ namespace mn
 		Stdin_Reader_Wrapper()
 		{
 			self.stream = file_stdin();
-			self.buffer.str = str_new();
-			self.buffer.cursor = 0;
+			_memory_stream_init(&self.buffer, allocator_top());
 			self.consumed_bytes = 0;
 		}
 
@@ -46,8 +45,7 @@ namespace mn
 		Reader self = alloc_from<IReader>(allocator);
 		self->allocator = allocator;
 		self->stream = stream;
-		self->buffer.str = str_with_allocator(allocator);
-		self->buffer.cursor = 0;
+		_memory_stream_init(&self->buffer, allocator);
 		self->consumed_bytes = 0;
 		return self;
 	}
@@ -58,8 +56,7 @@ namespace mn
 		Reader self = alloc_from<IReader>(allocator);
 		self->allocator = allocator;
 		self->stream = stream;
-		self->buffer.str = str_with_allocator(allocator);
-		self->buffer.cursor = 0;
+		_memory_stream_init(&self->buffer, allocator);
 		self->consumed_bytes = 0;
 		return self;
 	}
@@ -71,8 +68,7 @@ namespace mn
 		Reader self = alloc_from<IReader>(allocator);
 		self->allocator = allocator;
 		self->stream = nullptr;
-		self->buffer.str = str_with_allocator(allocator);
-		self->buffer.cursor = 0;
+		_memory_stream_init(&self->buffer, allocator);
 		self->consumed_bytes = 0;
 		memory_stream_write(&self->buffer, Block{ str.ptr, str.count });
 		memory_stream_cursor_to_start(&self->buffer);
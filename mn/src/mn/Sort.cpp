@@ -0,0 +1,134 @@
+#include "mn/Sort.h"
+#include "mn/Memory.h"
+#include "mn/Defer.h"
+
+namespace mn
+{
+	// below this count the string buckets are sorted using insertion sort
+	constexpr size_t SORT_STR_INSERTION_THRESHOLD = 32;
+
+	inline static Str_View
+	_radix_sort_str_view(const Str& str)
+	{
+		return Str_View{str.ptr, str.count};
+	}
+
+	inline static Str_View
+	_radix_sort_str_view(const Str_View& str)
+	{
+		return str;
+	}
+
+	// returns the digit of the given string at the given depth, strings which end before the depth are in bucket 0
+	inline static size_t
+	_radix_sort_str_digit(Str_View str, size_t depth)
+	{
+		return depth < str.count ? size_t(uint8_t(str.ptr[depth])) + 1 : 0;
+	}
+
+	// compares the given strings starting from the given depth, since all the previous bytes are equal
+	inline static bool
+	_radix_sort_str_less(Str_View a, Str_View b, size_t depth)
+	{
+		auto a_count = a.count - depth;
+		auto b_count = b.count - depth;
+		auto count = a_count < b_count ? a_count : b_count;
+		auto res = count ? ::memcmp(a.ptr + depth, b.ptr + depth, count) : 0;
+		return res < 0 || (res == 0 && a_count < b_count);
+	}
+
+	// sorts the strings using MSD radix sort, LSD doesn't fit variable length keys so the strings are distributed by
+	// their bytes starting from the first one, and the buckets are processed using an explicit stack so long common
+	// prefixes don't overflow the call stack
+	template<typename T>
+	inline static void
+	_radix_sort_strings(T* ptr, size_t count)
+	{
+		struct Frame
+		{
+			size_t begin;
+			size_t count;
+			size_t depth;
+		};
+
+		if (count < 2)
+			return;
+
+		auto tmp = buf_with_allocator<T>(memory::tmp());
+		auto stack = buf_with_allocator<Frame>(memory::tmp());
+		mn_defer({
+			buf_free(tmp);
+			buf_free(stack);
+		});
+		buf_resize(tmp, count);
+		buf_push(stack, Frame{0, count, 0});
+
+		size_t histogram[257];
+		size_t offsets[257];
+		while (stack.count > 0)
+		{
+			auto frame = buf_top(stack);
+			buf_pop(stack);
+			auto items = ptr + frame.begin;
+			auto depth = frame.depth;
+
+			if (frame.count < SORT_STR_INSERTION_THRESHOLD)
+			{
+				auto less = [depth](const T& a, const T& b) {
+					return _radix_sort_str_less(_radix_sort_str_view(a), _radix_sort_str_view(b), depth);
+				};
+				_sort_insertion<false>(items, items + frame.count, less);
+				continue;
+			}
+
+			::memset(histogram, 0, sizeof(histogram));
+			for (size_t i = 0; i < frame.count; ++i)
+				++histogram[_radix_sort_str_digit(_radix_sort_str_view(items[i]), depth)];
+
+			// all the strings have the same byte at this depth so there's nothing to move
+			auto first_digit = _radix_sort_str_digit(_radix_sort_str_view(items[0]), depth);
+			if (histogram[first_digit] == frame.count)
+			{
+				if (first_digit != 0)
+					buf_push(stack, Frame{frame.begin, frame.count, depth + 1});
+				continue;
+			}
+
+			size_t offset = 0;
+			for (size_t digit = 0; digit < 257; ++digit)
+			{
+				offsets[digit] = offset;
+				offset += histogram[digit];
+			}
+
+			for (size_t i = 0; i < frame.count; ++i)
+			{
+				auto digit = _radix_sort_str_digit(_radix_sort_str_view(items[i]), depth);
+				tmp[offsets[digit]++] = items[i];
+			}
+			::memcpy((void*)items, tmp.ptr, frame.count * sizeof(T));
+
+			// the strings which ended at this depth (bucket 0) are equal and in their final place
+			offset = histogram[0];
+			for (size_t digit = 1; digit < 257; ++digit)
+			{
+				if (histogram[digit] > 1)
+					buf_push(stack, Frame{frame.begin + offset, histogram[digit], depth + 1});
+				offset += histogram[digit];
+			}
+		}
+	}
+
+	// API
+	void
+	buf_radix_sort(Buf<Str>& self)
+	{
+		_radix_sort_strings(self.ptr, self.count);
+	}
+
+	void
+	buf_radix_sort(Buf<Str_View>& self)
+	{
+		_radix_sort_strings(self.ptr, self.count);
+	}
+}
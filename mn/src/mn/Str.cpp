@@ -375,6 +375,56 @@ namespace mn
 		return result;
 	}
 
+	size_t
+	str_view_find(Str_View self, Str_View target, size_t start)
+	{
+		if (start > self.count || self.count - start < target.count)
+			return size_t(-1);
+		if (target.count == 0)
+			return start;
+
+		// memchr for the first character is vectorized by the libc so it skips the non matching parts quickly, then only
+		// the candidates are compared
+		auto it = self.ptr + start;
+		auto last = self.ptr + self.count - target.count;
+		while (it <= last)
+		{
+			it = (const char*)::memchr(it, target.ptr[0], size_t(last - it) + 1);
+			if (it == nullptr)
+				break;
+			if (::memcmp(it + 1, target.ptr + 1, target.count - 1) == 0)
+				return size_t(it - self.ptr);
+			++it;
+		}
+		return size_t(-1);
+	}
+
+	size_t
+	str_view_find_last(Str_View self, Str_View target)
+	{
+		if (target.count > self.count)
+			return size_t(-1);
+		if (target.count == 0)
+			return self.count;
+
+		for (size_t i = self.count - target.count + 1; i > 0; --i)
+		{
+			auto it = self.ptr + i - 1;
+			if (*it == target.ptr[0] && ::memcmp(it + 1, target.ptr + 1, target.count - 1) == 0)
+				return i - 1;
+		}
+		return size_t(-1);
+	}
+
+	Buf<Str_View>
+	str_view_split(Str_View self, Str_View delim, bool skip_empty, Allocator allocator)
+	{
+		auto result = buf_with_allocator<Str_View>(allocator);
+		for (auto piece: str_split_iter(self, delim, skip_empty))
+			buf_push(result, piece);
+		return result;
+	}
+
 	bool
 	str_prefix(const Str& self, const Str& prefix)
 	{
@@ -1,37 +1,267 @@
 #include "mn/Str_Intern.h"
+#include "mn/Memory.h"
+#include "mn/Thread.h"
+#include "mn/Defer.h"
 #include "mn/Assert.h"
 
+#include <atomic>
+
+#if MN_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
 namespace mn
 {
 	const char*
 	str_intern(Str_Intern& self, const char* str)
 	{
-		if(auto it = set_lookup(self.strings, str_lit(str)))
-		{
-			return it->ptr;
-		}
-		return set_insert(self.strings, str_from_c(str, self.tmp_str.allocator))->ptr;
+		return set_insert_if_absent(self.strings, str_view(str), [&](Str_View v) {
+			return str_from_view(v, self.tmp_str.allocator);
+		})->ptr;
 	}
 
 	const char*
 	str_intern(Str_Intern& self, const Str& str)
 	{
-		if(auto it = set_lookup(self.strings, str))
-		{
-			return it->ptr;
-		}
-		return set_insert(self.strings, str_clone(str, self.tmp_str.allocator))->ptr;
+		return set_insert_if_absent(self.strings, str, [&](const Str& s) {
+			return str_clone(s, self.tmp_str.allocator);
+		})->ptr;
 	}
 
 	const char*
 	str_intern(Str_Intern& self, const char* begin, const char* end)
 	{
-		mn_assert_msg(end >= begin, "Invalid SubStr");
-		str_clear(self.tmp_str);
-		buf_resize(self.tmp_str, end - begin + 1);
-		--self.tmp_str.count;
-		::memcpy(self.tmp_str.ptr, begin, self.tmp_str.count);
-		self.tmp_str.ptr[self.tmp_str.count] = '\0';
-		return str_intern(self, self.tmp_str);
+		return set_insert_if_absent(self.strings, str_view(begin, end), [&](Str_View v) {
+			return str_from_view(v, self.tmp_str.allocator);
+		})->ptr;
+	}
+
+	// log2 of the entries count of the first segment, segment i has 2^(BITS + i) entries so the segments never move
+	// and ids up to 2^32 fit in a fixed array of segments
+	constexpr size_t CONCURRENT_STR_INTERN_SEGMENT_BITS = 10;
+	constexpr size_t CONCURRENT_STR_INTERN_SEGMENTS_COUNT = 32 - CONCURRENT_STR_INTERN_SEGMENT_BITS + 1;
+
+	struct Concurrent_Str_Intern_Entry
+	{
+		const char* ptr;
+		uint32_t count;
+		// low 32-bit of the hash which selects the slot in the table, the high 32-bit is stored in the slot itself
+		uint32_t hash;
+	};
+
+	// open addressing hash table, each slot is 0 when empty, otherwise it's the high 32-bit of the hash followed by
+	// id + 1, old tables are kept alive until the interner is freed since lock free readers may still be probing them
+	struct Concurrent_Str_Intern_Table
+	{
+		Concurrent_Str_Intern_Table* prev;
+		size_t mask;
+		std::atomic<uint64_t>* slots;
+	};
+
+	struct IConcurrent_Str_Intern
+	{
+		Allocator allocator;
+		Mutex mtx;
+		memory::Arena* arena;
+		std::atomic<Concurrent_Str_Intern_Table*> table;
+		std::atomic<Concurrent_Str_Intern_Entry*> segments[CONCURRENT_STR_INTERN_SEGMENTS_COUNT];
+		std::atomic<uint32_t> count;
+	};
+
+	inline static size_t
+	_concurrent_str_intern_msb_index(uint64_t v)
+	{
+		#if MN_COMPILER_MSVC
+			unsigned long index = 0;
+			_BitScanReverse64(&index, v);
+			return size_t(index);
+		#else
+			return size_t(63 - __builtin_clzll(v));
+		#endif
+	}
+
+	inline static Concurrent_Str_Intern_Entry*
+	_concurrent_str_intern_entry(IConcurrent_Str_Intern* self, uint32_t id, bool create)
+	{
+		auto v = uint64_t(id) + (uint64_t(1) << CONCURRENT_STR_INTERN_SEGMENT_BITS);
+		auto msb = _concurrent_str_intern_msb_index(v);
+		auto segment_index = msb - CONCURRENT_STR_INTERN_SEGMENT_BITS;
+		auto segment = self->segments[segment_index].load(std::memory_order_acquire);
+		if (segment == nullptr)
+		{
+			mn_assert(create);
+			auto segment_count = size_t(1) << msb;
+			segment = (Concurrent_Str_Intern_Entry*)alloc_from(
+				self->allocator,
+				sizeof(Concurrent_Str_Intern_Entry) * segment_count,
+				alignof(Concurrent_Str_Intern_Entry)
+			).ptr;
+			self->segments[segment_index].store(segment, std::memory_order_release);
+		}
+		return segment + (v - (uint64_t(1) << msb));
+	}
+
+	inline static Concurrent_Str_Intern_Table*
+	_concurrent_str_intern_table_new(Allocator allocator, size_t slots_count)
+	{
+		auto table = alloc_construct_from<Concurrent_Str_Intern_Table>(allocator);
+		table->mask = slots_count - 1;
+		table->slots = (std::atomic<uint64_t>*)alloc_from(
+			allocator,
+			sizeof(std::atomic<uint64_t>) * slots_count,
+			alignof(std::atomic<uint64_t>)
+		).ptr;
+		for (size_t i = 0; i < slots_count; ++i)
+			::new (table->slots + i) std::atomic<uint64_t>(0);
+		return table;
+	}
+
+	inline static void
+	_concurrent_str_intern_table_insert(Concurrent_Str_Intern_Table* table, uint32_t hash_lo, uint64_t slot)
+	{
+		for (auto i = hash_lo & table->mask;; i = (i + 1) & table->mask)
+		{
+			if (table->slots[i].load(std::memory_order_relaxed) == 0)
+			{
+				table->slots[i].store(slot, std::memory_order_release);
+				return;
+			}
+		}
+	}
+
+	inline static uint32_t
+	_concurrent_str_intern_find(IConcurrent_Str_Intern* self, Str_View str, uint64_t hash)
+	{
+		auto table = self->table.load(std::memory_order_acquire);
+		auto tag = hash >> 32;
+		for (auto i = hash & table->mask;; i = (i + 1) & table->mask)
+		{
+			auto slot = table->slots[i].load(std::memory_order_acquire);
+			if (slot == 0)
+				return STR_INTERN_INVALID_ID;
+			if ((slot >> 32) != tag)
+				continue;
+
+			auto id = uint32_t(slot) - 1;
+			auto entry = _concurrent_str_intern_entry(self, id, false);
+			if (entry->count == str.count && (str.count == 0 || ::memcmp(entry->ptr, str.ptr, str.count) == 0))
+				return id;
+		}
+	}
+
+	// API
+	Concurrent_Str_Intern
+	concurrent_str_intern_new(Allocator allocator)
+	{
+		auto self = alloc_construct_from<IConcurrent_Str_Intern>(allocator);
+		self->allocator = allocator;
+		self->mtx = mutex_new("concurrent string intern mutex");
+		self->arena = allocator_arena_new(64ULL * 1024ULL, allocator);
+		self->table.store(_concurrent_str_intern_table_new(allocator, 1024), std::memory_order_relaxed);
+		for (auto& segment: self->segments)
+			segment.store(nullptr, std::memory_order_relaxed);
+		self->count.store(0, std::memory_order_relaxed);
+		return self;
+	}
+
+	void
+	concurrent_str_intern_free(Concurrent_Str_Intern self)
+	{
+		auto table = self->table.load(std::memory_order_relaxed);
+		while (table)
+		{
+			auto prev = table->prev;
+			free_from(self->allocator, Block{table->slots, sizeof(std::atomic<uint64_t>) * (table->mask + 1)});
+			free_destruct_from(self->allocator, table);
+			table = prev;
+		}
+
+		for (size_t i = 0; i < CONCURRENT_STR_INTERN_SEGMENTS_COUNT; ++i)
+		{
+			if (auto segment = self->segments[i].load(std::memory_order_relaxed))
+			{
+				auto segment_count = size_t(1) << (CONCURRENT_STR_INTERN_SEGMENT_BITS + i);
+				free_from(self->allocator, Block{segment, sizeof(Concurrent_Str_Intern_Entry) * segment_count});
+			}
+		}
+
+		allocator_free(self->arena);
+		mutex_free(self->mtx);
+		free_destruct_from(self->allocator, self);
+	}
+
+	uint32_t
+	concurrent_str_intern(Concurrent_Str_Intern self, Str_View str)
+	{
+		mn_assert(str.count < UINT32_MAX);
+
+		auto hash = uint64_t(hash_bytes(str.ptr, str.count));
+		auto id = _concurrent_str_intern_find(self, str, hash);
+		if (id != STR_INTERN_INVALID_ID)
+			return id;
+
+		mutex_lock(self->mtx);
+		mn_defer(mutex_unlock(self->mtx));
+
+		// another thread might have interned it while we were waiting for the lock
+		id = _concurrent_str_intern_find(self, str, hash);
+		if (id != STR_INTERN_INVALID_ID)
+			return id;
+
+		id = self->count.load(std::memory_order_relaxed);
+		mn_assert_msg(id < STR_INTERN_INVALID_ID - 1, "concurrent string intern ids overflow");
+
+		// keep the load factor under 1/2, the new table is filled then published so readers always see a complete table
+		auto table = self->table.load(std::memory_order_relaxed);
+		if ((size_t(id) + 1) * 2 > table->mask + 1)
+		{
+			auto new_table = _concurrent_str_intern_table_new(self->allocator, (table->mask + 1) * 2);
+			for (size_t i = 0; i <= table->mask; ++i)
+			{
+				auto slot = table->slots[i].load(std::memory_order_relaxed);
+				if (slot == 0)
+					continue;
+				auto entry = _concurrent_str_intern_entry(self, uint32_t(slot) - 1, false);
+				_concurrent_str_intern_table_insert(new_table, entry->hash, slot);
+			}
+			new_table->prev = table;
+			self->table.store(new_table, std::memory_order_release);
+			table = new_table;
+		}
+
+		auto ptr = (char*)alloc_from(self->arena, str.count + 1, alignof(char)).ptr;
+		if (str.count > 0)
+			::memcpy(ptr, str.ptr, str.count);
+		ptr[str.count] = '\0';
+
+		auto entry = _concurrent_str_intern_entry(self, id, true);
+		entry->ptr = ptr;
+		entry->count = uint32_t(str.count);
+		entry->hash = uint32_t(hash);
+
+		// the slot is published with release semantics after the entry is written
+		_concurrent_str_intern_table_insert(table, uint32_t(hash), ((hash >> 32) << 32) | (uint64_t(id) + 1));
+		self->count.store(id + 1, std::memory_order_release);
+		return id;
+	}
+
+	uint32_t
+	concurrent_str_intern_lookup(Concurrent_Str_Intern self, Str_View str)
+	{
+		return _concurrent_str_intern_find(self, str, uint64_t(hash_bytes(str.ptr, str.count)));
+	}
+
+	Str_View
+	concurrent_str_intern_str(Concurrent_Str_Intern self, uint32_t id)
+	{
+		mn_assert(id < self->count.load(std::memory_order_acquire));
+		auto entry = _concurrent_str_intern_entry(self, id, false);
+		return Str_View{entry->ptr, entry->count};
+	}
+
+	size_t
+	concurrent_str_intern_count(Concurrent_Str_Intern self)
+	{
+		return self->count.load(std::memory_order_acquire);
 	}
-}
\ No newline at end of file
+}
@@ -393,7 +393,7 @@ namespace mn
 			offset
 		);
 
-		if (ptr == nullptr)
+		if (ptr == MAP_FAILED)
 			return nullptr;
 
 		auto self = alloc_zerod<IMapped_File>();
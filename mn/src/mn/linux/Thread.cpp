@@ -11,6 +11,8 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include <chrono>
 
@@ -24,38 +26,6 @@ namespace mn
 		void* profile_user_data;
 	};
 
-	struct Leak_Allocator_Mutex
-	{
-		Source_Location srcloc;
-		IMutex self;
-
-		Leak_Allocator_Mutex()
-		{
-			srcloc.name = "allocators mutex";
-			srcloc.function = "mn::_leak_allocator_mutex";
-			srcloc.file = __FILE__;
-			srcloc.line = __LINE__;
-			srcloc.color = 0;
-			self.name = srcloc.name;
-			self.srcloc = &srcloc;
-			[[maybe_unused]] int result = pthread_mutex_init(&self.handle, NULL);
-			mn_assert(result == 0);
-			self.profile_user_data = _mutex_new(&self, self.name);
-		}
-
-		~Leak_Allocator_Mutex()
-		{
-			_mutex_free(&self, self.profile_user_data);
-		}
-	};
-
-	Mutex
-	_leak_allocator_mutex()
-	{
-		static Leak_Allocator_Mutex mtx;
-		return &mtx.self;
-	}
-
 	static void
 	ms2ts(struct timespec *ts, unsigned long ms)
 	{
@@ -762,4 +732,25 @@ namespace mn
 		if (self->count == 0)
 			pthread_cond_broadcast(&self->cv);
 	}
+
+	void
+	futex_wait(const std::atomic<uint32_t>& value, uint32_t expected)
+	{
+		worker_block_ahead();
+		mn_defer(worker_block_clear());
+
+		syscall(SYS_futex, (const uint32_t*)&value, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+	}
+
+	void
+	futex_wake_one(std::atomic<uint32_t>& value)
+	{
+		syscall(SYS_futex, (uint32_t*)&value, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+	}
+
+	void
+	futex_wake_all(std::atomic<uint32_t>& value)
+	{
+		syscall(SYS_futex, (uint32_t*)&value, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+	}
 }
@@ -392,7 +392,7 @@ namespace mn
 			offset
 		);
 
-		if (ptr == nullptr)
+		if (ptr == MAP_FAILED)
 			return nullptr;
 
 		auto self = alloc_zerod<IMapped_File>();
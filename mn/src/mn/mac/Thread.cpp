@@ -24,38 +24,6 @@ namespace mn
 		void* profile_user_data;
 	};
 
-	struct Leak_Allocator_Mutex
-	{
-		Source_Location srcloc;
-		IMutex self;
-
-		Leak_Allocator_Mutex()
-		{
-			srcloc.name = "allocators mutex";
-			srcloc.function = "mn::_leak_allocator_mutex";
-			srcloc.file = __FILE__;
-			srcloc.line = __LINE__;
-			srcloc.color = 0;
-			self.name = srcloc.name;
-			self.srcloc = &srcloc;
-			[[maybe_unused]] int result = pthread_mutex_init(&self.handle, NULL);
-			mn_assert(result == 0);
-			self.profile_user_data = _mutex_new(&self, self.name);
-		}
-
-		~Leak_Allocator_Mutex()
-		{
-			_mutex_free(&self, self.profile_user_data);
-		}
-	};
-
-	Mutex
-	_leak_allocator_mutex()
-	{
-		static Leak_Allocator_Mutex mtx;
-		return &mtx.self;
-	}
-
 	static void
 	ms2ts(struct timespec *ts, unsigned long ms)
 	{
@@ -764,4 +732,71 @@ namespace mn
 		if (self->count == 0)
 			pthread_cond_broadcast(&self->cv);
 	}
+
+	// macOS has no public futex api, so waiters park on a condition variable of a bucket selected by the address
+	struct Futex_Bucket
+	{
+		pthread_mutex_t mtx;
+		pthread_cond_t cv;
+	};
+
+	struct Futex_Buckets
+	{
+		Futex_Bucket buckets[64];
+
+		Futex_Buckets()
+		{
+			for (auto& bucket: buckets)
+			{
+				pthread_mutex_init(&bucket.mtx, NULL);
+				pthread_cond_init(&bucket.cv, NULL);
+			}
+		}
+
+		~Futex_Buckets()
+		{
+			for (auto& bucket: buckets)
+			{
+				pthread_mutex_destroy(&bucket.mtx);
+				pthread_cond_destroy(&bucket.cv);
+			}
+		}
+	};
+
+	inline static Futex_Bucket*
+	_futex_bucket(const void* address)
+	{
+		static Futex_Buckets _futex_buckets;
+		auto index = (uintptr_t(address) >> 2) * 0x9E3779B97F4A7C15ULL;
+		return &_futex_buckets.buckets[index >> 58];
+	}
+
+	void
+	futex_wait(const std::atomic<uint32_t>& value, uint32_t expected)
+	{
+		worker_block_ahead();
+		mn_defer(worker_block_clear());
+
+		auto bucket = _futex_bucket(&value);
+		pthread_mutex_lock(&bucket->mtx);
+		if (value.load() == expected)
+			pthread_cond_wait(&bucket->cv, &bucket->mtx);
+		pthread_mutex_unlock(&bucket->mtx);
+	}
+
+	void
+	futex_wake_one(std::atomic<uint32_t>& value)
+	{
+		// the bucket is shared between addresses so all of its waiters are woken up
+		futex_wake_all(value);
+	}
+
+	void
+	futex_wake_all(std::atomic<uint32_t>& value)
+	{
+		auto bucket = _futex_bucket(&value);
+		pthread_mutex_lock(&bucket->mtx);
+		pthread_cond_broadcast(&bucket->cv);
+		pthread_mutex_unlock(&bucket->mtx);
+	}
 }
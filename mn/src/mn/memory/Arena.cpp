@@ -13,6 +13,9 @@ namespace mn::memory
 		this->total_mem = 0;
 		this->used_mem = 0;
 		this->highwater_mem = 0;
+		this->allocations_count = 0;
+		this->total_allocations_count = 0;
+		this->total_allocations_size = 0;
 		this->clear_all_readjust_threshold = 4ULL * 1024ULL * 1024ULL;
 		this->clear_all_current_highwater = 0;
 		this->clear_all_previous_highwater = 0;
@@ -31,6 +34,9 @@ namespace mn::memory
 		uint8_t* ptr = this->head->alloc_head;
 		this->head->alloc_head += size;
 		this->used_mem += size;
+		++this->allocations_count;
+		++this->total_allocations_count;
+		this->total_allocations_size += size;
 		this->highwater_mem = this->highwater_mem > this->used_mem ? this->highwater_mem : this->used_mem;
 		this->clear_all_current_highwater = this->clear_all_current_highwater > this->used_mem ? this->clear_all_current_highwater : this->used_mem;
 
@@ -78,6 +84,7 @@ namespace mn::memory
 		this->head = nullptr;
 		this->total_mem = 0;
 		this->used_mem = 0;
+		this->allocations_count = 0;
 	}
 
 	void
@@ -102,6 +109,7 @@ namespace mn::memory
 		{
 			this->head->alloc_head = (uint8_t*)this->head->mem.ptr;
 			this->used_mem = 0;
+			this->allocations_count = 0;
 			this->clear_all_current_highwater = 0;
 		}
 	}
@@ -124,10 +132,12 @@ namespace mn::memory
 	{
 		State s{};
 		s.head = this->head;
-		s.alloc_head = this->head->alloc_head;
+		// the arena might not have allocated any memory yet
+		s.alloc_head = this->head ? this->head->alloc_head : nullptr;
 		s.total_mem = this->total_mem;
 		s.used_mem = this->used_mem;
 		s.highwater_mem = this->highwater_mem;
+		s.allocations_count = this->allocations_count;
 		return s;
 	}
 
@@ -142,8 +152,23 @@ namespace mn::memory
 		}
 		mn_assert(this->head == s.head);
 		this->head = s.head;
-		this->head->alloc_head = s.alloc_head;
+		if (this->head)
+			this->head->alloc_head = s.alloc_head;
 		this->total_mem = s.total_mem;
 		this->used_mem = s.used_mem;
+		this->allocations_count = s.allocations_count;
+	}
+
+	Stats
+	Arena::stats() const
+	{
+		Stats res{};
+		res.live_size = this->used_mem;
+		res.live_count = this->allocations_count;
+		res.peak_size = this->highwater_mem;
+		res.total_count = this->total_allocations_count;
+		res.total_size = this->total_allocations_size;
+		res.reserved_size = this->total_mem;
+		return res;
 	}
 }
@@ -1,8 +1,14 @@
 #include "mn/memory/Buddy.h"
+#include "mn/Thread.h"
+#include "mn/Assert.h"
 
 #include <math.h>
 #include <string.h>
 
+#if MN_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
 namespace mn::memory
 {
 	constexpr size_t BUDDY_HEADER_SIZE = 8;
@@ -45,6 +51,19 @@ namespace mn::memory
 		return back;
 	}
 
+	// returns the index of the most significant set bit, v should not be 0
+	inline static size_t
+	_buddy_msb_index(uint64_t v)
+	{
+		#if MN_COMPILER_MSVC
+			unsigned long index = 0;
+			_BitScanReverse64(&index, v);
+			return size_t(index);
+		#else
+			return size_t(63 - __builtin_clzll(v));
+		#endif
+	}
+
 	inline static size_t
 	next_power_of_2(size_t v)
 	{
@@ -75,130 +94,289 @@ namespace mn::memory
 	}
 
 	inline static uint8_t*
-	ptr_for_node(Buddy* self, size_t index, size_t bucket)
+	ptr_for_node(Buddy* self, Buddy::Heap* heap, size_t index, size_t bucket)
 	{
-		return self->base_ptr + ((index - ((size_t)1 << bucket) + (size_t)1) << (self->max_alloc_log2 - bucket));
+		return heap->base_ptr + ((index - ((size_t)1 << bucket) + (size_t)1) << (self->max_alloc_log2 - bucket));
 	}
 
 	inline static size_t
-	node_for_ptr(Buddy* self, uint8_t* ptr, size_t bucket)
+	node_for_ptr(Buddy* self, Buddy::Heap* heap, uint8_t* ptr, size_t bucket)
 	{
-		return ((ptr - self->base_ptr) >> (self->max_alloc_log2 - bucket)) + ((size_t)1 << bucket) - (size_t)1;
+		return ((ptr - heap->base_ptr) >> (self->max_alloc_log2 - bucket)) + ((size_t)1 << bucket) - (size_t)1;
 	}
 
 	inline static bool
-	parent_is_split(Buddy* self, size_t index)
+	parent_is_split(Buddy::Heap* heap, size_t index)
 	{
 		index = (index - 1) / 2;
-		return (bool) ((self->node_is_split[index/8] >> (index % 8)) & 1);
+		return (bool) ((heap->node_is_split[index/8] >> (index % 8)) & 1);
 	}
 
 	inline static void
-	flip_parent_is_split(Buddy* self, size_t index)
+	flip_parent_is_split(Buddy::Heap* heap, size_t index)
 	{
 		index = (index - 1) / 2;
-		self->node_is_split[index/8] ^= 1 << (index % 8);
+		heap->node_is_split[index/8] ^= 1 << (index % 8);
+	}
+
+	// free list operations which keeps the non empty buckets mask in sync
+	inline static void
+	buddy_bucket_push(Buddy::Heap* heap, size_t bucket, uint8_t* ptr)
+	{
+		node_push(&heap->buckets[bucket], (Buddy::Node*)ptr);
+		heap->buckets_mask |= uint64_t(1) << bucket;
+	}
+
+	inline static uint8_t*
+	buddy_bucket_pop(Buddy::Heap* heap, size_t bucket)
+	{
+		auto list = &heap->buckets[bucket];
+		auto res = node_pop(list);
+		if (list->next == list)
+			heap->buckets_mask &= ~(uint64_t(1) << bucket);
+		return (uint8_t*)res;
+	}
+
+	inline static void
+	buddy_bucket_remove(Buddy::Heap* heap, size_t bucket, uint8_t* ptr)
+	{
+		auto list = &heap->buckets[bucket];
+		node_remove((Buddy::Node*)ptr);
+		if (list->next == list)
+			heap->buckets_mask &= ~(uint64_t(1) << bucket);
+	}
+
+	inline static Buddy::Heap*
+	buddy_heap_new(Buddy* self)
+	{
+		// increase size for buckets
+		size_t buckets_size = sizeof(Buddy::Node) * self->bucket_max;
+		// increase size for node_is_split lookup
+		size_t node_is_split_size = (((size_t)1 << (self->bucket_max - 1)) + 7) / 8;
+		size_t total_size = self->max_alloc + sizeof(Buddy::Heap) + buckets_size + node_is_split_size;
+
+		auto memory = self->meta->alloc(total_size, alignof(Buddy::Heap));
+		if (memory.ptr == nullptr)
+			return nullptr;
+
+		// the book keeping data lives after the heap memory so that the heap memory itself stays
+		// aligned to whatever the meta allocator returns (page aligned in case of virtual memory)
+		auto heap = (Buddy::Heap*)((uint8_t*)memory.ptr + self->max_alloc);
+		heap->memory = memory;
+		heap->base_ptr = (uint8_t*)memory.ptr;
+		heap->allocations_count = 0;
+		heap->buckets_mask = 0;
+
+		heap->buckets = (Buddy::Node*)(heap + 1);
+		for (size_t i = 0; i < self->bucket_max; ++i)
+			node_init(&heap->buckets[i]);
+
+		heap->node_is_split = (uint8_t*)heap->buckets + buckets_size;
+		::memset(heap->node_is_split, 0, node_is_split_size);
+
+		// init the root bucket with the entire heap
+		buddy_bucket_push(heap, 0, heap->base_ptr);
+		return heap;
 	}
 
 	inline static void
-	update_max_ptr(Buddy* self, uint8_t* new_ptr)
+	buddy_heap_free(Buddy* self, Buddy::Heap* heap)
+	{
+		self->meta->free(heap->memory);
+	}
+
+	inline static uint8_t*
+	buddy_heap_alloc(Buddy* self, Buddy::Heap* heap, size_t bucket)
+	{
+		// find the smallest free block which is as large or larger than the request, larger blocks
+		// have smaller bucket indices so we're looking for the highest set bit in [0, bucket]
+		uint64_t candidates = heap->buckets_mask & ((uint64_t(2) << bucket) - 1);
+		if (candidates == 0)
+			return nullptr;
+
+		size_t free_bucket = _buddy_msb_index(candidates);
+		uint8_t* ptr = buddy_bucket_pop(heap, free_bucket);
+		mn_assert(ptr != nullptr);
+
+		// If we got a node off the free list, change the node from UNUSED to
+		// USED. This involves flipping our parent's "is split" bit because that
+		// bit is the exclusive-or of the UNUSED flags of both children, and our
+		// UNUSED flag (which isn't ever stored explicitly) has just changed.
+		//
+		// Note that we shouldn't ever need to flip the "is split" bit of our
+		// grandparent because we know our buddy is USED so it's impossible for
+		// our grandparent to be UNUSED (if our buddy chunk was UNUSED, our
+		// parent wouldn't ever have been split in the first place).
+		size_t i = node_for_ptr(self, heap, ptr, free_bucket);
+		if (i != 0)
+			flip_parent_is_split(heap, i);
+
+		// If the node we got is larger than we need, split it down to the
+		// correct size and put the new unused child nodes on the free list in
+		// the corresponding bucket. This is done by repeatedly moving to the
+		// left child, splitting the parent, and then adding the right child to
+		// the free list.
+		while (free_bucket < bucket)
+		{
+			i = i * 2 + 1;
+			++free_bucket;
+			flip_parent_is_split(heap, i);
+			buddy_bucket_push(heap, free_bucket, ptr_for_node(self, heap, i + 1, free_bucket));
+		}
+
+		++heap->allocations_count;
+		return ptr;
+	}
+
+	inline static void
+	buddy_heap_free_ptr(Buddy* self, Buddy::Heap* heap, uint8_t* ptr)
+	{
+		size_t bucket = bucket_for_request(self, *(size_t *) ptr + BUDDY_HEADER_SIZE);
+		size_t i = node_for_ptr(self, heap, ptr, bucket);
+
+		// Traverse up to the root node, flipping USED blocks to UNUSED and merging
+		// UNUSED buddies together into a single UNUSED parent.
+		while (i != 0)
+		{
+			// Change this node from UNUSED to USED. This involves flipping our
+			// parent's "is split" bit because that bit is the exclusive-or of the
+			// UNUSED flags of both children, and our UNUSED flag (which isn't ever
+			// stored explicitly) has just changed.
+			flip_parent_is_split(heap, i);
+
+			// If the parent is now SPLIT, that means our buddy is USED, so don't
+			// merge with it. Instead, stop the iteration here and add ourselves to
+			// the free list for our bucket.
+			if (parent_is_split(heap, i))
+				break;
+
+			// If we get here, we know our buddy is UNUSED. In this case we should
+			// merge with that buddy and continue traversing up to the root node. We
+			// need to remove the buddy from its free list here but we don't need to
+			// add the merged parent to its free list yet. That will be done once
+			// after this loop is finished.
+			buddy_bucket_remove(heap, bucket, ptr_for_node(self, heap, ((i - 1) ^ 1) + 1, bucket));
+			i = (i - 1) / 2;
+			--bucket;
+		}
+
+		// Add ourselves to the free list for our bucket. We add to the back of the
+		// list because "alloc" takes from the back of the list and we want a
+		// "free" followed by an "alloc" of the same size to ideally use the same
+		// address for better memory locality.
+		buddy_bucket_push(heap, bucket, ptr_for_node(self, heap, i, bucket));
+		--heap->allocations_count;
+	}
+
+	inline static bool
+	buddy_heap_owns(Buddy* self, Buddy::Heap* heap, uint8_t* ptr)
 	{
-		if (new_ptr > self->max_ptr)
-			self->max_ptr = new_ptr;
+		return ptr >= heap->base_ptr && ptr < heap->base_ptr + self->max_alloc;
 	}
 
+	// returns the index of the heap which owns the given ptr or heaps_count if no heap owns it
+	inline static size_t
+	buddy_heap_find(Buddy* self, uint8_t* ptr)
+	{
+		// find the last heap with base_ptr <= ptr
+		size_t begin = 0;
+		size_t end = self->heaps_count;
+		while (begin < end)
+		{
+			size_t mid = begin + (end - begin) / 2;
+			if (self->heaps[mid]->base_ptr <= ptr)
+				begin = mid + 1;
+			else
+				end = mid;
+		}
+
+		if (begin == 0 || buddy_heap_owns(self, self->heaps[begin - 1], ptr) == false)
+			return self->heaps_count;
+		return begin - 1;
+	}
+
+	// inserts the given heap into the heaps array keeping it sorted by base address
 	inline static bool
-	lower_bucket_count(Buddy* self, size_t bucket)
+	buddy_heap_insert(Buddy* self, Buddy::Heap* heap)
 	{
-		while (bucket < self->bucket_count)
+		if (self->heaps_count == self->heaps_cap)
 		{
-			auto root = node_for_ptr(self, self->base_ptr, self->bucket_count);
-
-			/*
-			* If the parent isn't SPLIT, that means the node at the current bucket
-			* limit is UNUSED and our address space is entirely free. In that case,
-			* clear the root free list, increase the bucket limit, and add a single
-			* block with the newly-expanded address space to the new root free
-			* list.
-			*/
-			if (parent_is_split(self, root) == false)
+			size_t new_cap = self->heaps_cap ? self->heaps_cap * 2 : 8;
+			auto memory = self->meta->alloc(new_cap * sizeof(Buddy::Heap*), alignof(Buddy::Heap*));
+			if (memory.ptr == nullptr)
+				return false;
+			if (self->heaps)
 			{
-				node_remove((Buddy::Node*)self->base_ptr);
-				node_init(&self->buckets[--self->bucket_count]);
-				node_push(&self->buckets[self->bucket_count], (Buddy::Node*)self->base_ptr);
-				continue;
+				::memcpy(memory.ptr, self->heaps, self->heaps_count * sizeof(Buddy::Heap*));
+				self->meta->free(Block{self->heaps, self->heaps_cap * sizeof(Buddy::Heap*)});
 			}
+			self->heaps = (Buddy::Heap**)memory.ptr;
+			self->heaps_cap = new_cap;
+		}
 
-			/*
-			* Otherwise, the tree is currently in use. Create a parent node for the
-			* current root node in the SPLIT state with a right child on the free
-			* list. Make sure to reserve the memory for the free list entry before
-			* writing to it. Note that we do not need to flip the "is split" flag
-			* for our current parent because it's already on (we know because we
-			* just checked it above).
-			*/
-			auto right_child = ptr_for_node(self, root + 1, self->bucket_count);
-			update_max_ptr(self, right_child + sizeof(Buddy::Node));
-			node_push(&self->buckets[self->bucket_count], (Buddy::Node*)right_child);
-			node_init(&self->buckets[--self->bucket_count]);
-
-			/*
-			* Set the grandparent's SPLIT flag so if we need to lower the bucket
-			* limit again, we'll know that the new root node we just added is in
-			* use.
-			*/
-			root = (root - 1) / 2;
-			if (root != 0)
-				flip_parent_is_split(self, root);
+		size_t index = self->heaps_count;
+		while (index > 0 && self->heaps[index - 1]->base_ptr > heap->base_ptr)
+		{
+			self->heaps[index] = self->heaps[index - 1];
+			--index;
 		}
+		self->heaps[index] = heap;
+		++self->heaps_count;
 		return true;
 	}
 
-	Buddy::Buddy(size_t heap_size, Interface* meta_)
+	// removes the heap at the given index from the heaps array and frees it
+	inline static void
+	buddy_heap_remove(Buddy* self, size_t index)
+	{
+		auto heap = self->heaps[index];
+		::memmove(self->heaps + index, self->heaps + index + 1, (self->heaps_count - index - 1) * sizeof(Buddy::Heap*));
+		--self->heaps_count;
+		buddy_heap_free(self, heap);
+	}
+
+	Buddy::Buddy(size_t heap_size, Interface* meta_, uint32_t flags_)
 	{
 		meta = meta_;
+		flags = flags_;
+		mtx = nullptr;
+		if (flags & BUDDY_FLAGS_THREAD_SAFE)
+			mtx = mutex_new("buddy allocator mutex");
 
-		heap_size = next_power_of_2(heap_size);
+		heap_size = next_power_of_2(heap_size < BUDDY_MIN_ALLOC ? BUDDY_MIN_ALLOC : heap_size);
 		max_alloc = heap_size;
 		max_alloc_log2 = (size_t)log2((double)heap_size);
 
 		bucket_max = max_alloc_log2 - BUDDY_MIN_ALLOC_LOG2 + 1;
-		buckets = nullptr;
 
-		bucket_count = bucket_max - 1;
-
-		node_is_split = nullptr;
-
-		base_ptr = nullptr;
-		max_ptr = nullptr;
-
-		// increase size for buckets
-		size_t buckets_size = sizeof(Node) * bucket_max;
-		// increase size for node_is_split lookup
-		size_t node_is_split_size = (1 << (bucket_max - 1)) / 8;
-		size_t total_size = heap_size + buckets_size + node_is_split_size;
-
-		memory = meta->alloc(total_size, alignof(int));
-
-		base_ptr = (uint8_t*)memory.ptr;
-		max_ptr = (uint8_t*)memory.ptr;
-
-		buckets = (Node*)((uint8_t*)memory.ptr + heap_size);
-		::memset(buckets, 0, buckets_size);
-
-		node_is_split = (uint8_t*)memory.ptr + heap_size + buckets_size;
-		::memset(node_is_split, 0, node_is_split_size);
-
-		// init the buckets list with the entire allocation
-		node_init(&buckets[bucket_max - 1]);
-		node_push(&buckets[bucket_max - 1], (Buddy::Node*)base_ptr);
+		heaps = nullptr;
+		heaps_count = 0;
+		heaps_cap = 0;
+		empty_heaps_count = 0;
+		if (auto heap = buddy_heap_new(this))
+		{
+			if (buddy_heap_insert(this, heap))
+				empty_heaps_count = 1;
+			else
+				buddy_heap_free(this, heap);
+		}
 
-		update_max_ptr(this, base_ptr + sizeof(Buddy::Node));
+		used_mem = 0;
+		allocations_count = 0;
+		highwater_mem = 0;
+		total_allocations_count = 0;
+		total_allocations_size = 0;
 	}
 
 	Buddy::~Buddy()
 	{
-		meta->free(memory);
+		for (size_t i = 0; i < heaps_count; ++i)
+			buddy_heap_free(this, heaps[i]);
+		if (heaps)
+			meta->free(Block{heaps, heaps_cap * sizeof(Heap*)});
+
+		if (mtx)
+			mutex_free(mtx);
 	}
 
 	Block
@@ -209,80 +387,50 @@ namespace mn::memory
 
 		// find the smallest bucket that will fit this request
 		size_t bucket = bucket_for_request(this, request + BUDDY_HEADER_SIZE);
-		size_t original_bucket = bucket;
 
-		// search for a bucket with a non empty free list that's as large or larger
-		// if there isn't an exact match, we'll need to split a larger one
-		while (bucket + 1 != 0)
+		if (mtx) mutex_lock(mtx);
+
+		uint8_t* ptr = nullptr;
+		for (size_t i = 0; i < heaps_count && ptr == nullptr; ++i)
 		{
-			// We may need to grow the tree to be able to fit an allocation of this
-			// size. Try to grow the tree and stop here if we can't.
-			if (lower_bucket_count(this, bucket) == false)
-				return {};
-
-			// Try to pop a block off the free list for this bucket. If the free
-			// list is empty, we're going to have to split a larger block instead.
-			uint8_t* ptr = (uint8_t*)node_pop(&buckets[bucket]);
-			if (ptr == nullptr)
-			{
-				// If we're not at the root of the tree or it's impossible to grow
-				// the tree any more, continue on to the next bucket.
-				if (bucket != bucket_count || bucket == 0)
-				{
-					--bucket;
-					continue;
-				}
-
-				// Otherwise, grow the tree one more level and then pop a block off
-				// the free list again. Since we know the root of the tree is used
-				// (because the free list was empty), this will add a parent above
-				// this node in the SPLIT state and then add the new right child
-				// node to the free list for this bucket. Popping the free list will
-				// give us this right child.
-				if (lower_bucket_count(this, bucket - 1) == false)
-					return {};
-				ptr = (uint8_t*)node_pop(&buckets[bucket]);
-			}
+			auto heap = heaps[i];
+			ptr = buddy_heap_alloc(this, heap, bucket);
+			if (ptr && heap->allocations_count == 1)
+				--empty_heaps_count;
+		}
 
-			// Try to expand the address space first before going any further. If we
-			// have run out of space, put this block back on the free list and fail.
-			size_t size = (size_t) 1 << (max_alloc_log2 - bucket);
-			size_t bytes_needed = bucket < original_bucket ? size / 2 + sizeof(Buddy::Node) : size;
-			update_max_ptr(this, ptr + bytes_needed);
-
-			// If we got a node off the free list, change the node from UNUSED to
-			// USED. This involves flipping our parent's "is split" bit because that
-			// bit is the exclusive-or of the UNUSED flags of both children, and our
-			// UNUSED flag (which isn't ever stored explicitly) has just changed.
-			//
-			// Note that we shouldn't ever need to flip the "is split" bit of our
-			// grandparent because we know our buddy is USED so it's impossible for
-			// our grandparent to be UNUSED (if our buddy chunk was UNUSED, our
-			// parent wouldn't ever have been split in the first place).
-			size_t i = node_for_ptr(this, ptr, bucket);
-			if (i != 0)
-				flip_parent_is_split(this, i);
-
-			// If the node we got is larger than we need, split it down to the
-			// correct size and put the new unused child nodes on the free list in
-			// the corresponding bucket. This is done by repeatedly moving to the
-			// left child, splitting the parent, and then adding the right child to
-			// the free list.
-			while (bucket < original_bucket)
+		// all the heaps are exhausted, so add a new one
+		if (ptr == nullptr && heaps_count > 0 && (flags & BUDDY_FLAGS_GROWABLE))
+		{
+			if (auto heap = buddy_heap_new(this))
 			{
-				i = i * 2 + 1;
-				++bucket;
-				flip_parent_is_split(this, i);
-				node_push(&buckets[bucket], (Buddy::Node*)ptr_for_node(this, i + 1, bucket));
+				if (buddy_heap_insert(this, heap))
+					ptr = buddy_heap_alloc(this, heap, bucket);
+				else
+					buddy_heap_free(this, heap);
 			}
+		}
 
-			// Now that we have a memory address, write the block header (just the
-			// size of the allocation) and return the address immediately after the
-			// header.
-			*(size_t*)ptr = request;
-			return Block{ptr + BUDDY_HEADER_SIZE, request};
+		if (ptr)
+		{
+			used_mem += request;
+			++allocations_count;
+			++total_allocations_count;
+			total_allocations_size += request;
+			if (used_mem > highwater_mem)
+				highwater_mem = used_mem;
 		}
-		return {};
+
+		if (mtx) mutex_unlock(mtx);
+
+		if (ptr == nullptr)
+			return {};
+
+		// Now that we have a memory address, write the block header (just the
+		// size of the allocation) and return the address immediately after the
+		// header.
+		*(size_t*)ptr = request;
+		return Block{ptr + BUDDY_HEADER_SIZE, request};
 	}
 
 	void
@@ -292,47 +440,48 @@ namespace mn::memory
 		if (block_is_empty(block))
 			return;
 
-		// We were given the address returned by "malloc" so get back to the actual
-		// address of the node by subtracting off the size of the block header. Then
-		// look up the index of the node corresponding to this address.
+		// We were given the address returned by "alloc" so get back to the actual
+		// address of the node by subtracting off the size of the block header
 		uint8_t* ptr = (uint8_t *) block.ptr - BUDDY_HEADER_SIZE;
-		size_t bucket = bucket_for_request(this, *(size_t *) ptr + BUDDY_HEADER_SIZE);
-		size_t i = node_for_ptr(this, (uint8_t *) ptr, bucket);
 
-		// Traverse up to the root node, flipping USED blocks to UNUSED and merging
-		// UNUSED buddies together into a single UNUSED parent.
-		while (i != 0)
-		{
-			// Change this node from UNUSED to USED. This involves flipping our
-			// parent's "is split" bit because that bit is the exclusive-or of the
-			// UNUSED flags of both children, and our UNUSED flag (which isn't ever
-			// stored explicitly) has just changed.
-			flip_parent_is_split(this, i);
+		if (mtx) mutex_lock(mtx);
 
-			// If the parent is now SPLIT, that means our buddy is USED, so don't
-			// merge with it. Instead, stop the iteration here and add ourselves to
-			// the free list for our bucket.
-			//
-			// Also stop here if we're at the current root node, even if that root
-			// node is now UNUSED. Root nodes don't have a buddy so we can't merge
-			// with one.
-			if (parent_is_split(this, i) || bucket == bucket_count)
-				break;
+		size_t index = buddy_heap_find(this, ptr);
+		mn_assert_msg(index < heaps_count, "buddy allocator does not own this block");
+		auto heap = heaps[index];
 
-			// If we get here, we know our buddy is UNUSED. In this case we should
-			// merge with that buddy and continue traversing up to the root node. We
-			// need to remove the buddy from its free list here but we don't need to
-			// add the merged parent to its free list yet. That will be done once
-			// after this loop is finished.
-			node_remove((Buddy::Node*)ptr_for_node(this, ((i - 1) ^ 1) + 1, bucket));
-			i = (i - 1) / 2;
-			--bucket;
+		used_mem -= *(size_t*)ptr;
+		--allocations_count;
+		buddy_heap_free_ptr(this, heap, ptr);
+
+		// keep a single empty heap around as a spare and release the other empty heaps back to
+		// the meta allocator
+		if (heap->allocations_count == 0)
+		{
+			if (empty_heaps_count == 0)
+				++empty_heaps_count;
+			else
+				buddy_heap_remove(this, index);
 		}
 
-		// Add ourselves to the free list for our bucket. We add to the back of the
-		// list because "malloc" takes from the back of the list and we want a
-		// "free" followed by a "malloc" of the same size to ideally use the same
-		// address for better memory locality.
-		node_push(&buckets[bucket], (Buddy::Node*)ptr_for_node(this, i, bucket));
+		if (mtx) mutex_unlock(mtx);
+	}
+
+	Stats
+	Buddy::stats() const
+	{
+		if (mtx) mutex_lock(mtx);
+
+		Stats res{};
+		res.live_size = used_mem;
+		res.live_count = allocations_count;
+		res.peak_size = highwater_mem;
+		res.total_count = total_allocations_count;
+		res.total_size = total_allocations_size;
+		for (size_t i = 0; i < heaps_count; ++i)
+			res.reserved_size += heaps[i]->memory.size;
+
+		if (mtx) mutex_unlock(mtx);
+		return res;
 	}
 }
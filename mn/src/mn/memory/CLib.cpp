@@ -14,6 +14,8 @@ namespace mn::memory
 		if (res.ptr == nullptr && size > 0)
 			mn::panic("system out of memory");
 		res.size = size;
+		if (res.ptr)
+			atomic_stats.on_alloc(res.size);
 		_memory_profile_alloc(res.ptr, res.size);
 		return res;
 	}
@@ -21,10 +23,20 @@ namespace mn::memory
 	void
 	CLib::free(Block block)
 	{
+		if (block.ptr)
+			atomic_stats.on_free(block.size);
 		_memory_profile_free(block.ptr, block.size);
 		::free(block.ptr);
 	}
 
+	Stats
+	CLib::stats() const
+	{
+		auto res = atomic_stats.load();
+		res.reserved_size = res.live_size;
+		return res;
+	}
+
 	CLib*
 	clib()
 	{
@@ -55,6 +55,16 @@ namespace mn::memory
 		::free(block.ptr);
 	}
 
+	Stats
+	Fast_Leak::stats() const
+	{
+		Stats res{};
+		res.live_size = atomic_size.load();
+		res.live_count = atomic_count.load();
+		res.reserved_size = res.live_size;
+		return res;
+	}
+
 	Fast_Leak*
 	fast_leak()
 	{
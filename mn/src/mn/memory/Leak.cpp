@@ -10,11 +10,49 @@
 
 namespace mn::memory
 {
+	inline static size_t
+	_leak_shard_index(Leak::Node* node)
+	{
+		auto h = uint64_t(uintptr_t(node)) >> 4;
+		h *= 0x9E3779B97F4A7C15ULL;
+		return size_t(h >> 58) & (Leak::SHARDS_COUNT - 1);
+	}
+
+	inline static void
+	_leak_shard_lock(Leak::Shard& self)
+	{
+		size_t spins = 0;
+		while (true)
+		{
+			if (self.locked.exchange(true, std::memory_order_acquire) == false)
+				return;
+
+			while (self.locked.load(std::memory_order_relaxed))
+			{
+				if (++spins > 64)
+					thread_sleep(0);
+			}
+		}
+	}
+
+	inline static void
+	_leak_shard_unlock(Leak::Shard& self)
+	{
+		self.locked.store(false, std::memory_order_release);
+	}
+
+	// count of allocations done by this thread, used to sample the call stacks
+	thread_local size_t _LEAK_THREAD_ALLOCATIONS_COUNT = 0;
+
 	Leak::Leak()
 	{
-		this->head = nullptr;
-		this->mtx = _leak_allocator_mutex();
+		for (auto& shard: this->shards)
+		{
+			shard.locked = false;
+			shard.head = nullptr;
+		}
 		this->report_on_destruct = true;
+		this->callstack_sample_rate = 1;
 	}
 
 	Leak::~Leak()
@@ -33,14 +71,21 @@ namespace mn::memory
 
 		ptr->size = size;
 		ptr->prev = nullptr;
-		mutex_lock(this->mtx);
-			ptr->next = this->head;
-			if (this->head != nullptr)
-				this->head->prev = ptr;
-			this->head = ptr;
-		mutex_unlock(this->mtx);
-
-		callstack_capture(ptr->callstack, Leak::CALLSTACK_MAX_FRAMES);
+
+		auto sample_rate = this->callstack_sample_rate.load(std::memory_order_relaxed);
+		if (sample_rate > 0 && (_LEAK_THREAD_ALLOCATIONS_COUNT++ % sample_rate) == 0)
+			callstack_capture(ptr->callstack, Leak::CALLSTACK_MAX_FRAMES);
+		else
+			::memset(ptr->callstack, 0, sizeof(ptr->callstack));
+
+		auto& shard = this->shards[_leak_shard_index(ptr)];
+		_leak_shard_lock(shard);
+			ptr->next = shard.head;
+			if (shard.head != nullptr)
+				shard.head->prev = ptr;
+			shard.head = ptr;
+		_leak_shard_unlock(shard);
+
 		auto res = Block{ ptr + 1, size };
 		_memory_profile_alloc(res.ptr, res.size);
 		return res;
@@ -53,16 +98,17 @@ namespace mn::memory
 		{
 			Node* ptr = ((Node*)block.ptr) - 1;
 
-			mutex_lock(this->mtx);
-			if (ptr == this->head)
-				this->head = ptr->next;
+			auto& shard = this->shards[_leak_shard_index(ptr)];
+			_leak_shard_lock(shard);
+			if (ptr == shard.head)
+				shard.head = ptr->next;
 
 			if (ptr->prev)
 				ptr->prev->next = ptr->next;
 
 			if (ptr->next)
 				ptr->next->prev = ptr->prev;
-			mutex_unlock(this->mtx);
+			_leak_shard_unlock(shard);
 
 			_memory_profile_free(block.ptr, block.size);
 			::free(ptr);
@@ -73,43 +119,52 @@ namespace mn::memory
 	Leak::report(bool report_on_destruct_)
 	{
 		this->report_on_destruct = report_on_destruct_;
-		if (this->head == nullptr)
-			return;
 
 		size_t count = 0;
 		size_t size = 0;
-		auto it = head;
-		while (it)
+		for (auto& shard: this->shards)
 		{
-			::fprintf(stderr, "Leak size: %zu, call stack:\n", it->size);
-			#if DEBUG
-				callstack_print_to(it->callstack, Leak::CALLSTACK_MAX_FRAMES, file_stderr());
-			#else
-				::fprintf(stderr, "run in debug mode to get call stack info\n");
-			#endif
-
-			auto ptr = (char*)(it + 1);
-			size_t len = it->size > 128 ? 128 : it->size;
-
-			::fprintf(stderr, "content bytes[%zu]: {", len);
-			for (size_t i = 0; i < len; ++i)
+			_leak_shard_lock(shard);
+			auto it = shard.head;
+			while (it)
 			{
-				if (i + 1 < len)
-					::fprintf(stderr, "%#02x, ", ptr[i]);
-				else
-					::fprintf(stderr, "%#02x", ptr[i]);
+				::fprintf(stderr, "Leak size: %zu, call stack:\n", it->size);
+				#if DEBUG
+					if (it->callstack[0] != nullptr)
+						callstack_print_to(it->callstack, Leak::CALLSTACK_MAX_FRAMES, file_stderr());
+					else
+						::fprintf(stderr, "call stack was not sampled, set callstack_sample_rate to 1 to capture all call stacks\n");
+				#else
+					::fprintf(stderr, "run in debug mode to get call stack info\n");
+				#endif
+
+				auto ptr = (char*)(it + 1);
+				size_t len = it->size > 128 ? 128 : it->size;
+
+				::fprintf(stderr, "content bytes[%zu]: {", len);
+				for (size_t i = 0; i < len; ++i)
+				{
+					if (i + 1 < len)
+						::fprintf(stderr, "%#02x, ", ptr[i]);
+					else
+						::fprintf(stderr, "%#02x", ptr[i]);
+				}
+				::fprintf(stderr, "}\n");
+
+				::fprintf(stderr, "content string[%zu]: '", len);
+				for (size_t i = 0; i < len; ++i)
+					::fprintf(stderr, "%c", ptr[i]);
+				::fprintf(stderr, "'\n\n");
+
+				++count;
+				size += it->size;
+				it = it->next;
 			}
-			::fprintf(stderr, "}\n");
-
-			::fprintf(stderr, "content string[%zu]: '", len);
-			for (size_t i = 0; i < len; ++i)
-				::fprintf(stderr, "%c", ptr[i]);
-			::fprintf(stderr, "'\n\n");
-
-			++count;
-			size += it->size;
-			it = it->next;
+			_leak_shard_unlock(shard);
 		}
+
+		if (count == 0)
+			return;
 		::fprintf(stderr, "Leaks count: %zu, Leaks size(bytes): %zu\n", count, size);
 	}
 
@@ -11,6 +11,9 @@ namespace mn::memory
 		this->memory = meta->alloc(stack_size, alignof(uint8_t));
 		this->alloc_head = (uint8_t*)this->memory.ptr;
 		this->allocations_count = 0;
+		this->highwater_mem = 0;
+		this->total_allocations_count = 0;
+		this->total_allocations_size = 0;
 	}
 
 	Stack::~Stack()
@@ -29,6 +32,12 @@ namespace mn::memory
 		uint8_t* ptr = this->alloc_head;
 		this->alloc_head = ptr + size;
 		this->allocations_count++;
+		this->total_allocations_count++;
+		this->total_allocations_size += size;
+
+		size_t used_mem = this->alloc_head - (uint8_t*)this->memory.ptr;
+		if (used_mem > this->highwater_mem)
+			this->highwater_mem = used_mem;
 		return Block{ ptr, size };
 	}
 
@@ -47,4 +56,17 @@ namespace mn::memory
 		this->allocations_count = 0;
 		this->alloc_head = (uint8_t*)this->memory.ptr;
 	}
+
+	Stats
+	Stack::stats() const
+	{
+		Stats res{};
+		res.live_size = this->alloc_head - (uint8_t*)this->memory.ptr;
+		res.live_count = this->allocations_count;
+		res.peak_size = this->highwater_mem;
+		res.total_count = this->total_allocations_count;
+		res.total_size = this->total_allocations_size;
+		res.reserved_size = this->memory.size;
+		return res;
+	}
 }
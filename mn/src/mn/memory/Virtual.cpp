@@ -8,6 +8,8 @@ namespace mn::memory
 	Virtual::alloc(size_t size, uint8_t)
 	{
 		Block res = virtual_alloc(nullptr, size);
+		if (res.ptr)
+			atomic_stats.on_alloc(res.size);
 		_memory_profile_alloc(res.ptr, res.size);
 		return res;
 	}
@@ -15,10 +17,20 @@ namespace mn::memory
 	void
 	Virtual::free(Block block)
 	{
+		if (block.ptr)
+			atomic_stats.on_free(block.size);
 		_memory_profile_free(block.ptr, block.size);
 		virtual_free(block);
 	}
 
+	Stats
+	Virtual::stats() const
+	{
+		auto res = atomic_stats.load();
+		res.reserved_size = res.live_size;
+		return res;
+	}
+
 	Virtual*
 	virtual_mem()
 	{
@@ -2,10 +2,19 @@
 
 #include <mn/Memory.h>
 #include <mn/Buf.h>
+#include <mn/Small_Buf.h>
 #include <mn/Str.h>
+#include <mn/Small_Str.h>
 #include <mn/Map.h>
+#include <mn/Concurrent_Map.h>
+#include <mn/Concurrent_Ring.h>
+#include <mn/Frozen_Map.h>
+#include <mn/Filter.h>
+#include <mn/Ordered_Map.h>
 #include <mn/Pool.h>
 #include <mn/Memory_Stream.h>
+#include <mn/Memory_Profiler.h>
+#include <mn/Allocator_Registry.h>
 #include <mn/Virtual_Memory.h>
 #include <mn/IO.h>
 #include <mn/Str_Intern.h>
@@ -21,12 +30,19 @@
 #include <mn/Fabric.h>
 #include <mn/Block_Stream.h>
 #include <mn/Handle_Table.h>
+#include <mn/Concurrent_Handle_Table.h>
+#include <mn/Heap.h>
+#include <mn/Sort.h>
+#include <mn/Cache.h>
+#include <mn/Concurrent_Cache.h>
+#include <mn/Bitset.h>
 #include <mn/UUID.h>
 #include <mn/SIMD.h>
 #include <mn/Json.h>
 #include <mn/Regex.h>
 #include <mn/Log.h>
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <sstream>
@@ -140,6 +156,171 @@ TEST_CASE("buf pop")
 	mn::buf_free(arr);
 }
 
+TEST_CASE("small buf")
+{
+	auto buddy = mn::allocator_buddy_new(64 * 1024);
+
+	auto nums = mn::small_buf_with_allocator<int, 4>(buddy);
+	for (int i = 0; i < 4; ++i)
+		mn::buf_push(nums, i);
+	CHECK(mn::small_buf_is_inline(nums));
+	CHECK(buddy->stats().total_count == 0);
+
+	// spills to the allocator once it grows beyond the inline capacity
+	mn::buf_insert(nums, 0, -1);
+	CHECK(mn::small_buf_is_inline(nums) == false);
+	CHECK(buddy->stats().live_count == 1);
+	CHECK(nums.count == 5);
+	for (int i = 0; i < 5; ++i)
+		CHECK(nums[i] == i - 1);
+
+	mn::buf_remove_ordered(nums, 0);
+	auto copy = mn::clone(nums);
+	CHECK(copy.count == 4);
+	CHECK(mn::small_buf_is_inline(copy));
+	for (int i = 0; i < 4; ++i)
+		CHECK(copy[i] == i);
+	mn::small_buf_free(copy);
+
+	mn::small_buf_free(nums);
+	CHECK(buddy->stats().live_count == 0);
+	CHECK(mn::small_buf_is_inline(nums));
+
+	auto strs = mn::small_buf_with_allocator<mn::Str, 2>(buddy);
+	mn::buf_push(strs, mn::str_from_c("a", buddy));
+	mn::buf_push(strs, mn::str_from_c("b", buddy));
+	mn::buf_push(strs, mn::str_from_c("c", buddy));
+	size_t i = 0;
+	for (const auto& str: strs)
+		CHECK(str == strs[i++]);
+	destruct(strs);
+	CHECK(buddy->stats().live_count == 0);
+
+	mn::allocator_free(buddy);
+}
+
+TEST_CASE("small str")
+{
+	CHECK(sizeof(mn::Small_Str) == sizeof(mn::Str));
+
+	auto buddy = mn::allocator_buddy_new(64 * 1024);
+
+	auto str = mn::small_str_new(buddy);
+	CHECK(mn::small_str_count(str) == 0);
+	CHECK(mn::small_str_ptr(str)[0] == '\0');
+
+	// exactly the inline capacity without any allocation
+	mn::small_str_push(str, "Mostafa Saad");
+	mn::small_str_push(str, " Abdel-Ham");
+	CHECK(mn::small_str_count(str) == mn::SMALL_STR_INLINE_CAPACITY - 1);
+	mn::small_str_push(str, "e");
+	CHECK(mn::small_str_is_inline(str));
+	CHECK(mn::small_str_count(str) == mn::SMALL_STR_INLINE_CAPACITY);
+	CHECK(::strcmp(mn::small_str_ptr(str), "Mostafa Saad Abdel-Hame") == 0);
+	CHECK(buddy->stats().total_count == 0);
+
+	// spills into the allocator
+	mn::small_str_push(str, "ed");
+	CHECK(mn::small_str_is_inline(str) == false);
+	CHECK(str == "Mostafa Saad Abdel-Hameed");
+	CHECK(buddy->stats().live_count == 1);
+
+	str = mn::strf(str, " age: {}", 25);
+	CHECK(str == mn::str_lit("Mostafa Saad Abdel-Hameed age: 25"));
+	CHECK(mn::small_str_ptr(str)[mn::small_str_count(str)] == '\0');
+	CHECK(mn::Hash<mn::Small_Str>()(str) == mn::Hash<mn::Str>()(mn::str_lit("Mostafa Saad Abdel-Hameed age: 25")));
+
+	auto copy = mn::small_str_clone(str, buddy);
+	CHECK(copy == str);
+	mn::small_str_clear(str);
+	CHECK(mn::small_str_count(str) == 0);
+	CHECK(copy != str);
+	mn::small_str_free(copy);
+	mn::small_str_free(str);
+	CHECK(mn::small_str_is_inline(str));
+	CHECK(buddy->stats().live_count == 0);
+
+	auto total_count = buddy->stats().total_count;
+	auto map = mn::map_new<mn::Small_Str, int>();
+	for (int i = 0; i < 1000; ++i)
+		mn::map_insert(map, mn::small_strf(buddy, "key_{}", i), i);
+	CHECK(buddy->stats().total_count == total_count);
+
+	auto v = mn::map_lookup_as(map, "key_42");
+	REQUIRE(v != nullptr);
+	CHECK(v->value == 42);
+	v = mn::map_lookup_as(map, mn::str_lit("key_999"));
+	REQUIRE(v != nullptr);
+	CHECK(v->value == 999);
+	CHECK(fmt::format("{}", v->key) == "key_999");
+	CHECK(mn::map_lookup_as(map, mn::str_view("key_1000")) == nullptr);
+	mn::destruct(map);
+
+	mn::allocator_free(buddy);
+}
+
+TEST_CASE("str view")
+{
+	auto content = mn::str_lit("  key_1 = 10\nkey_2 = 20\n\n  key_3=30 \n");
+	auto view = mn::str_view(content);
+
+	CHECK(mn::str_view_find(view, "key") == 2);
+	CHECK(mn::str_view_find(view, "key", 3) == 13);
+	CHECK(mn::str_view_find(view, "key_4") == size_t(-1));
+	CHECK(mn::str_view_find(view, '=') == 8);
+	CHECK(mn::str_view_find_last(view, "key") == 27);
+	CHECK(mn::str_view_prefix(view, "  key_1"));
+	CHECK(mn::str_view_suffix(view, "=30 \n"));
+	CHECK(mn::str_view_prefix(view, "key_1") == false);
+	CHECK(mn::str_view_sub(view, 2, 5) == "key_1");
+	CHECK(mn::str_view_sub(view, view.count).count == 0);
+	CHECK(mn::str_view_trim(view) == "key_1 = 10\nkey_2 = 20\n\n  key_3=30");
+	CHECK(mn::str_view_trim_left(mn::str_view("xxabcx"), mn::str_view("x")) == "abcx");
+	CHECK(mn::str_view_trim_right(mn::str_view("xxabcx"), mn::str_view("x")) == "xxabc");
+	CHECK(mn::str_view_trim(mn::str_view("   ")).count == 0);
+	CHECK(mn::str_view("abc") < mn::str_view("abd"));
+	CHECK(mn::str_view("ab") < mn::str_view("abc"));
+	CHECK(mn::str_view_cmp(mn::str_view("abc"), mn::str_view("abc")) == 0);
+
+	auto map = mn::map_new<mn::Str, int>();
+	mn::map_insert(map, mn::str_from_c("key_1"), 0);
+	mn::map_insert(map, mn::str_from_c("key_2"), 0);
+	mn::map_insert(map, mn::str_from_c("key_3"), 0);
+
+	size_t lines_count = 0;
+	for (auto line: mn::str_split_iter(view, "\n", true))
+	{
+		++lines_count;
+		auto eq = mn::str_view_find(line, '=');
+		REQUIRE(eq != size_t(-1));
+		auto key = mn::str_view_trim(mn::str_view_sub(line, 0, eq));
+		auto value = mn::str_view_trim(mn::str_view_sub(line, eq + 1));
+		auto it = mn::map_lookup_as(map, key);
+		REQUIRE(it != nullptr);
+		it->value = ::atoi(mn::str_tmpf("{}", value).ptr);
+	}
+	CHECK(lines_count == 3);
+	CHECK(mn::map_lookup(map, mn::str_lit("key_1"))->value == 10);
+	CHECK(mn::map_lookup(map, mn::str_lit("key_2"))->value == 20);
+	CHECK(mn::map_lookup(map, mn::str_lit("key_3"))->value == 30);
+	mn::destruct(map);
+
+	// same pieces as str_split
+	const char* inputs[] = {"", ",", "a,b,", ",a,,b", "a||b||", "abc"};
+	const char* delims[] = {",", ",", ",", ",", "||", ","};
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); ++i)
+	{
+		for (auto skip_empty: {false, true})
+		{
+			auto expected = mn::str_split(inputs[i], delims[i], skip_empty);
+			auto views = mn::str_view_split(mn::str_view(inputs[i]), delims[i], skip_empty);
+			REQUIRE(views.count == expected.count);
+			for (size_t j = 0; j < views.count; ++j)
+				CHECK(views[j] == expected[j]);
+		}
+	}
+}
+
 TEST_CASE("str push")
 {
 	auto str = mn::str_new();
@@ -421,6 +602,582 @@ TEST_CASE("map general cases")
 	mn::map_free(num);
 }
 
+TEST_CASE("map many keys")
+{
+	// keys with the same lower bits stress the hash mixing and the group probing
+	auto num = mn::map_new<size_t, size_t>();
+	for (size_t i = 0; i < 10000; ++i)
+		mn::map_insert(num, i << 20, i);
+	CHECK(num.count == 10000);
+
+	for (size_t i = 0; i < 10000; i += 3)
+		CHECK(mn::map_remove(num, i << 20));
+
+	for (size_t i = 0; i < 10000; ++i)
+	{
+		auto it = mn::map_lookup(num, i << 20);
+		if (i % 3 == 0)
+		{
+			CHECK(it == nullptr);
+		}
+		else
+		{
+			CHECK(it != nullptr);
+			if (it)
+				CHECK(it->value == i);
+		}
+	}
+
+	size_t sum = 0;
+	for (const auto& [key, value]: num)
+		sum += value;
+	size_t expected_sum = 0;
+	for (size_t i = 0; i < 10000; ++i)
+		if (i % 3 != 0)
+			expected_sum += i;
+	CHECK(sum == expected_sum);
+
+	mn::map_clear(num);
+	CHECK(mn::map_lookup(num, size_t(1) << 20) == nullptr);
+	mn::map_insert(num, size_t(1) << 20, size_t(1));
+	CHECK(mn::map_lookup(num, size_t(1) << 20)->value == 1);
+
+	mn::map_free(num);
+}
+
+TEST_CASE("map bulk build")
+{
+	constexpr int COUNT = 100000;
+
+	SUBCASE("reserve")
+	{
+		auto m = mn::map_new<int, int>();
+		mn_defer(mn::map_free(m));
+		mn::map_reserve(m, COUNT);
+		auto cap = mn::map_capacity(m);
+		auto ctrl = m._ctrl.ptr;
+		for (int i = 0; i < COUNT; ++i)
+			mn::map_insert(m, i, i);
+		// no rehash happened while inserting
+		CHECK(mn::map_capacity(m) == cap);
+		CHECK(m._ctrl.ptr == ctrl);
+		// reserving what's already reserved is a no-op
+		mn::map_reserve(m, 1);
+		CHECK(m._ctrl.ptr == ctrl);
+	}
+
+	SUBCASE("from buf")
+	{
+		auto f = mn::fabric_new({});
+		mn_defer(mn::fabric_free(f));
+
+		for (auto fabric: {mn::Fabric{nullptr}, f})
+		{
+			auto items = mn::buf_with_capacity<mn::Key_Value<int, int>>(COUNT + COUNT / 10);
+			for (int i = 0; i < COUNT; ++i)
+				mn::buf_push(items, mn::Key_Value<int, int>{i * 7, i});
+			// duplicates replace the earlier values
+			for (int i = 0; i < COUNT / 10; ++i)
+				mn::buf_push(items, mn::Key_Value<int, int>{i * 70, -i});
+
+			auto m = mn::map_from_buf(items, fabric);
+			mn_defer(mn::map_free(m));
+			CHECK(items.ptr == nullptr);
+			CHECK(m.count == COUNT);
+			CHECK(m.values.count == COUNT);
+
+			bool all_found = true;
+			for (int i = 0; i < COUNT; ++i)
+			{
+				auto it = mn::map_lookup(m, i * 7);
+				auto expected = i % 10 == 0 ? -i / 10 : i;
+				if (it == nullptr || it->value != expected)
+					all_found = false;
+			}
+			CHECK(all_found);
+			CHECK(mn::map_lookup(m, 1) == nullptr);
+
+			// the map is usable after the bulk build
+			mn::map_insert(m, 1, 1);
+			CHECK(mn::map_remove(m, 7));
+			CHECK(mn::map_lookup(m, 7) == nullptr);
+			CHECK(mn::map_lookup(m, 14)->value == 2);
+			CHECK(m.count == COUNT);
+		}
+	}
+
+	SUBCASE("set from buf")
+	{
+		auto values = mn::buf_new<mn::Str>();
+		for (int i = 0; i < 1000; ++i)
+			mn::buf_push(values, mn::strf("value_{}", i));
+
+		auto s = mn::set_from_buf(values);
+		mn_defer(mn::destruct(s));
+		CHECK(s.count == 1000);
+		CHECK(mn::set_lookup_as(s, "value_999") != nullptr);
+		CHECK(mn::set_lookup_as(s, "value_1000") == nullptr);
+	}
+}
+
+TEST_CASE("map benchmark")
+{
+	auto keys = mn::buf_new<uint64_t>();
+	uint64_t x = 88172645463325252ULL;
+	for (size_t i = 0; i < 100000; ++i)
+	{
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		mn::buf_push(keys, x);
+	}
+
+	auto table = mn::map_new<uint64_t, uint64_t>();
+	ankerl::nanobench::Bench().minEpochIterations(10).run("map insert", [&]{
+		mn::map_clear(table);
+		for (auto key: keys)
+			mn::map_insert(table, key, key);
+	});
+
+	ankerl::nanobench::Bench().minEpochIterations(10).run("map lookup hit", [&]{
+		uint64_t sum = 0;
+		for (auto key: keys)
+			sum += mn::map_lookup(table, key)->value;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	ankerl::nanobench::Bench().minEpochIterations(10).run("map lookup miss", [&]{
+		size_t misses = 0;
+		for (auto key: keys)
+			misses += mn::map_lookup(table, key + 1) == nullptr;
+		ankerl::nanobench::doNotOptimizeAway(misses);
+	});
+
+	ankerl::nanobench::Bench().minEpochIterations(10).run("map remove", [&]{
+		auto copy = mn::map_memcpy_clone(table);
+		for (auto key: keys)
+			mn::map_remove(copy, key);
+		mn::map_free(copy);
+	});
+
+	mn::map_free(table);
+	mn::buf_free(keys);
+}
+
+TEST_CASE("hash bytes")
+{
+	// every length up to a few lanes must hash all of its bytes
+	char data[200] = {};
+	for (size_t len = 0; len < sizeof(data); ++len)
+	{
+		auto h = mn::hash_bytes(data, len);
+		CHECK(h == mn::hash_bytes(data, len));
+		CHECK(h != mn::hash_bytes(data, len, 1));
+		for (size_t i = 0; i < len; ++i)
+		{
+			data[i] = 1;
+			CHECK(h != mn::hash_bytes(data, len));
+			data[i] = 0;
+		}
+	}
+
+	CHECK(mn::hash_seed() == mn::hash_seed());
+	CHECK(mn::Str_Seeded_Hash()(mn::str_view("name")) == mn::Str_Seeded_Hash()("name"));
+
+	auto seeded = mn::map_new<mn::Str, int, mn::Str_Seeded_Hash>();
+	mn::map_insert(seeded, mn::str_lit("name"), 1);
+	CHECK(mn::map_lookup_as(seeded, "name")->value == 1);
+	mn::map_free(seeded);
+
+	auto names = mn::map_new<mn::Str_Hashed, int>();
+	auto name = mn::str_hashed(mn::str_from_c("name"));
+	CHECK(name.hash == mn::Hash<mn::Str>()(name.str));
+	mn::map_insert(names, name, 1);
+	CHECK(mn::map_lookup(names, name)->value == 1);
+	CHECK(mn::map_lookup_as(names, mn::str_view("name"))->value == 1);
+	CHECK(mn::map_lookup_as(names, "other") == nullptr);
+	destruct(names);
+}
+
+TEST_CASE("frozen map")
+{
+	auto map = mn::map_new<mn::Str, size_t>();
+	mn_defer(destruct(map));
+	for (size_t i = 0; i < 10000; ++i)
+		mn::map_insert(map, mn::strf("key_{}", i), i);
+
+	auto [frozen, build_err] = mn::frozen_map_build(map);
+	CHECK(!build_err);
+	CHECK(mn::frozen_map_count(frozen) == 10000);
+	for (size_t i = 0; i < 10000; ++i)
+	{
+		auto value = mn::frozen_map_lookup(frozen, mn::str_tmpf("key_{}", i));
+		CHECK((value && *value == i));
+	}
+	CHECK(mn::frozen_map_lookup(frozen, "key_10000") == nullptr);
+	CHECK(mn::frozen_map_lookup(frozen, "") == nullptr);
+
+	auto folder = mn::folder_tmp(mn::memory::tmp());
+	auto filename = mn::file_tmp(folder, "frozen", mn::memory::tmp());
+	auto file = mn::file_open(filename, mn::IO_MODE_WRITE, mn::OPEN_MODE_CREATE_OVERWRITE);
+	CHECK(mn::frozen_map_write(frozen, file));
+	mn::file_close(file);
+	mn::frozen_map_free(frozen);
+
+	auto [loaded, err] = mn::frozen_map_load<size_t>(filename);
+	CHECK(!err);
+	CHECK(mn::frozen_map_count(loaded) == 10000);
+	for (size_t i = 0; i < mn::frozen_map_count(loaded); ++i)
+	{
+		auto key = mn::frozen_map_key(loaded, i);
+		auto value = mn::frozen_map_lookup(loaded, key);
+		CHECK((value && *value == mn::map_lookup_as(map, key)->value));
+	}
+	mn::frozen_map_free(loaded);
+
+	auto [wrong, wrong_err] = mn::frozen_map_load<uint32_t>(filename);
+	CHECK(wrong_err);
+	mn::file_remove(filename);
+
+	auto empty_map = mn::map_new<mn::Str, int>();
+	auto [empty, empty_err] = mn::frozen_map_build(empty_map);
+	CHECK(!empty_err);
+	CHECK(mn::frozen_map_count(empty) == 0);
+	CHECK(mn::frozen_map_lookup(empty, "key") == nullptr);
+	mn::frozen_map_free(empty);
+	mn::map_free(empty_map);
+
+	// duplicate keys fail instead of searching for a seed forever
+	mn::Str_View keys[] = {mn::str_view("a"), mn::str_view("b"), mn::str_view("a")};
+	int values[] = {1, 2, 3};
+	auto [duplicate, duplicate_err] = mn::_frozen_map_build(keys, values, 3, sizeof(int), mn::allocator_top());
+	CHECK(duplicate_err);
+
+	// a slot which points outside of the keys section fails the validation
+	auto [blob, blob_err] = mn::_frozen_map_build(keys, values, 2, sizeof(int), mn::allocator_top());
+	CHECK(!blob_err);
+	CHECK(!mn::frozen_map_from_block<int>(blob).err);
+	auto header = (const mn::Frozen_Map_Header*)blob.ptr;
+	auto slots = (mn::Frozen_Map_Slot*)((char*)blob.ptr + header->slots_offset);
+	auto key_count = slots[1].key_count;
+	slots[1].key_count = header->size;
+	CHECK(mn::frozen_map_from_block<int>(blob).err);
+	slots[1].key_count = key_count;
+	CHECK(!mn::frozen_map_from_block<int>(blob).err);
+
+	// an offset which wraps around when the section size is added to it fails the validation
+	auto mutable_header = (mn::Frozen_Map_Header*)blob.ptr;
+	auto pilots_offset = mutable_header->pilots_offset;
+	mutable_header->pilots_offset = UINT64_MAX - 3;
+	CHECK(mn::frozen_map_from_block<int>(blob).err);
+	mutable_header->pilots_offset = pilots_offset;
+	auto values_offset = mutable_header->values_offset;
+	mutable_header->values_offset = UINT64_MAX - 7;
+	CHECK(mn::frozen_map_from_block<int>(blob).err);
+	mutable_header->values_offset = values_offset;
+	CHECK(!mn::frozen_map_from_block<int>(blob).err);
+	mn::free(blob);
+}
+
+TEST_CASE("bloom filter")
+{
+	constexpr size_t COUNT = 10000;
+	auto filter = mn::bloom_filter_new(COUNT, 0.01);
+	for (size_t i = 0; i < COUNT; ++i)
+		mn::bloom_filter_insert(filter, mn::str_tmpf("key_{}", i));
+	CHECK(mn::bloom_filter_count(filter) == COUNT);
+
+	size_t false_negatives = 0;
+	for (size_t i = 0; i < COUNT; ++i)
+		if (mn::bloom_filter_contains(filter, mn::str_view(mn::str_tmpf("key_{}", i))) == false)
+			++false_negatives;
+	CHECK(false_negatives == 0);
+
+	size_t false_positives = 0;
+	for (size_t i = COUNT; i < COUNT * 11; ++i)
+		if (mn::bloom_filter_contains(filter, mn::str_tmpf("key_{}", i)))
+			++false_positives;
+	// 1% of 100000 probes with some slack
+	CHECK(false_positives < 1500);
+
+	auto folder = mn::folder_tmp(mn::memory::tmp());
+	auto filename = mn::file_tmp(folder, "bloom", mn::memory::tmp());
+	auto file = mn::file_open(filename, mn::IO_MODE_WRITE, mn::OPEN_MODE_CREATE_OVERWRITE);
+	CHECK(mn::bloom_filter_write(filter, file));
+	mn::file_close(file);
+
+	auto [loaded, err] = mn::bloom_filter_load(filename);
+	CHECK(!err);
+	CHECK(mn::bloom_filter_count(loaded) == COUNT);
+	bool same = true;
+	for (size_t i = 0; i < COUNT * 2; ++i)
+	{
+		auto key = mn::str_tmpf("key_{}", i);
+		if (mn::bloom_filter_contains(loaded, key) != mn::bloom_filter_contains(filter, key))
+			same = false;
+	}
+	CHECK(same);
+	mn::bloom_filter_free(loaded);
+
+	auto [wrong, wrong_err] = mn::cuckoo_filter_load(filename);
+	CHECK(wrong_err);
+	mn::file_remove(filename);
+
+	mn::bloom_filter_clear(filter);
+	CHECK(mn::bloom_filter_contains(filter, 42) == false);
+	mn::bloom_filter_insert(filter, 42);
+	CHECK(mn::bloom_filter_contains(filter, 42));
+	mn::bloom_filter_free(filter);
+}
+
+TEST_CASE("cuckoo filter")
+{
+	constexpr int COUNT = 10000;
+	auto filter = mn::cuckoo_filter_new(COUNT);
+	mn_defer(mn::cuckoo_filter_free(filter));
+
+	bool all_inserted = true;
+	for (int i = 0; i < COUNT; ++i)
+		if (mn::cuckoo_filter_insert(filter, i) == false)
+			all_inserted = false;
+	CHECK(all_inserted);
+	CHECK(mn::cuckoo_filter_count(filter) == COUNT);
+
+	size_t false_negatives = 0;
+	for (int i = 0; i < COUNT; ++i)
+		if (mn::cuckoo_filter_contains(filter, i) == false)
+			++false_negatives;
+	CHECK(false_negatives == 0);
+
+	size_t false_positives = 0;
+	for (int i = COUNT; i < COUNT * 11; ++i)
+		if (mn::cuckoo_filter_contains(filter, i))
+			++false_positives;
+	CHECK(false_positives < 100);
+
+	// remove the even keys
+	bool all_removed = true;
+	for (int i = 0; i < COUNT; i += 2)
+		if (mn::cuckoo_filter_remove(filter, i) == false)
+			all_removed = false;
+	CHECK(all_removed);
+	CHECK(mn::cuckoo_filter_count(filter) == COUNT / 2);
+	size_t removed_found = 0;
+	false_negatives = 0;
+	for (int i = 0; i < COUNT; ++i)
+	{
+		auto found = mn::cuckoo_filter_contains(filter, i);
+		if (i % 2 == 0 && found)
+			++removed_found;
+		else if (i % 2 == 1 && found == false)
+			++false_negatives;
+	}
+	CHECK(false_negatives == 0);
+	CHECK(removed_found < 10);
+
+	// serialize into a memory stream and view the blob in place
+	auto stream = mn::memory_stream_new();
+	CHECK(mn::cuckoo_filter_write(filter, stream));
+	auto [view, err] = mn::cuckoo_filter_from_block(mn::Block{(void*)mn::memory_stream_ptr(stream), size_t(mn::memory_stream_size(stream))});
+	CHECK(!err);
+	CHECK(mn::cuckoo_filter_count(view) == COUNT / 2);
+	CHECK(mn::cuckoo_filter_contains(view, 1));
+	mn::memory_stream_free(stream);
+
+	// fill it until it's full, no inserted key is ever lost
+	int inserted_count = 0;
+	for (int i = COUNT; ; ++i)
+	{
+		if (mn::cuckoo_filter_insert(filter, i) == false)
+			break;
+		++inserted_count;
+	}
+	CHECK(mn::cuckoo_filter_count(filter) > COUNT);
+	false_negatives = 0;
+	for (int i = COUNT; i < COUNT + inserted_count; ++i)
+		if (mn::cuckoo_filter_contains(filter, i) == false)
+			++false_negatives;
+	CHECK(false_negatives == 0);
+
+	// removing a key makes room again
+	CHECK(mn::cuckoo_filter_remove(filter, 1));
+	CHECK(mn::cuckoo_filter_insert(filter, 1));
+}
+
+template<typename T>
+inline static size_t
+_ordered_node_check(const mn::Ordered_Node<T>* node, bool is_root, size_t& count)
+{
+	// returns the height of the subtree and checks the b-tree invariants
+	if (is_root == false)
+		CHECK(node->count >= mn::Ordered_Node<T>::MIN_COUNT);
+	CHECK(node->count <= mn::Ordered_Node<T>::CAPACITY);
+	count += node->count;
+	if (node->is_leaf)
+		return 1;
+
+	auto children = ((const mn::Ordered_Internal_Node<T>*)node)->children;
+	size_t height = 0;
+	for (size_t i = 0; i <= node->count; ++i)
+	{
+		CHECK(children[i]->parent == node);
+		CHECK(children[i]->position == i);
+		auto child_height = _ordered_node_check(children[i], false, count);
+		if (i == 0)
+			height = child_height;
+		CHECK(child_height == height);
+	}
+	return height + 1;
+}
+
+TEST_CASE("ordered set")
+{
+	auto set = mn::ordered_set_new<int>();
+	auto reference = mn::set_new<int>();
+
+	uint32_t random = 1;
+	for (size_t i = 0; i < 50000; ++i)
+	{
+		random = random * 1664525 + 1013904223;
+		int value = int((random >> 8) % 5000);
+		if ((random >> 4) % 3 == 0)
+			CHECK(mn::ordered_set_remove(set, value) == mn::set_remove(reference, value));
+		else
+			mn::set_insert(reference, *mn::ordered_set_insert(set, value));
+	}
+
+	CHECK(set.count == reference.count);
+	size_t count = 0;
+	if (set.root)
+		_ordered_node_check(set.root, true, count);
+	CHECK(count == set.count);
+
+	int prev = -1;
+	size_t visited = 0;
+	for (auto value: set)
+	{
+		CHECK(prev < value);
+		CHECK(mn::set_lookup(reference, value) != nullptr);
+		prev = value;
+		++visited;
+	}
+	CHECK(visited == reference.count);
+
+	for (int value = 0; value < 5000; ++value)
+	{
+		auto it = mn::ordered_set_lower_bound(set, value);
+		if (mn::set_lookup(reference, value))
+		{
+			CHECK(*it == value);
+			CHECK(*mn::ordered_set_lookup(set, value) == value);
+		}
+		else
+		{
+			CHECK(mn::ordered_set_lookup(set, value) == nullptr);
+		}
+		auto upper = mn::ordered_set_upper_bound(set, value);
+		if (upper != mn::ordered_set_end(set))
+			CHECK(*upper > value);
+	}
+
+	mn::ordered_set_free(set);
+	mn::set_free(reference);
+}
+
+TEST_CASE("ordered map")
+{
+	// big values make small nodes which exercises the deeper trees
+	struct Payload
+	{
+		int id;
+		char data[120];
+	};
+
+	auto items = mn::buf_new<mn::Key_Value<int, Payload>>();
+	for (int i = 0; i < 1000; ++i)
+		mn::buf_push(items, mn::Key_Value<int, Payload>{i * 2, Payload{i, {}}});
+
+	auto map = mn::ordered_map_from_sorted(items);
+	mn::buf_free(items);
+	CHECK(map.count == 1000);
+	size_t count = 0;
+	_ordered_node_check(map.root, true, count);
+	CHECK(count == 1000);
+
+	for (int i = 0; i < 1000; ++i)
+		mn::ordered_map_insert(map, i * 2 + 1, Payload{-i, {}});
+	for (int i = 0; i < 2000; i += 3)
+		CHECK(mn::ordered_map_remove(map, i));
+	CHECK(mn::ordered_map_remove(map, 3) == false);
+	count = 0;
+	_ordered_node_check(map.root, true, count);
+	CHECK(count == map.count);
+
+	// range iteration over the keys [100, 200]
+	int expected = 100;
+	for (auto it = mn::ordered_map_lower_bound(map, 100); it != mn::ordered_map_upper_bound(map, 200); ++it)
+	{
+		if (expected % 3 == 0)
+			++expected;
+		CHECK(it->key == expected);
+		CHECK(it->value.id == (expected % 2 == 0 ? expected / 2 : -(expected / 2)));
+		++expected;
+	}
+	CHECK(expected == 201);
+
+	mn::ordered_map_lookup(map, 4)->value.id = 42;
+	CHECK(mn::ordered_map_lookup(map, 4)->value.id == 42);
+	CHECK(mn::ordered_map_lookup(map, 6) == nullptr);
+
+	// remove everything in order to shrink the tree down to nothing
+	for (int i = 0; i < 2000; ++i)
+		mn::ordered_map_remove(map, i);
+	CHECK(map.count == 0);
+	CHECK(map.root == nullptr);
+	mn::ordered_map_free(map);
+
+	auto names = mn::ordered_map_new<mn::Str, int>();
+	mn::ordered_map_insert(names, mn::str_lit("b"), 2);
+	mn::ordered_map_insert(names, mn::str_lit("a"), 1);
+	CHECK(mn::ordered_map_lookup(names, "a")->value == 1);
+	CHECK(mn::ordered_map_begin(names)->key == "a");
+	mn::ordered_map_free(names);
+}
+
+TEST_CASE("map heterogeneous lookup")
+{
+	auto table = mn::map_new<mn::Str, int>();
+	mn::map_insert(table, mn::str_from_c("hello"), 1);
+	mn::map_insert(table, mn::str_from_c("world"), 2);
+
+	const char* text = "hello world";
+	CHECK(mn::map_lookup_as(table, "hello")->value == 1);
+	CHECK(mn::map_lookup_as(table, mn::str_view(text, text + 5))->value == 1);
+	CHECK(mn::map_lookup_as(table, mn::str_view(text + 6, text + 11))->value == 2);
+	CHECK(mn::map_lookup_as(table, mn::str_view(text, text + 4)) == nullptr);
+	CHECK(mn::map_lookup_as(table, "hello world") == nullptr);
+
+	size_t make_calls = 0;
+	auto make_key = [&](mn::Str_View v) { ++make_calls; return mn::str_from_view(v); };
+	auto it = mn::map_insert_if_absent(table, mn::str_view(text, text + 5), make_key);
+	CHECK(it->value == 1);
+	CHECK(make_calls == 0);
+	it = mn::map_insert_if_absent(table, mn::str_view(text + 2, text + 5), make_key);
+	CHECK(it->key == "llo");
+	CHECK(it->value == 0);
+	CHECK(make_calls == 1);
+	CHECK(table.count == 3);
+	CHECK(mn::map_lookup(table, mn::str_lit("llo")) == it);
+
+	mn::destruct(table);
+
+	auto strings = mn::set_new<mn::Str>();
+	mn::set_insert(strings, mn::str_from_c("abc"));
+	CHECK(mn::set_lookup_as(strings, "abc") != nullptr);
+	const char* abcd = "abcd";
+	CHECK(mn::set_lookup_as(strings, mn::str_view(abcd, abcd + 3)) != nullptr);
+	CHECK(mn::set_lookup_as(strings, "ab") == nullptr);
+	mn::destruct(strings);
+}
+
 TEST_CASE("Pool general case")
 {
 	auto pool = mn::pool_new(sizeof(int), 1024);
@@ -461,6 +1218,65 @@ TEST_CASE("Memory_Stream general case")
 	mn::memory_stream_free(mem);
 }
 
+TEST_CASE("Memory_Stream chunked")
+{
+	auto mem = mn::memory_stream_chunked_new(16);
+	CHECK(mn::memory_stream_is_chunked(mem));
+	for (int i = 0; i < 10; ++i)
+		mn::memory_stream_write(mem, mn::block_lit("Mostafa"));
+	CHECK(mn::memory_stream_size(mem) == 70);
+	CHECK(mn::memory_stream_capacity(mem) == 80);
+
+	mn::memory_stream_cursor_set(mem, 14);
+	char name[8] = { 0 };
+	CHECK(mn::memory_stream_read(mem, mn::Block{name, 7}) == 7);
+	CHECK(::strcmp(name, "Mostafa") == 0);
+
+	// a span crossing chunks is viewed as multiple blocks
+	mn::memory_stream_cursor_set(mem, 10);
+	auto blocks = mn::memory_stream_blocks_ahead(mem, 30);
+	CHECK(blocks.count == 3);
+	CHECK(blocks[0].size == 6);
+	CHECK(blocks[1].size == 16);
+	CHECK(blocks[2].size == 8);
+	CHECK(mn::memory_stream_block_ahead(mem, 0).size == 6);
+
+	auto out = mn::memory_stream_new();
+	mn::memory_stream_cursor_to_start(mem);
+	CHECK(mn::memory_stream_pipe_to(mem, out) == 70);
+	CHECK(mn::memory_stream_eof(mem));
+	auto expected = mn::str_lit("MostafaMostafaMostafaMostafaMostafaMostafaMostafaMostafaMostafaMostafa");
+	auto out_str = mn::memory_stream_str(out);
+	CHECK(out_str == expected);
+	mn::str_free(out_str);
+
+	// pipe from another stream into the chunks
+	mn::memory_stream_write(out, mn::Block{expected.ptr, expected.count});
+	mn::memory_stream_cursor_to_start(out);
+	mn::memory_stream_clear(mem);
+	CHECK(mn::memory_stream_size(mem) == 0);
+	CHECK(mn::memory_stream_capacity(mem) == 80);
+	CHECK(mn::memory_stream_pipe(mem, out, 100) == 70);
+	CHECK(mn::memory_stream_size(mem) == 70);
+
+	auto folder = mn::folder_tmp(mn::memory::tmp());
+	auto filename = mn::file_tmp(folder, "chunked", mn::memory::tmp());
+	auto file = mn::file_open(filename, mn::IO_MODE_WRITE, mn::OPEN_MODE_CREATE_OVERWRITE);
+	mn::memory_stream_cursor_to_start(mem);
+	CHECK(mn::memory_stream_pipe_to(mem, file) == 70);
+	mn::file_close(file);
+	CHECK(mn::file_content_str(filename, mn::memory::tmp()) == expected);
+	mn::file_remove(filename);
+
+	auto str = mn::memory_stream_str(mem);
+	CHECK(str == expected);
+	CHECK(mn::memory_stream_size(mem) == 0);
+
+	mn::str_free(str);
+	mn::memory_stream_free(out);
+	mn::memory_stream_free(mem);
+}
+
 TEST_CASE("virtual memory allocation")
 {
 	size_t size = 1ULL * 1024ULL * 1024ULL * 1024ULL;
@@ -548,6 +1364,62 @@ TEST_CASE("Str_Intern general case")
 	mn::str_intern_free(intern);
 }
 
+TEST_CASE("concurrent str intern")
+{
+	constexpr size_t WORKGROUPS_COUNT = 16;
+	constexpr size_t SYMBOLS_COUNT = 5000;
+
+	auto intern = mn::concurrent_str_intern_new(mn::memory::clib());
+	CHECK(mn::concurrent_str_intern_lookup(intern, "sym_0") == mn::STR_INTERN_INVALID_ID);
+
+	auto ids = mn::buf_with_allocator<uint32_t>(mn::memory::clib());
+	mn::buf_resize_fill(ids, WORKGROUPS_COUNT * SYMBOLS_COUNT, mn::STR_INTERN_INVALID_ID);
+
+	auto f = mn::fabric_new({});
+	mn::compute(f, {WORKGROUPS_COUNT, 1, 1}, {1, 1, 1}, [&](mn::Compute_Args args) {
+		auto id = args.workgroup_id.x;
+		// each workgroup interns all the symbols starting from a different offset
+		for (size_t j = 0; j < SYMBOLS_COUNT; ++j)
+		{
+			auto i = (j + id * 997) % SYMBOLS_COUNT;
+			char name[32];
+			::snprintf(name, sizeof(name), "sym_%zu", i);
+			ids[id * SYMBOLS_COUNT + i] = mn::concurrent_str_intern(intern, name);
+		}
+	});
+	mn::fabric_free(f);
+
+	REQUIRE(mn::concurrent_str_intern_count(intern) == SYMBOLS_COUNT);
+	auto seen = mn::buf_with_allocator<bool>(mn::memory::clib());
+	mn::buf_resize_fill(seen, SYMBOLS_COUNT, false);
+	for (size_t i = 0; i < SYMBOLS_COUNT; ++i)
+	{
+		auto symbol = ids[i];
+		REQUIRE(symbol < SYMBOLS_COUNT);
+		CHECK(seen[symbol] == false);
+		seen[symbol] = true;
+		for (size_t id = 1; id < WORKGROUPS_COUNT; ++id)
+			CHECK(ids[id * SYMBOLS_COUNT + i] == symbol);
+
+		char name[32];
+		::snprintf(name, sizeof(name), "sym_%zu", i);
+		auto str = mn::concurrent_str_intern_str(intern, symbol);
+		CHECK(str == name);
+		CHECK(str.ptr[str.count] == '\0');
+		CHECK(mn::concurrent_str_intern_lookup(intern, name) == symbol);
+	}
+
+	CHECK(mn::concurrent_str_intern_lookup(intern, "sym_5000") == mn::STR_INTERN_INVALID_ID);
+	auto empty = mn::concurrent_str_intern(intern, "");
+	CHECK(empty == SYMBOLS_COUNT);
+	CHECK(mn::concurrent_str_intern(intern, mn::str_lit("")) == empty);
+	CHECK(mn::concurrent_str_intern_str(intern, empty).count == 0);
+
+	mn::buf_free(seen);
+	mn::buf_free(ids);
+	mn::concurrent_str_intern_free(intern);
+}
+
 TEST_CASE("simple data ring case")
 {
 	mn::allocator_push(mn::memory::leak());
@@ -610,6 +1482,118 @@ TEST_CASE("complex data ring case")
 	mn::allocator_pop();
 }
 
+TEST_CASE("spsc ring")
+{
+	constexpr uint64_t VALUES_COUNT = 100000;
+
+	auto ring = mn::spsc_ring_new<uint64_t>(100, mn::memory::clib());
+	CHECK(mn::spsc_ring_capacity(ring) == 128);
+
+	uint64_t value = 0;
+	CHECK(mn::spsc_ring_pop(ring, value) == false);
+	for (uint64_t i = 0; i < 128; ++i)
+		CHECK(mn::spsc_ring_push(ring, i));
+	CHECK(mn::spsc_ring_push(ring, uint64_t(128)) == false);
+	CHECK(mn::spsc_ring_count(ring) == 128);
+	uint64_t values[200];
+	CHECK(mn::spsc_ring_pop_many(ring, values, 200) == 128);
+	CHECK(values[127] == 127);
+
+	auto producer = mn::thread_new([](void* arg) {
+		auto ring = (mn::SPSC_Ring<uint64_t>)arg;
+		uint64_t batch[7];
+		for (uint64_t i = 0; i < VALUES_COUNT;)
+		{
+			size_t count = 0;
+			for (; count < 7 && i + count < VALUES_COUNT; ++count)
+				batch[count] = i + count;
+			size_t pushed = 0;
+			while (pushed < count)
+				pushed += mn::spsc_ring_push_many(ring, batch + pushed, count - pushed);
+			i += count;
+		}
+	}, ring, "spsc ring producer");
+
+	uint64_t expected = 0;
+	bool in_order = true;
+	while (expected < VALUES_COUNT)
+	{
+		auto count = mn::spsc_ring_pop_many_wait(ring, values, 200);
+		for (size_t i = 0; i < count; ++i)
+			in_order &= values[i] == expected++;
+	}
+	CHECK(in_order);
+	CHECK(expected == VALUES_COUNT);
+
+	mn::thread_join(producer);
+	mn::thread_free(producer);
+	mn::spsc_ring_free(ring);
+}
+
+TEST_CASE("mpsc ring")
+{
+	constexpr uint64_t PRODUCERS_COUNT = 4;
+	constexpr uint64_t VALUES_COUNT = 50000;
+
+	auto ring = mn::mpsc_ring_new<uint64_t>(256, mn::memory::clib());
+
+	struct Producer_Args
+	{
+		mn::MPSC_Ring<uint64_t> ring;
+		uint64_t id;
+	};
+	Producer_Args args[PRODUCERS_COUNT];
+	mn::Thread producers[PRODUCERS_COUNT];
+	for (uint64_t p = 0; p < PRODUCERS_COUNT; ++p)
+	{
+		args[p] = Producer_Args{ring, p};
+		producers[p] = mn::thread_new([](void* arg) {
+			auto [ring, id] = *(Producer_Args*)arg;
+			for (uint64_t i = 0; i < VALUES_COUNT;)
+			{
+				// mix batch and single pushes
+				uint64_t batch[2] = {(id << 32) | i, (id << 32) | (i + 1)};
+				size_t count = i % 3 == 0 && i + 1 < VALUES_COUNT ? 2 : 1;
+				size_t pushed = 0;
+				while (pushed < count)
+					pushed += mn::mpsc_ring_push_many(ring, batch + pushed, count - pushed);
+				i += count;
+			}
+		}, &args[p], "mpsc ring producer");
+	}
+
+	uint64_t next[PRODUCERS_COUNT] = {};
+	bool in_order = true;
+	uint64_t total = 0;
+	uint64_t values[64];
+	while (total < PRODUCERS_COUNT * VALUES_COUNT)
+	{
+		auto count = mn::mpsc_ring_pop_many_wait(ring, values, 64);
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto id = values[i] >> 32;
+			auto value = values[i] & 0xFFFFFFFF;
+			in_order &= id < PRODUCERS_COUNT && next[id] == value;
+			if (id < PRODUCERS_COUNT)
+				next[id] = value + 1;
+		}
+		total += count;
+	}
+	CHECK(in_order);
+	for (auto n: next)
+		CHECK(n == VALUES_COUNT);
+
+	for (auto producer: producers)
+	{
+		mn::thread_join(producer);
+		mn::thread_free(producer);
+	}
+	uint64_t value = 0;
+	CHECK(mn::mpsc_ring_pop(ring, value) == false);
+	CHECK(mn::mpsc_ring_count(ring) == 0);
+	mn::mpsc_ring_free(ring);
+}
+
 TEST_CASE("Rune")
 {
 	CHECK(mn::rune_upper('a') == 'A');
@@ -734,6 +1718,136 @@ TEST_CASE("Deque")
 
 		mn::deque_free(nums);
 	}
+
+	SUBCASE("deque queue reuses buckets")
+	{
+		auto buddy = mn::allocator_buddy_new(1024 * 1024);
+		auto nums = mn::deque_with_allocator<int>(buddy);
+		CHECK(nums.bucket_size == 1024);
+
+		int next_push = 0, next_pop = 0;
+		for (int i = 0; i < 3000; ++i)
+			mn::deque_push_back(nums, next_push++);
+
+		// a queue which never gets empty, it needs a single extra bucket at first then it doesn't allocate
+		bool in_order = true;
+		size_t allocations_count = 0;
+		for (int i = 0; i < 100000; ++i)
+		{
+			if (i == 2000)
+				allocations_count = buddy->stats().total_count;
+			mn::deque_push_back(nums, next_push++);
+			in_order &= mn::deque_front(nums) == next_pop++;
+			mn::deque_pop_front(nums);
+		}
+		CHECK(in_order);
+		CHECK(buddy->stats().total_count == allocations_count);
+
+		// a stack at the front
+		for (int i = 0; i < 100000; ++i)
+		{
+			mn::deque_push_front(nums, i);
+			mn::deque_pop_back(nums);
+		}
+		CHECK(nums.count == 3000);
+		CHECK(buddy->stats().total_count == allocations_count);
+
+		mn::deque_free(nums);
+		CHECK(buddy->stats().live_count == 0);
+		mn::allocator_free(buddy);
+	}
+
+	SUBCASE("deque bulk")
+	{
+		struct Big { int value; char pad[60]; };
+		auto nums = mn::deque_new<Big>();
+		CHECK(nums.bucket_size == 64);
+
+		auto values = mn::buf_new<Big>();
+		mn_defer(mn::buf_free(values));
+		for (int i = 0; i < 1000; ++i)
+			mn::buf_push(values, Big{i, {}});
+
+		mn::deque_push_back_many(nums, values.ptr + 500, 500);
+		mn::deque_push_front_many(nums, values.ptr, 500);
+		REQUIRE(nums.count == 1000);
+		bool in_order = true;
+		for (int i = 0; i < 1000; ++i)
+			in_order &= nums[i].value == i;
+		CHECK(in_order);
+
+		Big popped[300];
+		CHECK(mn::deque_pop_front_many(nums, popped, 300) == 300);
+		CHECK(popped[0].value == 0);
+		CHECK(popped[299].value == 299);
+		CHECK(mn::deque_pop_back_many(nums, popped, 300) == 300);
+		CHECK(popped[0].value == 700);
+		CHECK(popped[299].value == 999);
+		CHECK(mn::deque_front(nums).value == 300);
+		CHECK(mn::deque_back(nums).value == 699);
+		CHECK(mn::deque_pop_back_many(nums, (Big*)nullptr, 1000) == 400);
+		CHECK(nums.count == 0);
+
+		mn::deque_free(nums);
+	}
+
+	SUBCASE("deque random ops")
+	{
+		auto nums = mn::deque_new<int>();
+		auto model = mn::buf_new<int>();
+		mn_defer(mn::buf_free(model));
+
+		uint64_t state = 42;
+		auto next_random = [&state]() {
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			return uint32_t(state >> 33);
+		};
+
+		int values[3000];
+		for (int i = 0; i < 3000; ++i)
+			values[i] = i;
+
+		bool same = true;
+		for (int step = 0; step < 2000; ++step)
+		{
+			auto count = next_random() % 3000;
+			switch (next_random() % 4)
+			{
+			case 0:
+				mn::deque_push_back_many(nums, values, count);
+				for (size_t i = 0; i < count; ++i)
+					mn::buf_push(model, values[i]);
+				break;
+			case 1:
+				mn::deque_push_front_many(nums, values, count);
+				mn::buf_resize(model, model.count + count);
+				::memmove(model.ptr + count, model.ptr, (model.count - count) * sizeof(int));
+				::memcpy(model.ptr, values, count * sizeof(int));
+				break;
+			case 2:
+				count = mn::deque_pop_front_many(nums, (int*)nullptr, count);
+				::memmove(model.ptr, model.ptr + count, (model.count - count) * sizeof(int));
+				mn::buf_resize(model, model.count - count);
+				break;
+			case 3:
+				count = mn::deque_pop_back_many(nums, (int*)nullptr, count);
+				mn::buf_resize(model, model.count - count);
+				break;
+			}
+
+			same &= nums.count == model.count;
+			if (nums.count > 0)
+			{
+				same &= mn::deque_front(nums) == model[0];
+				same &= mn::deque_back(nums) == mn::buf_top(model);
+				auto ix = next_random() % nums.count;
+				same &= nums[ix] == model[ix];
+			}
+		}
+		CHECK(same);
+
+		mn::deque_free(nums);
+	}
 }
 
 mn::Result<int> my_div(int a, int b)
@@ -1005,6 +2119,184 @@ TEST_CASE("buddy")
 	mn::allocator_free(buddy);
 }
 
+TEST_CASE("buddy growable heaps")
+{
+	auto buddy = mn::allocator_buddy_new(64 * 1024, mn::memory::virtual_mem(), mn::memory::BUDDY_FLAGS_GROWABLE);
+	auto blocks = mn::buf_new<mn::Block>();
+	for (size_t i = 0; i < 64; ++i)
+	{
+		auto block = mn::alloc_from(buddy, 4000, alignof(int));
+		CHECK(block.ptr != nullptr);
+		::memset(block.ptr, int(i), block.size);
+		mn::buf_push(blocks, block);
+	}
+	CHECK(buddy->heaps_count > 1);
+
+	// requests larger than the heap size still fail
+	auto big = mn::alloc_from(buddy, 64 * 1024, alignof(int));
+	CHECK(big.ptr == nullptr);
+
+	for (size_t i = 0; i < blocks.count; ++i)
+	{
+		CHECK(((uint8_t*)blocks[i].ptr)[0] == uint8_t(i));
+		CHECK(((uint8_t*)blocks[i].ptr)[blocks[i].size - 1] == uint8_t(i));
+		mn::free_from(buddy, blocks[i]);
+	}
+	CHECK(buddy->heaps_count == 1);
+
+	// alloc/free pairs around a heap boundary reuse the spare heap instead of releasing it
+	auto first = mn::alloc_from(buddy, 60000, alignof(int));
+	auto second = mn::alloc_from(buddy, 60000, alignof(int));
+	CHECK(buddy->heaps_count == 2);
+	for (int i = 0; i < 10; ++i)
+	{
+		mn::free_from(buddy, second);
+		CHECK(buddy->heaps_count == 2);
+		auto again = mn::alloc_from(buddy, 60000, alignof(int));
+		CHECK(again.ptr == second.ptr);
+		second = again;
+	}
+	mn::free_from(buddy, second);
+	mn::free_from(buddy, first);
+	CHECK(buddy->heaps_count == 1);
+
+	mn::buf_free(blocks);
+	mn::allocator_free(buddy);
+}
+
+TEST_CASE("buddy thread safe")
+{
+	auto buddy = mn::allocator_buddy_new(
+		64 * 1024,
+		mn::memory::virtual_mem(),
+		mn::memory::BUDDY_FLAGS_GROWABLE | mn::memory::BUDDY_FLAGS_THREAD_SAFE
+	);
+	auto f = mn::fabric_new({});
+	std::atomic<size_t> failures = 0;
+	mn::compute(f, {64, 1, 1}, {1, 1, 1}, [&](mn::Compute_Args args) {
+		auto nums = mn::buf_with_allocator<size_t>(buddy);
+		for (size_t i = 0; i < 1000; ++i)
+			mn::buf_push(nums, i * args.workgroup_id.x);
+		for (size_t i = 0; i < 1000; ++i)
+			if (nums[i] != i * args.workgroup_id.x)
+				++failures;
+		mn::buf_free(nums);
+	});
+	CHECK(failures == 0);
+	CHECK(buddy->heaps_count == 1);
+	mn::fabric_free(f);
+	mn::allocator_free(buddy);
+}
+
+TEST_CASE("concurrent map")
+{
+	auto map = mn::concurrent_map_new<size_t, size_t>(64, mn::memory::clib());
+	mn::concurrent_map_reserve(map, 1000);
+
+	auto f = mn::fabric_new({});
+	mn::compute(f, {64, 1, 1}, {1, 1, 1}, [&](mn::Compute_Args args) {
+		auto id = args.workgroup_id.x;
+		// each workgroup inserts its own keys and increments a shared set of counters
+		for (size_t i = 0; i < 1000; ++i)
+			mn::concurrent_map_insert(map, id * 1000 + i + 100, i);
+		for (size_t i = 0; i < 100; ++i)
+			mn::concurrent_map_upsert(map, i, [](size_t& value, bool) { ++value; });
+		for (size_t i = 0; i < 1000; i += 2)
+			mn::concurrent_map_remove(map, id * 1000 + i + 100);
+	});
+	mn::fabric_free(f);
+
+	CHECK(mn::concurrent_map_count(map) == 100 + 64 * 500);
+	for (size_t i = 0; i < 100; ++i)
+	{
+		size_t value = 0;
+		CHECK(mn::concurrent_map_lookup(map, i, &value));
+		CHECK(value == 64);
+	}
+
+	size_t value = 0;
+	CHECK(mn::concurrent_map_lookup(map, size_t(3 * 1000 + 1 + 100), &value));
+	CHECK(value == 1);
+	CHECK(mn::concurrent_map_lookup(map, size_t(3 * 1000 + 2 + 100)) == false);
+
+	CHECK(mn::concurrent_map_remove(map, size_t(0), &value));
+	CHECK(value == 64);
+	CHECK(mn::concurrent_map_insert(map, size_t(0), size_t(1)));
+	CHECK(mn::concurrent_map_insert(map, size_t(0), size_t(2)) == false);
+
+	size_t sum = 0;
+	mn::concurrent_map_each(map, [&](const size_t& key, const size_t&) { sum += key; });
+	size_t expected_sum = 99 * 100 / 2;
+	for (size_t id = 0; id < 64; ++id)
+		for (size_t i = 1; i < 1000; i += 2)
+			expected_sum += id * 1000 + i + 100;
+	CHECK(sum == expected_sum);
+
+	mn::concurrent_map_free(map);
+}
+
+TEST_CASE("memory profiler")
+{
+	auto profiler = mn::memory_profiler_new(1024);
+	auto old_interface = mn::memory_profile_interface_set(mn::memory_profiler_interface(profiler));
+
+	auto blocks = mn::buf_with_allocator<mn::Block>(mn::memory::clib());
+	for (size_t i = 0; i < 1000; ++i)
+		mn::buf_push(blocks, mn::alloc(256, alignof(int)));
+
+	auto stats = mn::memory_profiler_stats(profiler);
+	CHECK(stats.live_count > 0);
+
+	auto report = mn::memory_stream_new();
+	mn::memory_profiler_report(profiler, report);
+	auto report_str = mn::memory_stream_str(report);
+	CHECK(mn::str_find(report_str, "heap profile:", 0) == 0);
+	mn::str_free(report_str);
+	mn::memory_stream_free(report);
+
+	for (auto block: blocks)
+		mn::free(block);
+	mn::buf_free(blocks);
+
+	stats = mn::memory_profiler_stats(profiler);
+	CHECK(stats.live_count == 0);
+	CHECK(stats.live_size == 0);
+	CHECK(stats.total_count > 0);
+
+	mn::memory_profile_interface_set(old_interface);
+	mn::memory_profiler_free(profiler);
+}
+
+TEST_CASE("leak allocator concurrent")
+{
+	auto leak = mn::memory::leak();
+	auto old_sample_rate = leak->callstack_sample_rate.load();
+	leak->callstack_sample_rate = 16;
+
+	auto live_count = [leak] {
+		size_t res = 0;
+		for (const auto& shard: leak->shards)
+			for (auto it = shard.head; it; it = it->next)
+				++res;
+		return res;
+	};
+	auto live_count_before = live_count();
+
+	auto f = mn::fabric_new({});
+	mn::compute(f, {64, 1, 1}, {1, 1, 1}, [&](mn::Compute_Args) {
+		auto blocks = mn::buf_with_allocator<mn::Block>(mn::memory::clib());
+		for (size_t i = 0; i < 1000; ++i)
+			mn::buf_push(blocks, mn::alloc_from(leak, 64, alignof(int)));
+		for (auto block: blocks)
+			mn::free_from(leak, block);
+		mn::buf_free(blocks);
+	});
+	mn::fabric_free(f);
+	CHECK(live_count() == live_count_before);
+
+	leak->callstack_sample_rate = old_sample_rate;
+}
+
 TEST_CASE("handle table generation check")
 {
 	auto table = mn::handle_table_new<int>();
@@ -1061,6 +2353,700 @@ TEST_CASE("handle table generation check")
 	mn::buf_free(handles);
 }
 
+TEST_CASE("handle table soa")
+{
+	auto table = mn::handle_table_soa_new<int>();
+	auto handles = mn::buf_new<uint64_t>();
+	for (int i = 0; i < 10; ++i)
+		mn::buf_push(handles, mn::handle_table_soa_insert(table, i));
+	CHECK(table.values.count == 10);
+
+	for (size_t i = 0; i < handles.count; i += 2)
+		mn::handle_table_soa_remove(table, handles[i]);
+	CHECK(table.values.count == 5);
+
+	for (size_t i = 0; i < handles.count; ++i)
+	{
+		CHECK(mn::handle_table_soa_exists(table, handles[i]) == (i % 2 == 1));
+		auto ptr = mn::handle_table_soa_get(table, handles[i]);
+		if (i % 2 == 1)
+			CHECK(*ptr == int(i));
+		else
+			CHECK(ptr == nullptr);
+	}
+
+	// the values are dense and each one maps back to its handle
+	for (size_t i = 0; i < table.values.count; ++i)
+	{
+		auto handle = mn::handle_table_soa_handle(table, i);
+		CHECK(*mn::handle_table_soa_get(table, handle) == table.values[i]);
+		CHECK(handles[table.values[i]] == handle);
+	}
+
+	auto new_handle = mn::handle_table_soa_insert(table, 42);
+	CHECK(mn::handle_table_soa_exists(table, handles[8]) == false);
+	CHECK(*mn::handle_table_soa_get(table, new_handle) == 42);
+
+	mn::handle_table_soa_free(table);
+	mn::buf_free(handles);
+}
+
+TEST_CASE("concurrent handle table")
+{
+	constexpr size_t WORKGROUPS_COUNT = 8;
+	constexpr size_t VALUES_COUNT = 3000;
+
+	auto table = mn::concurrent_handle_table_new<uint64_t>(mn::memory::clib());
+
+	uint64_t stale = mn::concurrent_handle_table_insert(table, uint64_t(7));
+	CHECK(mn::concurrent_handle_table_exists(table, stale));
+	CHECK(mn::concurrent_handle_table_remove(table, stale));
+	CHECK(mn::concurrent_handle_table_remove(table, stale) == false);
+	CHECK(mn::concurrent_handle_table_exists(table, stale) == false);
+	CHECK(mn::concurrent_handle_table_exists(table, mn::HANDLE_TABLE_INVLAID_INDEX) == false);
+
+	// each workgroup inserts its values in batches, and reads the other workgroups values while they're being inserted
+	// and removed, every successful read should return the value which belongs to the handle
+	std::atomic<size_t> bad_reads = 0;
+	auto shared_handles = (std::atomic<uint64_t>*)::calloc(WORKGROUPS_COUNT * VALUES_COUNT, sizeof(std::atomic<uint64_t>));
+	for (size_t i = 0; i < WORKGROUPS_COUNT * VALUES_COUNT; ++i)
+		shared_handles[i].store(mn::HANDLE_TABLE_INVLAID_INDEX);
+	auto f = mn::fabric_new({});
+	mn::compute(f, {WORKGROUPS_COUNT, 1, 1}, {1, 1, 1}, [&](mn::Compute_Args args) {
+		auto id = args.workgroup_id.x;
+		auto values = mn::buf_with_allocator<uint64_t>(mn::memory::clib());
+		auto handles = mn::buf_with_allocator<uint64_t>(mn::memory::clib());
+		mn_defer({
+			mn::buf_free(values);
+			mn::buf_free(handles);
+		});
+		for (size_t i = 0; i < VALUES_COUNT; ++i)
+			mn::buf_push(values, uint64_t(id) << 32 | i);
+		mn::buf_resize(handles, VALUES_COUNT);
+
+		for (size_t round = 0; round < 4; ++round)
+		{
+			for (size_t i = 0; i < VALUES_COUNT; i += 100)
+				mn::concurrent_handle_table_insert_many(table, values.ptr + i, 100, handles.ptr + i);
+
+			for (size_t i = 0; i < VALUES_COUNT; ++i)
+			{
+				uint64_t value = 0;
+				if (mn::concurrent_handle_table_get(table, handles[i], &value) == false || value != values[i])
+					bad_reads.fetch_add(1);
+			}
+
+			// read the values of the next workgroup using its published handles which may be removed at any moment
+			for (size_t i = 0; i < VALUES_COUNT; ++i)
+				shared_handles[id * VALUES_COUNT + i].store(handles[i]);
+			auto other = (id + 1) % WORKGROUPS_COUNT;
+			for (size_t i = 0; i < VALUES_COUNT; ++i)
+			{
+				uint64_t value = 0;
+				auto handle = shared_handles[other * VALUES_COUNT + i].load();
+				if (mn::concurrent_handle_table_get(table, handle, &value) && value != (uint64_t(other) << 32 | i))
+					bad_reads.fetch_add(1);
+			}
+
+			CHECK(mn::concurrent_handle_table_remove_many(table, handles.ptr, VALUES_COUNT) == VALUES_COUNT);
+			for (size_t i = 0; i < VALUES_COUNT; ++i)
+				if (mn::concurrent_handle_table_exists(table, handles[i]))
+					bad_reads.fetch_add(1);
+		}
+	});
+	mn::fabric_free(f);
+	::free(shared_handles);
+
+	CHECK(bad_reads == 0);
+	CHECK(mn::concurrent_handle_table_count(table) == 0);
+
+	uint64_t handles[3];
+	uint64_t values[3] = {1, 2, 3};
+	mn::concurrent_handle_table_insert_many(table, values, 3, handles);
+	uint64_t sum = 0;
+	size_t visited = 0;
+	mn::concurrent_handle_table_each(table, [&](uint64_t handle, uint64_t value) {
+		uint64_t v = 0;
+		CHECK(mn::concurrent_handle_table_get(table, handle, &v));
+		CHECK(v == value);
+		sum += value;
+		++visited;
+	});
+	CHECK(visited == 3);
+	CHECK(sum == 6);
+	CHECK(mn::concurrent_handle_table_count(table) == 3);
+
+	mn::concurrent_handle_table_free(table);
+}
+
+TEST_CASE("heap")
+{
+	auto heap = mn::heap_new<int>();
+	mn_defer(mn::heap_free(heap));
+
+	uint32_t state = 7;
+	auto sorted = mn::buf_with_allocator<int>(mn::memory::tmp());
+	for (int i = 0; i < 1000; ++i)
+	{
+		state = state * 1664525 + 1013904223;
+		auto v = int(state >> 16) % 500;
+		mn::heap_push(heap, v);
+		mn::buf_push(sorted, v);
+	}
+	std::sort(begin(sorted), end(sorted));
+
+	CHECK(mn::heap_count(heap) == 1000);
+	CHECK(mn::heap_top(heap) == sorted[0]);
+	bool in_order = true;
+	for (auto v: sorted)
+		in_order &= mn::heap_pop(heap) == v;
+	CHECK(in_order);
+	CHECK(mn::heap_empty(heap));
+
+	// heapify a buf in place, with a greater than ordering and a binary layout
+	struct Greater
+	{
+		bool operator()(int a, int b) const { return a > b; }
+	};
+	auto items = mn::buf_lit({3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5});
+	auto max_heap = mn::heap_from_buf<int, Greater, 2>(items);
+	CHECK(items.ptr == nullptr);
+	int expected[] = {9, 6, 5, 5, 5, 4, 3, 3, 2, 1, 1};
+	for (auto v: expected)
+		CHECK(mn::heap_pop(max_heap) == v);
+	mn::heap_free(max_heap);
+}
+
+TEST_CASE("indexed heap")
+{
+	// dijkstra shortest paths on a small grid graph using decrease key
+	constexpr int N = 16;
+	auto weight = [](int from, int to) { return (from * 31 + to * 7919) % 13 + 1; };
+
+	auto dist = mn::buf_with_allocator<int>(mn::memory::tmp());
+	mn::buf_resize_fill(dist, N * N, INT32_MAX);
+	auto handles = mn::buf_with_allocator<uint64_t>(mn::memory::tmp());
+	mn::buf_resize_fill(handles, N * N, mn::HANDLE_TABLE_INVLAID_INDEX);
+
+	struct Entry
+	{
+		int dist;
+		int node;
+		bool operator<(const Entry& other) const { return dist < other.dist; }
+	};
+	auto queue = mn::indexed_heap_new<Entry>();
+	mn_defer(mn::indexed_heap_free(queue));
+
+	dist[0] = 0;
+	handles[0] = mn::indexed_heap_push(queue, Entry{0, 0});
+	size_t decrease_count = 0;
+	while (mn::indexed_heap_empty(queue) == false)
+	{
+		auto top = mn::indexed_heap_pop(queue);
+		CHECK(top.dist == dist[top.node]);
+		int x = top.node % N, y = top.node / N;
+		int neighbours[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+		for (auto [nx, ny]: neighbours)
+		{
+			if (nx < 0 || ny < 0 || nx >= N || ny >= N)
+				continue;
+			auto next = ny * N + nx;
+			auto d = top.dist + weight(top.node, next);
+			if (d >= dist[next])
+				continue;
+			if (dist[next] != INT32_MAX)
+			{
+				REQUIRE(mn::indexed_heap_exists(queue, handles[next]));
+				mn::indexed_heap_update(queue, handles[next], Entry{d, next});
+				++decrease_count;
+			}
+			else
+			{
+				handles[next] = mn::indexed_heap_push(queue, Entry{d, next});
+			}
+			dist[next] = d;
+		}
+	}
+	CHECK(decrease_count > 0);
+
+	// compare with bellman ford
+	auto expected = mn::buf_with_allocator<int>(mn::memory::tmp());
+	mn::buf_resize_fill(expected, N * N, INT32_MAX);
+	expected[0] = 0;
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (int node = 0; node < N * N; ++node)
+		{
+			if (expected[node] == INT32_MAX)
+				continue;
+			int x = node % N, y = node / N;
+			int neighbours[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+			for (auto [nx, ny]: neighbours)
+			{
+				if (nx < 0 || ny < 0 || nx >= N || ny >= N)
+					continue;
+				auto next = ny * N + nx;
+				if (expected[node] + weight(node, next) < expected[next])
+				{
+					expected[next] = expected[node] + weight(node, next);
+					changed = true;
+				}
+			}
+		}
+	}
+	bool same = true;
+	for (int node = 0; node < N * N; ++node)
+		same &= dist[node] == expected[node];
+	CHECK(same);
+
+	// remove items from the middle and update them in both directions
+	auto a = mn::indexed_heap_push(queue, Entry{5, 0});
+	auto b = mn::indexed_heap_push(queue, Entry{3, 1});
+	auto c = mn::indexed_heap_push(queue, Entry{8, 2});
+	CHECK(mn::indexed_heap_top(queue).node == 1);
+	CHECK(mn::indexed_heap_remove(queue, b).node == 1);
+	CHECK(mn::indexed_heap_exists(queue, b) == false);
+	mn::indexed_heap_update(queue, a, Entry{10, 0});
+	CHECK(mn::indexed_heap_top_handle(queue) == c);
+	CHECK(mn::indexed_heap_get(queue, a).dist == 10);
+	CHECK(mn::indexed_heap_pop(queue).node == 2);
+	CHECK(mn::indexed_heap_pop(queue).node == 0);
+	CHECK(mn::indexed_heap_empty(queue));
+}
+
+TEST_CASE("sort")
+{
+	uint32_t state = 1234;
+	auto next_random = [&]() {
+		state = state * 1664525 + 1013904223;
+		return state;
+	};
+
+	// patterns which break naive quick sorts
+	auto items = mn::buf_with_allocator<int>(mn::memory::tmp());
+	auto expected = mn::buf_with_allocator<int>(mn::memory::tmp());
+	for (int pattern = 0; pattern < 6; ++pattern)
+	{
+		for (size_t count: {0, 1, 2, 23, 24, 129, 5000})
+		{
+			mn::buf_clear(items);
+			for (size_t i = 0; i < count; ++i)
+			{
+				switch (pattern)
+				{
+				case 0: mn::buf_push(items, int(next_random())); break;
+				case 1: mn::buf_push(items, int(i)); break;
+				case 2: mn::buf_push(items, int(count - i)); break;
+				case 3: mn::buf_push(items, int(next_random() % 4)); break;
+				case 4: mn::buf_push(items, int(i % 2 ? i : count - i)); break;
+				default: mn::buf_push(items, i < count / 2 ? int(i) : int(count - i)); break;
+				}
+			}
+			expected = mn::buf_memcpy_clone(items, mn::memory::tmp());
+			std::sort(begin(expected), end(expected));
+			mn::buf_sort(items);
+			CHECK(::memcmp(items.ptr, expected.ptr, sizeof(int) * count) == 0);
+		}
+	}
+
+	// sort with custom ordering and non trivial items
+	auto strs = mn::buf_with_allocator<mn::Str>(mn::memory::tmp());
+	for (int i = 0; i < 200; ++i)
+		mn::buf_push(strs, mn::strf(mn::memory::tmp(), "str_{}", next_random() % 100));
+	auto str_views = mn::buf_with_allocator<mn::Str_View>(mn::memory::tmp());
+	for (const auto& str: strs)
+		mn::buf_push(str_views, mn::str_view(str));
+	mn::buf_sort(strs, [](const mn::Str& a, const mn::Str& b) { return b < a; });
+	CHECK(mn::buf_is_sorted(strs, [](const mn::Str& a, const mn::Str& b) { return b < a; }));
+
+	// radix sort strings matches the comparison sort
+	mn::buf_radix_sort(strs);
+	CHECK(mn::buf_is_sorted(strs));
+	mn::buf_radix_sort(str_views);
+	CHECK(mn::buf_is_sorted(str_views));
+	auto prefixed = mn::buf_lit({mn::str_view("abc"), mn::str_view("ab"), mn::str_view(""), mn::str_view("abcd"), mn::str_view("b"), mn::str_view("ab"), mn::str_view("a")});
+	mn::buf_radix_sort(prefixed);
+	CHECK(prefixed[0] == "");
+	CHECK(prefixed[1] == "a");
+	CHECK(prefixed[2] == "ab");
+	CHECK(prefixed[3] == "ab");
+	CHECK(prefixed[4] == "abc");
+	CHECK(prefixed[5] == "abcd");
+	CHECK(prefixed[6] == "b");
+	mn::buf_free(prefixed);
+
+	// stable sort and radix sort keep the order of the equal keys
+	struct Pair
+	{
+		int key;
+		int order;
+	};
+	auto pairs = mn::buf_with_allocator<Pair>(mn::memory::tmp());
+	for (int i = 0; i < 1000; ++i)
+		mn::buf_push(pairs, Pair{int(next_random() % 50) - 25, i});
+	auto radix_pairs = mn::buf_memcpy_clone(pairs, mn::memory::tmp());
+	mn::buf_stable_sort(pairs, [](const Pair& a, const Pair& b) { return a.key < b.key; });
+	mn::buf_radix_sort(radix_pairs, [](const Pair& p) { return p.key; });
+	bool stable = true;
+	for (size_t i = 1; i < pairs.count; ++i)
+		stable &= pairs[i - 1].key < pairs[i].key || (pairs[i - 1].key == pairs[i].key && pairs[i - 1].order < pairs[i].order);
+	CHECK(stable);
+	CHECK(::memcmp(pairs.ptr, radix_pairs.ptr, sizeof(Pair) * pairs.count) == 0);
+
+	// radix sort floats including negative numbers
+	auto floats = mn::buf_lit<float>({3.5f, -1.0f, 0.0f, -100.25f, 42.0f, -0.5f, 1e-3f});
+	mn::buf_radix_sort(floats);
+	CHECK(mn::buf_is_sorted(floats));
+	CHECK(floats[0] == -100.25f);
+	mn::buf_free(floats);
+
+	auto ints = mn::buf_with_allocator<int64_t>(mn::memory::tmp());
+	for (int i = 0; i < 3000; ++i)
+		mn::buf_push(ints, int64_t(next_random()) - INT32_MAX + (int64_t(next_random()) << 32));
+	mn::buf_radix_sort(ints);
+	CHECK(mn::buf_is_sorted(ints));
+}
+
+TEST_CASE("sorted search")
+{
+	auto nums = mn::buf_with_allocator<int32_t>(mn::memory::tmp());
+	auto unums = mn::buf_with_allocator<uint32_t>(mn::memory::tmp());
+	auto dnums = mn::buf_with_allocator<double>(mn::memory::tmp());
+	for (int32_t i = -500; i < 500; ++i)
+	{
+		// every value is duplicated to exercise the bounds
+		for (int j = 0; j < 2; ++j)
+		{
+			mn::buf_push(nums, i * 3);
+			mn::buf_push(unums, uint32_t(i + 500) * 3 + (i >= 0 ? 0x80000000u : 0u));
+			mn::buf_push(dnums, i * 3.0);
+		}
+	}
+
+	CHECK(mn::buf_lower_bound(mn::buf_with_allocator<int>(mn::memory::tmp()), 1) == 0);
+	bool same = true;
+	for (int32_t v = -1510; v < 1510; ++v)
+	{
+		for (size_t count: {size_t(0), size_t(1), size_t(7), size_t(17), nums.count})
+		{
+			same &= mn::lower_bound(nums.ptr, count, v) == size_t(std::lower_bound(nums.ptr, nums.ptr + count, v) - nums.ptr);
+			same &= mn::upper_bound(nums.ptr, count, v) == size_t(std::upper_bound(nums.ptr, nums.ptr + count, v) - nums.ptr);
+
+			auto uv = uint32_t(v + 1500) + (v >= 0 ? 0x80000000u : 0u);
+			same &= mn::lower_bound(unums.ptr, count, uv) == size_t(std::lower_bound(unums.ptr, unums.ptr + count, uv) - unums.ptr);
+			same &= mn::upper_bound(unums.ptr, count, uv) == size_t(std::upper_bound(unums.ptr, unums.ptr + count, uv) - unums.ptr);
+
+			auto dv = v * 1.0;
+			same &= mn::lower_bound(dnums.ptr, count, dv) == size_t(std::lower_bound(dnums.ptr, dnums.ptr + count, dv) - dnums.ptr);
+			same &= mn::upper_bound(dnums.ptr, count, dv) == size_t(std::upper_bound(dnums.ptr, dnums.ptr + count, dv) - dnums.ptr);
+		}
+	}
+	CHECK(same);
+
+	// values of another type are compared as is instead of being truncated to the item type
+	auto small = mn::buf_with_allocator<int32_t>(mn::memory::tmp());
+	for (int32_t i = 0; i < 40; ++i)
+		mn::buf_push(small, i);
+	CHECK(mn::buf_lower_bound(small, 2.5) == 3);
+	CHECK(mn::buf_upper_bound(small, 2.5) == 3);
+	CHECK(mn::buf_lower_bound(small, int64_t(INT32_MAX) + 1) == 40);
+	CHECK(mn::buf_upper_bound(small, int64_t(-1) - INT32_MAX) == 0);
+
+	CHECK(mn::buf_binary_search(nums, 3) == 1002);
+	CHECK(mn::buf_binary_search(nums, 4) == SIZE_MAX);
+	CHECK(mn::buf_upper_bound(nums, 3) == 1004);
+
+	auto strs = mn::buf_lit({mn::str_view("a"), mn::str_view("b"), mn::str_view("d")});
+	CHECK(mn::buf_lower_bound(strs, mn::str_view("c")) == 2);
+	CHECK(mn::buf_binary_search(strs, mn::str_view("b")) == 1);
+	mn::buf_free(strs);
+}
+
+TEST_CASE("cache")
+{
+	SUBCASE("lru")
+	{
+		auto cache = mn::cache_new<int, int>(3);
+		mn_defer(mn::cache_free(cache));
+
+		for (int i = 0; i < 3; ++i)
+			CHECK(mn::cache_insert(cache, i, i * 10));
+		CHECK(*mn::cache_lookup(cache, 0) == 0);
+		// 1 is the least recently used now
+		mn::cache_insert(cache, 3, 30);
+		CHECK(mn::cache_lookup(cache, 1) == nullptr);
+		CHECK(mn::cache_lookup(cache, 0) != nullptr);
+		CHECK(mn::cache_lookup(cache, 2) != nullptr);
+		mn::cache_insert(cache, 4, 40);
+		CHECK(mn::cache_lookup(cache, 3) == nullptr);
+
+		// overwrite doesn't evict
+		mn::cache_insert(cache, 4, 41);
+		CHECK(*mn::cache_lookup(cache, 4) == 41);
+		CHECK(mn::cache_count(cache) == 3);
+
+		auto stats = mn::cache_stats(cache);
+		CHECK(stats.hits == 4);
+		CHECK(stats.misses == 2);
+		CHECK(stats.evictions == 2);
+		CHECK(stats.count == 3);
+		CHECK(stats.size == 3);
+	}
+
+	SUBCASE("clock")
+	{
+		auto cache = mn::cache_new<int, int>(3, mn::CACHE_POLICY_CLOCK);
+		mn_defer(mn::cache_free(cache));
+
+		for (int i = 0; i < 3; ++i)
+			mn::cache_insert(cache, i, i);
+		// 0 and 2 get a second chance so 1 is evicted
+		mn::cache_lookup(cache, 0);
+		mn::cache_lookup(cache, 2);
+		mn::cache_insert(cache, 3, 3);
+		CHECK(mn::cache_lookup(cache, 1) == nullptr);
+		CHECK(mn::cache_lookup(cache, 0) != nullptr);
+		CHECK(mn::cache_lookup(cache, 3) != nullptr);
+		CHECK(mn::cache_count(cache) == 3);
+		CHECK(mn::cache_remove(cache, 3));
+		CHECK(mn::cache_remove(cache, 3) == false);
+		CHECK(mn::cache_count(cache) == 2);
+	}
+
+	SUBCASE("sized entries with evict callback")
+	{
+		auto cache = mn::cache_new<mn::Str, mn::Str>(64);
+		size_t evicted_count = 0;
+		mn::cache_set_evict_callback(cache, +[](void* user_data, mn::Str& key, mn::Str& value) {
+			++*(size_t*)user_data;
+			mn::str_free(key);
+			mn::str_free(value);
+		}, &evicted_count);
+
+		for (int i = 0; i < 10; ++i)
+		{
+			auto key = mn::strf("file_{}", i);
+			auto content = mn::str_new();
+			for (int j = 0; j < 20; ++j)
+				mn::str_push(content, 'x');
+			CHECK(mn::cache_insert(cache, key, content, content.count));
+		}
+		// only 3 files of 20 bytes fit in 64 bytes
+		CHECK(mn::cache_count(cache) == 3);
+		CHECK(evicted_count == 7);
+		CHECK(mn::cache_lookup(cache, mn::str_view("file_9")) != nullptr);
+		CHECK(mn::cache_lookup(cache, "file_6") == nullptr);
+
+		// too big to fit
+		auto big = mn::str_from_c("big");
+		CHECK(mn::cache_insert(cache, big, big, 65) == false);
+		mn::str_free(big);
+
+		mn::cache_free(cache);
+		CHECK(evicted_count == 10);
+	}
+}
+
+TEST_CASE("concurrent cache")
+{
+	constexpr size_t WORKGROUPS_COUNT = 8;
+	constexpr int KEYS_COUNT = 2000;
+
+	auto cache = mn::concurrent_cache_new<int, int>(1024, mn::CACHE_POLICY_CLOCK, 8, mn::memory::clib());
+	std::atomic<size_t> bad_values = 0;
+	auto f = mn::fabric_new({});
+	mn::compute(f, {WORKGROUPS_COUNT, 1, 1}, {1, 1, 1}, [&](mn::Compute_Args args) {
+		auto id = int(args.workgroup_id.x);
+		for (int i = 0; i < KEYS_COUNT * 4; ++i)
+		{
+			auto key = (i * 7 + id * 131) % KEYS_COUNT;
+			int value = 0;
+			if (mn::concurrent_cache_lookup(cache, key, &value))
+			{
+				if (value != key * 2)
+					bad_values.fetch_add(1);
+			}
+			else
+			{
+				mn::concurrent_cache_insert(cache, key, key * 2);
+			}
+		}
+	});
+	mn::fabric_free(f);
+	CHECK(bad_values == 0);
+
+	auto stats = mn::concurrent_cache_stats(cache);
+	CHECK(stats.hits + stats.misses == WORKGROUPS_COUNT * KEYS_COUNT * 4);
+	CHECK(stats.count <= stats.capacity);
+	CHECK(stats.size == stats.count);
+	CHECK(stats.evictions > 0);
+
+	mn::concurrent_cache_free(cache);
+}
+
+TEST_CASE("bitset")
+{
+	constexpr size_t COUNT = 1000;
+	auto a = mn::bitset_new(COUNT);
+	auto b = mn::bitset_new(COUNT / 2);
+	mn_defer({
+		mn::bitset_free(a);
+		mn::bitset_free(b);
+	});
+
+	bool ref_a[COUNT]{}, ref_b[COUNT]{};
+	for (size_t i = 0; i < COUNT; i += 3)
+	{
+		mn::bitset_set(a, i);
+		ref_a[i] = true;
+	}
+	for (size_t i = 0; i < COUNT / 2; i += 5)
+	{
+		mn::bitset_set(b, i);
+		ref_b[i] = true;
+	}
+	mn::bitset_unset(a, 3);
+	ref_a[3] = false;
+
+	size_t ref_count = 0;
+	for (size_t i = 0; i < COUNT; ++i)
+	{
+		CHECK(mn::bitset_test(a, i) == ref_a[i]);
+		ref_count += ref_a[i];
+	}
+	CHECK(mn::bitset_popcount(a) == ref_count);
+	CHECK(mn::bitset_find_next(a, 0) == 0);
+	CHECK(mn::bitset_find_next(a, 1) == 6);
+	CHECK(mn::bitset_find_next(a, 997) == 999);
+	CHECK(mn::bitset_find_next(a, COUNT) == mn::BITSET_NPOS);
+
+	size_t each_count = 0;
+	size_t last = 0;
+	bool ordered = true;
+	mn::bitset_each(a, [&](size_t i) {
+		if (each_count > 0 && i <= last)
+			ordered = false;
+		last = i;
+		++each_count;
+	});
+	CHECK(ordered);
+	CHECK(each_count == ref_count);
+
+	auto check_op = [&](auto op, auto ref_op) {
+		auto r = mn::bitset_clone(a);
+		mn_defer(mn::bitset_free(r));
+		op(r, b);
+		CHECK(r.count == COUNT);
+		size_t expected_count = 0;
+		for (size_t i = 0; i < COUNT; ++i)
+		{
+			bool expected = ref_op(ref_a[i], ref_b[i]);
+			CHECK(mn::bitset_test(r, i) == expected);
+			expected_count += expected;
+		}
+		CHECK(mn::bitset_popcount(r) == expected_count);
+	};
+	check_op([](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_and(x, y); }, [](bool x, bool y) { return x && y; });
+	check_op([](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_or(x, y); }, [](bool x, bool y) { return x || y; });
+	check_op([](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_xor(x, y); }, [](bool x, bool y) { return x != y; });
+	check_op([](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_andnot(x, y); }, [](bool x, bool y) { return x && !y; });
+
+	// or grows the smaller bitset
+	auto c = mn::bitset_clone(b);
+	mn_defer(mn::bitset_free(c));
+	mn::bitset_or(c, a);
+	CHECK(c.count == COUNT);
+	CHECK(mn::bitset_test(c, 999));
+
+	// shrinking masks the bits beyond the count so they don't reappear when growing
+	mn::bitset_resize(c, 10);
+	mn::bitset_resize(c, COUNT);
+	CHECK(mn::bitset_find_next(c, 10) == mn::BITSET_NPOS);
+	mn::bitset_insert(c, 2000);
+	CHECK(c.count == 2001);
+	CHECK(mn::bitset_find_next(c, 10) == 2000);
+}
+
+TEST_CASE("roaring bitset")
+{
+	auto a = mn::roaring_bitset_new();
+	auto b = mn::roaring_bitset_new();
+	auto ref_a = mn::bitset_new(1 << 20);
+	auto ref_b = mn::bitset_new(1 << 20);
+	mn_defer({
+		mn::roaring_bitset_free(a);
+		mn::roaring_bitset_free(b);
+		mn::bitset_free(ref_a);
+		mn::bitset_free(ref_b);
+	});
+
+	// a has a dense container at key 0 and sparse ones elsewhere, b has a dense container at key 1
+	for (uint32_t i = 0; i < 10000; ++i)
+	{
+		CHECK(mn::roaring_bitset_add(a, i * 3));
+		mn::bitset_set(ref_a, i * 3);
+	}
+	for (uint32_t i = 0; i < 1000; ++i)
+	{
+		mn::roaring_bitset_add(a, (i * 7919) % (1 << 20));
+		mn::bitset_set(ref_a, (i * 7919) % (1 << 20));
+	}
+	for (uint32_t i = 0; i < 30000; ++i)
+	{
+		mn::roaring_bitset_add(b, 20000 + i * 2);
+		mn::bitset_set(ref_b, 20000 + i * 2);
+	}
+	CHECK(mn::roaring_bitset_add(a, 0) == false);
+	CHECK(a.containers[0].bitmap.count == mn::ROARING_BITMAP_WORDS_COUNT);
+	CHECK(mn::roaring_bitset_count(a) == mn::bitset_popcount(ref_a));
+	CHECK(mn::roaring_bitset_count(b) == mn::bitset_popcount(ref_b));
+	CHECK(mn::roaring_bitset_contains(a, 9));
+	CHECK(mn::roaring_bitset_contains(a, 10) == false);
+
+	auto check_equal = [](const mn::Roaring_Bitset& r, const mn::Bitset& ref) {
+		CHECK(mn::roaring_bitset_count(r) == mn::bitset_popcount(ref));
+		size_t next = 0;
+		bool equal = true;
+		mn::roaring_bitset_each(r, [&](uint32_t v) {
+			next = mn::bitset_find_next(ref, next);
+			if (next != v)
+				equal = false;
+			++next;
+		});
+		CHECK(equal);
+		CHECK(mn::bitset_find_next(ref, next) == mn::BITSET_NPOS);
+	};
+	check_equal(a, ref_a);
+	check_equal(b, ref_b);
+
+	auto check_op = [&](auto op, auto ref_op) {
+		auto r = op(a, b);
+		auto ref = mn::bitset_clone(ref_a);
+		mn_defer({
+			mn::roaring_bitset_free(r);
+			mn::bitset_free(ref);
+		});
+		ref_op(ref, ref_b);
+		check_equal(r, ref);
+	};
+	check_op([](const auto& x, const auto& y) { return mn::roaring_bitset_and(x, y); }, [](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_and(x, y); });
+	check_op([](const auto& x, const auto& y) { return mn::roaring_bitset_or(x, y); }, [](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_or(x, y); });
+	check_op([](const auto& x, const auto& y) { return mn::roaring_bitset_xor(x, y); }, [](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_xor(x, y); });
+	check_op([](const auto& x, const auto& y) { return mn::roaring_bitset_andnot(x, y); }, [](mn::Bitset& x, const mn::Bitset& y) { mn::bitset_andnot(x, y); });
+
+	// removing items from the dense container converts it back to an array
+	for (uint32_t i = 0; i < 10000; ++i)
+		CHECK(mn::roaring_bitset_remove(a, i * 3));
+	CHECK(mn::roaring_bitset_remove(a, 3) == false);
+	CHECK((a.containers.count == 0 || a.containers[0].bitmap.count == 0));
+	for (const auto& container: a.containers)
+		CHECK(container.count > 0);
+
+	mn::roaring_bitset_clear(b);
+	CHECK(mn::roaring_bitset_count(b) == 0);
+}
+
 TEST_CASE("zero init buf")
 {
 	mn::Buf<int> nums{};
@@ -1366,3 +3352,117 @@ TEST_CASE("arena scopes")
 	mn::allocator_arena_restore(mn::memory::tmp(), checkpoint);
 	CHECK(name == "my name is mostafa");
 }
+
+TEST_CASE("scratch arenas")
+{
+	auto outer = mn::scratch_begin();
+	auto outer_str = mn::str_from_c("outer scratch", outer.arena);
+
+	[](mn::Allocator allocator) {
+		auto inner = mn::scratch_begin({allocator});
+		CHECK(inner.arena != allocator);
+		for (size_t i = 0; i < 100; ++i)
+			mn::str_from_c("inner scratch", inner.arena);
+	}(outer.arena);
+	CHECK(outer_str == "outer scratch");
+
+	auto used_mem = outer.arena->used_mem;
+	{
+		auto nested = mn::scratch_begin();
+		CHECK(nested.arena == outer.arena);
+		mn::str_from_c("nested scratch", nested.arena);
+		CHECK(outer.arena->used_mem > used_mem);
+	}
+	CHECK(outer.arena->used_mem == used_mem);
+	CHECK(outer_str == "outer scratch");
+
+	mn::scratch_end(outer);
+	CHECK(outer.arena == nullptr);
+}
+
+TEST_CASE("allocator stats")
+{
+	auto arena = mn::allocator_arena_new(1024);
+	mn::alloc_from(arena, 100, alignof(int));
+	mn::alloc_from(arena, 200, alignof(int));
+	auto stats = arena->stats();
+	CHECK(stats.live_size == 300);
+	CHECK(stats.live_count == 2);
+	CHECK(stats.total_count == 2);
+	CHECK(stats.reserved_size >= 300);
+	mn::allocator_arena_clear_all(arena);
+	stats = arena->stats();
+	CHECK(stats.live_size == 0);
+	CHECK(stats.live_count == 0);
+	CHECK(stats.peak_size == 300);
+	CHECK(stats.total_size == 300);
+	mn::allocator_free(arena);
+
+	auto buddy = mn::allocator_buddy_new(64 * 1024);
+	auto a = mn::alloc_from(buddy, 100, alignof(int));
+	auto b = mn::alloc_from(buddy, 1000, alignof(int));
+	stats = buddy->stats();
+	CHECK(stats.live_size == 1100);
+	CHECK(stats.live_count == 2);
+	CHECK(stats.reserved_size >= 64 * 1024);
+	mn::free_from(buddy, a);
+	mn::free_from(buddy, b);
+	stats = buddy->stats();
+	CHECK(stats.live_size == 0);
+	CHECK(stats.live_count == 0);
+	CHECK(stats.peak_size == 1100);
+	CHECK(stats.total_count == 2);
+	mn::allocator_free(buddy);
+
+	auto pool = mn::pool_new(sizeof(int), 64);
+	auto p1 = mn::pool_get(pool);
+	auto p2 = mn::pool_get(pool);
+	mn::pool_put(pool, p1);
+	stats = mn::pool_stats(pool);
+	CHECK(stats.live_count == 1);
+	CHECK(stats.total_count == 2);
+	CHECK(stats.peak_size == 2 * sizeof(void*));
+	mn::pool_put(pool, p2);
+	mn::pool_free(pool);
+
+	auto clib_stats = mn::memory::clib()->stats();
+	auto block = mn::alloc_from(mn::memory::clib(), 64, alignof(int));
+	stats = mn::memory::clib()->stats();
+	CHECK(stats.total_count > clib_stats.total_count);
+	mn::free_from(mn::memory::clib(), block);
+}
+
+TEST_CASE("allocator registry")
+{
+	auto stack = mn::allocator_stack_new(1024);
+	mn::allocator_register(stack, "test stack");
+	mn::allocator_register(mn::memory::clib(), "clib");
+
+	auto block = mn::alloc_from(stack, 128, alignof(int));
+
+	auto entries = mn::allocator_registry_snapshot();
+	bool found = false;
+	for (const auto& entry: entries)
+	{
+		if (entry.allocator == stack)
+		{
+			found = true;
+			CHECK(entry.name == "test stack");
+			CHECK(entry.stats.live_size == 128);
+			CHECK(entry.stats.reserved_size == 1024);
+		}
+	}
+	CHECK(found);
+	mn::destruct(entries);
+
+	mn::free_from(stack, block);
+	mn::allocator_unregister(stack);
+	mn::allocator_unregister(mn::memory::clib());
+
+	entries = mn::allocator_registry_snapshot();
+	for (const auto& entry: entries)
+		CHECK(entry.allocator != stack);
+	mn::destruct(entries);
+
+	mn::allocator_free(stack);
+}